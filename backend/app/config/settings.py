@@ -3,7 +3,11 @@ Configuration settings for Financial AI Assistant
 """
 import os
 from typing import List, Optional
-from pydantic import BaseSettings, validator
+from pydantic import validator
+try:
+    from pydantic_settings import BaseSettings
+except ImportError:  # pydantic 1.x
+    from pydantic import BaseSettings
 import secrets
 from enum import Enum
 
@@ -58,6 +62,7 @@ class Settings(BaseSettings):
     DATABASE_ECHO: bool = False
     DATABASE_POOL_SIZE: int = 10
     DATABASE_MAX_OVERFLOW: int = 20
+    DATABASE_POOL_TIMEOUT: int = 30
     
     # Redis settings (for caching and rate limiting)
     REDIS_URL: Optional[str] = None
@@ -166,6 +171,16 @@ class Settings(BaseSettings):
         # Default SQLite for development
         return "sqlite:///./financial_ai.db"
     
+    def get_async_database_url(self) -> str:
+        """Get database URL with the async driver (aiosqlite or asyncpg)"""
+        url = self.get_database_url()
+        if url.startswith("sqlite:"):
+            return "sqlite+aiosqlite:" + url[len("sqlite:"):]
+        for prefix in ("postgresql+psycopg2:", "postgresql:", "postgres:"):
+            if url.startswith(prefix):
+                return "postgresql+asyncpg:" + url[len(prefix):]
+        return url
+    
     def get_redis_url(self) -> str:
         """Get Redis URL"""
         if self.REDIS_URL:
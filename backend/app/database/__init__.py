@@ -22,11 +22,17 @@ from .connection import (
     DatabaseManager,
     db_manager,
     get_db,
+    get_async_db,
     run_migrations,
     create_initial_admin_user,
     migrate_json_data
 )
 
+from .repository import (
+    TransactionRepository,
+    get_transaction_repository
+)
+
 __all__ = [
     # Models
     "Base",
@@ -47,7 +53,12 @@ __all__ = [
     "DatabaseManager",
     "db_manager",
     "get_db",
+    "get_async_db",
     "run_migrations", 
     "create_initial_admin_user",
-    "migrate_json_data"
+    "migrate_json_data",
+    
+    # Repositories
+    "TransactionRepository",
+    "get_transaction_repository"
 ]
\ No newline at end of file
@@ -1,19 +1,45 @@
 """
 Database connection and session management for Financial AI Assistant
 """
-from sqlalchemy import create_engine, event, pool
+from sqlalchemy import create_engine, event, pool, text
 from sqlalchemy.orm import sessionmaker, Session
 from sqlalchemy.engine import Engine
-from contextlib import contextmanager
+from sqlalchemy.ext.asyncio import create_async_engine, async_sessionmaker, AsyncEngine, AsyncSession
+from contextlib import contextmanager, asynccontextmanager
+from datetime import datetime, timezone
+import asyncio
 import logging
 import os
-from typing import Generator, Optional
+from typing import AsyncGenerator, Generator, Optional, Dict, Any
 
 from ..config import settings
 from .models import Base, get_all_models
 
 logger = logging.getLogger(__name__)
 
+def _set_sqlite_pragma(dbapi_connection, connection_record):
+    """Per-connection SQLite settings, shared by the sync and async engines"""
+    cursor = dbapi_connection.cursor()
+    cursor.execute("PRAGMA foreign_keys=ON")
+    cursor.execute("PRAGMA journal_mode=WAL")
+    cursor.execute("PRAGMA synchronous=NORMAL")
+    cursor.execute("PRAGMA temp_store=memory")
+    cursor.execute("PRAGMA mmap_size=268435456")  # 256MB
+    cursor.close()
+
+def _pool_stats(engine_pool: pool.Pool) -> Dict[str, Any]:
+    """Connection pool gauges; pools without a fixed size report only their type"""
+    stats: Dict[str, Any] = {"pool_class": type(engine_pool).__name__}
+    if isinstance(engine_pool, pool.QueuePool):
+        stats.update({
+            "size": engine_pool.size(),
+            "checked_in": engine_pool.checkedin(),
+            "checked_out": engine_pool.checkedout(),
+            "overflow": engine_pool.overflow(),
+            "timeout": engine_pool.timeout()
+        })
+    return stats
+
 class DatabaseManager:
     """Database connection and session manager"""
     
@@ -21,6 +47,9 @@ class DatabaseManager:
         self.engine: Optional[Engine] = None
         self.SessionLocal: Optional[sessionmaker] = None
         self._initialized = False
+        self.async_engine: Optional[AsyncEngine] = None
+        self.AsyncSessionLocal: Optional[async_sessionmaker] = None
+        self._async_lock = asyncio.Lock()
     
     def initialize(self):
         """Initialize database connection"""
@@ -42,15 +71,7 @@ class DatabaseManager:
                 )
                 
                 # Enable foreign keys for SQLite
-                @event.listens_for(self.engine, "connect")
-                def set_sqlite_pragma(dbapi_connection, connection_record):
-                    cursor = dbapi_connection.cursor()
-                    cursor.execute("PRAGMA foreign_keys=ON")
-                    cursor.execute("PRAGMA journal_mode=WAL")
-                    cursor.execute("PRAGMA synchronous=NORMAL")
-                    cursor.execute("PRAGMA temp_store=memory")
-                    cursor.execute("PRAGMA mmap_size=268435456")  # 256MB
-                    cursor.close()
+                event.listen(self.engine, "connect", _set_sqlite_pragma)
                     
             else:
                 # PostgreSQL or other database settings
@@ -59,6 +80,7 @@ class DatabaseManager:
                     echo=settings.DATABASE_ECHO,
                     pool_size=settings.DATABASE_POOL_SIZE,
                     max_overflow=settings.DATABASE_MAX_OVERFLOW,
+                    pool_timeout=settings.DATABASE_POOL_TIMEOUT,
                     pool_pre_ping=True,
                     pool_recycle=3600  # Recycle connections after 1 hour
                 )
@@ -77,6 +99,88 @@ class DatabaseManager:
             logger.error(f"Failed to initialize database connection: {e}")
             raise
     
+    def _initialize_async(self):
+        """Create the async engine and session factory"""
+        database_url = settings.get_async_database_url()
+        
+        if database_url.startswith("sqlite"):
+            # A single shared connection keeps in-memory databases alive; file
+            # databases get a small pool since SQLite serializes writers anyway
+            memory = ":memory:" in database_url or database_url.endswith("://")
+            self.async_engine = create_async_engine(
+                database_url,
+                echo=settings.DATABASE_ECHO,
+                poolclass=pool.StaticPool if memory else pool.AsyncAdaptedQueuePool,
+                **({} if memory else {"pool_size": 5, "max_overflow": 0})
+            )
+            event.listen(self.async_engine.sync_engine, "connect", _set_sqlite_pragma)
+        else:
+            self.async_engine = create_async_engine(
+                database_url,
+                echo=settings.DATABASE_ECHO,
+                pool_size=settings.DATABASE_POOL_SIZE,
+                max_overflow=settings.DATABASE_MAX_OVERFLOW,
+                pool_timeout=settings.DATABASE_POOL_TIMEOUT,
+                pool_pre_ping=True,
+                pool_recycle=3600
+            )
+        
+        # Rows stay readable after commit without another round-trip
+        self.AsyncSessionLocal = async_sessionmaker(
+            self.async_engine,
+            expire_on_commit=False,
+            autoflush=False
+        )
+        logger.info("Async database engine initialized")
+    
+    async def initialize_async(self):
+        """Initialize the async engine, creating tables on first use"""
+        if self.async_engine is not None:
+            return
+        
+        async with self._async_lock:
+            if self.async_engine is not None:
+                return
+            try:
+                self._initialize_async()
+                async with self.async_engine.begin() as connection:
+                    await connection.run_sync(Base.metadata.create_all)
+            except Exception as e:
+                logger.error(f"Failed to initialize async database engine: {e}")
+                self.async_engine = None
+                self.AsyncSessionLocal = None
+                raise
+    
+    @asynccontextmanager
+    async def get_async_session(self) -> AsyncGenerator[AsyncSession, None]:
+        """Get async database session with automatic cleanup"""
+        await self.initialize_async()
+        
+        async with self.AsyncSessionLocal() as session:
+            try:
+                yield session
+            except Exception as e:
+                await session.rollback()
+                logger.error(f"Database session error: {e}")
+                raise
+    
+    async def health_check_async(self) -> bool:
+        """Check async database connection health"""
+        try:
+            async with self.get_async_session() as session:
+                await session.execute(text("SELECT 1"))
+                return True
+        except Exception as e:
+            logger.error(f"Async database health check failed: {e}")
+            return False
+    
+    async def dispose_async(self):
+        """Close every pooled async connection (call on shutdown)"""
+        if self.async_engine is not None:
+            await self.async_engine.dispose()
+            self.async_engine = None
+            self.AsyncSessionLocal = None
+    
     def create_tables(self):
         """Create all database tables"""
         if not self._initialized:
@@ -140,7 +244,7 @@ class DatabaseManager:
         try:
             with self.get_session() as session:
                 # Simple query to test connection
-                session.execute("SELECT 1")
+                session.execute(text("SELECT 1"))
                 return True
         except Exception as e:
             logger.error(f"Database health check failed: {e}")
@@ -152,24 +256,30 @@ class DatabaseManager:
             return {"status": "not_connected"}
         
         try:
+            pools = {"sync": _pool_stats(self.engine.pool)}
+            if self.async_engine is not None:
+                pools["async"] = _pool_stats(self.async_engine.pool)
+            
             with self.get_session() as session:
                 # Get database version and basic info
                 if settings.get_database_url().startswith("sqlite"):
-                    result = session.execute("SELECT sqlite_version()").scalar()
+                    result = session.execute(text("SELECT sqlite_version()")).scalar()
                     return {
                         "status": "connected",
                         "type": "sqlite",
                         "version": result,
-                        "url": settings.get_database_url()
+                        "url": settings.get_database_url(),
+                        "pools": pools
                     }
                 else:
-                    result = session.execute("SELECT version()").scalar()
+                    result = session.execute(text("SELECT version()")).scalar()
                     return {
                         "status": "connected", 
                         "type": "postgresql",
                         "version": result.split()[1] if result else "unknown",
                         "pool_size": settings.DATABASE_POOL_SIZE,
-                        "max_overflow": settings.DATABASE_MAX_OVERFLOW
+                        "max_overflow": settings.DATABASE_MAX_OVERFLOW,
+                        "pools": pools
                     }
         except Exception as e:
             return {
@@ -189,6 +299,11 @@ def get_db() -> Generator[Session, None, None]:
     finally:
         session.close()
 
+async def get_async_db() -> AsyncGenerator[AsyncSession, None]:
+    """FastAPI dependency to get an async database session"""
+    async with db_manager.get_async_session() as session:
+        yield session
+
 # Migration functions
 def run_migrations():
     """Run database migrations"""
@@ -262,13 +377,26 @@ def create_initial_admin_user(session: Session):
         logger.error(f"Failed to create initial admin user: {e}")
         raise
 
+def _parse_transaction_date(value) -> datetime:
+    """Parse a JSON transaction date into the naive UTC datetime stored in the database"""
+    if isinstance(value, str):
+        try:
+            parsed = datetime.fromisoformat(value.replace("Z", "+00:00"))
+            if parsed.tzinfo is not None:
+                parsed = parsed.astimezone(timezone.utc).replace(tzinfo=None)
+            return parsed
+        except ValueError:
+            logger.warning(f"Unparseable transaction date {value!r}, using migration time")
+    return datetime.utcnow()
+
 def migrate_json_data():
     """Migrate existing JSON data to database"""
     logger.info("Starting JSON to database migration...")
     
     try:
         from ..services.data_service import DataService
-        from .models import User, Account, Transaction, Investment, Asset, Liability
+        from .models import User, Account, Transaction, Investment, Asset, Liability, PrivacySetting
+        from ..security.auth import security_manager
         
         # Load existing JSON data
         data_service = DataService()
@@ -322,8 +450,9 @@ def migrate_json_data():
                                 amount=float(trans_data.get("amount", 0.0)),
                                 category=trans_data.get("category", "other"),
                                 transaction_type="credit" if trans_data.get("amount", 0.0) > 0 else "debit",
-                                transaction_date=trans_data.get("date", func.now()),
-                                merchant_name=trans_data.get("merchant")
+                                transaction_date=_parse_transaction_date(trans_data.get("date")),
+                                merchant_name=trans_data.get("merchant"),
+                                reference_id=trans_data.get("id")
                             )
                             session.add(transaction)
             
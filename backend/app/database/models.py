@@ -1,7 +1,7 @@
 """
 Database models for Financial AI Assistant
 """
-from sqlalchemy import Column, Integer, String, Float, DateTime, Boolean, Text, ForeignKey, JSON
+from sqlalchemy import Column, Integer, String, Float, DateTime, Boolean, Text, ForeignKey, JSON, Index
 from sqlalchemy.ext.declarative import declarative_base
 from sqlalchemy.orm import relationship
 from sqlalchemy.sql import func
@@ -58,7 +58,7 @@ class Account(BaseModel):
     """Financial accounts model"""
     __tablename__ = "accounts"
     
-    user_id = Column(String(36), ForeignKey("users.id"), nullable=False)
+    user_id = Column(String(36), ForeignKey("users.id"), nullable=False, index=True)
     account_name = Column(String(200), nullable=False)
     account_type = Column(String(50), nullable=False)  # savings, checking, credit_card, etc.
     account_number = Column(String(100))  # Encrypted
@@ -104,6 +104,14 @@ class Transaction(BaseModel):
     user = relationship("User", back_populates="transactions")
     account = relationship("Account", back_populates="transactions")
     
+    # Listing, "recent N" and category views are backward range scans over these;
+    # id is the keyset tiebreaker for transactions sharing a timestamp
+    __table_args__ = (
+        Index("ix_transactions_user_date", "user_id", "transaction_date", "id"),
+        Index("ix_transactions_user_category_date", "user_id", func.lower(category), "transaction_date", "id"),
+        Index("ix_transactions_user_reference", "user_id", "reference_id"),
+    )
+    
     def to_dict(self) -> Dict[str, Any]:
         return {
             "id": self.id,
@@ -118,6 +126,19 @@ class Transaction(BaseModel):
             "notes": self.notes,
             "tags": self.tags
         }
+    
+    def to_record(self) -> Dict[str, Any]:
+        """Transaction in the shape of the JSON data files served by the API"""
+        return {
+            "id": self.reference_id or self.id,
+            "date": self.transaction_date.isoformat() + "Z" if self.transaction_date else None,
+            "amount": self.amount,
+            "description": self.description,
+            "category": self.category,
+            "account": self.account_id,
+            "type": "income" if self.transaction_type == "credit" else "expense",
+            "merchant": self.merchant_name
+        }
 
 class Investment(BaseModel):
     """Investment holdings model"""
@@ -0,0 +1,247 @@
+"""
+Transaction repository for Financial AI Assistant
+Serves the transaction API from the Transaction table through its composite
+(user_id, transaction_date, id) and (user_id, lower(category), transaction_date, id)
+indexes, with keyset pagination so deep pages and "recent N" cost an index
+range scan instead of OFFSET row skipping. Queries run on the async engine so
+database round-trips do not block the event loop
+"""
+from datetime import datetime, timezone
+import logging
+import threading
+from typing import Dict, Any, List, Optional, Tuple
+
+from sqlalchemy import func, or_, and_, select
+from sqlalchemy.ext.asyncio import AsyncSession
+
+from .connection import db_manager
+from .models import User, Account, Transaction
+
+logger = logging.getLogger(__name__)
+
+# JSON transaction fields and the columns they map to
+RECORD_FIELDS = {
+    "description": "description",
+    "amount": "amount",
+    "category": "category",
+    "merchant": "merchant_name",
+    "notes": "notes",
+    "subcategory": "subcategory",
+}
+
+
+def _to_datetime(value: Any) -> Optional[datetime]:
+    """Convert an ISO string or epoch seconds to the naive UTC datetime the table stores"""
+    if value is None:
+        return None
+    if isinstance(value, (int, float)):
+        return datetime.fromtimestamp(value, timezone.utc).replace(tzinfo=None)
+    parsed = datetime.fromisoformat(str(value).replace("Z", "+00:00"))
+    if parsed.tzinfo is not None:
+        parsed = parsed.astimezone(timezone.utc).replace(tzinfo=None)
+    return parsed
+
+
+class TransactionRepository:
+    """Transaction queries and writes for one database, scoped by user"""
+
+    def __init__(self, manager=None):
+        """
+        Initialize the repository
+
+        Args:
+            manager: DatabaseManager providing async sessions (defaults to the global one)
+        """
+        self.manager = manager or db_manager
+        self._user_ids: Dict[str, str] = {}
+        self._lock = threading.Lock()
+
+    async def user_id_for(self, username: str) -> Optional[str]:
+        """Resolve a username to its user id, caching the lookup"""
+        with self._lock:
+            user_id = self._user_ids.get(username)
+        if user_id is not None:
+            return user_id
+
+        async with self.manager.get_async_session() as session:
+            user_id = await session.scalar(select(User.id).where(User.username == username))
+        if user_id is not None:
+            with self._lock:
+                self._user_ids[username] = user_id
+        return user_id
+
+    @staticmethod
+    def _conditions(user_id: str, category: Optional[str], start: Optional[float],
+                    end: Optional[float]) -> List[Any]:
+        """Filters matching the leading columns of the composite indexes"""
+        conditions = [Transaction.user_id == user_id]
+        if category:
+            conditions.append(func.lower(Transaction.category) == category.lower())
+        if start is not None:
+            conditions.append(Transaction.transaction_date >= _to_datetime(start))
+        if end is not None:
+            conditions.append(Transaction.transaction_date <= _to_datetime(end))
+        return conditions
+
+    async def page(self, user_id: str, limit: int, category: Optional[str] = None,
+                   start: Optional[float] = None, end: Optional[float] = None,
+                   key: Optional[Dict[str, Any]] = None, offset: int = 0,
+                   with_total: bool = True) -> Tuple[List[Dict[str, Any]], Optional[Dict[str, Any]], Optional[int]]:
+        """
+        Get one newest-first page of a user's transactions
+
+        Args:
+            user_id: Owner of the transactions
+            limit: Maximum records returned
+            category: Case-insensitive category filter
+            start: Inclusive lower bound in epoch seconds
+            end: Inclusive upper bound in epoch seconds
+            key: Keyset key of the previous page's last row; takes precedence over offset
+            offset: Rows skipped from the newest, for clients without a cursor
+            with_total: Also count every matching row
+
+        Returns:
+            (records, key of the last record or None when nothing follows, total or None)
+        """
+        limit = max(0, limit)
+        conditions = self._conditions(user_id, category, start, end)
+
+        async with self.manager.get_async_session() as session:
+            total = None
+            if with_total:
+                total = await session.scalar(select(func.count()).select_from(Transaction).where(*conditions))
+
+            query = select(Transaction).where(*conditions)
+            if key is not None:
+                after = _to_datetime(key["t"])
+                query = query.where(or_(
+                    Transaction.transaction_date < after,
+                    and_(Transaction.transaction_date == after, Transaction.id < key["id"])
+                ))
+            elif offset:
+                query = query.offset(offset)
+
+            # Fetch one extra row to learn whether another page follows
+            query = query.order_by(Transaction.transaction_date.desc(), Transaction.id.desc()).limit(limit + 1)
+            rows = list((await session.scalars(query)).all())
+            has_more = len(rows) > limit
+            rows = rows[:limit]
+
+            next_key = None
+            if has_more and rows:
+                last = rows[-1]
+                next_key = {"t": last.transaction_date.replace(tzinfo=timezone.utc).timestamp(), "id": last.id}
+            return [row.to_record() for row in rows], next_key, total
+
+    async def recent(self, user_id: str, limit: int) -> List[Dict[str, Any]]:
+        """Get a user's most recent transactions, newest first"""
+        records, _, _ = await self.page(user_id, limit, with_total=False)
+        return records
+
+    async def all_records(self, user_id: str, batch_size: int = 1000) -> List[Dict[str, Any]]:
+        """Get every transaction of a user, oldest first, reading keyset pages of ``batch_size``"""
+        records: List[Dict[str, Any]] = []
+        key = None
+        while True:
+            page, key, _ = await self.page(user_id, batch_size, key=key, with_total=False)
+            records.extend(page)
+            if key is None:
+                break
+        records.reverse()
+        return records
+
+    @staticmethod
+    async def _lookup(session: AsyncSession, user_id: str, transaction_id: str) -> Optional[Transaction]:
+        """Find a transaction by its JSON reference id or its primary key"""
+        return await session.scalar(select(Transaction).where(
+            Transaction.user_id == user_id,
+            or_(Transaction.reference_id == transaction_id, Transaction.id == transaction_id)
+        ).limit(1))
+
+    async def get(self, user_id: str, transaction_id: str) -> Optional[Dict[str, Any]]:
+        """Get one transaction record, or None if the user has no such transaction"""
+        async with self.manager.get_async_session() as session:
+            row = await self._lookup(session, user_id, transaction_id)
+            return row.to_record() if row else None
+
+    async def create(self, user_id: str, record: Dict[str, Any]) -> Dict[str, Any]:
+        """
+        Insert a transaction from a JSON-shaped record
+
+        Args:
+            user_id: Owner of the transaction
+            record: Record with at least amount and date; ``account`` names the account
+
+        Returns:
+            The stored record
+        """
+        async with self.manager.get_async_session() as session:
+            account_id = await self._account_id(session, user_id, record.get("account"))
+            amount = float(record.get("amount", 0))
+            row = Transaction(
+                user_id=user_id,
+                account_id=account_id,
+                description=record.get("description", "New Transaction"),
+                amount=amount,
+                category=record.get("category", "Uncategorized"),
+                transaction_type="credit" if amount > 0 else "debit",
+                transaction_date=_to_datetime(record.get("date")) or datetime.utcnow(),
+                merchant_name=record.get("merchant"),
+                reference_id=record.get("id")
+            )
+            session.add(row)
+            await session.commit()
+            return row.to_record()
+
+    async def update(self, user_id: str, transaction_id: str, fields: Dict[str, Any]) -> Optional[Dict[str, Any]]:
+        """Update the supplied fields of a transaction; returns None if it does not exist"""
+        async with self.manager.get_async_session() as session:
+            row = await self._lookup(session, user_id, transaction_id)
+            if row is None:
+                return None
+            for field, column in RECORD_FIELDS.items():
+                if field in fields:
+                    setattr(row, column, float(fields[field]) if field == "amount" else fields[field])
+            if "amount" in fields:
+                row.transaction_type = "credit" if row.amount > 0 else "debit"
+            if "date" in fields:
+                row.transaction_date = _to_datetime(fields["date"])
+            await session.commit()
+            return row.to_record()
+
+    async def delete(self, user_id: str, transaction_id: str) -> bool:
+        """Delete a transaction; returns False if it does not exist"""
+        async with self.manager.get_async_session() as session:
+            row = await self._lookup(session, user_id, transaction_id)
+            if row is None:
+                return False
+            await session.delete(row)
+            await session.commit()
+            return True
+
+    @staticmethod
+    async def _account_id(session: AsyncSession, user_id: str, account_name: Optional[str]) -> str:
+        """Resolve an account name to an id, falling back to the user's first account"""
+        query = select(Account.id).where(Account.user_id == user_id)
+        if account_name:
+            account_id = await session.scalar(query.where(Account.account_name == account_name))
+            if account_id is not None:
+                return account_id
+        account_id = await session.scalar(query.order_by(Account.created_at).limit(1))
+        if account_id is None:
+            raise ValueError(f"User {user_id} has no account to record transactions against")
+        return account_id
+
+
+# Global repository instance
+_repository: Optional[TransactionRepository] = None
+_repository_lock = threading.Lock()
+
+
+def get_transaction_repository() -> TransactionRepository:
+    """Get the process-wide transaction repository"""
+    global _repository
+    with _repository_lock:
+        if _repository is None:
+            _repository = TransactionRepository()
+        return _repository
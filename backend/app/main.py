@@ -3,14 +3,27 @@ Main FastAPI application for Financial AI Assistant Backend
 """
 from fastapi import FastAPI, HTTPException
 from fastapi.middleware.cors import CORSMiddleware
-from fastapi.responses import JSONResponse
+from fastapi.responses import JSONResponse, PlainTextResponse
 import logging
+import time
 import uvicorn
 from datetime import datetime
 
-from .routers import insights, transactions, accounts, investments, privacy, chat, dashboard, auth
+from .routers import insights, transactions, accounts, investments, privacy, chat, dashboard, auth, updates
 from .services.data_service import DataService
-from .security import add_security_headers
+from .services.context_store import flush_context_stores, context_store_stats
+from .services.audit_log import close_audit_logs, audit_log_stats
+from .services.data_validator import shutdown_validation_pool
+from .security import (add_security_headers, RateLimitMiddleware, rate_limiting_enabled,
+                       get_rate_limiter, security_manager)
+from .services.response_encoding import CompressionMiddleware
+from .services.metrics import (MetricsMiddleware, Sample, cache_samples, get_metrics_registry,
+                               metrics_enabled, PROCESS_START)
+from .services.result_cache import get_analysis_cache
+from .services.response_cache import get_response_cache
+from .services.portfolio_engine import get_portfolio_engine
+from .services.precompute_scheduler import get_precompute_scheduler, precompute_enabled
+from .services.change_feed import get_change_feed
 
 # Configure logging
 logging.basicConfig(
@@ -28,6 +41,18 @@ app = FastAPI(
     redoc_url="/redoc"
 )
 
+# gzip/brotli for complete responses above the size threshold (innermost, so it sees final bodies)
+app.add_middleware(CompressionMiddleware)
+
+# Per-client token buckets and load shedding (added before CORS so rejections carry CORS headers)
+if rate_limiting_enabled():
+    app.add_middleware(RateLimitMiddleware)
+
+# Per-route latency histograms (outside the limiter so 429/503 rejections are counted);
+# the update stream stays open for the life of a client, so it would only skew them
+if metrics_enabled():
+    app.add_middleware(MetricsMiddleware, exclude=("/metrics", "/api/updates/stream"))
+
 # Configure CORS
 app.add_middleware(
     CORSMiddleware,
@@ -35,6 +60,7 @@ app.add_middleware(
     allow_credentials=True,
     allow_methods=["*"],
     allow_headers=["*"],
+    expose_headers=["ETag"],
 )
 
 # Include routers
@@ -46,20 +72,63 @@ app.include_router(investments.router)
 app.include_router(privacy.router)
 app.include_router(chat.router)
 app.include_router(dashboard.router)
+app.include_router(updates.router)
 
 # Initialize data service
 data_service = DataService()
 
 
+def _service_metrics():
+    """Cache hit counters and queue depths read from the services at scrape time"""
+    analysis = get_analysis_cache().get_stats()
+    samples = cache_samples("analysis", analysis)
+    samples += cache_samples("ai_response", get_response_cache().get_stats())
+    samples += cache_samples("token", security_manager.token_cache.get_stats())
+
+    samples.append(Sample("app_queue_depth", {"queue": "analysis_in_flight"}, analysis["in_flight"]))
+    samples.append(Sample("app_queue_depth", {"queue": "password_hash"},
+                          security_manager.get_hash_stats()["pending"]))
+    for writer in audit_log_stats():
+        samples.append(Sample("app_queue_depth", {"queue": "audit_log", "path": writer["storage_path"]},
+                              writer["pending"]))
+
+    if rate_limiting_enabled():
+        limiter = get_rate_limiter().get_stats()
+        samples.append(Sample("app_queue_depth", {"queue": "rate_limit_in_flight"}, limiter["in_flight"]))
+        for event in ("allowed", "limited", "shed"):
+            samples.append(Sample("app_events_total", {"event": f"rate_limit_{event}"}, limiter.get(event, 0)))
+
+    for namespace, stats in context_store_stats().items():
+        samples.append(Sample("app_cache_entries", {"cache": f"context_{namespace}"}, stats["sessions"]))
+
+    precompute = get_precompute_scheduler().get_stats()
+    samples.append(Sample("app_queue_depth", {"queue": "precompute"}, precompute["queued"]))
+    for event in ("runs", "failures", "coalesced", "inline_computes"):
+        samples.append(Sample("app_events_total", {"event": f"precompute_{event}"}, precompute[event]))
+
+    feed = get_change_feed().get_stats()
+    samples.append(Sample("app_queue_depth", {"queue": "update_subscribers"}, feed["subscribers"]))
+    for event in ("events", "delivered", "overflows"):
+        samples.append(Sample("app_events_total", {"event": f"update_{event}"}, feed[event]))
+
+    portfolio = get_portfolio_engine().get_stats()
+    samples.append(Sample("app_cache_entries", {"cache": "prices"}, portfolio["cached_prices"]))
+    samples.append(Sample("app_events_total", {"event": "price_fetches"}, portfolio["upstream_fetches"]))
+    return samples
+
+
+get_metrics_registry().register_collector(_service_metrics)
+
+
 @app.on_event("startup")
 async def startup_event():
     """Application startup event"""
     logger.info("Starting Financial AI Assistant API...")
     
     try:
-        # Load and validate data on startup
+        # Load the shared data store once; requests then reuse its snapshots
         logger.info("Loading financial data...")
-        data = data_service.load_all_data()
+        data = data_service.store.load()
         
         if data_service.validate_data_structure(data):
             logger.info("Financial data loaded and validated successfully")
@@ -69,12 +138,40 @@ async def startup_event():
     except Exception as e:
         logger.error(f"Failed to load data on startup: {str(e)}")
         # Don't fail startup, but log the error
+    
+    # With TRANSACTION_STORE=database the table replaces transactions.json; failing
+    # here stops startup rather than serving the file's transactions instead
+    loaded = await transactions.load_repository_transactions()
+    if loaded:
+        logger.info(f"Loaded {loaded} transactions from the database")
+    
+    # Recompute dashboard and insight results in the background whenever the data changes
+    if precompute_enabled():
+        get_precompute_scheduler().start()
 
 
 @app.on_event("shutdown")
 async def shutdown_event():
     """Application shutdown event"""
     logger.info("Shutting down Financial AI Assistant API...")
+    
+    # Stop background precomputation before the stores it reads are closed
+    await get_precompute_scheduler().stop()
+    
+    # Persist live conversation contexts when a spill database is configured
+    flush_context_stores()
+    
+    # Write and index audit entries still queued
+    close_audit_logs()
+    
+    # Stop the background price refresh thread
+    get_portfolio_engine().close()
+    
+    # Stop the bulk validation worker processes
+    shutdown_validation_pool()
+    
+    # Close pooled async database connections
+    await transactions.close_transaction_store()
 
 
 @app.get("/")
@@ -116,7 +213,10 @@ async def api_status():
             "timestamp": datetime.utcnow().isoformat() + "Z",
             "data_status": "loaded" if data_summary else "not_loaded",
             "data_categories": len(data_summary),
-            "uptime": "running"
+            "data_version": data_service.store.version,
+            "uptime_seconds": round(time.time() - PROCESS_START, 1),
+            "started_at": datetime.utcfromtimestamp(PROCESS_START).isoformat() + "Z",
+            "stage_latency": get_metrics_registry().stage_summary()
         }
     except Exception as e:
         logger.error(f"Error getting API status: {str(e)}")
@@ -127,6 +227,18 @@ async def api_status():
         }
 
 
+@app.get("/metrics", include_in_schema=False)
+async def metrics():
+    """
+    Prometheus scrape endpoint
+    
+    Returns:
+        Latency histograms, counters and gauges in text exposition format
+    """
+    return PlainTextResponse(get_metrics_registry().render(),
+                             media_type="text/plain; version=0.0.4; charset=utf-8")
+
+
 @app.exception_handler(HTTPException)
 async def http_exception_handler(request, exc):
     """Custom HTTP exception handler"""
@@ -7,7 +7,7 @@ import logging
 from datetime import datetime
 
 from ..models.requests import Permissions
-from ..services.data_service import DataService
+from ..services.data_store import get_data_store
 from ..services.privacy_service import PrivacyService
 
 logger = logging.getLogger(__name__)
@@ -16,7 +16,7 @@ logger = logging.getLogger(__name__)
 router = APIRouter(prefix="/api", tags=["accounts"])
 
 # Initialize services
-data_service = DataService()
+data_store = get_data_store()
 privacy_service = PrivacyService()
 
 
@@ -60,7 +60,7 @@ async def get_accounts(
             )
         
         # Load all data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         
         # Get accounts
         accounts = all_data.get("accounts", [])
@@ -124,7 +124,7 @@ async def get_account_balance(
             )
         
         # Load data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         accounts = all_data.get("accounts", [])
         
         # Find account by ID
@@ -179,7 +179,7 @@ async def get_net_worth(
             )
         
         # Load data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         accounts = all_data.get("accounts", [])
         assets = all_data.get("assets", [])
         liabilities = all_data.get("liabilities", [])
@@ -9,7 +9,8 @@ import logging
 from datetime import datetime
 
 from ..security import (
-    authenticate_user,
+    authenticate_user_async,
+    MOCK_USERS,
     create_user_tokens,
     security_manager,
     get_current_user,
@@ -66,8 +67,8 @@ async def login(login_data: LoginRequest):
         
         logger.info(f"Login attempt for user: {username}")
         
-        # Authenticate user
-        user = authenticate_user(username, password)
+        # Authenticate user; bcrypt runs on the hashing pool
+        user = await authenticate_user_async(username, password)
         if not user:
             # Log failed attempt
             security_manager.audit_log(username, "login_failed", {"reason": "invalid_credentials"})
@@ -288,7 +289,7 @@ async def change_password(
         Success message
     """
     try:
-        # In production, verify current password and update in database
+        # In production, update the password in the database
         user_id = current_user["user_id"]
         
         # Basic validation
@@ -298,6 +299,16 @@ async def change_password(
                 detail="Password must be at least 8 characters long"
             )
         
+        # Verify and re-hash on the hashing pool so bcrypt never blocks the loop
+        user = MOCK_USERS.get(current_user.get("username") or user_id)
+        if user:
+            if not await security_manager.verify_password_async(current_password, user["hashed_password"]):
+                raise HTTPException(
+                    status_code=status.HTTP_400_BAD_REQUEST,
+                    detail="Current password is incorrect"
+                )
+            user["hashed_password"] = await security_manager.hash_password_async(new_password)
+        
         # Log password change
         security_manager.audit_log(user_id, "password_change")
         
@@ -2,16 +2,23 @@
 API router for AI chat endpoints
 """
 from fastapi import APIRouter, HTTPException, Depends
-from typing import Dict, Any, List, Optional
+from fastapi.responses import StreamingResponse
+from typing import Dict, Any, List, Optional, AsyncIterator, Tuple
+import asyncio
+import json
 import logging
 from datetime import datetime
 
 from ..models.requests import Permissions
-from ..services.data_service import DataService
+from ..services.data_store import get_data_store
 from ..services.privacy_service import PrivacyService
 from ..services.nlp_service import NLPService
 from ..services.analysis_service import AnalysisService
+from ..services.result_cache import AnalysisCacheScope
 from ..services.ai_service import AIService
+from ..services.retrieval_service import get_retrieval_service
+from ..services.context_store import ChatHistoryStore, get_context_spill
+from ..services.metrics import timed
 
 logger = logging.getLogger(__name__)
 
@@ -19,14 +26,18 @@ logger = logging.getLogger(__name__)
 router = APIRouter(prefix="/api", tags=["chat"])
 
 # Initialize services
-data_service = DataService()
+data_store = get_data_store()
 privacy_service = PrivacyService()
 nlp_service = NLPService()
 analysis_service = AnalysisService()
 ai_service = AIService()
+retrieval_service = get_retrieval_service()
 
-# In-memory chat history (in production, this would be stored in a database)
-chat_history = []
+# Per-user ring buffers of recent exchanges, persisted when CONTEXT_STORE_DB is set
+chat_history = ChatHistoryStore(limit=100, spill=get_context_spill())
+
+# Chat endpoints are not authenticated yet; every exchange belongs to this user
+CHAT_USER_ID = "default_user"
 
 
 def get_default_permissions() -> Permissions:
@@ -61,59 +72,22 @@ async def send_chat_message(
         Dictionary containing AI response and chat metadata
     """
     try:
-        message = request_data.get("message", "")
-        context = request_data.get("context", {})
-        
-        if not message.strip():
-            raise HTTPException(
-                status_code=400,
-                detail="Message cannot be empty"
-            )
-        
-        logger.info(f"Processing chat message: {message[:50]}...")
-        
-        # Process the message with NLP
-        nlp_result = nlp_service.process_query(message)
-        intent = nlp_result.get("intent", "unknown")
-        entities = nlp_result.get("entities", {})
-        
-        logger.info(f"Chat intent: {intent}")
-        
-        # Load and filter data based on permissions
-        all_data = data_service.load_all_data()
-        filtered_data = privacy_service.filter_data_by_permissions(all_data, permissions)
-        
-        # Perform analysis based on intent
-        analysis_result = await _perform_financial_analysis(intent, filtered_data, entities)
+        message, context = _parse_chat_request(request_data)
+        nlp_result, analysis_result = await _prepare_chat(message, permissions)
         
         # Generate AI response
-        ai_response = ai_service.generate_response(analysis_result, message)
-        
-        # Create chat entry
-        chat_entry = {
-            "id": f"chat_{datetime.utcnow().timestamp()}",
-            "user_message": message,
-            "ai_response": ai_response,
-            "intent": intent,
-            "analysis_type": analysis_result.get("analysis_type", "unknown"),
-            "timestamp": datetime.utcnow().isoformat() + "Z",
-            "context": context
-        }
-        
-        # Add to chat history
-        chat_history.append(chat_entry)
-        
-        # Keep only last 100 messages
-        if len(chat_history) > 100:
-            chat_history.pop(0)
+        ai_response = await ai_service.generate_response_async(
+            analysis_result, message, nlp_result.get("entities")
+        )
         
+        chat_entry = _record_chat(message, ai_response, nlp_result, analysis_result, context)
         logger.info(f"Chat response generated: {len(ai_response)} characters")
         
         return {
             "response": ai_response,
             "chat_id": chat_entry["id"],
-            "intent": intent,
-            "analysis_type": analysis_result.get("analysis_type", "unknown"),
+            "intent": chat_entry["intent"],
+            "analysis_type": chat_entry["analysis_type"],
             "confidence": nlp_result.get("confidence", {}),
             "timestamp": datetime.utcnow().isoformat() + "Z"
         }
@@ -128,6 +102,140 @@ async def send_chat_message(
         )
 
 
+@router.post("/chat/stream")
+async def stream_chat_message(
+    request_data: Dict[str, Any],
+    permissions: Permissions = Depends(get_default_permissions)
+) -> StreamingResponse:
+    """
+    Send a chat message and stream the AI response as server-sent events
+    
+    Emits one ``meta`` event with the intent and analysis type, ``token``
+    events carrying response text as it is generated, then ``done`` with the
+    chat id, or ``error`` if generation fails.
+    
+    Args:
+        request_data: Dictionary containing message and context
+        permissions: User's data access permissions
+        
+    Returns:
+        text/event-stream response
+    """
+    try:
+        message, context = _parse_chat_request(request_data)
+        nlp_result, analysis_result = await _prepare_chat(message, permissions)
+    except HTTPException:
+        raise
+    except Exception as e:
+        logger.error(f"Error processing chat message: {str(e)}")
+        raise HTTPException(
+            status_code=500,
+            detail=f"Internal server error: {str(e)}"
+        )
+    
+    async def events() -> AsyncIterator[str]:
+        yield _sse_event("meta", {
+            "intent": nlp_result.get("intent", "unknown"),
+            "analysis_type": analysis_result.get("analysis_type", "unknown"),
+            "confidence": nlp_result.get("confidence", {})
+        })
+        
+        pieces = []
+        try:
+            async for piece in ai_service.stream_response(analysis_result, message, nlp_result.get("entities")):
+                pieces.append(piece)
+                yield _sse_event("token", {"text": piece})
+        except Exception as e:
+            logger.error(f"Error streaming chat response: {str(e)}")
+            yield _sse_event("error", {"detail": str(e)})
+            return
+        
+        ai_response = "".join(pieces)
+        chat_entry = _record_chat(message, ai_response, nlp_result, analysis_result, context)
+        logger.info(f"Chat response streamed: {len(ai_response)} characters")
+        yield _sse_event("done", {
+            "chat_id": chat_entry["id"],
+            "timestamp": datetime.utcnow().isoformat() + "Z"
+        })
+    
+    return StreamingResponse(
+        events(),
+        media_type="text/event-stream",
+        headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"}
+    )
+
+
+def _parse_chat_request(request_data: Dict[str, Any]) -> Tuple[str, Dict[str, Any]]:
+    """Extract and validate the message and context of a chat request"""
+    message = request_data.get("message", "")
+    context = request_data.get("context", {})
+    
+    if not message.strip():
+        raise HTTPException(
+            status_code=400,
+            detail="Message cannot be empty"
+        )
+    return message, context
+
+
+async def _prepare_chat(message: str, permissions: Permissions) -> Tuple[Dict[str, Any], Dict[str, Any]]:
+    """
+    Classify a chat message and run the analysis it asks for
+    
+    Args:
+        message: User's chat message
+        permissions: User's data access permissions
+        
+    Returns:
+        Tuple of (NLP result, analysis result)
+    """
+    logger.info(f"Processing chat message: {message[:50]}...")
+    
+    # Process the message with NLP
+    nlp_result = nlp_service.process_query(message)
+    intent = nlp_result.get("intent", "unknown")
+    entities = nlp_result.get("entities", {})
+    
+    logger.info(f"Chat intent: {intent}")
+    
+    # Load and filter data based on permissions
+    data_version, all_data = data_store.versioned_snapshot()
+    filtered_data = privacy_service.filter_data_by_permissions(all_data, permissions)
+    
+    # Perform analysis based on intent
+    cache_scope = AnalysisCacheScope.for_request(data_version, permissions)
+    analysis_result = await _perform_financial_analysis(intent, filtered_data, entities, cache_scope)
+    
+    # Only the nearest examples and transactions go into the prompt; the
+    # analysis result may be shared through the cache, so extend a copy
+    retrieved = await asyncio.to_thread(retrieval_service.retrieve, message, filtered_data, data_version)
+    analysis_result = {**analysis_result, "retrieved": retrieved}
+    return nlp_result, analysis_result
+
+
+def _record_chat(message: str, ai_response: str, nlp_result: Dict[str, Any],
+                 analysis_result: Dict[str, Any], context: Dict[str, Any]) -> Dict[str, Any]:
+    """Append a completed exchange to the chat history and return its entry"""
+    chat_entry = {
+        "id": f"chat_{datetime.utcnow().timestamp()}",
+        "user_message": message,
+        "ai_response": ai_response,
+        "intent": nlp_result.get("intent", "unknown"),
+        "analysis_type": analysis_result.get("analysis_type", "unknown"),
+        "timestamp": datetime.utcnow().isoformat() + "Z",
+        "context": context
+    }
+    
+    # Add to chat history; the ring buffer keeps the last 100 messages
+    chat_history.append(CHAT_USER_ID, chat_entry)
+    return chat_entry
+
+
+def _sse_event(event: str, data: Dict[str, Any]) -> str:
+    """Format one server-sent event"""
+    return f"event: {event}\ndata: {json.dumps(data)}\n\n"
+
+
 @router.get("/chat/history")
 async def get_chat_history(
     limit: int = 50,
@@ -147,11 +255,11 @@ async def get_chat_history(
         logger.info(f"Fetching chat history (limit: {limit})")
         
         # Get recent chat messages
-        recent_messages = chat_history[-limit:] if chat_history else []
+        recent_messages = chat_history.recent(CHAT_USER_ID, limit)
         
         return {
             "messages": recent_messages,
-            "total_messages": len(chat_history),
+            "total_messages": chat_history.count(CHAT_USER_ID),
             "limit": limit,
             "timestamp": datetime.utcnow().isoformat() + "Z"
         }
@@ -181,8 +289,7 @@ async def clear_chat_history(
         logger.info("Clearing chat history")
         
         # Clear chat history
-        global chat_history
-        chat_history.clear()
+        chat_history.clear(CHAT_USER_ID)
         
         return {
             "message": "Chat history cleared successfully",
@@ -197,7 +304,9 @@ async def clear_chat_history(
         )
 
 
-async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any], entities: Dict[str, Any]) -> Dict[str, Any]:
+@timed("analysis")
+async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any], entities: Dict[str, Any],
+                                      cache_scope: Optional[AnalysisCacheScope] = None) -> Dict[str, Any]:
     """
     Perform financial analysis based on intent and filtered data
     
@@ -205,6 +314,7 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
         intent: The classified intent from NLP
         filtered_data: Financial data filtered by permissions
         entities: Extracted entities from NLP
+        cache_scope: Data version and permissions the data was filtered with, enabling result caching
         
     Returns:
         Dictionary containing analysis results
@@ -220,17 +330,26 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
         
         if intent == "get_spending_summary" or intent == "get_spending_by_category":
             analysis_result["analysis_type"] = "spending_analysis"
-            analysis_result["results"] = analysis_service.calculate_spending(filtered_data, entities)
+            analysis_result["results"] = await analysis_service.cached_result(
+                "spending_summary", "default_user", entities, cache_scope,
+                lambda: analysis_service.calculate_spending(filtered_data, entities)
+            )
             analysis_result["success"] = True
             
         elif intent == "project_future_balance" or intent == "get_savings_analysis":
             analysis_result["analysis_type"] = "savings_projection"
-            analysis_result["results"] = analysis_service.project_savings(filtered_data, entities)
+            analysis_result["results"] = await analysis_service.cached_result(
+                "savings_projection", "default_user", entities, cache_scope,
+                lambda: analysis_service.project_savings(filtered_data, entities)
+            )
             analysis_result["success"] = True
             
         elif intent == "check_affordability":
             analysis_result["analysis_type"] = "affordability_check"
-            analysis_result["results"] = analysis_service.check_affordability(filtered_data, entities)
+            analysis_result["results"] = await analysis_service.cached_result(
+                "affordability_check", "default_user", entities, cache_scope,
+                lambda: analysis_service.check_affordability(filtered_data, entities)
+            )
             analysis_result["success"] = True
             
         elif intent == "get_income_summary":
@@ -1,14 +1,17 @@
 """
 API router for dashboard-related endpoints
 """
-from fastapi import APIRouter, HTTPException, Depends, Query
+from fastapi import APIRouter, HTTPException, Depends, Query, Request
 from typing import Dict, Any, List, Optional
 import logging
-from datetime import datetime, timedelta
+from datetime import datetime, timedelta, timezone
 
 from ..models.requests import Permissions
-from ..services.data_service import DataService
+from ..services.data_store import get_data_store
+from ..services.aggregate_store import TransactionAggregates, month_code_of, day_number_of
 from ..services.privacy_service import PrivacyService
+from ..services.response_encoding import check_not_modified, json_response, permission_scope
+from ..services.precompute_scheduler import PrecomputeJob, get_precompute_scheduler, DEFAULT_USER_ID
 
 logger = logging.getLogger(__name__)
 
@@ -16,8 +19,9 @@ logger = logging.getLogger(__name__)
 router = APIRouter(prefix="/api", tags=["dashboard"])
 
 # Initialize services
-data_service = DataService()
+data_store = get_data_store()
 privacy_service = PrivacyService()
+precompute = get_precompute_scheduler()
 
 
 def get_default_permissions() -> Permissions:
@@ -38,6 +42,7 @@ def get_default_permissions() -> Permissions:
 
 @router.get("/dashboard")
 async def get_dashboard_data(
+    request: Request,
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
@@ -52,8 +57,12 @@ async def get_dashboard_data(
     try:
         logger.info("Fetching dashboard data")
         
-        # Load all data
-        all_data = data_service.load_all_data()
+        # Clients already holding this data version get a 304 before any work
+        data_version, all_data, aggregates = data_store.versioned_view()
+        etag, not_modified = check_not_modified(request, data_version, permission_scope(permissions))
+        if not_modified is not None:
+            return not_modified
+        
         filtered_data = privacy_service.filter_data_by_permissions(all_data, permissions)
         
         # Calculate key metrics
@@ -65,8 +74,8 @@ async def get_dashboard_data(
         # Total balance
         total_balance = sum(acc.get("balance", 0) for acc in accounts)
         
-        # Monthly spending (last 30 days)
-        monthly_spending = _calculate_monthly_spending(transactions)
+        # Monthly spending (last 30 days), read from the running daily rollups
+        monthly_spending = _calculate_monthly_spending(aggregates) if permissions.transactions else 0.0
         
         # Savings progress
         savings_progress = _calculate_savings_progress(accounts, transactions)
@@ -84,7 +93,7 @@ async def get_dashboard_data(
         spending_change = -12.3  # Mock percentage change
         investment_change = 15.2  # Mock percentage change
         
-        return {
+        return json_response({
             "total_balance": round(total_balance, 2),
             "monthly_spending": round(monthly_spending, 2),
             "savings_progress": round(savings_progress, 2),
@@ -95,7 +104,7 @@ async def get_dashboard_data(
             "spending_change": spending_change,
             "investment_change": investment_change,
             "timestamp": datetime.utcnow().isoformat() + "Z"
-        }
+        }, etag if data_store.version == data_version else None)
         
     except Exception as e:
         logger.error(f"Error fetching dashboard data: {str(e)}")
@@ -107,6 +116,7 @@ async def get_dashboard_data(
 
 @router.get("/spending-trend")
 async def get_spending_trend(
+    request: Request,
     period: str = Query("1m", description="Time period for spending trend"),
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
@@ -130,20 +140,20 @@ async def get_spending_trend(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Load data
-        all_data = data_service.load_all_data()
-        transactions = all_data.get("transactions", [])
+        # Clients already holding this data version get a 304 before any work
+        data_version, all_data = data_store.versioned_snapshot()
+        etag, not_modified = check_not_modified(request, data_version, permission_scope(permissions))
+        if not_modified is not None:
+            return not_modified
         
-        # Calculate spending by week
-        spending_data = _calculate_weekly_spending(transactions, period)
+        # Precomputed by the scheduler for the standard periods; computed inline otherwise
+        trend = await precompute.serve("spending_trend", DEFAULT_USER_ID, permissions,
+                                       data_version, all_data, period=period)
         
-        return {
-            "labels": spending_data["labels"],
-            "spending": spending_data["amounts"],
-            "period": period,
-            "total_spending": sum(spending_data["amounts"]),
+        return json_response({
+            **trend,
             "timestamp": datetime.utcnow().isoformat() + "Z"
-        }
+        }, etag if data_store.version == data_version else None)
         
     except HTTPException:
         raise
@@ -157,6 +167,7 @@ async def get_spending_trend(
 
 @router.get("/category-breakdown")
 async def get_category_breakdown(
+    request: Request,
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
@@ -178,19 +189,22 @@ async def get_category_breakdown(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Load data
-        all_data = data_service.load_all_data()
-        transactions = all_data.get("transactions", [])
+        # Clients already holding this data version get a 304 before any work
+        data_version, all_data = data_store.versioned_snapshot()
+        etag, not_modified = check_not_modified(request, data_version, permission_scope(permissions))
+        if not_modified is not None:
+            return not_modified
         
-        # Calculate category breakdown
-        category_data = _calculate_category_breakdown(transactions)
+        # Category breakdown from the monthly-by-category rollups, usually precomputed
+        category_data = await precompute.serve("category_breakdown", DEFAULT_USER_ID, permissions,
+                                               data_version, all_data)
         
-        return {
+        return json_response({
             "categories": category_data["categories"],
             "amounts": category_data["amounts"],
-            "total_spending": sum(category_data["amounts"]),
+            "total_spending": round(sum(category_data["amounts"]), 2),
             "timestamp": datetime.utcnow().isoformat() + "Z"
-        }
+        }, etag if data_store.version == data_version else None)
         
     except HTTPException:
         raise
@@ -204,6 +218,7 @@ async def get_category_breakdown(
 
 @router.get("/insights/dashboard")
 async def get_dashboard_insights(
+    request: Request,
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
@@ -225,18 +240,21 @@ async def get_dashboard_insights(
                 detail="Access denied: Dashboard insights permission required"
             )
         
-        # Load data
-        all_data = data_service.load_all_data()
-        filtered_data = privacy_service.filter_data_by_permissions(all_data, permissions)
+        # Clients already holding this data version get a 304 before any work
+        data_version, all_data = data_store.versioned_snapshot()
+        etag, not_modified = check_not_modified(request, data_version, permission_scope(permissions))
+        if not_modified is not None:
+            return not_modified
         
-        # Generate insights based on available data
-        insights = _generate_dashboard_insights(filtered_data)
+        # Insights for this data version, usually precomputed in the background
+        insights = await precompute.serve("dashboard_insights", DEFAULT_USER_ID, permissions,
+                                          data_version, all_data)
         
-        return {
+        return json_response({
             "insights": insights,
             "count": len(insights),
             "timestamp": datetime.utcnow().isoformat() + "Z"
-        }
+        }, etag if data_store.version == data_version else None)
         
     except HTTPException:
         raise
@@ -248,21 +266,10 @@ async def get_dashboard_insights(
         )
 
 
-def _calculate_monthly_spending(transactions: List[Dict[str, Any]]) -> float:
-    """Calculate monthly spending from transactions"""
-    # Get transactions from last 30 days
-    cutoff_date = datetime.now() - timedelta(days=30)
-    
-    monthly_transactions = []
-    for t in transactions:
-        try:
-            transaction_date = datetime.fromisoformat(t["date"].replace('Z', '+00:00'))
-            if transaction_date >= cutoff_date and t.get("amount", 0) < 0:
-                monthly_transactions.append(abs(t.get("amount", 0)))
-        except (ValueError, KeyError):
-            continue
-    
-    return sum(monthly_transactions)
+def _calculate_monthly_spending(aggregates: TransactionAggregates) -> float:
+    """Calculate spending over the last 30 days from the daily rollups"""
+    cutoff_date = datetime.now(timezone.utc) - timedelta(days=30)
+    return aggregates.expenses_since(cutoff_date.timestamp())
 
 
 def _calculate_savings_progress(accounts: List[Dict[str, Any]], transactions: List[Dict[str, Any]]) -> float:
@@ -271,43 +278,57 @@ def _calculate_savings_progress(accounts: List[Dict[str, Any]], transactions: Li
     return sum(acc.get("balance", 0) for acc in accounts)
 
 
-def _calculate_weekly_spending(transactions: List[Dict[str, Any]], period: str) -> Dict[str, Any]:
-    """Calculate weekly spending data"""
-    # Mock data for now - in real app, this would calculate actual weekly spending
+def _calculate_period_spending(aggregates: TransactionAggregates, period: str, as_of: datetime) -> Dict[str, Any]:
+    """Calculate spending buckets for a trend period ending at ``as_of``"""
     if period == "1m":
+        # Four 7-day weeks ending on the as-of day
+        end_day = day_number_of(as_of)
         labels = ["Week 1", "Week 2", "Week 3", "Week 4"]
-        amounts = [12000, 15000, 13500, 18000]
-    elif period == "3m":
-        labels = ["Month 1", "Month 2", "Month 3"]
-        amounts = [45000, 52000, 48000]
-    elif period == "6m":
-        labels = ["Month 1", "Month 2", "Month 3", "Month 4", "Month 5", "Month 6"]
-        amounts = [45000, 52000, 48000, 55000, 49000, 51000]
+        amounts = [
+            aggregates.expenses_between_days(end_day - 27 + week * 7, end_day - 21 + week * 7)
+            for week in range(4)
+        ]
+    elif period in ("3m", "6m"):
+        months = 3 if period == "3m" else 6
+        end_month = month_code_of(as_of)
+        codes = list(range(end_month - months + 1, end_month + 1))
+        labels = [datetime(code // 12, code % 12 + 1, 1).strftime("%b %Y") for code in codes]
+        amounts = aggregates.monthly_expenses(codes)
     else:  # 1y
+        # Four quarters of three calendar months each
+        end_month = month_code_of(as_of)
+        monthly = aggregates.monthly_expenses(list(range(end_month - 11, end_month + 1)))
         labels = ["Q1", "Q2", "Q3", "Q4"]
-        amounts = [150000, 165000, 158000, 172000]
+        amounts = [sum(monthly[quarter * 3:quarter * 3 + 3]) for quarter in range(4)]
     
     return {
         "labels": labels,
-        "amounts": amounts
+        "amounts": [round(amount, 2) for amount in amounts]
+    }
+
+
+def _spending_trend(aggregates: TransactionAggregates, period: str) -> Dict[str, Any]:
+    """Spending trend chart data for a period, anchored at the latest transaction"""
+    as_of = aggregates.as_of()
+    spending_data = _calculate_period_spending(aggregates, period, as_of)
+    return {
+        "labels": spending_data["labels"],
+        "spending": spending_data["amounts"],
+        "period": period,
+        "total_spending": round(sum(spending_data["amounts"]), 2),
+        "as_of": as_of.isoformat().replace("+00:00", "Z")
     }
 
 
-def _calculate_category_breakdown(transactions: List[Dict[str, Any]]) -> Dict[str, Any]:
+def _calculate_category_breakdown(aggregates: TransactionAggregates) -> Dict[str, Any]:
     """Calculate spending breakdown by category"""
-    category_totals = {}
-    
-    for t in transactions:
-        if t.get("amount", 0) < 0:  # Only expenses
-            category = t.get("category", "Uncategorized")
-            amount = abs(t.get("amount", 0))
-            category_totals[category] = category_totals.get(category, 0) + amount
+    category_totals = aggregates.category_expenses()
     
     # Sort by amount and get top categories
     sorted_categories = sorted(category_totals.items(), key=lambda x: x[1], reverse=True)
     
     categories = [cat[0] for cat in sorted_categories[:5]]  # Top 5
-    amounts = [cat[1] for cat in sorted_categories[:5]]
+    amounts = [round(cat[1], 2) for cat in sorted_categories[:5]]
     
     return {
         "categories": categories,
@@ -344,3 +365,21 @@ def _generate_dashboard_insights(filtered_data: Dict[str, Any]) -> List[Dict[str
         })
     
     return insights
+
+
+# Jobs the background scheduler keeps warm; rollup-based jobs read the published
+# aggregates on the event loop, and the scheduler drops their result if the
+# store has moved past the job's version by the time it finishes
+precompute.register_job(PrecomputeJob(
+    "dashboard_insights", lambda context: _generate_dashboard_insights(context.data),
+    requires=("dashboard_insights",)
+))
+precompute.register_job(PrecomputeJob(
+    "spending_trend", lambda context, period: _spending_trend(context.store.published_aggregates(), period),
+    variants=tuple({"period": period} for period in ("1m", "3m", "6m", "1y")),
+    requires=("transactions",), priority=1
+))
+precompute.register_job(PrecomputeJob(
+    "category_breakdown", lambda context: _calculate_category_breakdown(context.store.published_aggregates()),
+    requires=("transactions",), priority=1
+))
@@ -309,7 +309,10 @@ async def filter_data_by_permissions(
 async def get_audit_trail(
     user_id: str,
     limit: int = Query(100, ge=1, le=1000, description="Maximum number of entries"),
-    action_filter: Optional[List[str]] = Query(None, description="Filter by specific actions")
+    action_filter: Optional[List[str]] = Query(None, description="Filter by specific actions"),
+    offset: int = Query(0, ge=0, description="Entries to skip from the most recent one"),
+    since: Optional[datetime] = Query(None, description="Earliest entry time (ISO 8601, UTC if naive)"),
+    until: Optional[datetime] = Query(None, description="Latest entry time (ISO 8601, UTC if naive)")
 ) -> Dict[str, Any]:
     """
     Get user's audit trail
@@ -318,9 +321,12 @@ async def get_audit_trail(
         user_id: User identifier
         limit: Maximum number of entries to return
         action_filter: Optional filter for specific actions
+        offset: Entries to skip, for paging
+        since: Optional earliest entry time
+        until: Optional latest entry time
         
     Returns:
-        User's audit trail
+        One page of the user's audit trail
     """
     try:
         logger.info(f"Fetching audit trail for user: {user_id}")
@@ -329,7 +335,7 @@ async def get_audit_trail(
         audit_action_filter = None
         if action_filter:
             try:
-                audit_action_filter = [AuditAction(action.upper()) for action in action_filter]
+                audit_action_filter = [AuditAction(action.lower()) for action in action_filter]
             except ValueError as e:
                 raise HTTPException(
                     status_code=400,
@@ -340,13 +346,18 @@ async def get_audit_trail(
         audit_entries = await privacy_service.get_audit_trail(
             user_id=user_id,
             limit=limit,
-            action_filter=audit_action_filter
+            action_filter=audit_action_filter,
+            offset=offset,
+            since=since,
+            until=until
         )
         
         return {
             "user_id": user_id,
             "audit_trail": audit_entries,
             "total_entries": len(audit_entries),
+            "offset": offset,
+            "has_more": len(audit_entries) == limit,
             "timestamp": datetime.utcnow().isoformat()
         }
         
@@ -615,6 +626,7 @@ async def get_compliance_status(user_id: str) -> Dict[str, Any]:
             )
         
         profile = privacy_service._privacy_profiles[user_id]
+        audit_summary = await privacy_service.get_audit_summary(user_id)
         
         # Calculate compliance metrics
         total_categories = len(privacy_service._data_categories)
@@ -637,7 +649,7 @@ async def get_compliance_status(user_id: str) -> Dict[str, Any]:
                 "gdpr_compliant": True,
                 "consent_given": profile.consent_timestamp.isoformat(),
                 "data_minimization_enabled": profile.data_minimization,
-                "audit_trail_available": len(profile.audit_trail) > 0,
+                "audit_trail_available": audit_summary["total_entries"] > 0,
                 "privacy_level": profile.privacy_level
             },
             "risk_assessment": {
@@ -648,11 +660,8 @@ async def get_compliance_status(user_id: str) -> Dict[str, Any]:
                 "risk_level": "low" if len(high_risk_permissions) == 0 else "medium" if len(high_risk_permissions) <= 2 else "high"
             },
             "audit_summary": {
-                "total_audit_entries": len(profile.audit_trail),
-                "last_audit_entry": max(
-                    (entry.timestamp for entry in profile.audit_trail),
-                    default=profile.consent_timestamp
-                ).isoformat()
+                "total_audit_entries": audit_summary["total_entries"],
+                "last_audit_entry": (audit_summary["last_entry"] or profile.consent_timestamp).isoformat()
             },
             "timestamp": datetime.utcnow().isoformat()
         }
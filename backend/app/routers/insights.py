@@ -2,16 +2,20 @@
 API router for financial insights endpoint
 """
 from fastapi import APIRouter, HTTPException, Depends
-from typing import Dict, Any
+from typing import Dict, Any, Optional
 import logging
 from datetime import datetime
 
 from ..models.requests import InsightsRequest, InsightsResponse, Permissions
 from ..services.data_service import DataService
+from ..services.data_store import get_data_store
 from ..services.privacy_service import PrivacyService
 from ..services.nlp_service import NLPService
 from ..services.analysis_service import AnalysisService
+from ..services.result_cache import AnalysisCacheScope
 from ..services.ai_service import AIService
+from ..services.metrics import timed
+from ..services.precompute_scheduler import PrecomputeJob, get_precompute_scheduler, DEFAULT_USER_ID
 
 logger = logging.getLogger(__name__)
 
@@ -20,10 +24,32 @@ router = APIRouter(prefix="/api", tags=["insights"])
 
 # Initialize services
 data_service = DataService()
+data_store = get_data_store()
 privacy_service = PrivacyService()
 nlp_service = NLPService()
 analysis_service = AnalysisService()
 ai_service = AIService()
+precompute = get_precompute_scheduler()
+
+
+def _comprehensive_insights(context, timeframe_days: int):
+    """Spending, anomaly, forecast and health analyses for one user's filtered data"""
+    return analysis_service.get_comprehensive_insights(
+        context.user_id,
+        context.data.get("accounts", []),
+        context.data.get("liabilities", []),
+        context.data.get("transactions", []),
+        context.data.get("investments", []),
+        timeframe_days=timeframe_days
+    )
+
+
+# The heaviest dashboard computation; offloaded to a worker thread since it only reads the snapshot
+if analysis_service.has_advanced_features:
+    precompute.register_job(PrecomputeJob(
+        "comprehensive_insights", _comprehensive_insights, variants=({"timeframe_days": 30},),
+        requires=("transactions",), priority=2, offload=True
+    ))
 
 
 @router.post("/insights", response_model=InsightsResponse)
@@ -65,7 +91,7 @@ async def get_financial_insights(request: InsightsRequest) -> InsightsResponse:
         
         # Load all financial data
         logger.info("Loading financial data...")
-        all_data = data_service.load_all_data()
+        data_version, all_data = data_store.versioned_snapshot()
         
         # Validate data structure
         if not data_service.validate_data_structure(all_data):
@@ -83,11 +109,12 @@ async def get_financial_insights(request: InsightsRequest) -> InsightsResponse:
         
         # Perform financial analysis based on intent
         logger.info(f"Performing analysis for intent: {intent}")
-        analysis_result = await _perform_financial_analysis(intent, filtered_data, entities)
+        cache_scope = AnalysisCacheScope.for_request(data_version, request.permissions)
+        analysis_result = await _perform_financial_analysis(intent, filtered_data, entities, cache_scope)
         
         # Generate AI response from analysis results
         logger.info("Generating AI response from analysis results")
-        ai_response = ai_service.generate_response(analysis_result, request.query)
+        ai_response = await ai_service.generate_response_async(analysis_result, request.query, entities)
         
         # Get permission summary for logging
         permission_summary = privacy_service.get_permission_summary(request.permissions)
@@ -129,7 +156,9 @@ async def get_financial_insights(request: InsightsRequest) -> InsightsResponse:
         )
 
 
-async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any], entities: Dict[str, Any]) -> Dict[str, Any]:
+@timed("analysis")
+async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any], entities: Dict[str, Any],
+                                      cache_scope: Optional[AnalysisCacheScope] = None) -> Dict[str, Any]:
     """
     Perform financial analysis based on intent and filtered data
     
@@ -137,6 +166,7 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
         intent: The classified intent from NLP
         filtered_data: Financial data filtered by permissions
         entities: Extracted entities from NLP
+        cache_scope: Data version and permissions the data was filtered with, enabling result caching
         
     Returns:
         Dictionary containing analysis results
@@ -158,7 +188,8 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
                     user_id = "default_user"  # In real app, get from auth
                     timeframe_days = entities.get("time_periods", [{}])[0].get("days", 30)
                     advanced_result = await analysis_service.get_advanced_spending_analysis(
-                        user_id, filtered_data.get("transactions", []), timeframe_days
+                        user_id, filtered_data.get("transactions", []), timeframe_days,
+                        cache_scope=cache_scope
                     )
                     analysis_result["results"] = advanced_result
                 else:
@@ -179,7 +210,8 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
                         user_id,
                         filtered_data.get("accounts", []),
                         filtered_data.get("transactions", []),
-                        months_ahead
+                        months_ahead,
+                        cache_scope=cache_scope
                     )
                     analysis_result["results"] = advanced_result
                 else:
@@ -206,7 +238,8 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
                             filtered_data.get("transactions", []),
                             filtered_data.get("liabilities", []),
                             purchase_amount,
-                            target_item
+                            target_item,
+                            cache_scope=cache_scope
                         )
                         analysis_result["results"] = advanced_result
                     else:
@@ -244,7 +277,8 @@ async def _perform_financial_analysis(intent: str, filtered_data: Dict[str, Any]
                         filtered_data.get("accounts", []),
                         filtered_data.get("liabilities", []),
                         filtered_data.get("transactions", []),
-                        filtered_data.get("investments", [])
+                        filtered_data.get("investments", []),
+                        cache_scope=cache_scope
                     )
                     analysis_result["results"] = advanced_result
                 else:
@@ -405,6 +439,21 @@ async def ai_status() -> Dict[str, Any]:
         )
 
 
+@router.get("/analysis/cache-stats")
+async def analysis_cache_stats() -> Dict[str, Any]:
+    """
+    Get hit/miss metrics of the shared analysis result cache and its precompute scheduler
+    
+    Returns:
+        Dictionary with cache counters, hit rate and scheduler counters
+    """
+    return {
+        "analysis_cache": analysis_service.result_cache.get_stats(),
+        "precompute": precompute.get_stats(),
+        "timestamp": datetime.utcnow().isoformat() + "Z"
+    }
+
+
 @router.get("/data/summary")
 async def get_data_summary() -> Dict[str, Any]:
     """
@@ -437,14 +486,15 @@ async def detect_anomalies(request: InsightsRequest) -> Dict[str, Any]:
         logger.info("Detecting financial anomalies")
         
         # Load and filter data
-        all_data = data_service.load_all_data()
+        data_version, all_data = data_store.versioned_snapshot()
         filtered_data = privacy_service.filter_data_by_permissions(all_data, request.permissions)
         
         # Use advanced anomaly detection if available
         if analysis_service.has_advanced_features:
             user_id = "default_user"  # In real app, get from auth
             result = await analysis_service.detect_anomalies(
-                user_id, filtered_data.get("transactions", [])
+                user_id, filtered_data.get("transactions", []),
+                cache_scope=AnalysisCacheScope.for_request(data_version, request.permissions)
             )
         else:
             result = {"error": "Advanced anomaly detection not available", "anomalies": []}
@@ -468,7 +518,7 @@ async def get_debt_strategy(request: InsightsRequest) -> Dict[str, Any]:
         logger.info("Analyzing debt repayment strategy")
         
         # Load and filter data
-        all_data = data_service.load_all_data()
+        data_version, all_data = data_store.versioned_snapshot()
         filtered_data = privacy_service.filter_data_by_permissions(all_data, request.permissions)
         
         # Use advanced debt strategy analysis if available
@@ -485,7 +535,8 @@ async def get_debt_strategy(request: InsightsRequest) -> Dict[str, Any]:
                     user_id,
                     filtered_data.get("liabilities", []),
                     filtered_data.get("transactions", []),
-                    strategy_type
+                    strategy_type,
+                    cache_scope=AnalysisCacheScope.for_request(data_version, request.permissions)
                 )
             except AttributeError:
                 # Method doesn't exist, fall back to basic analysis
@@ -512,7 +563,7 @@ async def analyze_portfolio(request: InsightsRequest) -> Dict[str, Any]:
         logger.info("Analyzing investment portfolio")
         
         # Load and filter data
-        all_data = data_service.load_all_data()
+        data_version, all_data = data_store.versioned_snapshot()
         filtered_data = privacy_service.filter_data_by_permissions(all_data, request.permissions)
         
         # Use advanced portfolio analysis if available
@@ -530,7 +581,8 @@ async def analyze_portfolio(request: InsightsRequest) -> Dict[str, Any]:
                 result = await analysis_service.analyze_investment_portfolio(
                     user_id,
                     filtered_data.get("investments", []),
-                    risk_profile
+                    risk_profile,
+                    cache_scope=AnalysisCacheScope.for_request(data_version, request.permissions)
                 )
             except AttributeError:
                 # Method doesn't exist, fall back to basic analysis
@@ -557,7 +609,7 @@ async def analyze_budget(request: InsightsRequest, budget_data: Dict[str, Any] =
         logger.info("Analyzing budget performance")
         
         # Load and filter data
-        all_data = data_service.load_all_data()
+        data_version, all_data = data_store.versioned_snapshot()
         filtered_data = privacy_service.filter_data_by_permissions(all_data, request.permissions)
         
         # Create a sample budget if none provided
@@ -581,7 +633,8 @@ async def analyze_budget(request: InsightsRequest, budget_data: Dict[str, Any] =
                 result = await analysis_service.analyze_budget_performance(
                     user_id,
                     filtered_data.get("transactions", []),
-                    budget_data
+                    budget_data,
+                    cache_scope=AnalysisCacheScope.for_request(data_version, request.permissions)
                 )
             except AttributeError:
                 # Method doesn't exist, fall back to basic analysis
@@ -675,27 +728,59 @@ async def generate_insights(
         logger.info("Generating AI insights")
         
         # Load and filter data
-        all_data = data_service.load_all_data()
+        data_version, all_data = data_store.versioned_snapshot()
         filtered_data = privacy_service.filter_data_by_permissions(all_data, permissions)
         
+        # Spending, anomaly, forecast and health analyses share one scan of the transactions
+        # Usually precomputed by the background scheduler for this data version;
+        # a miss is computed on a worker thread
+        comprehensive = {}
+        if analysis_service.has_advanced_features:
+            comprehensive = await precompute.serve(
+                "comprehensive_insights",
+                DEFAULT_USER_ID,  # In real app, get from auth
+                permissions, data_version, all_data, timeframe_days=30
+            )
+        
+        health_results = comprehensive.get("financial_health")
+        if not health_results or "error" in health_results:
+            health_results = _analyze_financial_health(filtered_data, {})
+        
         # Generate insights using AI service
         mock_analysis = {
             "intent": "get_financial_health",
             "analysis_type": "financial_health",
-            "results": _analyze_financial_health(filtered_data, {}),
+            "results": health_results,
             "success": True
         }
         
-        ai_response = ai_service.generate_response(mock_analysis, "Generate financial insights for my dashboard")
+        ai_response = await ai_service.generate_response_async(mock_analysis, "Generate financial insights for my dashboard")
+        
+        insights = [
+            {
+                "id": "1",
+                "type": "AI Insight",
+                "text": ai_response
+            }
+        ]
+        
+        # Surface the leading finding of each fused analysis alongside the AI summary
+        for key, insight_type, field in (("spending_analysis", "Spending Insight", "insights"),
+                                         ("anomaly_detection", "Anomaly Insight", "recommendations"),
+                                         ("balance_forecast", "Forecast Insight", "insights")):
+            analysis = comprehensive.get(key) or {}
+            if key == "anomaly_detection" and not analysis.get("anomalies_detected"):
+                continue
+            analysis_insights = analysis.get(field) or []
+            if analysis_insights:
+                insights.append({
+                    "id": str(len(insights) + 1),
+                    "type": insight_type,
+                    "text": analysis_insights[0]
+                })
         
         return {
-            "insights": [
-                {
-                    "id": "1",
-                    "type": "AI Insight",
-                    "text": ai_response
-                }
-            ],
+            "insights": insights,
             "timestamp": datetime.utcnow().isoformat() + "Z"
         }
         
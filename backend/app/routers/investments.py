@@ -7,7 +7,7 @@ import logging
 from datetime import datetime
 
 from ..models.requests import Permissions
-from ..services.data_service import DataService
+from ..services.data_store import get_data_store
 from ..services.privacy_service import PrivacyService
 
 logger = logging.getLogger(__name__)
@@ -16,7 +16,7 @@ logger = logging.getLogger(__name__)
 router = APIRouter(prefix="/api", tags=["investments"])
 
 # Initialize services
-data_service = DataService()
+data_store = get_data_store()
 privacy_service = PrivacyService()
 
 
@@ -60,7 +60,7 @@ async def get_investments(
             )
         
         # Load all data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         
         # Get investments
         investments = all_data.get("investments", [])
@@ -134,7 +134,7 @@ async def get_investment_performance(
             )
         
         # Load data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         investments = all_data.get("investments", [])
         
         # Find investment by ID
@@ -198,7 +198,7 @@ async def get_assets(
             )
         
         # Load all data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         
         # Get assets
         assets = all_data.get("assets", [])
@@ -260,7 +260,7 @@ async def get_liabilities(
             )
         
         # Load all data
-        all_data = data_service.load_all_data()
+        all_data = data_store.snapshot()
         
         # Get liabilities
         liabilities = all_data.get("liabilities", [])
@@ -1,14 +1,18 @@
 """
 API router for transaction-related endpoints
 """
-from fastapi import APIRouter, HTTPException, Query, Depends
-from typing import Dict, Any, List, Optional
+from fastapi import APIRouter, HTTPException, Query, Depends, Request
+from typing import Dict, Any, List, Optional, Sequence, Tuple
 import logging
-from datetime import datetime
+import os
+from datetime import datetime, timedelta
 
 from ..models.requests import Permissions
-from ..services.data_service import DataService
+from ..services.data_store import get_data_store
+from ..services.transaction_store import parse_timestamp, encode_cursor, decode_cursor
+from ..services.anomaly_engine import RollingAnomalyDetector
 from ..services.privacy_service import PrivacyService
+from ..services.response_encoding import check_not_modified, json_response, permission_scope
 
 logger = logging.getLogger(__name__)
 
@@ -16,8 +20,65 @@ logger = logging.getLogger(__name__)
 router = APIRouter(prefix="/api", tags=["transactions"])
 
 # Initialize services
-data_service = DataService()
+data_store = get_data_store()
 privacy_service = PrivacyService()
+anomaly_monitor = RollingAnomalyDetector()
+anomaly_monitor.attach(data_store)
+
+# "database" makes the Transaction table the only source of transactions:
+# list, lookup and writes query it, and the data store that analyses, the
+# dashboard and the change feed read is loaded from it at startup (instead of
+# transactions.json) and mirrors every repository write
+TRANSACTION_STORE = os.getenv("TRANSACTION_STORE", "memory").lower()
+DEFAULT_USERNAME = os.getenv("TRANSACTION_STORE_USER", "demo_user")
+_repository = None
+
+
+def _get_repository():
+    """Get the database repository when the database store is enabled"""
+    global _repository
+    if TRANSACTION_STORE != "database":
+        return None
+    if _repository is None:
+        # Imported lazily so the in-memory deployment never loads SQLAlchemy
+        from ..database.repository import get_transaction_repository
+        _repository = get_transaction_repository()
+    return _repository
+
+
+async def load_repository_transactions() -> int:
+    """
+    Load the data store's transactions from the database store when it is enabled (call on startup)
+
+    Returns:
+        Number of transactions loaded, 0 with the in-memory store
+    """
+    repository = _get_repository()
+    if repository is None:
+        return 0
+    records = await repository.all_records(await _repository_user(repository))
+    data_store.load_external("transactions", records, "database")
+    return len(records)
+
+
+async def close_transaction_store() -> None:
+    """Release pooled database connections if the database store was used (call on shutdown)"""
+    if _repository is not None:
+        await _repository.manager.dispose_async()
+
+
+async def _repository_user(repository) -> str:
+    """Resolve the user whose transactions the API serves"""
+    user_id = await repository.user_id_for(DEFAULT_USERNAME)
+    if user_id is None:
+        raise HTTPException(status_code=404, detail=f"User {DEFAULT_USERNAME} not found")
+    return user_id
+
+
+def _mirror_update(record: Dict[str, Any]) -> None:
+    """Copy a repository row into the data store, adding it if the store never held it"""
+    if data_store.update_transaction(record["id"], record) is None:
+        data_store.add_transaction(record)
 
 
 def get_default_permissions() -> Permissions:
@@ -36,24 +97,97 @@ def get_default_permissions() -> Permissions:
     )
 
 
+def _parse_date_bound(value: Optional[str], field: str, end_of_day: bool = False) -> Optional[float]:
+    """Parse a date query parameter into an inclusive timestamp bound"""
+    if not value:
+        return None
+    
+    timestamp = parse_timestamp(value)
+    if timestamp is None:
+        raise HTTPException(
+            status_code=400,
+            detail=f"Invalid {field}: expected an ISO date (YYYY-MM-DD)"
+        )
+    
+    # A bare date as the upper bound covers the whole day
+    if end_of_day and len(value) == 10:
+        timestamp += timedelta(days=1).total_seconds() - 1e-6
+    return timestamp
+
+
+def _paginate_newest_first(columns, positions: Sequence[int], undated: List[Dict[str, Any]],
+                           offset: int, limit: int) -> Tuple[List[Dict[str, Any]], Optional[Dict[str, Any]]]:
+    """Slice one page from oldest-first positions, returning it newest first with the next keyset key"""
+    offset = max(0, offset or 0)
+    limit = max(0, limit or 0)
+    dated_count = len(positions)
+    
+    # Only the page itself is materialized: walk positions backwards from the newest
+    page_end = max(0, dated_count - offset)
+    page_start = max(0, page_end - limit)
+    page = [columns.records[positions[i]] for i in range(page_end - 1, page_start - 1, -1)]
+    
+    # Undated records sort after every dated one
+    remaining = limit - len(page)
+    if remaining > 0 and undated:
+        undated_offset = max(0, offset - dated_count)
+        page += undated[undated_offset:undated_offset + remaining]
+    
+    # Hand out a cursor so the next page does not depend on the offset
+    consumed = offset + limit
+    if limit == 0 or consumed >= dated_count + len(undated):
+        return page, None
+    if consumed <= dated_count:
+        return page, columns.key_at(positions[dated_count - consumed])
+    return page, {"u": consumed - dated_count}
+
+
+def _decode_cursor_param(cursor: Optional[str]) -> Optional[Dict[str, Any]]:
+    """Decode the cursor query parameter, rejecting malformed values"""
+    if not cursor:
+        return None
+    key = decode_cursor(cursor)
+    if key is None or not ("u" in key or ("t" in key and "id" in key)):
+        raise HTTPException(status_code=400, detail="Invalid cursor")
+    return key
+
+
+def _validate_transaction_fields(transaction_data: Dict[str, Any]) -> None:
+    """Reject amounts and dates the aggregates cannot index"""
+    if "amount" in transaction_data:
+        try:
+            float(transaction_data["amount"])
+        except (TypeError, ValueError):
+            raise HTTPException(status_code=400, detail="Invalid amount: must be a number")
+    if "date" in transaction_data and parse_timestamp(transaction_data["date"]) is None:
+        raise HTTPException(status_code=400, detail="Invalid date: expected ISO 8601 format")
+
+
 @router.get("/transactions")
 async def get_transactions(
+    request: Request,
     limit: Optional[int] = Query(10, description="Number of transactions to return"),
     offset: Optional[int] = Query(0, description="Number of transactions to skip"),
     category: Optional[str] = Query(None, description="Filter by category"),
     start_date: Optional[str] = Query(None, description="Start date (YYYY-MM-DD)"),
     end_date: Optional[str] = Query(None, description="End date (YYYY-MM-DD)"),
+    cursor: Optional[str] = Query(None, description="Cursor from a previous page's pagination.next_cursor"),
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
     Get transactions with optional filtering
     
+    Transactions come back newest first by date, with records lacking a
+    parseable date after every dated one; this replaced the data file's order
+    when keyset pagination was added, in both storage modes.
+    
     Args:
         limit: Maximum number of transactions to return
-        offset: Number of transactions to skip
+        offset: Number of transactions to skip (ignored when a cursor is given)
         category: Filter by transaction category
         start_date: Filter transactions from this date
         end_date: Filter transactions until this date
+        cursor: Resume after the last transaction of a previous page
         permissions: User's data access permissions
         
     Returns:
@@ -69,40 +203,61 @@ async def get_transactions(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Load all data
-        all_data = data_service.load_all_data()
-        
-        # Get transactions
-        transactions = all_data.get("transactions", [])
-        
-        # Apply filters
-        filtered_transactions = transactions
-        
-        if category:
-            filtered_transactions = [t for t in filtered_transactions if t.get("category", "").lower() == category.lower()]
-        
-        if start_date:
-            filtered_transactions = [t for t in filtered_transactions if t.get("date", "") >= start_date]
-        
-        if end_date:
-            filtered_transactions = [t for t in filtered_transactions if t.get("date", "") <= end_date]
-        
-        # Apply pagination
-        total_count = len(filtered_transactions)
-        paginated_transactions = filtered_transactions[offset:offset + limit]
+        # Resolve date bounds to timestamps for the columnar index
+        start_ts = _parse_date_bound(start_date, "start_date")
+        end_ts = _parse_date_bound(end_date, "end_date", end_of_day=True)
+        key = _decode_cursor_param(cursor)
+        if key is not None:
+            offset = 0
+        
+        # The in-memory store is versioned, so clients revalidate pages with If-None-Match
+        repository = _get_repository()
+        etag = data_version = None
+        if repository is None:
+            data_version, _ = data_store.versioned_snapshot()
+            etag, not_modified = check_not_modified(request, data_version, permission_scope(permissions))
+            if not_modified is not None:
+                return not_modified
+        
+        if repository is not None:
+            # Index range scan over (user_id, [lower(category),] transaction_date, id)
+            paginated_transactions, next_key, total_count = await repository.page(
+                await _repository_user(repository), limit, category=category, start=start_ts, end=end_ts,
+                key=key, offset=offset
+            )
+        else:
+            # Filter via binary search over the date-sorted, category-indexed columns
+            columns = data_store.transaction_columns()
+            positions = columns.positions(category=category, start=start_ts, end=end_ts, ignore_case=True)
+            
+            # Records without a parseable date only match when no date filter is set
+            undated = []
+            if start_ts is None and end_ts is None:
+                undated = [
+                    t for t in columns.undated_records
+                    if not category or str(t.get("category", "")).lower() == category.lower()
+                ]
+            
+            # Apply pagination, newest first
+            total_count = len(positions) + len(undated)
+            if key is not None:
+                paginated_transactions, next_key = columns.page_before(positions, undated, limit, key)
+            else:
+                paginated_transactions, next_key = _paginate_newest_first(columns, positions, undated, offset, limit)
         
         # Calculate summary statistics
         total_amount = sum(t.get("amount", 0) for t in paginated_transactions)
         income_amount = sum(t.get("amount", 0) for t in paginated_transactions if t.get("amount", 0) > 0)
         expense_amount = abs(sum(t.get("amount", 0) for t in paginated_transactions if t.get("amount", 0) < 0))
         
-        return {
+        return json_response({
             "transactions": paginated_transactions,
             "pagination": {
                 "limit": limit,
                 "offset": offset,
                 "total": total_count,
-                "has_more": offset + limit < total_count
+                "has_more": next_key is not None,
+                "next_cursor": encode_cursor(next_key) if next_key is not None else None
             },
             "summary": {
                 "total_amount": round(total_amount, 2),
@@ -116,7 +271,7 @@ async def get_transactions(
                 "end_date": end_date
             },
             "timestamp": datetime.utcnow().isoformat() + "Z"
-        }
+        }, etag if data_store.version == data_version else None)
         
     except HTTPException:
         raise
@@ -130,6 +285,7 @@ async def get_transactions(
 
 @router.get("/transactions/recent")
 async def get_recent_transactions(
+    request: Request,
     limit: int = Query(10, description="Number of recent transactions to return"),
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
@@ -153,19 +309,28 @@ async def get_recent_transactions(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Load data
-        all_data = data_service.load_all_data()
-        transactions = all_data.get("transactions", [])
-        
-        # Sort by date (most recent first) and take limit
-        sorted_transactions = sorted(transactions, key=lambda x: x.get("date", ""), reverse=True)
-        recent_transactions = sorted_transactions[:limit]
-        
-        return {
+        repository = _get_repository()
+        etag = data_version = None
+        if repository is None:
+            data_version, _ = data_store.versioned_snapshot()
+            etag, not_modified = check_not_modified(request, data_version, permission_scope(permissions))
+            if not_modified is not None:
+                return not_modified
+        
+        if repository is not None:
+            recent_transactions = await repository.recent(await _repository_user(repository), limit)
+        else:
+            # Columns are already date-sorted, so recent N is a tail slice
+            columns = data_store.transaction_columns()
+            recent_transactions = columns.latest(limit)
+            if len(recent_transactions) < limit:
+                recent_transactions += columns.undated_records[:limit - len(recent_transactions)]
+        
+        return json_response({
             "transactions": recent_transactions,
             "count": len(recent_transactions),
             "timestamp": datetime.utcnow().isoformat() + "Z"
-        }
+        }, etag if data_store.version == data_version else None)
         
     except HTTPException:
         raise
@@ -202,12 +367,12 @@ async def get_transaction_by_id(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Load data
-        all_data = data_service.load_all_data()
-        transactions = all_data.get("transactions", [])
-        
         # Find transaction by ID
-        transaction = next((t for t in transactions if t.get("id") == transaction_id), None)
+        repository = _get_repository()
+        if repository is not None:
+            transaction = await repository.get(await _repository_user(repository), transaction_id)
+        else:
+            transaction = data_store.transaction_columns().find(transaction_id)
         
         if not transaction:
             raise HTTPException(
@@ -236,7 +401,7 @@ async def create_transaction(
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
-    Create a new transaction (mock implementation)
+    Create a new transaction
     
     Args:
         transaction_data: Transaction data to create
@@ -255,7 +420,8 @@ async def create_transaction(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Mock implementation - in real app, this would save to database
+        _validate_transaction_fields(transaction_data)
+        
         new_transaction = {
             "id": f"txn_{datetime.utcnow().timestamp()}",
             "description": transaction_data.get("description", "New Transaction"),
@@ -266,11 +432,28 @@ async def create_transaction(
             "created_at": datetime.utcnow().isoformat() + "Z"
         }
         
-        return {
+        # Score against rolling baselines before the write so history excludes
+        # it; the store adds it to them once it is published
+        if not anomaly_monitor.seeded:
+            anomaly_monitor.seed(data_store.snapshot().get("transactions", []))
+        anomaly = anomaly_monitor.score(new_transaction)
+        
+        repository = _get_repository()
+        if repository is not None:
+            new_transaction = await repository.create(await _repository_user(repository), new_transaction)
+        # The store updates the dashboard aggregates incrementally; the new
+        # data version alone retires cached analyses built on the old one
+        data_store.add_transaction(new_transaction)
+        
+        response = {
             "transaction": new_transaction,
             "message": "Transaction created successfully",
             "timestamp": datetime.utcnow().isoformat() + "Z"
         }
+        if anomaly:
+            response["anomaly"] = anomaly
+        
+        return response
         
     except HTTPException:
         raise
@@ -289,7 +472,7 @@ async def update_transaction(
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
-    Update an existing transaction (mock implementation)
+    Update an existing transaction
     
     Args:
         transaction_id: ID of the transaction to update
@@ -309,16 +492,24 @@ async def update_transaction(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Mock implementation - in real app, this would update database
-        updated_transaction = {
-            "id": transaction_id,
-            "description": transaction_data.get("description", "Updated Transaction"),
-            "amount": transaction_data.get("amount", 0),
-            "category": transaction_data.get("category", "Uncategorized"),
-            "account": transaction_data.get("account", "Default Account"),
-            "date": transaction_data.get("date", datetime.utcnow().isoformat() + "Z"),
-            "updated_at": datetime.utcnow().isoformat() + "Z"
-        }
+        _validate_transaction_fields(transaction_data)
+        
+        # Only the supplied fields change; the id is never rewritten
+        fields = {key: value for key, value in transaction_data.items() if key != "id"}
+        fields["updated_at"] = datetime.utcnow().isoformat() + "Z"
+        
+        repository = _get_repository()
+        if repository is not None:
+            updated_transaction = await repository.update(await _repository_user(repository), transaction_id, fields)
+            if updated_transaction is not None:
+                _mirror_update(updated_transaction)
+        else:
+            updated_transaction = data_store.update_transaction(transaction_id, fields)
+        if updated_transaction is None:
+            raise HTTPException(
+                status_code=404,
+                detail=f"Transaction with ID {transaction_id} not found"
+            )
         
         return {
             "transaction": updated_transaction,
@@ -342,7 +533,7 @@ async def delete_transaction(
     permissions: Permissions = Depends(get_default_permissions)
 ) -> Dict[str, Any]:
     """
-    Delete a transaction (mock implementation)
+    Delete a transaction
     
     Args:
         transaction_id: ID of the transaction to delete
@@ -361,7 +552,19 @@ async def delete_transaction(
                 detail="Access denied: Transaction data permission required"
             )
         
-        # Mock implementation - in real app, this would delete from database
+        repository = _get_repository()
+        if repository is not None:
+            deleted = await repository.delete(await _repository_user(repository), transaction_id)
+            if deleted:
+                data_store.delete_transaction(transaction_id)
+        else:
+            deleted = data_store.delete_transaction(transaction_id) is not None
+        if not deleted:
+            raise HTTPException(
+                status_code=404,
+                detail=f"Transaction with ID {transaction_id} not found"
+            )
+        
         return {
             "message": f"Transaction {transaction_id} deleted successfully",
             "deleted_id": transaction_id,
@@ -0,0 +1,158 @@
+"""
+API router for pushed data updates
+"""
+from fastapi import APIRouter, HTTPException, Depends, Query, Request
+from fastapi.responses import StreamingResponse
+from typing import Dict, Any, Optional, AsyncIterator
+import asyncio
+import json
+import logging
+from datetime import datetime
+
+from ..models.requests import Permissions
+from ..services.change_feed import get_change_feed
+
+logger = logging.getLogger(__name__)
+
+# Create router instance
+router = APIRouter(prefix="/api", tags=["updates"])
+
+# Initialize services
+change_feed = get_change_feed()
+
+# Seconds between keepalive comments on an idle stream
+HEARTBEAT_SECONDS = 15.0
+
+
+def get_default_permissions() -> Permissions:
+    """Get default permissions for testing (all enabled)"""
+    return Permissions(
+        transactions=True,
+        accounts=True,
+        assets=True,
+        liabilities=True,
+        epf_balance=True,
+        credit_score=True,
+        investments=True,
+        spending_trends=True,
+        category_breakdown=True,
+        dashboard_insights=True
+    )
+
+
+@router.get("/updates")
+async def get_updates(
+    since: int = Query(..., description="Last data version the client applied"),
+    permissions: Permissions = Depends(get_default_permissions)
+) -> Dict[str, Any]:
+    """
+    Get the data deltas published after a version
+
+    Args:
+        since: Last data version the client applied
+        permissions: User's data access permissions
+
+    Returns:
+        Current version plus the events after ``since``, or ``resync`` when
+        the client must refetch because the backlog no longer reaches back
+    """
+    try:
+        events = change_feed.since(since)
+        return {
+            "version": change_feed.version,
+            "resync": events is None,
+            "events": [_visible(event, permissions) for event in events or []],
+            "timestamp": datetime.utcnow().isoformat() + "Z"
+        }
+
+    except Exception as e:
+        logger.error(f"Error fetching updates: {str(e)}")
+        raise HTTPException(
+            status_code=500,
+            detail=f"Internal server error: {str(e)}"
+        )
+
+
+@router.get("/updates/stream")
+async def stream_updates(
+    request: Request,
+    since: Optional[int] = Query(None, description="Last data version the client applied"),
+    permissions: Permissions = Depends(get_default_permissions)
+) -> StreamingResponse:
+    """
+    Stream data deltas as server-sent events
+
+    Emits ``hello`` with the current version, then one ``transactions`` or
+    ``reload`` event per new version, each with the version as its event id
+    so EventSource reconnects resume through Last-Event-ID. ``resync`` means
+    the client's version can no longer be caught up and it must refetch.
+
+    Args:
+        since: Last data version the client applied; Last-Event-ID takes precedence
+        permissions: User's data access permissions
+
+    Returns:
+        text/event-stream response
+    """
+    last_event_id = request.headers.get("last-event-id")
+    if last_event_id and last_event_id.isdigit():
+        since = int(last_event_id)
+
+    async def events() -> AsyncIterator[str]:
+        queue = change_feed.subscribe()
+        try:
+            yield _sse_event("hello", {"version": change_feed.version})
+            if since is not None:
+                backlog = change_feed.since(since)
+                if backlog is None:
+                    yield _sse_event("resync", {"version": change_feed.version})
+                for event in backlog or []:
+                    visible = _visible(event, permissions)
+                    yield _sse_event(visible["type"], visible, event["version"])
+
+            while not await request.is_disconnected():
+                try:
+                    event = await asyncio.wait_for(queue.get(), HEARTBEAT_SECONDS)
+                except asyncio.TimeoutError:
+                    yield ": keepalive\n\n"
+                    continue
+                if event is None:
+                    yield _sse_event("resync", {"version": change_feed.version})
+                    continue
+                visible = _visible(event, permissions)
+                yield _sse_event(visible["type"], visible, event["version"])
+        finally:
+            change_feed.unsubscribe(queue)
+
+    return StreamingResponse(
+        events(),
+        media_type="text/event-stream",
+        headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"}
+    )
+
+
+def _visible(event: Dict[str, Any], permissions: Permissions) -> Dict[str, Any]:
+    """
+    Strip the parts of an event the user may not see
+
+    Without transaction access only the version bump remains; without
+    spending trends the month and day totals are emptied, and without the
+    category breakdown the category totals are.
+    """
+    if event["type"] != "transactions":
+        return event
+    if not permissions.transactions:
+        return {"version": event["version"], "type": "version", "timestamp": event["timestamp"]}
+
+    hidden = {}
+    if not permissions.spending_trends:
+        hidden.update(months=[], days=[])
+    if not permissions.category_breakdown:
+        hidden["categories"] = {}
+    return {**event, **hidden} if hidden else event
+
+
+def _sse_event(event: str, data: Dict[str, Any], event_id: Optional[int] = None) -> str:
+    """Format one server-sent event"""
+    prefix = f"id: {event_id}\n" if event_id is not None else ""
+    return f"{prefix}event: {event}\ndata: {json.dumps(data, default=str)}\n\n"
@@ -13,9 +13,18 @@ from .auth import (
     DataEncryption,
     add_security_headers,
     authenticate_user,
+    authenticate_user_async,
     create_user_tokens,
+    TokenCache,
+    MOCK_USERS,
     SECURITY_HEADERS
 )
+from .rate_limit import (
+    RateLimiter,
+    RateLimitMiddleware,
+    get_rate_limiter,
+    rate_limiting_enabled
+)
 
 __all__ = [
     "SecurityManager",
@@ -28,6 +37,13 @@ __all__ = [
     "DataEncryption",
     "add_security_headers",
     "authenticate_user",
+    "authenticate_user_async",
     "create_user_tokens",
-    "SECURITY_HEADERS"
+    "TokenCache",
+    "MOCK_USERS",
+    "SECURITY_HEADERS",
+    "RateLimiter",
+    "RateLimitMiddleware",
+    "get_rate_limiter",
+    "rate_limiting_enabled"
 ]
\ No newline at end of file
@@ -3,15 +3,22 @@ Authentication and security module for Financial AI Assistant
 """
 import os
 import jwt
+import asyncio
 import hashlib
 import secrets
+import threading
+import time
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime, timedelta
-from typing import Dict, Any, Optional
+from typing import Dict, Any, Optional, Tuple
 from fastapi import HTTPException, Depends, status
 from fastapi.security import HTTPBearer, HTTPAuthorizationCredentials
 from passlib.context import CryptContext
 import logging
 
+from .rate_limit import get_rate_limiter
+
 logger = logging.getLogger(__name__)
 
 # Security configuration
@@ -23,9 +30,73 @@ REFRESH_TOKEN_EXPIRE_DAYS = 7
 # Password hashing
 pwd_context = CryptContext(schemes=["bcrypt"], deprecated="auto")
 
+# bcrypt runs on a small worker pool; beyond PASSWORD_HASH_MAX_PENDING queued
+# hashes (workers busy plus waiting) new logins are turned away with 503
+PASSWORD_HASH_WORKERS = int(os.getenv("PASSWORD_HASH_WORKERS", "4"))
+PASSWORD_HASH_MAX_PENDING = int(os.getenv("PASSWORD_HASH_MAX_PENDING", str(PASSWORD_HASH_WORKERS * 8)))
+
+# Verified access tokens kept in memory, each only until its own expiry
+TOKEN_CACHE_SIZE = int(os.getenv("TOKEN_CACHE_SIZE", "4096"))
+
 # JWT Bearer token authentication
 security = HTTPBearer()
 
+class TokenCache:
+    """
+    LRU cache of verified JWT payloads keyed by token digest
+
+    Entries never outlive the token's ``exp`` claim, so a cache hit is only
+    ever a token the signature check would still accept.
+    """
+    
+    def __init__(self, max_entries: int = TOKEN_CACHE_SIZE):
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[bytes, Tuple[float, Dict[str, Any]]]" = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+    
+    @staticmethod
+    def digest(token: str) -> bytes:
+        """Cache key for a token; the raw token is never held"""
+        return hashlib.sha256(token.encode("utf-8")).digest()
+    
+    def get(self, key: bytes) -> Optional[Dict[str, Any]]:
+        """Get a cached payload if its token has not expired yet"""
+        with self._lock:
+            entry = self._entries.get(key)
+            if entry is None:
+                self.misses += 1
+                return None
+            if entry[0] <= time.time():
+                del self._entries[key]
+                self.misses += 1
+                return None
+            self._entries.move_to_end(key)
+            self.hits += 1
+            return entry[1]
+    
+    def put(self, key: bytes, payload: Dict[str, Any]) -> None:
+        """Cache a verified payload; tokens without an expiry are not cached"""
+        expires_at = payload.get("exp")
+        if not isinstance(expires_at, (int, float)) or expires_at <= time.time():
+            return
+        with self._lock:
+            self._entries[key] = (float(expires_at), payload)
+            self._entries.move_to_end(key)
+            while len(self._entries) > self.max_entries:
+                self._entries.popitem(last=False)
+    
+    def clear(self) -> None:
+        """Drop every cached payload"""
+        with self._lock:
+            self._entries.clear()
+    
+    def get_stats(self) -> Dict[str, Any]:
+        """Get cache size and hit counters"""
+        with self._lock:
+            return {"entries": len(self._entries), "hits": self.hits, "misses": self.misses}
+
 class SecurityManager:
     """Central security management class"""
     
@@ -33,6 +104,10 @@ class SecurityManager:
         self.secret_key = SECRET_KEY
         self.algorithm = ALGORITHM
         self.pwd_context = pwd_context
+        self.token_cache = TokenCache()
+        self._hash_executor: Optional[ThreadPoolExecutor] = None
+        self._hash_pending = 0
+        self._hash_lock = threading.Lock()
         
     def hash_password(self, password: str) -> str:
         """Hash a password using bcrypt"""
@@ -42,6 +117,41 @@ class SecurityManager:
         """Verify a password against its hash"""
         return self.pwd_context.verify(plain_password, hashed_password)
     
+    async def _run_hash_worker(self, func, *args):
+        """Run a bcrypt call on the worker pool, shedding load past the pending cap"""
+        with self._hash_lock:
+            if self._hash_pending >= PASSWORD_HASH_MAX_PENDING:
+                logger.warning("Password hashing queue full, rejecting request")
+                raise HTTPException(
+                    status_code=status.HTTP_503_SERVICE_UNAVAILABLE,
+                    detail="Authentication service busy, please retry",
+                    headers={"Retry-After": "1"},
+                )
+            self._hash_pending += 1
+            if self._hash_executor is None:
+                self._hash_executor = ThreadPoolExecutor(
+                    max_workers=PASSWORD_HASH_WORKERS, thread_name_prefix="password-hash"
+                )
+        try:
+            return await asyncio.get_running_loop().run_in_executor(self._hash_executor, func, *args)
+        finally:
+            with self._hash_lock:
+                self._hash_pending -= 1
+    
+    def get_hash_stats(self) -> Dict[str, Any]:
+        """Get the password hashing queue depth and capacity"""
+        with self._hash_lock:
+            return {"pending": self._hash_pending, "max_pending": PASSWORD_HASH_MAX_PENDING,
+                    "workers": PASSWORD_HASH_WORKERS}
+    
+    async def hash_password_async(self, password: str) -> str:
+        """Hash a password on the worker pool without blocking the event loop"""
+        return await self._run_hash_worker(self.hash_password, password)
+    
+    async def verify_password_async(self, plain_password: str, hashed_password: str) -> bool:
+        """Verify a password on the worker pool without blocking the event loop"""
+        return await self._run_hash_worker(self.verify_password, plain_password, hashed_password)
+    
     def create_access_token(self, data: Dict[str, Any], expires_delta: Optional[timedelta] = None) -> str:
         """Create a JWT access token"""
         to_encode = data.copy()
@@ -64,17 +174,23 @@ class SecurityManager:
         return encoded_jwt
     
     def decode_token(self, token: str) -> Dict[str, Any]:
-        """Decode and validate a JWT token"""
+        """Decode and validate a JWT token, reusing the result for repeat presentations"""
+        key = self.token_cache.digest(token)
+        cached = self.token_cache.get(key)
+        if cached is not None:
+            return dict(cached)
+        
         try:
             payload = jwt.decode(token, self.secret_key, algorithms=[self.algorithm])
-            return payload
+            self.token_cache.put(key, payload)
+            return dict(payload)
         except jwt.ExpiredSignatureError:
             raise HTTPException(
                 status_code=status.HTTP_401_UNAUTHORIZED,
                 detail="Token has expired",
                 headers={"WWW-Authenticate": "Bearer"},
             )
-        except jwt.JWTError:
+        except jwt.InvalidTokenError:
             raise HTTPException(
                 status_code=status.HTTP_401_UNAUTHORIZED,
                 detail="Could not validate credentials",
@@ -122,11 +238,11 @@ class SecurityManager:
         return True
     
     def rate_limit_check(self, user_id: str, endpoint: str, limit_per_minute: int = 60) -> bool:
-        """Basic rate limiting check (in production, use Redis or similar)"""
-        # This is a basic implementation - in production use Redis
-        # For now, we'll just log the request
-        logger.info(f"Rate limit check: {user_id} accessing {endpoint}")
-        return True  # Allow all requests for now
+        """Token-bucket rate limit check in process memory (see rate_limit.RateLimitMiddleware)"""
+        allowed = get_rate_limiter().check(user_id, endpoint, limit_per_minute)
+        if not allowed:
+            logger.warning(f"Rate limit exceeded: {user_id} accessing {endpoint}")
+        return allowed
     
     def audit_log(self, user_id: str, action: str, details: Dict[str, Any] = None):
         """Log security-relevant actions"""
@@ -279,6 +395,19 @@ def authenticate_user(username: str, password: str) -> Optional[Dict[str, Any]]:
     security_manager.audit_log(user["user_id"], "login_success")
     return user
 
+async def authenticate_user_async(username: str, password: str) -> Optional[Dict[str, Any]]:
+    """Authenticate a user, verifying the password off the event loop"""
+    user = MOCK_USERS.get(username)
+    if not user or not user["is_active"]:
+        return None
+    
+    if not await security_manager.verify_password_async(password, user["hashed_password"]):
+        return None
+    
+    # Log successful authentication
+    security_manager.audit_log(user["user_id"], "login_success")
+    return user
+
 def create_user_tokens(user: Dict[str, Any]) -> Dict[str, str]:
     """Create access and refresh tokens for a user"""
     token_data = {
@@ -0,0 +1,409 @@
+"""
+Token-bucket rate limiting and load shedding for the Financial AI Assistant
+Each client gets one bucket per route group; expensive routes draw more tokens
+per request. Buckets live in process memory by default, or in a SQLite file
+(placed on /dev/shm for a memory-backed store) or Redis so every worker shares
+them. An in-flight cost budget sheds excess load with 503 before it queues.
+"""
+import asyncio
+import json
+import math
+import os
+import sqlite3
+import threading
+import time
+from collections import OrderedDict
+from datetime import datetime
+from typing import Any, Callable, Dict, List, Optional, Tuple
+import logging
+
+logger = logging.getLogger(__name__)
+
+# Environment: bucket size, refill window, shed budget and shared store
+# (unset = in-process, redis://... = Redis, anything else = SQLite file path)
+ENABLED_ENV = "ENABLE_RATE_LIMITING"
+REQUESTS_ENV = "RATE_LIMIT_REQUESTS"
+PERIOD_ENV = "RATE_LIMIT_PERIOD"
+MAX_IN_FLIGHT_ENV = "RATE_LIMIT_MAX_IN_FLIGHT"
+STORE_ENV = "RATE_LIMIT_STORE"
+
+# (path prefix, route group, cost); the first matching prefix wins
+ROUTE_COSTS: List[Tuple[str, str, int]] = [
+    ("/api/chat/history", "chat_history", 1),
+    ("/api/chat", "chat", 5),
+    ("/api/insights/generate", "insights_generate", 10),
+    ("/api/insights", "insights", 3),
+    ("/api/dashboard", "dashboard", 2),
+]
+DEFAULT_ROUTE = ("default", 1)
+
+# Paths that are never limited
+EXEMPT_PATHS = frozenset({"/", "/health", "/docs", "/redoc", "/openapi.json", "/metrics"})
+
+# Long-lived streams held open by idle clients: charged on connect, but they
+# would pin an in-flight reservation for as long as the client stays connected
+STREAM_PATHS = frozenset({"/api/updates/stream"})
+
+
+class MemoryBucketStore:
+    """Token buckets in process memory, bounded to the most recently used keys"""
+
+    def __init__(self, max_keys: int = 10000):
+        """
+        Initialize the store
+
+        Args:
+            max_keys: Buckets kept; idle ones beyond this are dropped (they would be full)
+        """
+        self.max_keys = max(1, max_keys)
+        self._buckets: "OrderedDict[str, Tuple[float, float]]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    def take(self, key: str, cost: float, capacity: float, rate: float) -> Tuple[bool, float, float]:
+        """
+        Draw tokens from a bucket
+
+        Args:
+            key: Bucket key
+            cost: Tokens the request needs
+            capacity: Bucket size
+            rate: Refill rate in tokens per second
+
+        Returns:
+            (allowed, tokens left, seconds until the request would be allowed)
+        """
+        now = time.monotonic()
+        with self._lock:
+            tokens, last = self._buckets.get(key, (capacity, now))
+            tokens = min(capacity, tokens + (now - last) * rate)
+            allowed = tokens >= cost
+            if allowed:
+                tokens -= cost
+            self._buckets[key] = (tokens, now)
+            self._buckets.move_to_end(key)
+            while len(self._buckets) > self.max_keys:
+                self._buckets.popitem(last=False)
+        return allowed, tokens, 0.0 if allowed else (cost - tokens) / rate
+
+
+class SQLiteBucketStore:
+    """Token buckets in a SQLite file shared by the workers of one host"""
+
+    def __init__(self, path: str):
+        """
+        Open (and create) the bucket database
+
+        Args:
+            path: SQLite file path, e.g. under /dev/shm
+        """
+        self.path = path
+        self._lock = threading.Lock()
+        self._conn = sqlite3.connect(path, timeout=1.0, check_same_thread=False, isolation_level=None)
+        self._conn.execute("PRAGMA journal_mode=WAL")
+        self._conn.execute("PRAGMA synchronous=OFF")
+        self._conn.execute(
+            "CREATE TABLE IF NOT EXISTS buckets (key TEXT PRIMARY KEY, tokens REAL NOT NULL, updated REAL NOT NULL)"
+        )
+
+    def take(self, key: str, cost: float, capacity: float, rate: float) -> Tuple[bool, float, float]:
+        """Draw tokens from a bucket (see MemoryBucketStore.take)"""
+        now = time.time()
+        with self._lock:
+            self._conn.execute("BEGIN IMMEDIATE")
+            try:
+                row = self._conn.execute("SELECT tokens, updated FROM buckets WHERE key = ?", (key,)).fetchone()
+                tokens, last = row if row else (capacity, now)
+                tokens = min(capacity, tokens + max(0.0, now - last) * rate)
+                allowed = tokens >= cost
+                if allowed:
+                    tokens -= cost
+                self._conn.execute("INSERT OR REPLACE INTO buckets VALUES (?, ?, ?)", (key, tokens, now))
+                self._conn.execute("COMMIT")
+            except sqlite3.Error:
+                self._conn.execute("ROLLBACK")
+                raise
+        return allowed, tokens, 0.0 if allowed else (cost - tokens) / rate
+
+    async def take_async(self, key: str, cost: float, capacity: float, rate: float) -> Tuple[bool, float, float]:
+        """Draw tokens on a worker thread; BEGIN IMMEDIATE may wait on other workers' locks"""
+        return await asyncio.to_thread(self.take, key, cost, capacity, rate)
+
+
+class RedisBucketStore:
+    """Token buckets in Redis, updated atomically by a server-side script"""
+
+    SCRIPT = """
+    local bucket = redis.call('HMGET', KEYS[1], 'tokens', 'updated')
+    local capacity, rate, cost, now = tonumber(ARGV[1]), tonumber(ARGV[2]), tonumber(ARGV[3]), tonumber(ARGV[4])
+    local tokens = tonumber(bucket[1]) or capacity
+    local updated = tonumber(bucket[2]) or now
+    tokens = math.min(capacity, tokens + math.max(0, now - updated) * rate)
+    local allowed = 0
+    if tokens >= cost then
+        tokens = tokens - cost
+        allowed = 1
+    end
+    redis.call('HSET', KEYS[1], 'tokens', tokens, 'updated', now)
+    redis.call('EXPIRE', KEYS[1], math.ceil(capacity / rate) + 1)
+    return {allowed, tostring(tokens)}
+    """
+
+    def __init__(self, url: str):
+        """
+        Connect to Redis
+
+        Args:
+            url: Redis URL
+        """
+        import redis.asyncio as redis_asyncio
+
+        self.path = url
+        self._client = redis_asyncio.from_url(url)
+        self._script = self._client.register_script(self.SCRIPT)
+
+    async def take_async(self, key: str, cost: float, capacity: float, rate: float) -> Tuple[bool, float, float]:
+        """Draw tokens from a bucket (see MemoryBucketStore.take)"""
+        allowed, tokens = await self._script(keys=[f"ratelimit:{key}"], args=[capacity, rate, cost, time.time()])
+        tokens = float(tokens)
+        return bool(allowed), tokens, 0.0 if allowed else (cost - tokens) / rate
+
+
+class RateLimiter:
+    """Per-client, per-route token buckets plus an in-flight cost budget"""
+
+    def __init__(self, requests: int = 100, period: float = 60, max_in_flight: int = 64,
+                 store: Optional[Any] = None, route_costs: Optional[List[Tuple[str, str, int]]] = None):
+        """
+        Initialize the limiter
+
+        Args:
+            requests: Bucket size in tokens; a cost-1 route allows this many requests per period
+            period: Seconds to refill an empty bucket
+            max_in_flight: Total cost of requests processed at once before shedding
+            store: Bucket store; in-process memory by default
+            route_costs: (path prefix, route group, cost) rules, first match wins
+        """
+        self.capacity = float(max(1, requests))
+        self.rate = self.capacity / max(period, 1e-3)
+        self.max_in_flight = max(1, max_in_flight)
+        self.store = store or MemoryBucketStore()
+        self._fallback = self.store if isinstance(self.store, MemoryBucketStore) else MemoryBucketStore()
+        self.route_costs = route_costs if route_costs is not None else ROUTE_COSTS
+        self.in_flight = 0
+        self._stats = {"allowed": 0, "limited": 0, "shed": 0, "store_errors": 0}
+
+    def route(self, path: str) -> Tuple[str, int]:
+        """Route group and token cost of a request path"""
+        for prefix, group, cost in self.route_costs:
+            if path == prefix or path.startswith(prefix + "/"):
+                return group, cost
+        return DEFAULT_ROUTE
+
+    async def acquire(self, client: str, path: str) -> Tuple[bool, float, float]:
+        """
+        Charge a request against the client's bucket for its route
+
+        A failing shared store falls back to in-process buckets rather than
+        rejecting or waving through all traffic.
+
+        Args:
+            client: Client identity (user or address)
+            path: Request path
+
+        Returns:
+            (allowed, tokens left, seconds until retry)
+        """
+        group, cost = self.route(path)
+        key = f"{client}:{group}"
+        cost = min(float(cost), self.capacity)
+        try:
+            if hasattr(self.store, "take_async"):
+                result = await self.store.take_async(key, cost, self.capacity, self.rate)
+            else:
+                result = self.store.take(key, cost, self.capacity, self.rate)
+        except Exception as e:
+            self._stats["store_errors"] += 1
+            logger.warning(f"Rate limit store unavailable, using local buckets: {str(e)}")
+            result = self._fallback.take(key, cost, self.capacity, self.rate)
+
+        self._stats["allowed" if result[0] else "limited"] += 1
+        return result
+
+    def check(self, client: str, endpoint: str, limit_per_minute: int) -> bool:
+        """
+        Synchronous one-token check against a per-minute limit in process memory
+
+        Args:
+            client: Client identity
+            endpoint: Endpoint name
+            limit_per_minute: Requests allowed per minute
+
+        Returns:
+            True if the request is within the limit
+        """
+        capacity = float(max(1, limit_per_minute))
+        allowed, _, _ = self._fallback.take(f"{client}:{endpoint}:{limit_per_minute}", 1.0,
+                                            capacity, capacity / 60.0)
+        return allowed
+
+    def admit(self, path: str) -> Optional[int]:
+        """
+        Reserve in-flight budget for a request
+
+        Returns:
+            The reserved cost to pass to ``release``, or None to shed the request
+        """
+        _, cost = self.route(path)
+        if self.in_flight > 0 and self.in_flight + cost > self.max_in_flight:
+            self._stats["shed"] += 1
+            return None
+        self.in_flight += cost
+        return cost
+
+    def release(self, cost: int) -> None:
+        """Return in-flight budget reserved by ``admit``"""
+        self.in_flight -= cost
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Get limiter counters
+
+        Returns:
+            Allowed, limited, shed and store error counts plus current load
+        """
+        stats = dict(self._stats)
+        stats["in_flight"] = self.in_flight
+        stats["max_in_flight"] = self.max_in_flight
+        stats["store"] = getattr(self.store, "path", "memory")
+        return stats
+
+
+def _bearer_user(authorization: str) -> Optional[str]:
+    """User ID of a valid bearer token, None otherwise"""
+    if not authorization.lower().startswith("bearer "):
+        return None
+    try:
+        from .auth import security_manager
+
+        return security_manager.decode_token(authorization[7:].strip()).get("sub")
+    except Exception:
+        return None
+
+
+def client_identity(scope: Dict[str, Any]) -> str:
+    """
+    Rate limit identity of an ASGI request
+
+    Verified bearer tokens limit per user; everything else limits per address.
+    """
+    for name, value in scope.get("headers") or ():
+        if name == b"authorization":
+            user_id = _bearer_user(value.decode("latin-1"))
+            if user_id:
+                return f"user:{user_id}"
+            break
+    client = scope.get("client")
+    return f"ip:{client[0] if client else 'unknown'}"
+
+
+class RateLimitMiddleware:
+    """ASGI middleware answering 429 over a client's rate and 503 when overloaded"""
+
+    def __init__(self, app: Callable, limiter: Optional[RateLimiter] = None,
+                 identify: Callable[[Dict[str, Any]], str] = client_identity):
+        """
+        Wrap an ASGI application
+
+        Args:
+            app: Downstream ASGI application
+            limiter: Limiter to enforce; the process-wide one by default
+            identify: Maps a request scope to a client identity
+        """
+        self.app = app
+        self.limiter = limiter or get_rate_limiter()
+        self.identify = identify
+
+    async def __call__(self, scope, receive, send):
+        if scope["type"] != "http" or scope["path"] in EXEMPT_PATHS or scope.get("method") == "OPTIONS":
+            await self.app(scope, receive, send)
+            return
+
+        streaming = scope["path"] in STREAM_PATHS
+        reserved = None if streaming else self.limiter.admit(scope["path"])
+        if reserved is None and not streaming:
+            await _reject(send, 503, "Service overloaded", "Too many requests in progress, retry shortly", 1)
+            return
+
+        try:
+            allowed, remaining, retry_after = await self.limiter.acquire(self.identify(scope), scope["path"])
+            if not allowed:
+                await _reject(send, 429, "Rate limit exceeded", "Too many requests for this endpoint",
+                              retry_after, remaining, self.limiter.capacity)
+                return
+            await self.app(scope, receive, send)
+        finally:
+            if reserved is not None:
+                self.limiter.release(reserved)
+
+
+async def _reject(send, status_code: int, error: str, detail: str, retry_after: float,
+                  remaining: Optional[float] = None, limit: Optional[float] = None) -> None:
+    """Send an error response in the API's JSON error format"""
+    body = json.dumps({
+        "error": error,
+        "detail": detail,
+        "retry_after": math.ceil(retry_after),
+        "timestamp": datetime.utcnow().isoformat() + "Z"
+    }).encode()
+    headers = [
+        (b"content-type", b"application/json"),
+        (b"content-length", str(len(body)).encode()),
+        (b"retry-after", str(max(1, math.ceil(retry_after))).encode()),
+    ]
+    if limit is not None:
+        headers.append((b"x-ratelimit-limit", str(int(limit)).encode()))
+        headers.append((b"x-ratelimit-remaining", str(int(remaining or 0)).encode()))
+    await send({"type": "http.response.start", "status": status_code, "headers": headers})
+    await send({"type": "http.response.body", "body": body})
+
+
+def rate_limiting_enabled() -> bool:
+    """Whether ``ENABLE_RATE_LIMITING`` leaves the limiter on (the default)"""
+    return os.getenv(ENABLED_ENV, "true").lower() not in ("0", "false", "no", "off")
+
+
+def _open_store(location: Optional[str]) -> Optional[Any]:
+    """Bucket store named by ``RATE_LIMIT_STORE``; None keeps buckets in process"""
+    if not location:
+        return None
+    try:
+        if location.startswith(("redis://", "rediss://", "unix://")):
+            return RedisBucketStore(location)
+        return SQLiteBucketStore(location)
+    except Exception as e:
+        logger.error(f"Failed to open rate limit store {location}: {str(e)}; using in-process buckets")
+        return None
+
+
+_limiter: Optional[RateLimiter] = None
+_limiter_lock = threading.Lock()
+
+
+def get_rate_limiter() -> RateLimiter:
+    """
+    Get the process-wide rate limiter configured from the environment
+
+    Returns:
+        Shared RateLimiter instance
+    """
+    global _limiter
+    if _limiter is None:
+        with _limiter_lock:
+            if _limiter is None:
+                _limiter = RateLimiter(
+                    requests=int(os.getenv(REQUESTS_ENV, "100")),
+                    period=float(os.getenv(PERIOD_ENV, "60")),
+                    max_in_flight=int(os.getenv(MAX_IN_FLIGHT_ENV, "64")),
+                    store=_open_store(os.getenv(STORE_ENV))
+                )
+    return _limiter
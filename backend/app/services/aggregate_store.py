@@ -0,0 +1,284 @@
+"""
+Incrementally maintained transaction aggregates
+Keeps monthly-by-category, daily and running income/expense totals that are
+updated per transaction mutation, so dashboard reads scale with months, not rows
+"""
+import threading
+from typing import Dict, Any, List, Optional, Iterable
+from datetime import datetime, timezone
+import logging
+
+from .transaction_store import _parse_date, month_key
+
+logger = logging.getLogger(__name__)
+
+SECONDS_PER_DAY = 86400
+
+# Category label used when a record has none, matching the dashboard's default
+DEFAULT_CATEGORY = "Uncategorized"
+
+
+class _Bucket:
+    """Income, expense and row count for one aggregate cell"""
+
+    __slots__ = ("income", "expenses", "count")
+
+    def __init__(self):
+        self.income = 0.0
+        self.expenses = 0.0
+        self.count = 0
+
+    def apply(self, amount: float, sign: int) -> None:
+        """Add (sign=1) or remove (sign=-1) one transaction amount"""
+        if amount > 0:
+            self.income += sign * amount
+        else:
+            self.expenses -= sign * amount
+        self.count += sign
+
+
+class TransactionAggregates:
+    """
+    Running rollups over a transaction list
+
+    Every transaction contributes to a (month, category) bucket, a UTC day
+    bucket and the running totals. ``add`` and ``remove`` adjust only the
+    buckets the transaction touches, so updates are O(1) and reads are
+    O(months x categories) or O(days) regardless of history length. Unlike
+    snapshots the aggregates are updated in place, so every access is locked.
+    """
+
+    def __init__(self, transactions: Iterable[Dict[str, Any]] = ()):
+        """
+        Build aggregates from an initial transaction list
+
+        Args:
+            transactions: Transaction records to aggregate
+        """
+        self.monthly: Dict[int, Dict[str, _Bucket]] = {}
+        self.daily: Dict[int, _Bucket] = {}
+        self.totals = _Bucket()
+        self.undated = _Bucket()
+        self.latest_timestamp: Optional[float] = None
+        self._lock = threading.RLock()
+
+        for transaction in transactions:
+            self.add(transaction)
+
+    def add(self, transaction: Dict[str, Any]) -> None:
+        """Add one transaction's contribution"""
+        with self._lock:
+            self._apply(transaction, 1)
+
+    def remove(self, transaction: Dict[str, Any]) -> None:
+        """Remove one transaction's contribution"""
+        with self._lock:
+            self._apply(transaction, -1)
+
+    def replace(self, old: Dict[str, Any], new: Dict[str, Any]) -> None:
+        """Swap one transaction's contribution for another's"""
+        with self._lock:
+            self._apply(old, -1)
+            self._apply(new, 1)
+
+    def _apply(self, transaction: Dict[str, Any], sign: int) -> None:
+        """Apply a signed contribution to every bucket the transaction touches (lock held)"""
+        try:
+            amount = float(transaction.get("amount", 0))
+        except (TypeError, ValueError):
+            amount = 0.0
+
+        self.totals.apply(amount, sign)
+
+        date_value = transaction.get("date", "")
+        parsed = _parse_date(date_value) if isinstance(date_value, str) and date_value else None
+        if parsed is None:
+            self.undated.apply(amount, sign)
+            return
+
+        timestamp, month_code = parsed[0], parsed[1]
+        category = transaction.get("category", DEFAULT_CATEGORY)
+
+        categories = self.monthly.setdefault(month_code, {})
+        bucket = categories.get(category)
+        if bucket is None:
+            bucket = categories[category] = _Bucket()
+        bucket.apply(amount, sign)
+        if bucket.count <= 0:
+            # Drop empty cells so float residue never shows up in reads
+            del categories[category]
+            if not categories:
+                del self.monthly[month_code]
+
+        day = int(timestamp // SECONDS_PER_DAY)
+        day_bucket = self.daily.get(day)
+        if day_bucket is None:
+            day_bucket = self.daily[day] = _Bucket()
+        day_bucket.apply(amount, sign)
+        if day_bucket.count <= 0:
+            del self.daily[day]
+
+        if sign > 0 and (self.latest_timestamp is None or timestamp > self.latest_timestamp):
+            self.latest_timestamp = timestamp
+        elif sign < 0 and timestamp == self.latest_timestamp:
+            # Fall back to the end of the latest active day rather than rescanning rows
+            self.latest_timestamp = (max(self.daily) + 1) * SECONDS_PER_DAY - 1 if self.daily else None
+
+    def category_expenses(self, start_month: Optional[int] = None,
+                          end_month: Optional[int] = None) -> Dict[str, float]:
+        """
+        Total expenses per category over a month range
+
+        Args:
+            start_month: Inclusive first month code, or None for unbounded
+            end_month: Inclusive last month code, or None for unbounded
+
+        Returns:
+            Mapping of category to expense total
+        """
+        totals: Dict[str, float] = {}
+        with self._lock:
+            for month_code, categories in self.monthly.items():
+                if start_month is not None and month_code < start_month:
+                    continue
+                if end_month is not None and month_code > end_month:
+                    continue
+                for category, bucket in categories.items():
+                    if bucket.expenses:
+                        totals[category] = totals.get(category, 0.0) + bucket.expenses
+        return totals
+
+    def monthly_expenses(self, month_codes: List[int]) -> List[float]:
+        """Total expenses for each requested month code"""
+        with self._lock:
+            return [
+                sum(bucket.expenses for bucket in self.monthly.get(code, {}).values())
+                for code in month_codes
+            ]
+
+    def monthly_flows(self, months_back: Optional[int] = None) -> List[Dict[str, Any]]:
+        """Income and expense totals per month, oldest first"""
+        with self._lock:
+            codes = sorted(self.monthly)
+            if months_back is not None:
+                codes = codes[-months_back:] if months_back > 0 else []
+            totals = [
+                (code,
+                 sum(b.income for b in self.monthly[code].values()),
+                 sum(b.expenses for b in self.monthly[code].values()))
+                for code in codes
+            ]
+        return [
+            {
+                "month": month_key(code),
+                "income": income,
+                "expenses": expenses,
+                "net_flow": income - expenses
+            }
+            for code, income, expenses in totals
+        ]
+
+    def month_totals(self, month_code: int) -> Dict[str, float]:
+        """Income and expense totals of one month"""
+        with self._lock:
+            buckets = list(self.monthly.get(month_code, {}).values())
+            income = sum(b.income for b in buckets)
+            expenses = sum(b.expenses for b in buckets)
+        return {"income": income, "expenses": expenses, "net_flow": income - expenses}
+
+    def day_totals(self, day: int) -> Dict[str, float]:
+        """Income and expense totals of one UTC day number"""
+        with self._lock:
+            bucket = self.daily.get(day)
+            income, expenses = (bucket.income, bucket.expenses) if bucket is not None else (0.0, 0.0)
+        return {"income": income, "expenses": expenses}
+
+    def expenses_between_days(self, start_day: int, end_day: int) -> float:
+        """Total expenses over an inclusive range of UTC day numbers"""
+        with self._lock:
+            if end_day - start_day + 1 > len(self.daily):
+                return sum(b.expenses for day, b in self.daily.items() if start_day <= day <= end_day)
+            total = 0.0
+            for day in range(start_day, end_day + 1):
+                bucket = self.daily.get(day)
+                if bucket is not None:
+                    total += bucket.expenses
+            return total
+
+    def expenses_since(self, timestamp: float) -> float:
+        """Total expenses from the UTC day containing ``timestamp`` onwards"""
+        with self._lock:
+            if not self.daily:
+                return 0.0
+            return self.expenses_between_days(int(timestamp // SECONDS_PER_DAY), max(self.daily))
+
+    def summary(self) -> Dict[str, Any]:
+        """Running income and expense totals"""
+        with self._lock:
+            return {
+                "total_income": round(self.totals.income, 2),
+                "total_expenses": round(self.totals.expenses, 2),
+                "net_flow": round(self.totals.income - self.totals.expenses, 2),
+                "transaction_count": self.totals.count,
+                "months_tracked": len(self.monthly)
+            }
+
+    def to_state(self) -> Dict[str, Any]:
+        """
+        Export the buckets as JSON-compatible rows
+
+        Returns:
+            State accepted by ``from_state``
+        """
+        with self._lock:
+            return {
+                "monthly": [[code, category, b.income, b.expenses, b.count]
+                            for code, categories in self.monthly.items()
+                            for category, b in categories.items()],
+                "daily": [[day, b.income, b.expenses, b.count] for day, b in self.daily.items()],
+                "totals": [self.totals.income, self.totals.expenses, self.totals.count],
+                "undated": [self.undated.income, self.undated.expenses, self.undated.count],
+                "latest_timestamp": self.latest_timestamp
+            }
+
+    @classmethod
+    def from_state(cls, state: Dict[str, Any]) -> "TransactionAggregates":
+        """
+        Rebuild aggregates exported by ``to_state`` without rescanning transactions
+
+        Args:
+            state: Exported bucket rows
+
+        Returns:
+            Equivalent TransactionAggregates
+        """
+        def bucket(income: float, expenses: float, count: int) -> _Bucket:
+            result = _Bucket()
+            result.income, result.expenses, result.count = income, expenses, count
+            return result
+
+        aggregates = cls()
+        for code, category, income, expenses, count in state.get("monthly", []):
+            aggregates.monthly.setdefault(code, {})[category] = bucket(income, expenses, count)
+        for day, income, expenses, count in state.get("daily", []):
+            aggregates.daily[day] = bucket(income, expenses, count)
+        aggregates.totals = bucket(*state.get("totals", (0.0, 0.0, 0)))
+        aggregates.undated = bucket(*state.get("undated", (0.0, 0.0, 0)))
+        aggregates.latest_timestamp = state.get("latest_timestamp")
+        return aggregates
+
+    def as_of(self) -> datetime:
+        """Timestamp of the latest dated transaction, or now if there is none"""
+        if self.latest_timestamp is None:
+            return datetime.now(timezone.utc)
+        return datetime.fromtimestamp(self.latest_timestamp, timezone.utc)
+
+
+def month_code_of(moment: datetime) -> int:
+    """Month code (year * 12 + month - 1) for a datetime"""
+    return moment.year * 12 + moment.month - 1
+
+
+def day_number_of(moment: datetime) -> int:
+    """UTC day number for an aware datetime"""
+    return int(moment.timestamp() // SECONDS_PER_DAY)
@@ -3,9 +3,13 @@ AI service for generating natural language responses from financial analysis
 """
 import logging
 import json
-from typing import Dict, Any, Optional
+from typing import Dict, Any, Optional, AsyncIterator
 from datetime import datetime
 
+from .llm_client import generate_text, stream_text, stream_words
+from .response_cache import get_prompt_library, get_response_cache, response_key
+from .retrieval_service import format_headline_figures, format_retrieved_context
+
 logger = logging.getLogger(__name__)
 
 # Try to import Google Generative AI, fallback to mock if not available
@@ -21,6 +25,24 @@ except ImportError:
 class AIService:
     """Service for generating AI-powered financial advice responses"""
     
+    # Instructions following the shared system prompt prefix
+    SYSTEM_INSTRUCTION = """You are an AI-powered financial advisor with expertise in personal finance. Your role is to:
+
+1. Provide clear, concise, and actionable financial advice
+2. Explain complex financial concepts in simple terms
+3. Offer practical recommendations based on the user's financial data
+4. Be encouraging and supportive while being honest about financial realities
+5. Focus on helping users make informed financial decisions
+6. Use a friendly, professional tone
+
+Guidelines:
+- Always base your advice on the provided financial data
+- Be specific with numbers and percentages when available
+- Suggest concrete next steps when appropriate
+- Highlight both positive aspects and areas for improvement
+- Keep responses conversational but informative
+- Avoid giving specific investment advice (stick to general principles)"""
+    
     def __init__(self, api_key: Optional[str] = None):
         """
         Initialize the AI service
@@ -30,6 +52,9 @@ class AIService:
         """
         self.api_key = api_key
         self.model = None
+        self.response_cache = get_response_cache()
+        self.prompt_library = get_prompt_library()
+        self._system_instructions: Dict[str, str] = {}
         self._initialize_model()
     
     def _initialize_model(self):
@@ -60,13 +85,15 @@ class AIService:
             logger.error(f"Failed to initialize AI model: {str(e)}")
             self.model = None
     
-    def generate_response(self, analysis_results: Dict[str, Any], user_query: str) -> str:
+    def generate_response(self, analysis_results: Dict[str, Any], user_query: str,
+                          entities: Optional[Dict[str, Any]] = None) -> str:
         """
         Generate a natural language response from financial analysis results
         
         Args:
             analysis_results: Results from financial analysis services
             user_query: Original user query for context
+            entities: Entities extracted from the query, used in the response cache key
             
         Returns:
             Natural language response from AI model
@@ -78,6 +105,12 @@ class AIService:
             if not self.model:
                 return self._generate_mock_response(analysis_results, user_query)
             
+            # Near-duplicate queries over unchanged data reuse an earlier answer
+            cache_key = response_key("ai_service", analysis_results, entities)
+            cached = self.response_cache.get(cache_key)
+            if cached:
+                return cached
+            
             # Construct the prompt
             prompt = self._construct_prompt(analysis_results, user_query)
             
@@ -86,7 +119,9 @@ class AIService:
             
             if response and response.text:
                 logger.info("AI response generated successfully")
-                return response.text.strip()
+                text = response.text.strip()
+                self.response_cache.put(cache_key, text)
+                return text
             else:
                 logger.warning("Empty response from AI model, using fallback")
                 return self._generate_fallback_response(analysis_results, user_query)
@@ -95,6 +130,88 @@ class AIService:
             logger.error(f"Error generating AI response: {str(e)}")
             return self._generate_fallback_response(analysis_results, user_query)
     
+    async def generate_response_async(self, analysis_results: Dict[str, Any], user_query: str,
+                                      entities: Optional[Dict[str, Any]] = None) -> str:
+        """
+        Generate a response without blocking the event loop
+        
+        Concurrent identical requests share one model call.
+        
+        Args:
+            analysis_results: Results from financial analysis services
+            user_query: Original user query for context
+            entities: Entities extracted from the query, used in the response cache key
+            
+        Returns:
+            Natural language response from AI model
+        """
+        try:
+            if not self.model:
+                return self._generate_mock_response(analysis_results, user_query)
+            
+            text = await self.response_cache.get_or_compute(
+                response_key("ai_service", analysis_results, entities),
+                lambda: generate_text(self.model, self._construct_prompt(analysis_results, user_query)),
+                should_store=bool
+            )
+            
+            if text:
+                logger.info("AI response generated successfully")
+                return text
+            logger.warning("Empty response from AI model, using fallback")
+            return self._generate_fallback_response(analysis_results, user_query)
+            
+        except Exception as e:
+            logger.error(f"Error generating AI response: {str(e)}")
+            return self._generate_fallback_response(analysis_results, user_query)
+    
+    async def stream_response(self, analysis_results: Dict[str, Any], user_query: str,
+                              entities: Optional[Dict[str, Any]] = None) -> AsyncIterator[str]:
+        """
+        Stream a response as it is generated
+        
+        Falls back to the mock or fallback text if the model is unavailable or
+        fails before producing output; a failure mid-stream ends the stream.
+        Cached answers are replayed and complete streams are cached.
+        
+        Args:
+            analysis_results: Results from financial analysis services
+            user_query: Original user query for context
+            entities: Entities extracted from the query, used in the response cache key
+            
+        Yields:
+            Response text pieces in order
+        """
+        if not self.model:
+            async for piece in stream_words(self._generate_mock_response(analysis_results, user_query)):
+                yield piece
+            return
+        
+        cache_key = response_key("ai_service", analysis_results, entities)
+        cached = self.response_cache.get(cache_key)
+        if cached:
+            async for piece in stream_words(cached):
+                yield piece
+            return
+        
+        pieces = []
+        try:
+            prompt = self._construct_prompt(analysis_results, user_query)
+            async for piece in stream_text(self.model, prompt):
+                pieces.append(piece)
+                yield piece
+        except Exception as e:
+            logger.error(f"Error streaming AI response: {str(e)}")
+            if pieces:
+                return
+        else:
+            if pieces:
+                self.response_cache.put(cache_key, "".join(pieces).strip())
+        
+        if not pieces:
+            async for piece in stream_words(self._generate_fallback_response(analysis_results, user_query)):
+                yield piece
+    
     def _construct_prompt(self, analysis_results: Dict[str, Any], user_query: str) -> str:
         """
         Construct a detailed prompt for the AI model
@@ -112,26 +229,17 @@ class AIService:
         results = analysis_results.get("results", {})
         success = analysis_results.get("success", False)
         
-        # Format the analysis data for the prompt
-        analysis_summary = self._format_analysis_summary(results, analysis_type)
+        # Static instructions are assembled once per analysis type
+        system_instruction = self._system_instruction(analysis_type)
         
-        # Construct the system instruction
-        system_instruction = """You are an AI-powered financial advisor with expertise in personal finance. Your role is to:
-
-1. Provide clear, concise, and actionable financial advice
-2. Explain complex financial concepts in simple terms
-3. Offer practical recommendations based on the user's financial data
-4. Be encouraging and supportive while being honest about financial realities
-5. Focus on helping users make informed financial decisions
-6. Use a friendly, professional tone
-
-Guidelines:
-- Always base your advice on the provided financial data
-- Be specific with numbers and percentages when available
-- Suggest concrete next steps when appropriate
-- Highlight both positive aspects and areas for improvement
-- Keep responses conversational but informative
-- Avoid giving specific investment advice (stick to general principles)"""
+        # Nearest examples and transactions, when the chat router retrieved them;
+        # they carry the detail, so the analysis is cut to its headline figures
+        retrieved_context = format_retrieved_context(analysis_results.get("retrieved"))
+        if retrieved_context:
+            retrieved_context = f"\nRELEVANT CONTEXT:\n{retrieved_context}\n"
+            analysis_summary = format_headline_figures(results) or "No analysis data available."
+        else:
+            analysis_summary = self._format_analysis_summary(results, analysis_type)
         
         # Construct the full prompt
         prompt = f"""{system_instruction}
@@ -144,11 +252,20 @@ Analysis Type: {analysis_type}
 Success: {success}
 
 {analysis_summary}
-
+{retrieved_context}
 Please provide a helpful, personalized response to the user's financial query based on the analysis results above. Make it conversational, actionable, and easy to understand."""
 
         return prompt
     
+    def _system_instruction(self, analysis_type: str) -> str:
+        """Shared system prompt prefix plus this service's instructions"""
+        instruction = self._system_instructions.get(analysis_type)
+        if instruction is None:
+            prefix = self.prompt_library.prefix(analysis_type)
+            instruction = f"{prefix}\n\n{self.SYSTEM_INSTRUCTION}" if prefix else self.SYSTEM_INSTRUCTION
+            self._system_instructions[analysis_type] = instruction
+        return instruction
+    
     def _format_analysis_summary(self, results: Dict[str, Any], analysis_type: str) -> str:
         """
         Format analysis results into a readable summary for the AI prompt
@@ -332,5 +449,6 @@ Please provide a helpful, personalized response to the user's financial query ba
             "available": self.is_available(),
             "model_name": "gemini-pro" if self.model else None,
             "provider": "Google Generative AI",
+            "response_cache": self.response_cache.get_stats(),
             "timestamp": datetime.utcnow().isoformat() + "Z"
         }
@@ -0,0 +1,247 @@
+"""
+Fused single-pass analysis kernel
+Scans a transaction list once and produces every aggregate the spending,
+anomaly, forecast and health analyses need, so a full insights run costs one pass
+"""
+import math
+from typing import Dict, Any, List, Optional
+from datetime import datetime, timedelta, timezone
+import logging
+
+from .transaction_store import coerce_amount, get_transaction_columns, month_key
+from .anomaly_engine import zscore_outliers
+
+logger = logging.getLogger(__name__)
+
+
+class _RunningStats:
+    """Welford accumulator for count, mean and sample standard deviation"""
+
+    __slots__ = ("count", "mean", "_m2")
+
+    def __init__(self):
+        self.count = 0
+        self.mean = 0.0
+        self._m2 = 0.0
+
+    def push(self, value: float) -> None:
+        """Add one observation"""
+        self.count += 1
+        delta = value - self.mean
+        self.mean += delta / self.count
+        self._m2 += delta * (value - self.mean)
+
+    @property
+    def stdev(self) -> float:
+        """Sample standard deviation, 0 with fewer than two observations"""
+        return math.sqrt(self._m2 / (self.count - 1)) if self.count > 1 else 0.0
+
+
+class TransactionProfile:
+    """
+    One-scan summary of a transaction list
+
+    Holds everything the downstream analyses read: the column view the
+    anomaly and forecast engines work on, the expense/income partition,
+    per-month flows, and for the analysis window the category totals, amount
+    mean/stdev (fed to the z-score step) and the two trend half-window totals.
+    """
+
+    def __init__(self, transactions: List[Dict[str, Any]], timeframe_days: int = 30,
+                 now: Optional[datetime] = None):
+        """
+        Scan the transactions once and build the profile
+
+        Args:
+            transactions: Transaction records
+            timeframe_days: Length of the spending analysis window in days
+            now: Reference time for the window, defaults to the current UTC time
+        """
+        self.timeframe_days = timeframe_days
+        self.now = now or datetime.now(timezone.utc)
+        self.transaction_count = len(transactions)
+
+        window_start = (self.now - timedelta(days=timeframe_days)).timestamp()
+        trend_split = (self.now - timedelta(days=timeframe_days // 2)).timestamp()
+
+        columns = self.columns = get_transaction_columns(transactions)
+        records = columns.records
+        categories = columns.categories
+
+        self.expenses: List[Dict[str, Any]] = []
+        self.incomes: List[Dict[str, Any]] = []
+        self.window_expenses: List[Dict[str, Any]] = []
+        self.window_amounts: List[float] = []
+        self.window_stats = _RunningStats()
+        self.window_total = 0.0
+        self.recent_total = 0.0
+        self.older_total = 0.0
+        self.total_income = 0.0
+        self.total_expenses = 0.0
+
+        months: Dict[int, List[float]] = {}
+        category_totals: Dict[int, float] = {}
+        category_counts: Dict[int, int] = {}
+
+        # The single pass: every accumulator is fed from the same row
+        for position, (timestamp, month_code, amount, code) in enumerate(zip(
+                columns.timestamps, columns.month_codes, columns.amounts, columns.category_codes)):
+            record = records[position]
+            flows = months.get(month_code)
+            if flows is None:
+                flows = months[month_code] = [0.0, 0.0]
+
+            if amount >= 0:
+                flows[0] += amount
+                self.total_income += amount
+                self.incomes.append(record)
+                continue
+
+            spent = -amount
+            flows[1] += spent
+            self.total_expenses += spent
+            self.expenses.append(record)
+
+            if timestamp < window_start:
+                continue
+
+            self.window_expenses.append(record)
+            self.window_amounts.append(spent)
+            self.window_stats.push(spent)
+            self.window_total += spent
+            category_totals[code] = category_totals.get(code, 0.0) + spent
+            category_counts[code] = category_counts.get(code, 0) + 1
+            if timestamp >= trend_split:
+                self.recent_total += spent
+            else:
+                self.older_total += spent
+
+        # Undated rows cannot fall in a window but still count towards the partition
+        for record in columns.undated_records:
+            amount = coerce_amount(record.get("amount", 0))
+            if amount < 0:
+                self.expenses.append(record)
+                self.total_expenses -= amount
+            else:
+                self.incomes.append(record)
+                self.total_income += amount
+
+        self._months = sorted((code, values[0], values[1]) for code, values in months.items())
+        self._category_totals = {
+            categories[code] if categories[code] is not None else "uncategorized": (total, category_counts[code])
+            for code, total in category_totals.items()
+        }
+
+    @property
+    def window_count(self) -> int:
+        """Number of expenses inside the analysis window"""
+        return self.window_stats.count
+
+    def monthly_flows(self, months_back: Optional[int] = None) -> List[Dict[str, Any]]:
+        """
+        Get income and expense totals per calendar month
+
+        Args:
+            months_back: Keep only the most recent N months with activity
+
+        Returns:
+            Month dictionaries oldest first, shaped like the analyzers' cash flow rows
+        """
+        months = self._months
+        if months_back is not None:
+            months = months[-months_back:] if months_back > 0 else []
+        return [
+            {
+                "month": month_key(code),
+                "income": income,
+                "expenses": expenses,
+                "net_flow": income - expenses
+            }
+            for code, income, expenses in months
+        ]
+
+    def category_breakdown(self) -> Dict[str, Any]:
+        """Spending by category inside the analysis window"""
+        total_spending = sum(total for total, _ in self._category_totals.values())
+
+        breakdown = []
+        for category, (amount, count) in sorted(self._category_totals.items(), key=lambda x: x[1][0], reverse=True):
+            percentage = (amount / total_spending * 100) if total_spending > 0 else 0
+            breakdown.append({
+                "category": category,
+                "amount": round(amount, 2),
+                "percentage": round(percentage, 1),
+                "transaction_count": count,
+                "average_per_transaction": round(amount / count, 2)
+            })
+
+        return {
+            "categories": breakdown,
+            "top_category": breakdown[0]["category"] if breakdown else None,
+            "total_categories": len(breakdown)
+        }
+
+    def spending_trend(self) -> Dict[str, Any]:
+        """Compare daily spending between the two halves of the analysis window"""
+        if self.timeframe_days < 14:
+            return {"trend": "insufficient_data", "change_percentage": 0}
+
+        mid_point = self.timeframe_days // 2
+        recent_daily = self.recent_total / mid_point
+        older_daily = self.older_total / (self.timeframe_days - mid_point)
+
+        if older_daily > 0:
+            change_percentage = ((recent_daily - older_daily) / older_daily) * 100
+        else:
+            change_percentage = 0
+
+        if change_percentage > 10:
+            trend = "increasing"
+        elif change_percentage < -10:
+            trend = "decreasing"
+        else:
+            trend = "stable"
+
+        return {
+            "trend": trend,
+            "change_percentage": round(change_percentage, 1),
+            "recent_daily_average": round(recent_daily, 2),
+            "older_daily_average": round(older_daily, 2)
+        }
+
+    def spending_anomalies(self, threshold_std: float = 2.0) -> List[Dict[str, Any]]:
+        """Flag window expenses whose amount z-score exceeds the threshold"""
+        if self.window_count < 5:  # Need sufficient data
+            return []
+
+        anomalies = []
+        stats = self.window_stats
+        for position, z_score in zscore_outliers(self.window_amounts, threshold_std, stats.mean, stats.stdev):
+            expense = self.window_expenses[position]
+            anomalies.append({
+                "transaction_id": expense.get("id", "unknown"),
+                "description": expense.get("description", "Unknown"),
+                "amount": self.window_amounts[position],
+                "z_score": round(z_score, 2),
+                "date": expense.get("date", ""),
+                "category": expense.get("category", "uncategorized"),
+                "severity": "high" if abs(z_score) > 3 else "medium"
+            })
+
+        return sorted(anomalies, key=lambda x: abs(x["z_score"]), reverse=True)
+
+
+def build_transaction_profile(transactions: List[Dict[str, Any]], timeframe_days: int = 30,
+                              now: Optional[datetime] = None) -> TransactionProfile:
+    """
+    Build the fused profile for a transaction list
+
+    Args:
+        transactions: Transaction records
+        timeframe_days: Length of the spending analysis window in days
+        now: Reference time for the window
+
+    Returns:
+        TransactionProfile shared by every downstream analysis
+    """
+    return TransactionProfile(transactions, timeframe_days, now)
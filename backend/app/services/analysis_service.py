@@ -2,8 +2,9 @@
 Financial analysis service for processing financial data
 Integrates advanced financial algorithms and basic NLP-based analysis
 """
+import inspect
 import logging
-from typing import Dict, List, Any, Optional
+from typing import Dict, List, Any, Optional, Callable
 from datetime import datetime, timedelta
 from dateutil.relativedelta import relativedelta
 import statistics
@@ -19,6 +20,9 @@ except ImportError as e:
     DataValidator = None
     FinancialAnalyzerHelpers = None
 
+from .transaction_store import get_transaction_columns
+from .result_cache import AnalysisCacheScope, cached_analysis, get_analysis_cache
+
 logger = logging.getLogger(__name__)
 
 
@@ -39,9 +43,35 @@ class AnalysisService:
             self.has_advanced_features = False
             logger.warning("Using basic analysis features only")
         
-        # Cache for storing recent analysis results
-        self.analysis_cache = {}
+        # Recent analysis results, shared by every service instance in the process
+        self.result_cache = get_analysis_cache()
+    
+    async def cached_result(self, analysis_type: str, user_id: str, params: Any,
+                            cache_scope: Optional[AnalysisCacheScope], compute: Callable[[], Any]) -> Any:
+        """
+        Get an analysis result from the shared cache, computing it on a miss
         
+        Args:
+            analysis_type: Name of the analysis
+            user_id: User the analysis is for
+            params: Entities or arguments that change the result for the same data
+            cache_scope: Data version and permissions the inputs came from; None disables caching
+            compute: Zero-argument callable returning the result or an awaitable
+            
+        Returns:
+            Analysis result, shared with other callers and not to be mutated
+        """
+        if cache_scope is None:
+            result = compute()
+            return await result if inspect.isawaitable(result) else result
+        
+        key = self.result_cache.make_key(user_id, analysis_type, params, cache_scope)
+        return await self.result_cache.get_or_compute(
+            key, compute,
+            should_store=lambda result: not (isinstance(result, dict) and result.get("error"))
+        )
+    
+    @cached_analysis("advanced_spending", "timeframe_days")
     async def get_advanced_spending_analysis(self, user_id: str, transactions: List[Dict[str, Any]], 
                                            timeframe_days: int = 30) -> Dict[str, Any]:
         """Get advanced spending analysis if available, otherwise fall back to basic"""
@@ -54,13 +84,6 @@ class AnalysisService:
             validated_transactions = await self.data_validator.validate_transactions(transactions)
             result = self.advanced_analyzer.analyze_spending_patterns(validated_transactions, timeframe_days)
             
-            # Cache the result
-            cache_key = f"advanced_spending_{user_id}_{timeframe_days}"
-            self.analysis_cache[cache_key] = {
-                "timestamp": datetime.now(),
-                "data": result
-            }
-            
             return result
             
         except Exception as e:
@@ -68,6 +91,7 @@ class AnalysisService:
             # Fallback to basic analysis
             return self.calculate_spending({"transactions": transactions}, {})
     
+    @cached_analysis("financial_health")
     async def get_financial_health_score(self, user_id: str, accounts: List[Dict[str, Any]], 
                                        liabilities: List[Dict[str, Any]], 
                                        transactions: List[Dict[str, Any]], 
@@ -96,6 +120,36 @@ class AnalysisService:
             logger.error(f"Financial health calculation failed: {e}")
             return {"error": str(e), "score": 0}
     
+    @cached_analysis("comprehensive_insights", "timeframe_days")
+    async def get_comprehensive_insights(self, user_id: str, accounts: List[Dict[str, Any]], 
+                                       liabilities: List[Dict[str, Any]], 
+                                       transactions: List[Dict[str, Any]], 
+                                       investments: List[Dict[str, Any]] = None, 
+                                       timeframe_days: int = 30) -> Dict[str, Any]:
+        """Run every transaction analysis over one validated list and one shared scan"""
+        if not self.has_advanced_features:
+            return {"error": "Advanced insights not available", "analysis_type": "comprehensive_insights"}
+        
+        try:
+            validated_accounts = await self.data_validator.validate_accounts(accounts)
+            validated_liabilities = await self.data_validator.validate_liabilities(liabilities)
+            validated_transactions = await self.data_validator.validate_transactions(transactions)
+            
+            if investments:
+                validated_investments = await self.data_validator.validate_investments(investments)
+            else:
+                validated_investments = []
+            
+            return self.advanced_analyzer.generate_comprehensive_insights(
+                validated_accounts, validated_liabilities, validated_transactions,
+                validated_investments, timeframe_days
+            )
+            
+        except Exception as e:
+            logger.error(f"Comprehensive insights failed: {e}")
+            return {"error": str(e), "analysis_type": "comprehensive_insights"}
+    
+    @cached_analysis("balance_forecast", "months_ahead")
     async def get_balance_forecast(self, user_id: str, accounts: List[Dict[str, Any]], 
                                  transactions: List[Dict[str, Any]], 
                                  months_ahead: int = 6) -> Dict[str, Any]:
@@ -119,6 +173,7 @@ class AnalysisService:
             # Fallback to basic projection
             return self.project_savings({"transactions": transactions, "accounts": accounts}, {})
     
+    @cached_analysis("anomalies")
     async def detect_anomalies(self, user_id: str, transactions: List[Dict[str, Any]]) -> Dict[str, Any]:
         """Detect financial anomalies using advanced analysis"""
         if not self.has_advanced_features:
@@ -134,6 +189,7 @@ class AnalysisService:
             logger.error(f"Anomaly detection failed: {e}")
             return {"error": str(e), "anomalies": []}
     
+    @cached_analysis("purchase_affordability", "purchase_amount", "target_item")
     async def analyze_purchase_affordability(self, user_id: str, accounts: List[Dict[str, Any]], 
                                            transactions: List[Dict[str, Any]], 
                                            liabilities: List[Dict[str, Any]],
@@ -167,6 +223,7 @@ class AnalysisService:
                 {"transactions": transactions, "accounts": accounts}, entities
             )
     
+    @cached_analysis("debt_strategy", "strategy_type")
     async def suggest_debt_strategy(self, user_id: str, liabilities: List[Dict[str, Any]], 
                                   transactions: List[Dict[str, Any]],
                                   strategy_type: str = "avalanche") -> Dict[str, Any]:
@@ -204,6 +261,14 @@ class AnalysisService:
                 "strategy_type": strategy_type
             }
     
+    def portfolio_price_revision(self, user_id: str) -> int:
+        """Price ticks applied to a user's live portfolio, so cached valuations follow prices"""
+        if not self.has_advanced_features:
+            return 0
+        return self.advanced_analyzer.portfolio_engine.price_revision(user_id)
+    
+    @cached_analysis("investment_portfolio", "risk_profile",
+                     revision=lambda service, user_id: service.portfolio_price_revision(user_id))
     async def analyze_investment_portfolio(self, user_id: str, investments: List[Dict[str, Any]], 
                                          risk_profile: str = "moderate") -> Dict[str, Any]:
         """Analyze investment portfolio"""
@@ -212,7 +277,9 @@ class AnalysisService:
         
         try:
             validated_investments = await self.data_validator.validate_investments(investments)
-            result = self.advanced_analyzer.analyze_investment_portfolio(validated_investments, risk_profile)
+            result = self.advanced_analyzer.analyze_investment_portfolio(
+                validated_investments, risk_profile, portfolio_id=user_id
+            )
             
             return result
             
@@ -220,6 +287,7 @@ class AnalysisService:
             logger.error(f"Portfolio analysis failed: {e}")
             return {"error": str(e), "total_value": 0}
     
+    @cached_analysis("budget_performance", "budget")
     async def analyze_budget_performance(self, user_id: str, transactions: List[Dict[str, Any]], 
                                        budget: Dict[str, Any]) -> Dict[str, Any]:
         """Analyze budget performance against actual spending"""
@@ -305,34 +373,7 @@ class AnalysisService:
     def _analyze_monthly_cash_flow(self, transactions: List[Dict[str, Any]], 
                                  months_back: int) -> List[Dict[str, Any]]:
         """Analyze monthly cash flow patterns - helper method"""
-        from collections import defaultdict
-        monthly_data = defaultdict(lambda: {"income": 0, "expenses": 0})
-        
-        for transaction in transactions:
-            try:
-                trans_date = datetime.fromisoformat(transaction.get("date", "").replace('Z', '+00:00'))
-                month_key = trans_date.strftime("%Y-%m")
-                amount = transaction.get("amount", 0)
-                
-                if amount > 0:
-                    monthly_data[month_key]["income"] += amount
-                else:
-                    monthly_data[month_key]["expenses"] += abs(amount)
-            except (ValueError, TypeError):
-                continue
-        
-        # Get last N months
-        result = []
-        for month_key in sorted(monthly_data.keys())[-months_back:]:
-            data = monthly_data[month_key]
-            result.append({
-                "month": month_key,
-                "income": data["income"],
-                "expenses": data["expenses"],
-                "net_flow": data["income"] - data["expenses"]
-            })
-        
-        return result
+        return get_transaction_columns(transactions).monthly_flows(months_back)
     
     def calculate_spending(self, data: Dict[str, Any], entities: Dict[str, Any]) -> Dict[str, Any]:
         """
@@ -0,0 +1,509 @@
+"""
+Vectorized anomaly detection engine
+Runs amount, merchant, category and temporal anomaly checks as array operations
+over the columnar transaction store, with a rolling mode for single new transactions
+"""
+import math
+import statistics
+import threading
+from collections import deque
+from typing import Dict, Any, List, Optional, Sequence, Tuple
+import logging
+
+try:
+    import numpy as np
+except ImportError:  # NumPy is optional; fall back to the pure Python helpers
+    np = None
+
+from .transaction_store import TransactionColumns, coerce_amount, get_transaction_columns, month_key
+from .financial_analyzer_helpers import FinancialAnalyzerHelpers
+
+logger = logging.getLogger(__name__)
+
+SECONDS_PER_DAY = 86400
+
+
+def zscore_outliers(values: Sequence[float], threshold_std: float = 2.0,
+                    mean: Optional[float] = None, stdev: Optional[float] = None) -> List[Tuple[int, float]]:
+    """
+    Find values whose sample z-score magnitude exceeds the threshold
+
+    Args:
+        values: Observations to score
+        threshold_std: Absolute z-score above which a value is an outlier
+        mean: Mean of the values when the caller already accumulated it
+        stdev: Sample standard deviation of the values, with ``mean``
+
+    Returns:
+        (position, z_score) pairs in input order
+    """
+    if len(values) < 2:
+        return []
+
+    if np is None or (mean is not None and stdev is not None):
+        mean_value = statistics.mean(values) if mean is None or stdev is None else mean
+        std_value = statistics.stdev(values) if mean is None or stdev is None else stdev
+        if std_value <= 0:
+            return []
+        return [
+            (position, (value - mean_value) / std_value)
+            for position, value in enumerate(values)
+            if abs((value - mean_value) / std_value) > threshold_std
+        ]
+
+    data = np.asarray(values, dtype=np.float64)
+    std_value = data.std(ddof=1)
+    if not std_value > 0:
+        return []
+    z_scores = (data - data.mean()) / std_value
+    positions = np.flatnonzero(np.abs(z_scores) > threshold_std)
+    return [(int(p), float(z_scores[p])) for p in positions]
+
+
+class _Frame:
+    """NumPy arrays for one TransactionColumns, dated rows first then undated"""
+
+    def __init__(self, columns: TransactionColumns):
+        self.columns = columns
+        self.rows = columns.records + columns.undated_records
+        self.dated_count = len(columns.records)
+
+        undated_amounts = [coerce_amount(record.get("amount", 0)) for record in columns.undated_records]
+        self.amounts = np.concatenate([
+            np.asarray(columns.amounts, dtype=np.float64),
+            np.asarray(undated_amounts, dtype=np.float64)
+        ])
+        self.month_codes = np.asarray(columns.month_codes, dtype=np.int64)
+        self.category_codes = np.asarray(columns.category_codes, dtype=np.int64)
+        self.local_times = np.asarray(columns.local_times, dtype=np.float64)
+
+        # Merchant names are the one per-row field that has to be interned in Python
+        self.merchants: List[Any] = []
+        merchant_lookup: Dict[Any, int] = {}
+        codes = []
+        for record in self.rows:
+            merchant = record.get("merchant", record.get("description", "Unknown"))
+            code = merchant_lookup.get(merchant)
+            if code is None:
+                code = merchant_lookup[merchant] = len(self.merchants)
+                self.merchants.append(merchant)
+            codes.append(code)
+        self.merchant_codes = np.asarray(codes, dtype=np.int64)
+
+        self.expense_mask = self.amounts < 0
+
+
+class AnomalyEngine:
+    """
+    Batch anomaly detection over columnar transactions
+
+    Produces the same anomaly records as the FinancialAnalyzerHelpers
+    detectors, but each detector is a few array reductions (bincount,
+    unique, masked z-scores) instead of a Python loop over dictionaries.
+    Without NumPy it delegates to those helpers unchanged.
+    """
+
+    def __init__(self):
+        """Initialize the engine"""
+        self._lock = threading.Lock()
+        self._frame: Optional[_Frame] = None
+
+    @property
+    def vectorized(self) -> bool:
+        """Whether the NumPy backend is available"""
+        return np is not None
+
+    def detect(self, transactions: List[Dict[str, Any]], threshold_std: float = 2.0) -> List[Dict[str, Any]]:
+        """
+        Run every anomaly detector over a transaction list
+
+        Args:
+            transactions: Transaction history
+            threshold_std: Standard deviation threshold for amount anomalies
+
+        Returns:
+            Unscored anomalies: expense amounts, income amounts, merchant,
+            category and temporal anomalies, in that order
+        """
+        return self.detect_columns(get_transaction_columns(transactions), threshold_std)
+
+    def detect_columns(self, columns: TransactionColumns, threshold_std: float = 2.0) -> List[Dict[str, Any]]:
+        """
+        Run every anomaly detector over an already built column set
+
+        Args:
+            columns: Columnar view of the transactions, e.g. a profile's
+            threshold_std: Standard deviation threshold for amount anomalies
+
+        Returns:
+            Unscored anomalies, as ``detect``
+        """
+        if np is None:
+            # The helpers read raw amounts; hand them coerced copies of bad rows
+            expenses, incomes = [], []
+            for record in columns.records + columns.undated_records:
+                raw = record.get("amount", 0)
+                amount = coerce_amount(raw)
+                if not isinstance(raw, (int, float)):
+                    record = {**record, "amount": amount}
+                (expenses if amount < 0 else incomes).append(record)
+            return (FinancialAnalyzerHelpers.detect_amount_anomalies(expenses, threshold_std) +
+                    FinancialAnalyzerHelpers.detect_amount_anomalies(incomes, threshold_std) +
+                    FinancialAnalyzerHelpers.detect_merchant_anomalies(expenses) +
+                    FinancialAnalyzerHelpers.detect_category_anomalies(expenses) +
+                    FinancialAnalyzerHelpers.detect_temporal_anomalies(expenses))
+
+        frame = self._frame_for(columns)
+        expense_rows = np.flatnonzero(frame.expense_mask)
+        income_rows = np.flatnonzero(~frame.expense_mask)
+
+        return (self._amount_anomalies(frame, expense_rows, threshold_std) +
+                self._amount_anomalies(frame, income_rows, threshold_std) +
+                self._merchant_anomalies(frame, expense_rows) +
+                self._category_anomalies(frame, expense_rows) +
+                self._temporal_anomalies(frame, expense_rows))
+
+    def spending_anomalies(self, expenses: List[Dict[str, Any]], threshold_std: float = 2.0) -> List[Dict[str, Any]]:
+        """
+        Flag expenses whose amount z-score exceeds the threshold
+
+        Args:
+            expenses: Expense transactions
+            threshold_std: Standard deviation threshold
+
+        Returns:
+            Anomalies sorted by z-score magnitude
+        """
+        if len(expenses) < 5:  # Need sufficient data
+            return []
+
+        amounts = [abs(coerce_amount(expense.get("amount", 0))) for expense in expenses]
+        anomalies = [
+            _amount_record(expenses[position], amounts[position], z_score)
+            for position, z_score in zscore_outliers(amounts, threshold_std)
+        ]
+        return sorted(anomalies, key=lambda x: abs(x["z_score"]), reverse=True)
+
+    def _frame_for(self, columns: TransactionColumns) -> _Frame:
+        """Get the array frame for a column set, reusing the last one built"""
+        with self._lock:
+            frame = self._frame
+            if frame is not None and frame.columns is columns:
+                return frame
+        frame = _Frame(columns)
+        with self._lock:
+            self._frame = frame
+        return frame
+
+    def _amount_anomalies(self, frame: _Frame, rows: "np.ndarray", threshold_std: float) -> List[Dict[str, Any]]:
+        """Z-score outliers on absolute amount within a row subset"""
+        if rows.size < 5:
+            return []
+
+        amounts = np.abs(frame.amounts[rows])
+        std_amount = amounts.std(ddof=1)
+        if not std_amount > 0:
+            return []
+
+        z_scores = (amounts - amounts.mean()) / std_amount
+        hits = np.flatnonzero(np.abs(z_scores) > threshold_std)
+
+        anomalies = []
+        for hit in hits:
+            record = _amount_record(frame.rows[rows[hit]], float(amounts[hit]), float(z_scores[hit]))
+            record["type"] = "amount_anomaly"
+            anomalies.append(record)
+        return anomalies
+
+    def _merchant_anomalies(self, frame: _Frame, rows: "np.ndarray") -> List[Dict[str, Any]]:
+        """Merchants whose transaction count is more than two deviations above the mean"""
+        if rows.size == 0:
+            return []
+
+        # Re-number merchants present in the subset, keeping first-appearance order
+        present, first_seen, inverse = np.unique(frame.merchant_codes[rows], return_index=True, return_inverse=True)
+        order = np.argsort(first_seen, kind="stable")
+        rank = np.empty_like(order)
+        rank[order] = np.arange(order.size)
+        local = rank[inverse]
+        merchant_codes = present[order]
+
+        counts = np.bincount(local, minlength=merchant_codes.size)
+        if counts.size < 2:
+            return []
+        std_frequency = counts.std(ddof=1)
+        if not std_frequency > 0:
+            return []
+
+        totals = np.bincount(local, weights=np.abs(frame.amounts[rows]), minlength=merchant_codes.size)
+        z_scores = (counts - counts.mean()) / std_frequency
+
+        anomalies = []
+        for index in np.flatnonzero(z_scores > 2)[:10]:  # Limit to top 10
+            merchant = frame.merchants[merchant_codes[index]]
+            count = int(counts[index])
+            anomalies.append({
+                "merchant": merchant,
+                "transaction_count": count,
+                "average_amount": round(float(totals[index]) / count, 2),
+                "total_amount": round(float(totals[index]), 2),
+                "z_score": round(float(z_scores[index]), 2),
+                "type": "merchant_frequency_anomaly",
+                "severity": "medium",
+                "description": f"Unusually high activity with {merchant}"
+            })
+        return anomalies
+
+    def _category_anomalies(self, frame: _Frame, rows: "np.ndarray") -> List[Dict[str, Any]]:
+        """Category-months whose total deviates more than 1.5 deviations from that category's mean"""
+        dated = rows[rows < frame.dated_count]
+        if dated.size == 0:
+            return []
+
+        categories = frame.category_codes[dated]
+        months = frame.month_codes[dated]
+        min_month = months.min()
+        span = int(months.max() - min_month) + 1
+
+        # One cell per (category, month); totals via a single weighted bincount
+        cells, inverse = np.unique(categories * span + (months - min_month), return_inverse=True)
+        cell_totals = np.bincount(inverse, weights=np.abs(frame.amounts[dated]))
+        cell_categories = cells // span
+        cell_months = cells % span + min_month
+
+        category_ids, cell_group = np.unique(cell_categories, return_inverse=True)
+        month_counts = np.bincount(cell_group)
+        means = np.bincount(cell_group, weights=cell_totals) / month_counts
+        deviations = cell_totals - means[cell_group]
+        squares = np.bincount(cell_group, weights=deviations * deviations)
+
+        # Categories seen in fewer than two months have no baseline
+        stds = np.zeros_like(means)
+        baseline = month_counts > 1
+        stds[baseline] = np.sqrt(squares[baseline] / (month_counts[baseline] - 1))
+
+        cell_stds = stds[cell_group]
+        valid = cell_stds > 0
+        z_scores = np.zeros_like(cell_totals)
+        z_scores[valid] = deviations[valid] / cell_stds[valid]
+        hits = np.flatnonzero(valid & (np.abs(z_scores) > 1.5))
+        hits = hits[np.argsort(-np.abs(z_scores[hits]), kind="stable")][:10]
+
+        names = frame.columns.categories
+        anomalies = []
+        for hit in hits:
+            name = names[category_ids[cell_group[hit]]]
+            category = name if name is not None else "uncategorized"
+            month = month_key(int(cell_months[hit]))
+            anomalies.append({
+                "category": category,
+                "month": month,
+                "amount": round(float(cell_totals[hit]), 2),
+                "average_amount": round(float(means[cell_group[hit]]), 2),
+                "z_score": round(float(z_scores[hit]), 2),
+                "type": "category_spending_anomaly",
+                "severity": "low",
+                "description": f"Unusual {category} spending in {month}"
+            })
+        return anomalies
+
+    def _temporal_anomalies(self, frame: _Frame, rows: "np.ndarray") -> List[Dict[str, Any]]:
+        """Flag a high share of spending between 10 PM and 6 AM local time"""
+        dated = rows[rows < frame.dated_count]
+        if dated.size == 0:
+            return []
+
+        hours = (np.mod(frame.local_times[dated], SECONDS_PER_DAY) // 3600).astype(np.int64)
+        night = (hours >= 22) | (hours < 6)
+        night_count = int(night.sum())
+        day_count = int(dated.size - night_count)
+
+        if night_count and night_count > day_count * 0.3:  # More than 30% night spending
+            return [{
+                "type": "temporal_anomaly",
+                "pattern": "high_night_spending",
+                "night_transaction_count": night_count,
+                "total_night_amount": round(float(np.abs(frame.amounts[dated][night]).sum()), 2),
+                "severity": "medium",
+                "description": "Unusually high nighttime spending detected"
+            }]
+        return []
+
+
+def _amount_record(transaction: Dict[str, Any], amount: float, z_score: float) -> Dict[str, Any]:
+    """Build the anomaly record for one flagged transaction amount"""
+    return {
+        "transaction_id": transaction.get("id", "unknown"),
+        "description": transaction.get("description", "Unknown"),
+        "amount": amount,
+        "z_score": round(z_score, 2),
+        "date": transaction.get("date", ""),
+        "category": transaction.get("category", "uncategorized"),
+        "severity": "high" if abs(z_score) > 3 else "medium"
+    }
+
+
+class _RollingWindow:
+    """Fixed-size window of recent amounts with a Welford running mean and variance"""
+
+    __slots__ = ("values", "mean", "_m2")
+
+    def __init__(self, size: int):
+        self.values = deque(maxlen=size)
+        self.mean = 0.0
+        self._m2 = 0.0
+
+    def push(self, value: float) -> None:
+        """Add a value, evicting the oldest once the window is full"""
+        if len(self.values) == self.values.maxlen:
+            self._remove(self.values.popleft())
+        self.values.append(value)
+        delta = value - self.mean
+        self.mean += delta / len(self.values)
+        self._m2 += delta * (value - self.mean)
+
+    def _remove(self, value: float) -> None:
+        """Take an evicted value back out of the running moments"""
+        count = len(self.values)
+        if count == 0:
+            self.mean = self._m2 = 0.0
+            return
+        delta = value - self.mean
+        self.mean -= delta / count
+        self._m2 = max(0.0, self._m2 - delta * (value - self.mean))
+
+    def z_score(self, value: float) -> Optional[float]:
+        """Sample z-score of a value against the window, None without a baseline"""
+        count = len(self.values)
+        if count < 2:
+            return None
+        std = math.sqrt(self._m2 / (count - 1))
+        return (value - self.mean) / std if std > 0 else None
+
+
+class RollingAnomalyDetector:
+    """
+    Streaming anomaly detection for transactions as they arrive
+
+    Scores each new transaction against rolling baselines of recent amounts,
+    overall and per category (kept separately for income and expenses), and
+    then adds it to those baselines. Each call is O(1). Attached to a data
+    store, the baselines follow its transaction writes from any source.
+    """
+
+    def __init__(self, window: int = 500, threshold_std: float = 2.0, min_history: int = 5):
+        """
+        Initialize the detector
+
+        Args:
+            window: Number of recent amounts kept per baseline
+            threshold_std: Absolute z-score above which a transaction is flagged
+            min_history: Observations a baseline needs before it can flag
+        """
+        self.window = window
+        self.threshold_std = threshold_std
+        self.min_history = min_history
+        self.seeded = False
+        self._lock = threading.Lock()
+        self._overall: Dict[bool, _RollingWindow] = {}
+        self._categories: Dict[Tuple[bool, Any], _RollingWindow] = {}
+
+    def seed(self, transactions: List[Dict[str, Any]]) -> None:
+        """Feed history into the baselines without flagging, oldest first"""
+        columns = get_transaction_columns(transactions)
+        with self._lock:
+            for transaction in columns.records:
+                self._push(transaction)
+            self.seeded = True
+
+    def attach(self, store: Any) -> None:
+        """
+        Keep the baselines in step with a data store
+
+        Added transactions are pushed as the store publishes them. Updates,
+        deletes and reloads cannot be taken back out of a rolling window, so
+        they mark the detector unseeded and the caller seeds it again from
+        the next snapshot.
+
+        Args:
+            store: DataStore whose versions to follow
+        """
+        store.add_listener(self._on_version)
+
+    def _on_version(self, version: int, categories: Optional[List[str]],
+                    change: Optional[Dict[str, Any]]) -> None:
+        """Data store listener; runs with the store lock held"""
+        if categories is not None and "transactions" not in categories:
+            return
+        with self._lock:
+            if not self.seeded:
+                return  # The next seed reads this version
+            if change is not None and "added" in change:
+                self._push(change["added"])
+            else:
+                self.seeded = False
+                self._overall.clear()
+                self._categories.clear()
+
+    def observe(self, transaction: Dict[str, Any]) -> Optional[Dict[str, Any]]:
+        """
+        Score a new transaction, then add it to the baselines
+
+        Args:
+            transaction: Newly arrived transaction
+
+        Returns:
+            Anomaly record if the amount is unusual, otherwise None
+        """
+        return self.score(transaction, add=True)
+
+    def score(self, transaction: Dict[str, Any], add: bool = False) -> Optional[Dict[str, Any]]:
+        """
+        Score a new transaction against the baselines
+
+        Args:
+            transaction: Newly arrived transaction
+            add: Also add it to the baselines; leave False when an attached
+                store will add it once written
+
+        Returns:
+            Anomaly record if the amount is unusual, otherwise None
+        """
+        amount = coerce_amount(transaction.get("amount", 0))
+        is_expense = amount < 0
+        value = abs(amount)
+        category = transaction.get("category", "uncategorized")
+
+        with self._lock:
+            overall = self._overall.get(is_expense)
+            by_category = self._categories.get((is_expense, category))
+            overall_z = overall.z_score(value) if overall and len(overall.values) >= self.min_history else None
+            category_z = (by_category.z_score(value)
+                          if by_category and len(by_category.values) >= self.min_history else None)
+            if add:
+                self._push(transaction)
+
+        scores = [z for z in (overall_z, category_z) if z is not None and abs(z) > self.threshold_std]
+        if not scores:
+            return None
+
+        z_score = max(scores, key=abs)
+        record = _amount_record(transaction, value, z_score)
+        record["type"] = "amount_anomaly" if z_score == overall_z else "category_amount_anomaly"
+        return record
+
+    def _push(self, transaction: Dict[str, Any]) -> None:
+        """Add a transaction to its baselines (lock held)"""
+        amount = coerce_amount(transaction.get("amount", 0))
+        is_expense = amount < 0
+        category = transaction.get("category", "uncategorized")
+
+        overall = self._overall.get(is_expense)
+        if overall is None:
+            overall = self._overall[is_expense] = _RollingWindow(self.window)
+        by_category = self._categories.get((is_expense, category))
+        if by_category is None:
+            by_category = self._categories[(is_expense, category)] = _RollingWindow(self.window)
+
+        overall.push(abs(amount))
+        by_category.push(abs(amount))
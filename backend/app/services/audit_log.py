@@ -0,0 +1,304 @@
+"""
+Background audit log writer with an indexed on-disk store
+Audit records are queued without blocking the caller and drained by a single
+writer thread in size- or time-bounded batches into daily JSONL files owned by
+one process each; a shared SQLite index of (user, time, file offset) lets audit queries page by user and
+time range without holding the trail in memory
+"""
+import json
+import os
+import queue
+import sqlite3
+import threading
+import time
+import weakref
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import Dict, Any, List, Optional, Iterable, Tuple
+import logging
+
+logger = logging.getLogger(__name__)
+
+INDEX_FILE = "audit_index.sqlite"
+
+# Queue markers: a threading.Event asks for a flush, _CLOSE stops the writer
+_CLOSE = object()
+
+
+def _epoch(value: datetime) -> float:
+    """Epoch seconds of a timestamp; naive timestamps are taken as UTC"""
+    if value.tzinfo is None:
+        value = value.replace(tzinfo=timezone.utc)
+    return value.timestamp()
+
+
+class AuditLogWriter:
+    """
+    Append-only audit log drained by one background thread
+
+    ``submit`` only enqueues; the writer thread flushes once ``batch_size``
+    records are pending or the oldest pending record is ``flush_interval``
+    seconds old. Records go to ``audit_<day>_<pid>.jsonl`` for the UTC day of
+    their timestamp and are indexed by user, time, action and accessed
+    categories. Each worker process appends only to its own files, so the file
+    offsets it indexes are never shifted by another worker's appends.
+    """
+
+    def __init__(self, storage_path: str, batch_size: int = 100, flush_interval: float = 1.0):
+        """
+        Open the log directory and start the writer thread
+
+        Args:
+            storage_path: Directory holding the daily logs and the index
+            batch_size: Pending records that force a write
+            flush_interval: Longest time a record waits before being written
+        """
+        self.storage_path = Path(storage_path)
+        self.storage_path.mkdir(parents=True, exist_ok=True)
+        self.batch_size = max(1, batch_size)
+        self.flush_interval = flush_interval
+        self._queue: "queue.SimpleQueue[Any]" = queue.SimpleQueue()
+        self._lock = threading.Lock()
+        self._conn = sqlite3.connect(str(self.storage_path / INDEX_FILE), check_same_thread=False,
+                                     isolation_level=None)
+        self._conn.execute("PRAGMA journal_mode=WAL")
+        self._conn.execute("PRAGMA synchronous=NORMAL")
+        self._conn.execute(
+            "CREATE TABLE IF NOT EXISTS audit_index ("
+            " user_id TEXT NOT NULL, ts REAL NOT NULL, action TEXT NOT NULL,"
+            " file TEXT NOT NULL, offset INTEGER NOT NULL, length INTEGER NOT NULL)"
+        )
+        self._conn.execute("CREATE INDEX IF NOT EXISTS audit_index_user ON audit_index (user_id, ts)")
+        self._conn.execute(
+            "CREATE TABLE IF NOT EXISTS audit_categories ("
+            " user_id TEXT NOT NULL, category_id TEXT NOT NULL, PRIMARY KEY (user_id, category_id))"
+        )
+        self._stats = {"submitted": 0, "written": 0, "failed": 0, "batches": 0}
+        self._closed = False
+        self._thread = threading.Thread(target=self._run, name="audit-writer", daemon=True)
+        self._thread.start()
+        _writers.add(self)
+
+    def submit(self, record: Dict[str, Any]) -> None:
+        """
+        Queue one audit record for writing
+
+        Args:
+            record: JSON-serializable record with user_id, action and an ISO
+                timestamp; ``categories`` lists the data categories it covers
+        """
+        if self._closed:
+            raise RuntimeError("Audit log is closed")
+        self._stats["submitted"] += 1
+        self._queue.put(record)
+
+    def flush(self, timeout: Optional[float] = None) -> bool:
+        """
+        Block until every record submitted so far is written and indexed
+
+        Returns:
+            True if the writer caught up within ``timeout``
+        """
+        if self._closed:
+            return True
+        done = threading.Event()
+        self._queue.put(done)
+        return done.wait(timeout)
+
+    def close(self) -> None:
+        """Write pending records, stop the writer thread and close the index"""
+        if self._closed:
+            return
+        self._queue.put(_CLOSE)
+        self._thread.join()
+        self._closed = True
+        with self._lock:
+            self._conn.close()
+
+    def _run(self) -> None:
+        pending: List[Dict[str, Any]] = []
+        deadline = None
+        while True:
+            timeout = None if deadline is None else max(0.0, deadline - time.monotonic())
+            try:
+                item = self._queue.get(timeout=timeout)
+            except queue.Empty:
+                item = None
+
+            if isinstance(item, dict):
+                pending.append(item)
+                if deadline is None:
+                    deadline = time.monotonic() + self.flush_interval
+                if len(pending) < self.batch_size:
+                    continue
+
+            if pending:
+                self._write_batch(pending)
+                pending = []
+            deadline = None
+
+            if isinstance(item, threading.Event):
+                item.set()
+            elif item is _CLOSE:
+                return
+
+    def _write_batch(self, records: List[Dict[str, Any]]) -> None:
+        """Append records to their daily files, then index them in one transaction"""
+        by_file: Dict[str, List[Dict[str, Any]]] = {}
+        pid = os.getpid()
+        for record in records:
+            by_file.setdefault(f"audit_{record['timestamp'][:10]}_{pid}.jsonl", []).append(record)
+
+        rows = []
+        categories = set()
+        try:
+            for name, batch in by_file.items():
+                with open(self.storage_path / name, "ab") as f:
+                    offset = f.tell()
+                    lines = []
+                    for record in batch:
+                        line = json.dumps(record, default=str).encode("utf-8") + b"\n"
+                        lines.append(line)
+                        rows.append((record["user_id"], _epoch(datetime.fromisoformat(record["timestamp"])),
+                                     record["action"], name, offset, len(line)))
+                        offset += len(line)
+                        for category_id in record.get("categories") or ():
+                            categories.add((record["user_id"], category_id))
+                    f.write(b"".join(lines))
+
+            with self._lock:
+                try:
+                    self._conn.execute("BEGIN IMMEDIATE")
+                    self._conn.executemany("INSERT INTO audit_index VALUES (?, ?, ?, ?, ?, ?)", rows)
+                    self._conn.executemany("INSERT OR IGNORE INTO audit_categories VALUES (?, ?)", categories)
+                    self._conn.execute("COMMIT")
+                except sqlite3.Error:
+                    if self._conn.in_transaction:
+                        self._conn.execute("ROLLBACK")
+                    raise
+        except (OSError, sqlite3.Error, ValueError, KeyError) as e:
+            self._stats["failed"] += len(records)
+            logger.error(f"Failed to write {len(records)} audit records: {str(e)}")
+            return
+
+        self._stats["written"] += len(records)
+        self._stats["batches"] += 1
+        logger.debug(f"Wrote {len(records)} audit records to {', '.join(by_file)}")
+
+    def query(self, user_id: str, limit: int = 100, offset: int = 0,
+              actions: Optional[Iterable[str]] = None, since: Optional[datetime] = None,
+              until: Optional[datetime] = None) -> List[Dict[str, Any]]:
+        """
+        Page through one user's written records, newest first
+
+        Args:
+            user_id: User identifier
+            limit: Maximum records returned
+            offset: Records skipped from the newest matching one
+            actions: Only return these action values
+            since: Earliest timestamp, inclusive
+            until: Latest timestamp, inclusive
+
+        Returns:
+            Audit records as written
+        """
+        sql, params = self._where(user_id, actions, since, until)
+        with self._lock:
+            locations = self._conn.execute(
+                f"SELECT file, offset, length FROM audit_index WHERE {sql}"
+                " ORDER BY ts DESC, rowid DESC LIMIT ? OFFSET ?", params + [limit, offset]
+            ).fetchall()
+        return self._read(locations)
+
+    def count(self, user_id: str, actions: Optional[Iterable[str]] = None,
+              since: Optional[datetime] = None, until: Optional[datetime] = None) -> int:
+        """Number of written records matching a query"""
+        sql, params = self._where(user_id, actions, since, until)
+        with self._lock:
+            return self._conn.execute(f"SELECT COUNT(*) FROM audit_index WHERE {sql}", params).fetchone()[0]
+
+    def summary(self, user_id: str) -> Dict[str, Any]:
+        """
+        Aggregate a user's written records from the index alone
+
+        Returns:
+            Total count, per-action counts, last timestamp and accessed categories
+        """
+        with self._lock:
+            actions = dict(self._conn.execute(
+                "SELECT action, COUNT(*) FROM audit_index WHERE user_id = ? GROUP BY action", (user_id,)
+            ).fetchall())
+            last_ts = self._conn.execute(
+                "SELECT MAX(ts) FROM audit_index WHERE user_id = ?", (user_id,)
+            ).fetchone()[0]
+            categories = [row[0] for row in self._conn.execute(
+                "SELECT category_id FROM audit_categories WHERE user_id = ? ORDER BY category_id", (user_id,)
+            )]
+        return {
+            "total_entries": sum(actions.values()),
+            "actions": actions,
+            "last_entry": datetime.fromtimestamp(last_ts, timezone.utc) if last_ts is not None else None,
+            "categories_accessed": categories
+        }
+
+    @staticmethod
+    def _where(user_id: str, actions: Optional[Iterable[str]], since: Optional[datetime],
+               until: Optional[datetime]) -> Tuple[str, List[Any]]:
+        clauses, params = ["user_id = ?"], [user_id]
+        if actions:
+            actions = list(actions)
+            clauses.append(f"action IN ({', '.join('?' * len(actions))})")
+            params.extend(actions)
+        if since is not None:
+            clauses.append("ts >= ?")
+            params.append(_epoch(since))
+        if until is not None:
+            clauses.append("ts <= ?")
+            params.append(_epoch(until))
+        return " AND ".join(clauses), params
+
+    def _read(self, locations: List[Tuple[str, int, int]]) -> List[Dict[str, Any]]:
+        """Read indexed records, opening each daily file once"""
+        records: List[Optional[Dict[str, Any]]] = [None] * len(locations)
+        by_file: Dict[str, List[Tuple[int, int, int]]] = {}
+        for position, (name, offset, length) in enumerate(locations):
+            by_file.setdefault(name, []).append((offset, length, position))
+
+        for name, spans in by_file.items():
+            try:
+                with open(self.storage_path / name, "rb") as f:
+                    for offset, length, position in sorted(spans):
+                        f.seek(offset)
+                        records[position] = json.loads(f.read(length))
+            except (OSError, ValueError) as e:
+                logger.warning(f"Unreadable audit records in {name}: {str(e)}")
+        return [record for record in records if record is not None]
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Get writer counters
+
+        Returns:
+            Submitted, written, failed and batch counts plus the queue depth
+        """
+        stats = dict(self._stats)
+        stats["pending"] = stats["submitted"] - stats["written"] - stats["failed"]
+        stats["storage_path"] = str(self.storage_path)
+        return stats
+
+
+_writers: "weakref.WeakSet[AuditLogWriter]" = weakref.WeakSet()
+
+
+def audit_log_stats() -> List[Dict[str, Any]]:
+    """Counters of every live audit log writer"""
+    return [writer.get_stats() for writer in list(_writers)]
+
+
+def close_audit_logs() -> None:
+    """Write pending records of every audit log and stop their writers (call on shutdown)"""
+    for writer in list(_writers):
+        try:
+            writer.close()
+        except Exception as e:
+            logger.error(f"Failed to close audit log {writer.storage_path}: {str(e)}")
@@ -0,0 +1,194 @@
+"""
+Versioned change feed for pushing data deltas to clients
+Turns each published data store version into a small delta (changed
+transactions plus the month, day and category aggregates they touched) and
+fans it out to server-sent event subscribers, keeping a bounded backlog so
+reconnecting clients catch up from the version they last saw
+"""
+import asyncio
+import threading
+from collections import deque
+from datetime import datetime, timezone
+from typing import Any, Dict, List, Optional, Set, Tuple
+import logging
+
+from .data_store import DataStore, get_data_store
+from .aggregate_store import SECONDS_PER_DAY, DEFAULT_CATEGORY
+from .transaction_store import _parse_date, month_key
+
+logger = logging.getLogger(__name__)
+
+# Events kept for clients resuming from an older version
+MAX_BACKLOG = 500
+
+# Events buffered per subscriber before it is told to resync instead
+SUBSCRIBER_QUEUE_SIZE = 256
+
+
+class ChangeFeed:
+    """
+    Fan-out of data store versions as deltas
+
+    Transaction writes become ``transactions`` events carrying the written
+    rows and the aggregates they changed, read from the store's running
+    rollups right after the write. File reloads and versions adopted from
+    other workers become ``reload`` events naming the categories to refetch
+    (None for all of them). Every version is one event, so a client holding
+    version N is current after applying the events after N.
+    """
+
+    def __init__(self, store: Optional[DataStore] = None, max_backlog: int = MAX_BACKLOG):
+        """
+        Initialize the feed and start listening to the store
+
+        Args:
+            store: Data store to follow; defaults to the shared store
+            max_backlog: Events kept for resuming clients
+        """
+        self.store = store or get_data_store()
+        self._backlog: deque = deque(maxlen=max_backlog)
+        self._subscribers: Set[Tuple[asyncio.AbstractEventLoop, asyncio.Queue]] = set()
+        self._lock = threading.Lock()
+        self._stats = {"events": 0, "delivered": 0, "overflows": 0}
+        self.store.add_listener(self._on_version)
+
+    @property
+    def version(self) -> int:
+        """Latest data store version"""
+        return self.store.version
+
+    def since(self, version: int) -> Optional[List[Dict[str, Any]]]:
+        """
+        Events published after ``version``
+
+        Args:
+            version: Last version the client applied
+
+        Returns:
+            Events in version order, or None if the client must refetch
+            because the backlog no longer reaches back that far
+        """
+        current = self.store.version
+        if version == current:
+            return []
+        with self._lock:
+            events = list(self._backlog)
+        if version > current or not events or events[0]["version"] > version + 1:
+            return None
+        return [event for event in events if event["version"] > version]
+
+    def subscribe(self) -> asyncio.Queue:
+        """
+        Receive new events on a queue bound to the running event loop
+
+        A None item means the subscriber fell behind and must resync.
+        """
+        queue: asyncio.Queue = asyncio.Queue(SUBSCRIBER_QUEUE_SIZE)
+        with self._lock:
+            self._subscribers.add((asyncio.get_running_loop(), queue))
+        return queue
+
+    def unsubscribe(self, queue: asyncio.Queue) -> None:
+        """Stop delivering events to a queue"""
+        with self._lock:
+            self._subscribers = {entry for entry in self._subscribers if entry[1] is not queue}
+
+    def _on_version(self, version: int, categories: Optional[List[str]],
+                    change: Optional[Dict[str, Any]]) -> None:
+        """Data store listener: record the version's delta and fan it out"""
+        if change is not None:
+            event = self._transaction_event(version, change)
+        else:
+            event = {"version": version, "type": "reload", "categories": categories}
+        event["timestamp"] = datetime.utcnow().isoformat() + "Z"
+
+        with self._lock:
+            self._backlog.append(event)
+            subscribers = list(self._subscribers)
+            self._stats["events"] += 1
+
+        for loop, queue in subscribers:
+            try:
+                loop.call_soon_threadsafe(self._deliver, queue, event)
+            except RuntimeError:
+                # The subscriber's loop has closed; it unsubscribes on its way out
+                pass
+
+    def _deliver(self, queue: asyncio.Queue, event: Dict[str, Any]) -> None:
+        """Put an event on a subscriber queue, replacing a full queue with a resync marker"""
+        if queue.full():
+            while not queue.empty():
+                queue.get_nowait()
+            queue.put_nowait(None)
+            self._stats["overflows"] += 1
+            return
+        queue.put_nowait(event)
+        self._stats["delivered"] += 1
+
+    def _transaction_event(self, version: int, change: Dict[str, Any]) -> Dict[str, Any]:
+        """Build the delta for one transaction write from the updated aggregates"""
+        touched = [record for record in (change.get("added"), change.get("updated"),
+                                         change.get("previous"), change.get("deleted")) if record]
+        aggregates = self.store.published_aggregates()
+        months, days, categories = set(), set(), set()
+        for record in touched:
+            categories.add(record.get("category", DEFAULT_CATEGORY))
+            date_value = record.get("date", "")
+            parsed = _parse_date(date_value) if isinstance(date_value, str) and date_value else None
+            if parsed is not None:
+                months.add(parsed[1])
+                days.add(int(parsed[0] // SECONDS_PER_DAY))
+
+        category_totals = aggregates.category_expenses()
+        return {
+            "version": version,
+            "type": "transactions",
+            "added": [change["added"]] if change.get("added") else [],
+            "updated": [change["updated"]] if change.get("updated") else [],
+            "removed": [change["deleted"].get("id")] if change.get("deleted") else [],
+            "months": [
+                {"month": month_key(code), **_rounded(aggregates.month_totals(code))}
+                for code in sorted(months)
+            ],
+            "days": [
+                {
+                    "date": datetime.fromtimestamp(day * SECONDS_PER_DAY, timezone.utc).strftime("%Y-%m-%d"),
+                    **_rounded(aggregates.day_totals(day))
+                }
+                for day in sorted(days)
+            ],
+            "categories": {category: round(category_totals.get(category, 0.0), 2) for category in categories},
+            "summary": aggregates.summary()
+        }
+
+    def get_stats(self) -> Dict[str, Any]:
+        """Get event, delivery and subscriber counters"""
+        with self._lock:
+            stats = dict(self._stats)
+            stats["subscribers"] = len(self._subscribers)
+            stats["backlog"] = len(self._backlog)
+        stats["version"] = self.store.version
+        return stats
+
+
+def _rounded(totals: Dict[str, float]) -> Dict[str, float]:
+    return {key: round(value, 2) for key, value in totals.items()}
+
+
+_feed: Optional[ChangeFeed] = None
+_feed_lock = threading.Lock()
+
+
+def get_change_feed() -> ChangeFeed:
+    """
+    Get the process-wide change feed for the shared data store
+
+    Returns:
+        Shared ChangeFeed instance
+    """
+    global _feed
+    if _feed is None:
+        with _feed_lock:
+            if _feed is None:
+                _feed = ChangeFeed()
+    return _feed
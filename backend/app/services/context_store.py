@@ -0,0 +1,429 @@
+"""
+Bounded conversation state for the NLP and AI services
+Per-user, per-session contexts under a fixed session budget with LRU and idle
+TTL eviction, ring-buffer chat history, and an optional SQLite spill that
+contexts are written through to as JSON, so evicted state is reloaded on demand
+and survives worker restarts and crashes
+"""
+import json
+import os
+import sqlite3
+import threading
+import time
+import weakref
+from collections import OrderedDict, deque
+from typing import Dict, Any, List, Optional, Callable, Tuple
+import logging
+
+from .shared_snapshot import broadcast_invalidation, on_invalidation
+
+logger = logging.getLogger(__name__)
+
+# Environment variable naming the SQLite file; unset keeps state in memory only
+SPILL_PATH_ENV = "CONTEXT_STORE_DB"
+
+
+class SQLiteSpill:
+    """SQLite persistence for contexts and chat history, stored as JSON"""
+
+    def __init__(self, path: str):
+        """
+        Open (and create) the spill database
+
+        Args:
+            path: SQLite file path, or ':memory:'
+        """
+        self.path = path
+        self._lock = threading.Lock()
+        self._conn = sqlite3.connect(path, check_same_thread=False, isolation_level=None)
+        if path != ":memory:":
+            self._conn.execute("PRAGMA journal_mode=WAL")
+        self._conn.execute("PRAGMA synchronous=NORMAL")
+        self._conn.execute(
+            "CREATE TABLE IF NOT EXISTS contexts ("
+            " namespace TEXT NOT NULL, key TEXT NOT NULL, state TEXT NOT NULL, updated_at REAL NOT NULL,"
+            " PRIMARY KEY (namespace, key))"
+        )
+        self._conn.execute(
+            "CREATE TABLE IF NOT EXISTS chat_history ("
+            " id INTEGER PRIMARY KEY AUTOINCREMENT, user_id TEXT NOT NULL, entry TEXT NOT NULL)"
+        )
+        self._conn.execute("CREATE INDEX IF NOT EXISTS chat_history_user ON chat_history (user_id, id)")
+
+    def save_contexts(self, namespace: str, items: List[Tuple[str, Dict[str, Any]]]) -> None:
+        """Persist context states by key, replacing earlier versions"""
+        if not items:
+            return
+        now = time.time()
+        rows = [(namespace, key, json.dumps(state, default=str), now) for key, state in items]
+        with self._lock:
+            self._conn.executemany("INSERT OR REPLACE INTO contexts VALUES (?, ?, ?, ?)", rows)
+
+    def load_context(self, namespace: str, key: str) -> Optional[Dict[str, Any]]:
+        """Load a spilled context state, or None"""
+        with self._lock:
+            row = self._conn.execute(
+                "SELECT state FROM contexts WHERE namespace = ? AND key = ?", (namespace, key)
+            ).fetchone()
+        if row is None:
+            return None
+        try:
+            state = json.loads(row[0])
+            if not isinstance(state, dict):
+                raise ValueError("state is not an object")
+            return state
+        except (TypeError, ValueError) as e:
+            logger.warning(f"Discarding unreadable context {namespace}/{key}: {str(e)}")
+            self.delete_context(namespace, key)
+            return None
+
+    def delete_context(self, namespace: str, key: str) -> None:
+        """Remove a spilled context"""
+        with self._lock:
+            self._conn.execute("DELETE FROM contexts WHERE namespace = ? AND key = ?", (namespace, key))
+
+    def append_history(self, user_id: str, entry: Dict[str, Any], keep: int) -> None:
+        """Append a chat entry and drop the user's rows beyond the newest ``keep``"""
+        with self._lock:
+            self._conn.execute("BEGIN")
+            self._conn.execute("INSERT INTO chat_history (user_id, entry) VALUES (?, ?)",
+                               (user_id, json.dumps(entry, default=str)))
+            self._conn.execute(
+                "DELETE FROM chat_history WHERE user_id = ? AND id NOT IN"
+                " (SELECT id FROM chat_history WHERE user_id = ? ORDER BY id DESC LIMIT ?)",
+                (user_id, user_id, keep)
+            )
+            self._conn.execute("COMMIT")
+
+    def load_history(self, user_id: str, limit: int) -> List[Dict[str, Any]]:
+        """Newest ``limit`` chat entries of a user, oldest first"""
+        with self._lock:
+            rows = self._conn.execute(
+                "SELECT entry FROM chat_history WHERE user_id = ? ORDER BY id DESC LIMIT ?", (user_id, limit)
+            ).fetchall()
+        return [json.loads(row[0]) for row in reversed(rows)]
+
+    def clear_history(self, user_id: str) -> None:
+        """Delete a user's chat history"""
+        with self._lock:
+            self._conn.execute("DELETE FROM chat_history WHERE user_id = ?", (user_id,))
+
+    def close(self) -> None:
+        """Close the database connection"""
+        with self._lock:
+            self._conn.close()
+
+
+_stores: "weakref.WeakSet[ContextStore]" = weakref.WeakSet()
+
+
+class ContextStore:
+    """
+    Per-user, per-session context objects with a fixed session budget
+
+    The least recently used sessions beyond ``max_sessions`` and sessions idle
+    longer than ``ttl_seconds`` leave memory. With a spill backend, contexts
+    are serialized with their ``to_dict()`` and rebuilt with ``from_dict``;
+    callers ``save`` a context after mutating it so SQLite always holds the
+    latest state, and evicted sessions are transparently reloaded on access.
+    """
+
+    def __init__(self, namespace: str, max_sessions: int = 1000, ttl_seconds: float = 3600,
+                 spill: Optional[SQLiteSpill] = None,
+                 from_dict: Optional[Callable[[Dict[str, Any]], Any]] = None):
+        """
+        Initialize the store
+
+        Args:
+            namespace: Name separating this store's rows in the spill database
+            max_sessions: Sessions kept in memory
+            ttl_seconds: Idle time after which a session is evicted
+            spill: Optional SQLite backend for sessions
+            from_dict: Rebuilds a context from its ``to_dict()`` state; required with a spill
+        """
+        if spill is not None and from_dict is None:
+            raise ValueError(f"Context store {namespace} needs from_dict to reload spilled contexts")
+        self.namespace = namespace
+        self.max_sessions = max(1, max_sessions)
+        self.ttl_seconds = ttl_seconds
+        self.spill = spill
+        self.from_dict = from_dict
+        self._contexts: "OrderedDict[str, Tuple[Any, float]]" = OrderedDict()
+        self._lock = threading.Lock()
+        self._stats = {"hits": 0, "reloads": 0, "created": 0, "evictions": 0, "expirations": 0}
+        _stores.add(self)
+
+    @staticmethod
+    def make_key(user_id: str, session_id: Optional[str]) -> str:
+        """Key of one user session"""
+        return f"{user_id}:{session_id or 'default'}"
+
+    def get(self, user_id: str, session_id: Optional[str] = None) -> Optional[Any]:
+        """
+        Get a session's context without creating one
+
+        Args:
+            user_id: User identifier
+            session_id: Session identifier
+
+        Returns:
+            Context object, or None if the session is unknown
+        """
+        key = self.make_key(user_id, session_id)
+        now = time.monotonic()
+        with self._lock:
+            entry = self._contexts.get(key)
+            if entry is not None and now - entry[1] <= self.ttl_seconds:
+                self._contexts[key] = (entry[0], now)
+                self._contexts.move_to_end(key)
+                self._stats["hits"] += 1
+                return entry[0]
+
+        self._evict(now)
+        if self.spill is None:
+            return None
+        state = self.spill.load_context(self.namespace, key)
+        if state is None:
+            return None
+        try:
+            context = self.from_dict(state)
+        except (KeyError, TypeError, ValueError) as e:
+            logger.warning(f"Discarding unreadable context {self.namespace}/{key}: {str(e)}")
+            self.spill.delete_context(self.namespace, key)
+            return None
+        self._stats["reloads"] += 1
+        self._insert(key, context, now)
+        return context
+
+    def get_or_create(self, user_id: str, session_id: Optional[str], factory: Callable[[], Any]) -> Any:
+        """
+        Get a session's context, creating it with ``factory`` if unknown
+
+        Args:
+            user_id: User identifier
+            session_id: Session identifier
+            factory: Zero-argument constructor for a new context
+
+        Returns:
+            Context object, mutated in place by the caller
+        """
+        context = self.get(user_id, session_id)
+        if context is None:
+            context = factory()
+            self._stats["created"] += 1
+            self._insert(self.make_key(user_id, session_id), context, time.monotonic())
+        return context
+
+    def save(self, user_id: str, session_id: Optional[str], context: Any) -> None:
+        """
+        Write a session's context through to the spill backend after a change
+
+        Args:
+            user_id: User identifier
+            session_id: Session identifier
+            context: Context object that was mutated
+        """
+        if self.spill is None:
+            return
+        try:
+            self.spill.save_contexts(self.namespace, [(self.make_key(user_id, session_id), context.to_dict())])
+        except sqlite3.Error as e:
+            logger.error(f"Failed to save context {self.namespace}/{user_id}: {str(e)}")
+
+    def discard(self, user_id: str, session_id: Optional[str] = None) -> bool:
+        """
+        Forget a session, including any spilled copy and other workers' copies
+
+        Returns:
+            True if the session was held in memory
+        """
+        key = self.make_key(user_id, session_id)
+        removed = self._forget(key)
+        if self.spill is not None:
+            self.spill.delete_context(self.namespace, key)
+        broadcast_invalidation("context", f"{self.namespace}/{key}")
+        return removed
+
+    def _forget(self, key: str) -> bool:
+        """Drop a session from memory only"""
+        with self._lock:
+            return self._contexts.pop(key, None) is not None
+
+    def flush(self) -> None:
+        """Write every in-memory session to the spill backend"""
+        if self.spill is None:
+            return
+        with self._lock:
+            items = [(key, context) for key, (context, _) in self._contexts.items()]
+        self.spill.save_contexts(self.namespace, [(key, context.to_dict()) for key, context in items])
+
+    def _insert(self, key: str, context: Any, now: float) -> None:
+        with self._lock:
+            self._contexts[key] = (context, now)
+            self._contexts.move_to_end(key)
+        self._evict(now)
+
+    def _evict(self, now: float) -> None:
+        """Move expired and over-budget sessions out of memory"""
+        evicted = []
+        with self._lock:
+            while self._contexts:
+                key, (context, last_used) = next(iter(self._contexts.items()))
+                if now - last_used > self.ttl_seconds:
+                    self._stats["expirations"] += 1
+                elif len(self._contexts) > self.max_sessions:
+                    self._stats["evictions"] += 1
+                else:
+                    break
+                self._contexts.popitem(last=False)
+                evicted.append((key, context))
+
+        if evicted and self.spill is not None:
+            self.spill.save_contexts(self.namespace, [(key, context.to_dict()) for key, context in evicted])
+
+    def __len__(self) -> int:
+        return len(self._contexts)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Get store occupancy and eviction counters
+
+        Returns:
+            Counters plus current size and budget
+        """
+        with self._lock:
+            stats = dict(self._stats)
+            stats["sessions"] = len(self._contexts)
+        stats["max_sessions"] = self.max_sessions
+        stats["spill"] = self.spill.path if self.spill else None
+        return stats
+
+
+class ChatHistoryStore:
+    """
+    Per-user ring buffers of chat exchanges
+
+    Each user keeps the newest ``limit`` entries (deque semantics, O(1)
+    appends); the least recently active users beyond ``max_users`` leave
+    memory. With a spill backend every entry is written through, so history
+    survives restarts and evicted users reload on access.
+    """
+
+    def __init__(self, limit: int = 100, max_users: int = 1000, spill: Optional[SQLiteSpill] = None):
+        """
+        Initialize the store
+
+        Args:
+            limit: Entries kept per user
+            max_users: Users whose history is held in memory
+            spill: Optional SQLite backend
+        """
+        self.limit = limit
+        self.max_users = max(1, max_users)
+        self.spill = spill
+        self._histories: "OrderedDict[str, deque]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    def _history(self, user_id: str) -> deque:
+        """User's ring buffer, loading it from the spill on first access (lock held)"""
+        history = self._histories.get(user_id)
+        if history is None:
+            loaded = self.spill.load_history(user_id, self.limit) if self.spill else []
+            history = deque(loaded, maxlen=self.limit)
+            self._histories[user_id] = history
+            while len(self._histories) > self.max_users:
+                self._histories.popitem(last=False)
+        self._histories.move_to_end(user_id)
+        return history
+
+    def append(self, user_id: str, entry: Dict[str, Any]) -> None:
+        """Record one chat exchange"""
+        with self._lock:
+            self._history(user_id).append(entry)
+            if self.spill is not None:
+                self.spill.append_history(user_id, entry, self.limit)
+
+    def recent(self, user_id: str, limit: int = 50) -> List[Dict[str, Any]]:
+        """
+        Newest chat entries of a user
+
+        Args:
+            user_id: User identifier
+            limit: Maximum entries returned
+
+        Returns:
+            Entries oldest first
+        """
+        with self._lock:
+            history = self._history(user_id)
+            if limit <= 0:
+                return []
+            start = max(0, len(history) - limit)
+            return [history[i] for i in range(start, len(history))]
+
+    def count(self, user_id: str) -> int:
+        """Number of retained entries for a user"""
+        with self._lock:
+            return len(self._history(user_id))
+
+    def clear(self, user_id: str) -> None:
+        """Delete a user's history"""
+        with self._lock:
+            self._histories.pop(user_id, None)
+            if self.spill is not None:
+                self.spill.clear_history(user_id)
+
+
+_spill: Optional[SQLiteSpill] = None
+_spill_loaded = False
+_spill_lock = threading.Lock()
+
+
+def get_context_spill() -> Optional[SQLiteSpill]:
+    """
+    Get the process-wide spill backend configured by ``CONTEXT_STORE_DB``
+
+    Returns:
+        Shared SQLiteSpill, or None when state is memory-only
+    """
+    global _spill, _spill_loaded
+    if not _spill_loaded:
+        with _spill_lock:
+            if not _spill_loaded:
+                path = os.getenv(SPILL_PATH_ENV)
+                if path:
+                    try:
+                        _spill = SQLiteSpill(path)
+                        logger.info(f"Conversation state spills to {path}")
+                    except sqlite3.Error as e:
+                        logger.error(f"Failed to open context store {path}: {str(e)}")
+                _spill_loaded = True
+    return _spill
+
+
+def context_store_stats() -> Dict[str, Dict[str, Any]]:
+    """Occupancy and eviction counters of every live context store, by namespace"""
+    return {store.namespace: store.get_stats() for store in list(_stores)}
+
+
+def _forget_remote_discard(key: Optional[str]) -> None:
+    """Drop a session another worker discarded; None drops every session"""
+    namespace, _, session_key = (key or "").partition("/")
+    for store in list(_stores):
+        if key is None:
+            with store._lock:
+                store._contexts.clear()
+        elif store.namespace == namespace:
+            store._forget(session_key)
+
+
+on_invalidation("context", _forget_remote_discard)
+
+
+def flush_context_stores() -> None:
+    """Persist every live context store's sessions (call on shutdown)"""
+    for store in list(_stores):
+        try:
+            store.flush()
+        except Exception as e:
+            logger.error(f"Failed to flush context store {store.namespace}: {str(e)}")
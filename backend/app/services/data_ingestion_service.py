@@ -9,14 +9,18 @@ import os
 import logging
 import asyncio
 from datetime import datetime, timezone
-from typing import Dict, Any, List, Optional, Union, Tuple
+from typing import Dict, Any, List, Optional, Union, Tuple, Callable
 from pathlib import Path
-from dataclasses import dataclass
+from dataclasses import dataclass, replace
 from enum import Enum
 import hashlib
 
 # Import our validation service
 from .data_validator import DataValidator
+from .ingestion_stream import iter_file_chunks, stream_chunks, peek_json_array
+from .ingestion_manifest import ChunkManifest, ContentChunker, ManifestChunk
+from .synthetic_data import SyntheticDataGenerator
+from .shared_snapshot import broadcast_invalidation, on_invalidation
 
 logger = logging.getLogger(__name__)
 
@@ -63,21 +67,34 @@ class DataSourceConfig:
     refresh_interval: Optional[int] = None  # seconds
     last_updated: Optional[datetime] = None
     metadata: Optional[Dict[str, Any]] = None
+    manifest: Optional[ChunkManifest] = None  # Chunk hashes of the last list ingestion
 
 
 class DataIngestionService:
     """Enhanced data ingestion service with comprehensive validation and normalization"""
 
-    def __init__(self, data_dir: str = "data", validator: DataValidator = None):
+    def __init__(self, data_dir: str = "data", validator: DataValidator = None,
+                 stream_threshold_bytes: int = 8 * 1024 * 1024,
+                 stream_chunk_size: int = 5000,
+                 max_pending_chunks: int = 2,
+                 manifest_chunk_size: int = 512):
         """
         Initialize the enhanced data ingestion service
         
         Args:
             data_dir: Directory containing data files
             validator: Data validator instance
+            stream_threshold_bytes: File size from which JSON/CSV sources are streamed
+            stream_chunk_size: Records per chunk in streaming mode
+            max_pending_chunks: Chunks the file reader may run ahead of validation
+            manifest_chunk_size: Average records per content-addressed manifest chunk
         """
         self.data_dir = Path(data_dir)
         self.validator = validator or DataValidator()
+        self.stream_threshold_bytes = stream_threshold_bytes
+        self.stream_chunk_size = stream_chunk_size
+        self.max_pending_chunks = max_pending_chunks
+        self.manifest_chunk_size = manifest_chunk_size
         self._data_cache = {}
         self._ingestion_history = []
         self._source_configs = {}
@@ -85,6 +102,9 @@ class DataIngestionService:
         # Initialize default data source configurations
         self._initialize_default_sources()
 
+        # Caches cleared by another worker are cleared here too
+        on_invalidation("ingestion", self._forget_source)
+
     def _initialize_default_sources(self):
         """Initialize default data source configurations"""
         default_sources = [
@@ -210,24 +230,41 @@ class DataIngestionService:
                     failed_records=0,
                     validation_errors=[],
                     processing_time=0.0,
-                    data_hash=self._calculate_data_hash(cached_data),
+                    data_hash=self._data_hash_for(config, cached_data),
                     metadata={"source": "cache"}
                 )
         
+        if await asyncio.to_thread(self._should_stream, config):
+            return await self.ingest_data_source_streaming(source_name)
+        
         logger.info(f"Ingesting data from {source_name} ({config.source_type.value})")
         
         try:
             # Load raw data
             raw_data = await self._load_raw_data(config)
             
-            # Validate and normalize data
+            metadata = {
+                "source_type": config.source_type.value,
+                "source_path": config.path_or_url,
+                "schema": config.schema_name
+            }
+            
+            # Validate and normalize data, reusing chunks unchanged since the last run
             if isinstance(raw_data, list):
-                validation_result = await self._validate_bulk_data(raw_data, config.schema_name)
+                validation_result, manifest, validated_chunks = await asyncio.to_thread(
+                    self._validate_incremental, raw_data, config
+                )
+                metadata.update({
+                    "chunks": len(manifest.chunks),
+                    "validated_chunks": validated_chunks
+                })
             else:
                 validation_result = await self._validate_single_data(raw_data, config.schema_name)
+                manifest = None
             
             # Store validated data in cache
             self._data_cache[source_name] = validation_result["valid_data"]
+            config.manifest = manifest
             config.last_updated = datetime.now(timezone.utc)
             
             processing_time = (datetime.now() - start_time).total_seconds()
@@ -239,12 +276,8 @@ class DataIngestionService:
                 failed_records=validation_result["failed_records"],
                 validation_errors=validation_result["errors"],
                 processing_time=processing_time,
-                data_hash=self._calculate_data_hash(validation_result["valid_data"]),
-                metadata={
-                    "source_type": config.source_type.value,
-                    "source_path": config.path_or_url,
-                    "schema": config.schema_name
-                }
+                data_hash=self._data_hash_for(config, validation_result["valid_data"]),
+                metadata=metadata
             )
             
         except Exception as e:
@@ -262,6 +295,271 @@ class DataIngestionService:
                 metadata={"error": str(e)}
             )
 
+    async def ingest_data_source_streaming(self, source_name: str, chunk_size: Optional[int] = None,
+                                           on_chunk: Optional[Callable[[List[Dict]], Any]] = None) -> DataIngestionResult:
+        """
+        Ingest a JSON array or CSV source in bounded chunks
+        
+        The file is read on a worker thread at most ``max_pending_chunks`` chunks
+        ahead of validation, and each chunk is validated off the event loop and
+        normalized before the next is consumed. Memory stays bounded by the
+        chunk size: valid records are handed to ``on_chunk``, which owns them,
+        and are neither kept in the manifest (only digests and counts are) nor
+        cached, so ``get_cached_data`` is empty for a streamed source. Chunks
+        whose content hash is in the previous manifest reuse its counts, and
+        its records too when that manifest came from a whole-file load;
+        otherwise they are validated again to feed ``on_chunk``.
+        
+        Args:
+            source_name: Name of the data source
+            chunk_size: Records per chunk, defaults to ``stream_chunk_size``
+            on_chunk: Optional callback (sync or async) receiving each chunk's valid records
+            
+        Returns:
+            Data ingestion result
+        """
+        start_time = datetime.now()
+        
+        if source_name not in self._source_configs:
+            raise ValueError(f"Unknown data source: {source_name}")
+        
+        config = self._source_configs[source_name]
+        if config.source_type not in (DataSourceType.JSON, DataSourceType.CSV):
+            raise ValueError(f"Streaming not supported for source type {config.source_type.value}")
+        
+        file_path = self.data_dir / config.path_or_url
+        chunk_size = chunk_size or self.stream_chunk_size
+        logger.info(f"Streaming data from {source_name} in chunks of {chunk_size}")
+        
+        chunker = ContentChunker(self.manifest_chunk_size)
+        previous = config.manifest
+        resolved: List[ManifestChunk] = []
+        validated_chunks = 0
+        chunk_count = 0
+        
+        try:
+            if not await asyncio.to_thread(file_path.exists):
+                logger.warning(f"Data file not found: {file_path}")
+            else:
+                chunks = stream_chunks(
+                    lambda: iter_file_chunks(file_path, config.source_type.value, chunk_size),
+                    self.max_pending_chunks
+                )
+                async for chunk in chunks:
+                    chunk_resolved, chunk_validated = await asyncio.to_thread(
+                        self._resolve_stream_chunk, chunker, chunk, config.schema_name, previous,
+                        False, on_chunk is not None
+                    )
+                    validated_chunks += chunk_validated
+                    chunk_count += 1
+                    await self._notify_chunk(on_chunk, chunk_resolved)
+                    resolved.extend(replace(item, valid_data=None) for item in chunk_resolved)
+            
+            chunk_resolved, chunk_validated = await asyncio.to_thread(
+                self._resolve_stream_chunk, chunker, [], config.schema_name, previous,
+                True, on_chunk is not None
+            )
+            validated_chunks += chunk_validated
+            await self._notify_chunk(on_chunk, chunk_resolved)
+            resolved.extend(replace(item, valid_data=None) for item in chunk_resolved)
+            
+            manifest = ChunkManifest(config.schema_name, resolved)
+            validation_result = self._manifest_result(manifest)
+            
+            # The records went to on_chunk; a stale cached copy must not outlive them
+            self._data_cache.pop(source_name, None)
+            config.manifest = manifest
+            config.last_updated = datetime.now(timezone.utc)
+            
+            processing_time = (datetime.now() - start_time).total_seconds()
+            
+            return DataIngestionResult(
+                status=DataIngestionStatus.COMPLETED if validation_result["failed_records"] == 0 else DataIngestionStatus.PARTIAL,
+                total_records=validation_result["total_records"],
+                successful_records=validation_result["successful_records"],
+                failed_records=validation_result["failed_records"],
+                validation_errors=validation_result["errors"],
+                processing_time=processing_time,
+                data_hash=manifest.root,
+                metadata={
+                    "source_type": config.source_type.value,
+                    "source_path": config.path_or_url,
+                    "schema": config.schema_name,
+                    "streamed": True,
+                    "chunks": chunk_count,
+                    "chunk_size": chunk_size,
+                    "manifest_chunks": len(manifest.chunks),
+                    "validated_chunks": validated_chunks
+                }
+            )
+            
+        except Exception as e:
+            processing_time = (datetime.now() - start_time).total_seconds()
+            logger.error(f"Error streaming data from {source_name}: {e}")
+            
+            return DataIngestionResult(
+                status=DataIngestionStatus.FAILED,
+                total_records=sum(chunk.record_count for chunk in resolved),
+                successful_records=sum(chunk.valid_count for chunk in resolved),
+                failed_records=sum(chunk.failed_records for chunk in resolved),
+                validation_errors=[{"error": str(e)}],
+                processing_time=processing_time,
+                data_hash="",
+                metadata={"error": str(e), "streamed": True, "chunks": chunk_count}
+            )
+
+    @staticmethod
+    async def _notify_chunk(on_chunk: Optional[Callable[[List[Dict]], Any]],
+                            chunks: List[ManifestChunk]) -> None:
+        """Hand the valid records of newly resolved chunks to a streaming callback"""
+        if on_chunk is None:
+            return
+        valid_data = [item for chunk in chunks for item in chunk.valid_data or ()]
+        if valid_data:
+            pushed = on_chunk(valid_data)
+            if asyncio.iscoroutine(pushed):
+                await pushed
+
+    def _should_stream(self, config: DataSourceConfig) -> bool:
+        """Check whether a source is a file large enough to stream (blocking)"""
+        if config.source_type not in (DataSourceType.JSON, DataSourceType.CSV):
+            return False
+        
+        file_path = self.data_dir / config.path_or_url
+        try:
+            if file_path.stat().st_size < self.stream_threshold_bytes:
+                return False
+            if config.source_type == DataSourceType.JSON:
+                # Single-object documents keep the regular single-item validation path
+                with open(file_path, 'r', encoding='utf-8') as f:
+                    return peek_json_array(f)
+            return True
+        except OSError:
+            return False
+
+    def _validate_chunk(self, chunk: List[Dict], schema_name: str) -> Dict[str, Any]:
+        """Validate and normalize one chunk of records (runs on a worker thread)"""
+        validation_result = self.validator.validate_bulk_indexed(chunk, schema_name)
+        
+        return {
+            "total_records": validation_result["total_count"],
+            "successful_records": validation_result["valid_count"],
+            "failed_records": validation_result["invalid_count"],
+            "valid_data": validation_result["normalized"],
+            "errors": validation_result["summary_errors"]
+        }
+
+    def _validate_incremental(self, records: List[Dict],
+                              config: DataSourceConfig) -> Tuple[Dict[str, Any], ChunkManifest, int]:
+        """
+        Validate a record list, reusing chunks unchanged since the last ingestion (blocking)
+        
+        Args:
+            records: Raw records in source order
+            config: Data source configuration holding the previous manifest
+            
+        Returns:
+            Tuple of (validation result, new manifest, number of chunks validated)
+        """
+        chunker = ContentChunker(self.manifest_chunk_size)
+        chunks = list(chunker.feed(records))
+        chunks.extend(chunker.flush())
+        
+        resolved, validated_chunks = self._resolve_chunks(chunks, config.schema_name, config.manifest)
+        manifest = ChunkManifest(config.schema_name, resolved)
+        return self._manifest_result(manifest), manifest, validated_chunks
+
+    def _resolve_stream_chunk(self, chunker: ContentChunker, records: List[Dict], schema_name: str,
+                              previous: Optional[ChunkManifest], final: bool = False,
+                              need_records: bool = True) -> Tuple[List[ManifestChunk], int]:
+        """Feed streamed records to the chunker and resolve the chunks they complete (blocking)"""
+        chunks = list(chunker.feed(records))
+        if final:
+            chunks.extend(chunker.flush())
+        return self._resolve_chunks(chunks, schema_name, previous, need_records)
+
+    def _resolve_chunks(self, chunks: List[Tuple[str, List[Dict]]], schema_name: str,
+                        previous: Optional[ChunkManifest],
+                        need_records: bool = True) -> Tuple[List[ManifestChunk], int]:
+        """
+        Reuse chunks found in the previous manifest and validate the rest in one batch
+        
+        Args:
+            chunks: (digest, records) pairs in source order
+            schema_name: Schema to validate against
+            previous: Manifest of the last ingestion, if any
+            need_records: Whether reused chunks must carry their valid records;
+                digest-only chunks from a streamed manifest are then re-validated
+            
+        Returns:
+            Tuple of (resolved chunks in order, number of chunks validated)
+        """
+        if previous is not None and previous.schema_name != schema_name:
+            previous = None
+        
+        resolved: List[Optional[ManifestChunk]] = []
+        pending = []
+        for digest, records in chunks:
+            cached = previous.get(digest) if previous is not None else None
+            if cached is not None and cached.valid_data is None and need_records:
+                cached = None
+            if cached is None:
+                pending.append((len(resolved), digest, records))
+            resolved.append(cached)
+        
+        if pending:
+            # Validate all changed chunks together so large changes still use the process pool
+            flat = [record for _, _, records in pending for record in records]
+            validation_result = self.validator.validate_bulk_indexed(flat, schema_name)
+            normalized = validation_result["normalized"]
+            errors = validation_result["errors"]
+            
+            start = 0
+            valid_start = 0
+            for position, digest, records in pending:
+                error_counts: Dict[str, int] = {}
+                failed = 0
+                for index in range(start, start + len(records)):
+                    for error in errors.get(index, ()):
+                        field = error.get("field", "unknown") if isinstance(error, dict) else "general"
+                        error_counts[field] = error_counts.get(field, 0) + 1
+                    failed += index in errors
+                
+                valid_count = len(records) - failed
+                resolved[position] = ManifestChunk(
+                    digest=digest,
+                    record_count=len(records),
+                    valid_data=normalized[valid_start:valid_start + valid_count],
+                    failed_records=failed,
+                    error_counts=error_counts
+                )
+                start += len(records)
+                valid_start += valid_count
+        
+        return resolved, len(pending)
+
+    @staticmethod
+    def _manifest_result(manifest: ChunkManifest) -> Dict[str, Any]:
+        """Flatten a manifest into the validation result shape used by ingestion"""
+        valid_data: List[Dict] = []
+        successful_records = 0
+        failed_records = 0
+        error_counts: Dict[str, int] = {}
+        for chunk in manifest.chunks:
+            valid_data.extend(chunk.valid_data or ())
+            successful_records += chunk.valid_count
+            failed_records += chunk.failed_records
+            for field, count in chunk.error_counts.items():
+                error_counts[field] = error_counts.get(field, 0) + count
+        
+        return {
+            "total_records": manifest.record_count,
+            "successful_records": successful_records,
+            "failed_records": failed_records,
+            "valid_data": valid_data,
+            "errors": [{"field": field, "count": count} for field, count in error_counts.items()]
+        }
+
     async def _load_raw_data(self, config: DataSourceConfig) -> Union[List[Dict], Dict]:
         """
         Load raw data from the configured source
@@ -290,8 +588,7 @@ class DataIngestionService:
             return []
         
         try:
-            with open(file_path, 'r', encoding='utf-8') as f:
-                data = json.load(f)
+            data = await asyncio.to_thread(self._read_json_file, file_path)
             logger.info(f"Loaded JSON data from {file_path}")
             return data
         except json.JSONDecodeError as e:
@@ -310,13 +607,7 @@ class DataIngestionService:
             return []
         
         try:
-            data = []
-            with open(file_path, 'r', encoding='utf-8', newline='') as f:
-                reader = csv.DictReader(f)
-                for row_num, row in enumerate(reader, start=1):
-                    if row:  # Skip empty rows
-                        row['_source_row'] = row_num
-                        data.append(row)
+            data = await asyncio.to_thread(self._read_csv_file, file_path)
             
             logger.info(f"Loaded {len(data)} records from CSV: {file_path}")
             return data
@@ -324,6 +615,24 @@ class DataIngestionService:
             logger.error(f"Error reading CSV {file_path}: {e}")
             raise
 
+    @staticmethod
+    def _read_json_file(file_path: Path) -> Union[List[Dict], Dict]:
+        """Read and decode a JSON file (blocking)"""
+        with open(file_path, 'r', encoding='utf-8') as f:
+            return json.load(f)
+
+    @staticmethod
+    def _read_csv_file(file_path: Path) -> List[Dict]:
+        """Read a CSV file into row dictionaries (blocking)"""
+        data = []
+        with open(file_path, 'r', encoding='utf-8', newline='') as f:
+            reader = csv.DictReader(f)
+            for row_num, row in enumerate(reader, start=1):
+                if row:  # Skip empty rows
+                    row['_source_row'] = row_num
+                    data.append(row)
+        return data
+
     async def _load_mock_data(self, config: DataSourceConfig) -> List[Dict]:
         """Generate mock data for testing"""
         mock_data_generators = {
@@ -352,15 +661,7 @@ class DataIngestionService:
         Returns:
             Validation result dictionary
         """
-        validation_result = self.validator.validate_bulk_data(data, schema_name)
-        
-        return {
-            "total_records": validation_result["total_count"],
-            "successful_records": validation_result["valid_count"],
-            "failed_records": validation_result["invalid_count"],
-            "valid_data": [item["data"] for item in validation_result["valid_items"]],
-            "errors": validation_result["summary_errors"]
-        }
+        return self._validate_chunk(data, schema_name)
 
     async def _validate_single_data(self, data: Dict, schema_name: str) -> Dict[str, Any]:
         """
@@ -418,6 +719,12 @@ class DataIngestionService:
         time_since_update = (datetime.now(timezone.utc) - config.last_updated).total_seconds()
         return time_since_update < config.refresh_interval
 
+    def _data_hash_for(self, config: DataSourceConfig, data: Any) -> str:
+        """Use the manifest root as the data hash when the source has one"""
+        if config.manifest is not None:
+            return config.manifest.root
+        return self._calculate_data_hash(data)
+
     def _calculate_data_hash(self, data: Any) -> str:
         """
         Calculate hash of data for integrity checking
@@ -480,36 +787,15 @@ class DataIngestionService:
                 "schema": config.schema_name,
                 "last_updated": config.last_updated.isoformat() if config.last_updated else None,
                 "cached_records": len(cached_data) if isinstance(cached_data, list) else 1 if cached_data else 0,
-                "data_hash": self._calculate_data_hash(cached_data)
+                "data_hash": self._data_hash_for(config, cached_data)
             }
         return status
 
     # Mock data generators for testing
     def _generate_mock_transactions(self) -> List[Dict]:
-        """Generate mock transaction data"""
-        from datetime import timedelta
-        import random
-        
-        transactions = []
-        base_date = datetime.now() - timedelta(days=90)
-        
-        categories = ["food_dining", "transportation", "bills_utilities", "entertainment", "shopping", "healthcare"]
-        
-        for i in range(100):
-            date = base_date + timedelta(days=random.randint(0, 90))
-            amount = -round(random.uniform(100, 5000), 2)
-            category = random.choice(categories)
-            
-            transactions.append({
-                "id": f"mock_txn_{i:04d}",
-                "date": date.isoformat(),
-                "amount": amount,
-                "description": f"Mock {category} transaction",
-                "category": category,
-                "type": "expense"
-            })
-        
-        return transactions
+        """Generate mock transaction data (90 days from the synthetic generator)"""
+        generator = SyntheticDataGenerator(seed=0)
+        return list(generator.transactions(100, user_id="mock", days=90, id_prefix="mock_txn"))
 
     def _generate_mock_accounts(self) -> List[Dict]:
         """Generate mock account data"""
@@ -602,17 +888,29 @@ class DataIngestionService:
             logger.error(f"Error exporting data: {e}")
             return False
 
-    def clear_cache(self, source_name: str = None):
+    def clear_cache(self, source_name: str = None, broadcast: bool = True):
         """
         Clear cached data
         
         Args:
             source_name: Specific source to clear, or None to clear all
+            broadcast: Also clear it in the other workers
         """
+        if broadcast:
+            broadcast_invalidation("ingestion", source_name)
+        # Manifests hold validated chunks too, so they are dropped with the cache
         if source_name:
+            if source_name in self._source_configs:
+                self._source_configs[source_name].manifest = None
             if source_name in self._data_cache:
                 del self._data_cache[source_name]
                 logger.info(f"Cleared cache for {source_name}")
         else:
+            for config in self._source_configs.values():
+                config.manifest = None
             self._data_cache.clear()
-            logger.info("Cleared all cached data")
\ No newline at end of file
+            logger.info("Cleared all cached data")
+
+    def _forget_source(self, source_name: Optional[str]):
+        """Clear a source another worker cleared"""
+        self.clear_cache(source_name, broadcast=False)
\ No newline at end of file
@@ -1,12 +1,12 @@
 """
 Data service for loading and managing financial data
 """
-import json
-import os
 from typing import Dict, Any, List
 from pathlib import Path
 import logging
 
+from .data_store import DataStore, get_data_store
+
 logger = logging.getLogger(__name__)
 
 
@@ -21,45 +21,26 @@ class DataService:
             data_dir: Directory containing the JSON data files
         """
         self.data_dir = Path(data_dir)
-        self._data_cache = {}
+        # All instances for the same directory share one process-wide store
+        self._store = get_data_store(data_dir)
+    
+    @property
+    def store(self) -> DataStore:
+        """The shared data store backing this service"""
+        return self._store
         
     def load_all_data(self) -> Dict[str, Any]:
         """
         Load all financial data from JSON files
         
+        Files are parsed once and re-read only when their mtime or size changes.
+        
         Returns:
             Dictionary containing all loaded data
         """
         try:
-            data = {}
-            
-            # Define the data files to load
-            data_files = {
-                'transactions': 'transactions.json',
-                'assets': 'assets.json',
-                'liabilities': 'liabilities.json',
-                'investments': 'investments.json',
-                'accounts': 'accounts.json',
-                'spending_trends': 'spending_trends.json',
-                'category_breakdown': 'category_breakdown.json',
-                'dashboard_insights': 'dashboard_insights.json',
-                'epf_balance': 'epf_balance.json',
-                'credit_score': 'credit_score.json'
-            }
-            
-            for key, filename in data_files.items():
-                file_path = self.data_dir / filename
-                if file_path.exists():
-                    with open(file_path, 'r', encoding='utf-8') as f:
-                        data[key] = json.load(f)
-                    logger.info(f"Loaded {key} data from {filename}")
-                else:
-                    logger.warning(f"Data file not found: {file_path}")
-                    data[key] = []
-            
-            # Cache the data
-            self._data_cache = data
-            return data
+            # Shallow copy so callers can add keys without touching the shared snapshot
+            return dict(self._store.snapshot())
             
         except Exception as e:
             logger.error(f"Error loading data: {str(e)}")
@@ -75,10 +56,7 @@ class DataService:
         Returns:
             Data for the specified category
         """
-        if not self._data_cache:
-            self.load_all_data()
-        
-        return self._data_cache.get(category, [])
+        return self._store.get_category(category)
     
     def validate_data_structure(self, data: Dict[str, Any]) -> bool:
         """
@@ -129,11 +107,8 @@ class DataService:
         Returns:
             Dictionary containing data summary statistics
         """
-        if not self._data_cache:
-            self.load_all_data()
-        
         summary = {}
-        for category, data in self._data_cache.items():
+        for category, data in self._store.snapshot().items():
             if isinstance(data, list):
                 summary[category] = {
                     'count': len(data),
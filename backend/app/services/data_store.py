@@ -0,0 +1,511 @@
+"""
+Shared in-memory data store for financial data
+Loads the JSON data files once per process and reloads only the files that changed on disk
+"""
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from types import MappingProxyType
+from typing import Dict, Any, Callable, List, Mapping, Optional, Tuple
+from pathlib import Path
+import logging
+
+from .transaction_store import (TransactionColumns, get_transaction_columns, share_transaction_columns,
+                                forget_transaction_columns)
+from .aggregate_store import TransactionAggregates
+from .metrics import span
+from .shared_snapshot import (SharedSnapshot, SnapshotExchange, SnapshotMapping, AGGREGATES_SECTION,
+                              encode_section, get_snapshot_exchange, poll_invalidations)
+
+logger = logging.getLogger(__name__)
+
+
+# Data categories and the files they are loaded from
+DATA_FILES = {
+    'transactions': 'transactions.json',
+    'assets': 'assets.json',
+    'liabilities': 'liabilities.json',
+    'investments': 'investments.json',
+    'accounts': 'accounts.json',
+    'spending_trends': 'spending_trends.json',
+    'category_breakdown': 'category_breakdown.json',
+    'dashboard_insights': 'dashboard_insights.json',
+    'epf_balance': 'epf_balance.json',
+    'credit_score': 'credit_score.json'
+}
+
+
+class DataStore:
+    """
+    Process-wide, change-aware store for the financial data files
+
+    Each file is tracked by its (mtime, size) signature and re-parsed only when
+    that signature changes. Readers receive immutable top-level snapshots; the
+    store never mutates a published category in place, so a snapshot stays
+    consistent for as long as a request holds it.
+
+    Transaction writes go through ``add_transaction``, ``update_transaction``
+    and ``delete_transaction``, which publish a copied list and apply a delta
+    to the running aggregates instead of recomputing them. Writes are held in
+    memory; a later change to transactions.json on disk replaces them, unless
+    ``load_external`` made another source (the database) authoritative for the
+    transactions, in which case the file is no longer read.
+
+    With a ``SnapshotExchange`` the store is shared by worker processes: each
+    version is published as a read-only snapshot that the other workers map
+    and decode lazily instead of parsing the files and rebuilding the
+    aggregates themselves. Only a worker that sees a file change or makes a
+    write publishes, and ``version`` follows the shared snapshot version.
+    """
+
+    def __init__(self, data_dir: str = "data", refresh_interval: float = 1.0,
+                 exchange: Optional[SnapshotExchange] = None):
+        """
+        Initialize the data store
+
+        Args:
+            data_dir: Directory containing the JSON data files
+            refresh_interval: Minimum seconds between file change checks
+            exchange: Snapshot exchange shared with other workers, if any
+        """
+        self.data_dir = Path(data_dir)
+        self.refresh_interval = refresh_interval
+        self._lock = threading.RLock()
+        self._data: Dict[str, Any] = {}
+        self._file_stats: Dict[str, Optional[Tuple[int, int]]] = {}
+        self._external: set = set()
+        self._snapshot: Mapping[str, Any] = MappingProxyType({})
+        self._last_check = 0.0
+        self._loaded = False
+        self._aggregates = TransactionAggregates()
+        self._columns_source: Optional[list] = None
+        self._exchange = exchange
+        self._shared: Optional[SharedSnapshot] = None
+        self._listeners: List[Callable[[int, Optional[List[str]], Optional[Dict[str, Any]]], None]] = []
+        self.version = 0
+
+    def load(self) -> Mapping[str, Any]:
+        """
+        Load every data file, ignoring cached file signatures
+
+        Returns:
+            Read-only snapshot of all loaded data
+        """
+        with self._lock:
+            self._file_stats.clear()
+            if self._exchange is not None:
+                # A snapshot matching the files on disk stands in for a full parse
+                self._sync_shared()
+            else:
+                self._refresh_files()
+            self._loaded = True
+            return self._snapshot
+
+    def refresh(self, force: bool = False) -> bool:
+        """
+        Reload files whose mtime or size changed since the last check
+
+        Args:
+            force: Check files even if the refresh interval has not elapsed
+
+        Returns:
+            True if any category was reloaded
+        """
+        now = time.monotonic()
+        if not force and self._loaded and now - self._last_check < self.refresh_interval:
+            return False
+
+        with self._lock:
+            self._loaded = True
+            if self._exchange is not None:
+                return self._sync_shared()
+            return self._refresh_files()
+
+    def snapshot(self) -> Mapping[str, Any]:
+        """
+        Get a read-only snapshot of the current data
+
+        Returns:
+            Mapping of data category to its loaded value
+        """
+        self.refresh()
+        return self._snapshot
+
+    def versioned_snapshot(self) -> Tuple[int, Mapping[str, Any]]:
+        """
+        Get the current snapshot together with the version it was published as
+
+        Returns:
+            Tuple of (data version, read-only snapshot)
+        """
+        self.refresh()
+        with self._lock:
+            return self.version, self._snapshot
+
+    def versioned_view(self) -> Tuple[int, Mapping[str, Any], TransactionAggregates]:
+        """
+        Get the current snapshot and aggregates together with their version
+
+        Both are read under one lock acquisition, so the aggregates belong to
+        the same published version as the snapshot.
+
+        Returns:
+            Tuple of (data version, read-only snapshot, aggregates)
+        """
+        self.refresh()
+        with self._lock:
+            return self.version, self._snapshot, self._aggregates
+
+    def get_category(self, category: str) -> Any:
+        """
+        Get data for a single category from the current snapshot
+
+        Args:
+            category: The data category to retrieve
+
+        Returns:
+            Data for the specified category
+        """
+        return self.snapshot().get(category, [])
+
+    def transaction_columns(self) -> TransactionColumns:
+        """
+        Get the columnar transaction view for the current snapshot
+
+        Returns:
+            TransactionColumns built once per transactions version
+        """
+        snapshot = self.snapshot()
+        transactions = snapshot.get('transactions', [])
+        if not isinstance(transactions, list):
+            return get_transaction_columns([])
+        with self._lock:
+            if self._snapshot is snapshot:
+                # Adopted shared snapshots decode the list lazily, so share it here
+                self._share_columns(transactions)
+        return get_transaction_columns(transactions)
+
+    def aggregates(self) -> TransactionAggregates:
+        """
+        Get the incrementally maintained transaction aggregates
+
+        Returns:
+            TransactionAggregates matching the current transactions
+        """
+        self.refresh()
+        return self._aggregates
+
+    def published_aggregates(self) -> TransactionAggregates:
+        """
+        Get the aggregates as of the latest published version, without refreshing
+
+        Safe to call from a version listener, which runs inside the store lock
+        where ``aggregates()`` would try to refresh.
+
+        Returns:
+            TransactionAggregates of the current version
+        """
+        return self._aggregates
+
+    def load_external(self, category: str, value: Any, source: str) -> None:
+        """
+        Serve a category from another source instead of its data file
+
+        The category is published as a new version and its file is no longer
+        watched, so the store and that source cannot drift apart; later
+        writes go through the transaction methods as usual.
+
+        Args:
+            category: Data category to replace, e.g. 'transactions'
+            value: Full value loaded from the source
+            source: Name of the source, for logging
+        """
+        with self._lock, self._writing():
+            if not self._loaded:
+                self._refresh_files()
+                self._loaded = True
+            self._external.add(category)
+            self._file_stats.pop(category, None)
+            self._data[category] = value
+            if category == 'transactions':
+                self._aggregates = TransactionAggregates(value if isinstance(value, list) else [])
+            self._publish([category], action=f"loaded from {source}:")
+
+    def add_transaction(self, transaction: Dict[str, Any]) -> Dict[str, Any]:
+        """
+        Append a transaction and update the aggregates
+
+        Args:
+            transaction: Transaction record to add
+
+        Returns:
+            The stored transaction
+        """
+        with self._lock, self._writing():
+            transactions = list(self._transactions())
+            transactions.append(transaction)
+            self._data['transactions'] = transactions
+            self._aggregates.add(transaction)
+            self._publish(['transactions'], action="added to", change={"added": transaction})
+            return transaction
+
+    def update_transaction(self, transaction_id: Any, fields: Dict[str, Any]) -> Optional[Dict[str, Any]]:
+        """
+        Update a transaction by id and adjust the aggregates by the difference
+
+        Args:
+            transaction_id: Id of the transaction to update
+            fields: Fields to overwrite on the existing record
+
+        Returns:
+            The updated transaction, or None if no transaction has that id
+        """
+        with self._lock, self._writing():
+            transactions = self._transactions()
+            position = self._position_of(transactions, transaction_id)
+            if position is None:
+                return None
+
+            old = transactions[position]
+            new = {**old, **fields}
+            transactions = list(transactions)
+            transactions[position] = new
+            self._data['transactions'] = transactions
+            self._aggregates.replace(old, new)
+            self._publish(['transactions'], action="updated", change={"updated": new, "previous": old})
+            return new
+
+    def delete_transaction(self, transaction_id: Any) -> Optional[Dict[str, Any]]:
+        """
+        Delete a transaction by id and remove it from the aggregates
+
+        Args:
+            transaction_id: Id of the transaction to delete
+
+        Returns:
+            The deleted transaction, or None if no transaction has that id
+        """
+        with self._lock, self._writing():
+            transactions = self._transactions()
+            position = self._position_of(transactions, transaction_id)
+            if position is None:
+                return None
+
+            removed = transactions[position]
+            self._data['transactions'] = transactions[:position] + transactions[position + 1:]
+            self._aggregates.remove(removed)
+            self._publish(['transactions'], action="deleted from", change={"deleted": removed})
+            return removed
+
+    def _transactions(self) -> list:
+        """Get the current transaction list, loading files if needed (lock held)"""
+        if not self._loaded:
+            self._refresh_files()
+            self._loaded = True
+        transactions = self._snapshot.get('transactions', [])
+        return transactions if isinstance(transactions, list) else []
+
+    @contextmanager
+    def _writing(self):
+        """Hold the shared publish lock for a write, starting from the newest snapshot (lock held)"""
+        if self._exchange is None:
+            yield
+            return
+        with self._exchange.lock():
+            self._adopt_newer()
+            yield
+
+    @staticmethod
+    def _position_of(transactions: list, transaction_id: Any) -> Optional[int]:
+        """Find the list position of a transaction id"""
+        for position, transaction in enumerate(transactions):
+            if transaction.get("id") == transaction_id:
+                return position
+        return None
+
+    def get_file_stats(self) -> Dict[str, Any]:
+        """Get the tracked file signatures and store version"""
+        with self._lock:
+            return {
+                "version": self.version,
+                "data_dir": str(self.data_dir),
+                "files": {
+                    key: {"mtime_ns": stat[0], "size": stat[1]} if stat else None
+                    for key, stat in self._file_stats.items()
+                },
+                "shared": self._exchange.get_stats() if self._exchange is not None else None
+            }
+
+    def _sync_shared(self) -> bool:
+        """Adopt a newer shared snapshot, then reparse and publish local file changes (lock held)"""
+        self._last_check = time.monotonic()
+        poll_invalidations()
+        current = self._exchange.current()
+        if (current is None or current[0] <= self.version) and self._file_stats and \
+                all(self._stat_file(self.data_dir / name) == self._file_stats.get(key)
+                    for key, name in DATA_FILES.items() if key not in self._external):
+            return False
+
+        with self._exchange.lock():
+            adopted = self._adopt_newer()
+            return self._refresh_files() or adopted
+
+    def _adopt_newer(self) -> bool:
+        """Switch to the newest shared snapshot if another worker published one (lock held)"""
+        current = self._exchange.current()
+        if current is None or current[0] <= self.version:
+            return False
+        snapshot = self._exchange.open(current)
+        if snapshot is None:
+            return False
+        self._adopt(snapshot, {})
+        self._aggregates = TransactionAggregates.from_state(snapshot.load(AGGREGATES_SECTION))
+        self._share_columns(None)
+        logger.info(f"Data store version {self.version}: adopted shared snapshot")
+        # What another worker changed is unknown here, so listeners see a full reload
+        self._notify(None, None)
+        return True
+
+    def _adopt(self, snapshot: SharedSnapshot, primed: Dict[str, Any]) -> None:
+        """Serve a snapshot, with values this worker already holds for it (lock held)"""
+        self._shared = snapshot
+        self._snapshot = SnapshotMapping(snapshot, primed)
+        self._file_stats = dict(snapshot.file_stats)
+        self._data = {}
+        self.version = snapshot.version
+        self._loaded = True
+
+    def _publish_shared(self) -> None:
+        """Publish the current data as a new shared snapshot (lock and publish lock held)"""
+        sections = {}
+        for key in dict.fromkeys([*DATA_FILES, *self._data]):
+            if key in self._data:
+                sections[key] = encode_section(self._data[key])
+            elif self._shared is not None and key in self._shared.sections:
+                # Unchanged categories are copied over without being decoded
+                sections[key] = self._shared.raw(key)
+        sections[AGGREGATES_SECTION] = encode_section(self._aggregates.to_state())
+
+        # Everything this worker has decoded is still current in what it publishes
+        primed = self._snapshot.decoded() if isinstance(self._snapshot, SnapshotMapping) else {}
+        primed.update(self._data)
+        self._adopt(self._exchange.publish(sections, self._file_stats, self.version), primed)
+
+    def _refresh_files(self) -> bool:
+        """Stat every data file and re-parse the ones that changed (lock held)"""
+        self._last_check = time.monotonic()
+        changed = []
+
+        for key, filename in DATA_FILES.items():
+            if key in self._external:
+                continue
+            file_path = self.data_dir / filename
+            stat = self._stat_file(file_path)
+
+            if key in self._file_stats and self._file_stats[key] == stat:
+                continue
+
+            if stat is None:
+                logger.warning(f"Data file not found: {file_path}")
+                value = []
+            else:
+                try:
+                    with span("data_load"), open(file_path, 'r', encoding='utf-8') as f:
+                        value = json.load(f)
+                    logger.info(f"Loaded {key} data from {filename}")
+                except (OSError, ValueError) as e:
+                    # Keep serving the previous value if a file is mid-write or corrupt
+                    logger.error(f"Error loading {filename}: {str(e)}")
+                    if key in self._snapshot:
+                        continue
+                    value = []
+
+            self._file_stats[key] = stat
+            self._data[key] = value
+            changed.append(key)
+
+        if changed:
+            self._publish(changed)
+
+        return bool(changed)
+
+    def add_listener(self, listener: Callable[[int, Optional[List[str]], Optional[Dict[str, Any]]], None]) -> None:
+        """
+        Call ``listener(version, categories, change)`` after every published version
+
+        ``change`` describes a transaction write ({"added"}, {"updated",
+        "previous"} or {"deleted"} record) and is None for file reloads.
+        ``categories`` is None when the whole data set may have changed. The
+        listener runs with the store lock held and must not block.
+        """
+        with self._lock:
+            self._listeners.append(listener)
+
+    def _notify(self, categories: Optional[List[str]], change: Optional[Dict[str, Any]]) -> None:
+        """Tell listeners about the version just published (lock held)"""
+        for listener in self._listeners:
+            try:
+                listener(self.version, categories, change)
+            except Exception as e:
+                logger.error(f"Data store listener failed for version {self.version}: {str(e)}")
+
+    def _publish(self, changed_categories, action: str = "reloaded",
+                 change: Optional[Dict[str, Any]] = None) -> None:
+        """Swap in a new snapshot after categories changed (lock held)"""
+        if action == "reloaded" and 'transactions' in changed_categories:
+            transactions = self._data.get('transactions', [])
+            self._aggregates = TransactionAggregates(transactions if isinstance(transactions, list) else [])
+        if self._exchange is not None:
+            self._publish_shared()
+        else:
+            self._snapshot = MappingProxyType(dict(self._data))
+            self.version += 1
+        if 'transactions' in changed_categories:
+            self._share_columns(self._data.get('transactions'))
+        logger.info(f"Data store version {self.version}: {action} {', '.join(changed_categories)}")
+        self._notify(list(changed_categories), change)
+
+    def _share_columns(self, transactions: Any) -> None:
+        """Share the column view of the published transaction list, dropping its predecessor's (lock held)"""
+        if transactions is self._columns_source:
+            return
+        if self._columns_source is not None:
+            forget_transaction_columns(self._columns_source)
+        self._columns_source = transactions if isinstance(transactions, list) else None
+        if self._columns_source is not None:
+            share_transaction_columns(self._columns_source)
+
+    @staticmethod
+    def _stat_file(file_path: Path) -> Optional[Tuple[int, int]]:
+        """Get the (mtime_ns, size) signature of a file, or None if missing"""
+        try:
+            stat = os.stat(file_path)
+        except OSError:
+            return None
+        return (stat.st_mtime_ns, stat.st_size)
+
+
+# Shared store instances keyed by resolved data directory
+_stores: Dict[str, DataStore] = {}
+_stores_lock = threading.Lock()
+
+
+def get_data_store(data_dir: str = "data") -> DataStore:
+    """
+    Get the process-wide data store for a data directory
+
+    Args:
+        data_dir: Directory containing the JSON data files
+
+    Returns:
+        Shared DataStore instance
+    """
+    key = str(Path(data_dir).resolve())
+    with _stores_lock:
+        store = _stores.get(key)
+        if store is None:
+            store = DataStore(key, exchange=get_snapshot_exchange(key))
+            _stores[key] = store
+        return store
@@ -2,8 +2,12 @@
 Enhanced data validation and normalization service
 """
 import json
+import multiprocessing
+import os
+import threading
 import jsonschema
-from typing import Dict, Any, List, Optional
+from concurrent.futures import ProcessPoolExecutor
+from typing import Dict, Any, List, Optional, Callable, Iterator, Tuple
 from datetime import datetime, timezone
 from decimal import Decimal, InvalidOperation
 import logging
@@ -11,13 +15,240 @@ from pathlib import Path
 
 logger = logging.getLogger(__name__)
 
+# Keywords the fast-path compiler understands; "format" and "default" are
+# annotations only, since schemas are validated without a format checker
+_COMPILED_KEYWORDS = {"type", "required", "properties", "minLength", "maxLength",
+                      "minimum", "maximum", "enum", "items", "format", "default"}
+
+_TYPE_CHECKS: Dict[str, Callable[[Any], bool]] = {
+    "string": lambda v: isinstance(v, str),
+    "number": lambda v: isinstance(v, (int, float)) and not isinstance(v, bool),
+    # Integral floats are left to jsonschema, whose answer depends on the draft
+    "integer": lambda v: isinstance(v, int) and not isinstance(v, bool),
+    "object": lambda v: isinstance(v, dict),
+    "array": lambda v: isinstance(v, list),
+    "boolean": lambda v: isinstance(v, bool),
+    "null": lambda v: v is None,
+}
+
+
+def compile_schema(schema: Dict[str, Any]) -> Optional[Callable[[Any], bool]]:
+    """
+    Compile a schema into a fast acceptance check
+    
+    The check only ever answers "definitely valid": a False result means the
+    item must go through jsonschema, which produces the exact error. Schemas
+    using keywords outside the supported subset compile to None.
+    
+    Args:
+        schema: JSON schema dictionary
+        
+    Returns:
+        Predicate accepting valid instances, or None if the schema is unsupported
+    """
+    if not set(schema) <= _COMPILED_KEYWORDS:
+        return None
+    
+    checks: List[Callable[[Any], bool]] = []
+    
+    if "type" in schema:
+        names = schema["type"] if isinstance(schema["type"], list) else [schema["type"]]
+        if not all(name in _TYPE_CHECKS for name in names):
+            return None
+        type_checks = tuple(_TYPE_CHECKS[name] for name in names)
+        if len(type_checks) == 1:
+            checks.append(type_checks[0])
+        else:
+            checks.append(lambda v: any(check(v) for check in type_checks))
+    
+    if "enum" in schema:
+        if not all(isinstance(member, str) for member in schema["enum"]):
+            return None
+        members = frozenset(schema["enum"])
+        checks.append(lambda v: isinstance(v, str) and v in members)
+    
+    min_length, max_length = schema.get("minLength"), schema.get("maxLength")
+    if min_length is not None or max_length is not None:
+        low = min_length if min_length is not None else 0
+        high = max_length if max_length is not None else float("inf")
+        checks.append(lambda v: not isinstance(v, str) or low <= len(v) <= high)
+    
+    minimum, maximum = schema.get("minimum"), schema.get("maximum")
+    if minimum is not None or maximum is not None:
+        is_number = _TYPE_CHECKS["number"]
+        checks.append(lambda v: not is_number(v) or not (
+            (minimum is not None and v < minimum) or (maximum is not None and v > maximum)))
+    
+    if "items" in schema:
+        item_check = compile_schema(schema["items"])
+        if item_check is None:
+            return None
+        checks.append(lambda v: not isinstance(v, list) or all(item_check(item) for item in v))
+    
+    if "required" in schema or "properties" in schema:
+        required = tuple(schema.get("required", ()))
+        properties = []
+        for name, sub_schema in schema.get("properties", {}).items():
+            sub_check = compile_schema(sub_schema)
+            if sub_check is None:
+                return None
+            properties.append((name, sub_check))
+        
+        def check_object(v: Any) -> bool:
+            if not isinstance(v, dict):
+                return True  # Left to the "type" check
+            for name in required:
+                if name not in v:
+                    return False
+            for name, sub_check in properties:
+                if name in v and not sub_check(v[name]):
+                    return False
+            return True
+        
+        checks.append(check_object)
+    
+    checks = tuple(checks)
+    if len(checks) == 1:
+        return checks[0]
+    return lambda v: all(check(v) for check in checks)
+
+
+def bitmap_indexes(bitmap: bytes, count: int) -> Iterator[int]:
+    """
+    Iterate the indexes set in a validation bitmap
+    
+    Args:
+        bitmap: Bitmap with bit ``i % 8`` of byte ``i // 8`` set for item i
+        count: Number of items the bitmap covers
+        
+    Yields:
+        Set indexes in ascending order
+    """
+    for byte_index, byte in enumerate(bitmap):
+        if not byte:
+            continue
+        base = byte_index * 8
+        for bit in range(8):
+            if byte & (1 << bit) and base + bit < count:
+                yield base + bit
+
+
+# Per-process validator used by pool workers, built on first use
+_worker_validator = None
+
+# Process pool shared by every DataValidator, started on the first parallel bulk
+_pool: Optional[ProcessPoolExecutor] = None
+_pool_lock = threading.Lock()
+
+
+def _get_validation_pool(max_workers: int) -> ProcessPoolExecutor:
+    """
+    Get the shared bulk validation pool, starting it on first use
+
+    Workers are spawned rather than forked: the server process runs threads
+    (and holds their locks) that a forked child would inherit mid-operation.
+
+    Args:
+        max_workers: Pool size if the pool has to be started
+
+    Returns:
+        Shared ProcessPoolExecutor
+    """
+    global _pool
+    with _pool_lock:
+        if _pool is None:
+            _pool = ProcessPoolExecutor(max_workers=max_workers,
+                                        mp_context=multiprocessing.get_context("spawn"))
+        return _pool
+
+
+def shutdown_validation_pool() -> None:
+    """Stop the shared bulk validation pool and its worker processes (call on shutdown)"""
+    global _pool
+    with _pool_lock:
+        pool, _pool = _pool, None
+    if pool is not None:
+        pool.shutdown(wait=True, cancel_futures=True)
+
+
+def _validate_batch(schema_name: str, batch: List[Dict[str, Any]]) -> Dict[str, Any]:
+    """Validate one batch inside a pool worker"""
+    global _worker_validator
+    if _worker_validator is None:
+        _worker_validator = DataValidator(max_workers=1)
+    return _worker_validator.validate_bulk_indexed(batch, schema_name, parallel=False)
+
 
 class DataValidator:
     """Enhanced data validation and normalization service"""
     
-    def __init__(self):
-        """Initialize validator with schemas"""
+    # Category aliases mapped to their canonical names
+    CATEGORY_MAPPING = {
+        # Food related
+        "food": "food_dining",
+        "restaurant": "food_dining",
+        "dining": "food_dining",
+        "groceries": "food_dining",
+        "grocery": "food_dining",
+        
+        # Transport related
+        "transport": "transportation",
+        "taxi": "transportation",
+        "uber": "transportation",
+        "ola": "transportation",
+        "fuel": "transportation",
+        "petrol": "transportation",
+        
+        # Bills related
+        "utilities": "bills_utilities",
+        "electricity": "bills_utilities",
+        "phone": "bills_utilities",
+        "internet": "bills_utilities",
+        
+        # Entertainment
+        "entertainment": "entertainment",
+        "movies": "entertainment",
+        "gaming": "entertainment",
+        
+        # Shopping
+        "shopping": "shopping",
+        "retail": "shopping",
+        "clothes": "shopping",
+        "clothing": "shopping"
+    }
+    
+    def __init__(self, max_workers: Optional[int] = None, parallel_threshold: int = 10000,
+                 batch_size: int = 2048):
+        """
+        Initialize validator with schemas
+        
+        Args:
+            max_workers: Shared process pool size for bulk validation, defaults to the CPU count
+            parallel_threshold: Minimum bulk size validated across the process pool
+            batch_size: Items per pool task, rounded up to a multiple of 8
+        """
         self.schemas = self._load_schemas()
+        self.max_workers = max_workers or os.cpu_count() or 1
+        self.parallel_threshold = parallel_threshold
+        self.batch_size = max(8, (batch_size + 7) // 8 * 8)
+        
+        # Compile every schema once: the jsonschema validator (schema checked
+        # here rather than on each item), the fast acceptance check and the normalizer
+        self._validators = {}
+        self._fast_checks = {}
+        for name, schema in self.schemas.items():
+            validator_class = jsonschema.validators.validator_for(schema)
+            validator_class.check_schema(schema)
+            self._validators[name] = validator_class(schema)
+            self._fast_checks[name] = compile_schema(schema)
+        
+        self._normalizers = {
+            "transaction": self._normalize_transaction,
+            "account": self._normalize_account,
+            "investment": self._normalize_investment,
+            "asset": self._normalize_asset,
+            "liability": self._normalize_liability
+        }
     
     def _load_schemas(self) -> Dict[str, Any]:
         """Load JSON schemas for validation"""
@@ -119,53 +350,54 @@ class DataValidator:
             "normalized_data": None
         }
         
-        try:
-            schema = self.schemas.get(schema_name)
-            if not schema:
-                result["errors"].append(f"Schema '{schema_name}' not found")
-                return result
-            
-            # Validate against schema
-            jsonschema.validate(data, schema)
-            
-            # Normalize the data
-            normalized_data = self._normalize_data(data, schema_name)
-            
+        if schema_name not in self.schemas:
+            result["errors"].append(f"Schema '{schema_name}' not found")
+            return result
+        
+        normalized_data, errors = self._validate_item(data, schema_name)
+        if errors:
+            result["errors"] = errors
+        else:
             result.update({
                 "valid": True,
                 "normalized_data": normalized_data
             })
-            
-        except jsonschema.ValidationError as e:
-            result["errors"].append({
-                "field": ".".join(str(p) for p in e.absolute_path),
-                "message": e.message,
-                "invalid_value": e.instance
-            })
-        except Exception as e:
-            result["errors"].append(f"Validation error: {str(e)}")
         
         return result
     
+    def _validate_item(self, data: Any, schema_name: str) -> Tuple[Optional[Dict[str, Any]], List[Any]]:
+        """
+        Validate and normalize one item with the compiled schema
+        
+        Args:
+            data: Data to validate
+            schema_name: Name of a loaded schema
+            
+        Returns:
+            Tuple of (normalized data, errors); errors is empty when valid
+        """
+        try:
+            fast_check = self._fast_checks[schema_name]
+            if fast_check is None or not fast_check(data):
+                error = jsonschema.exceptions.best_match(self._validators[schema_name].iter_errors(data))
+                if error is not None:
+                    return None, [{
+                        "field": ".".join(str(p) for p in error.absolute_path),
+                        "message": error.message,
+                        "invalid_value": error.instance
+                    }]
+            
+            return self._normalize_data(data, schema_name), []
+        except Exception as e:
+            return None, [f"Validation error: {str(e)}"]
+    
     def _normalize_data(self, data: Dict[str, Any], schema_name: str) -> Dict[str, Any]:
         """Normalize data according to business rules"""
         normalized = data.copy()
         
-        if schema_name == "transaction":
-            # Normalize transaction data
-            normalized = self._normalize_transaction(normalized)
-        elif schema_name == "account":
-            # Normalize account data
-            normalized = self._normalize_account(normalized)
-        elif schema_name == "investment":
-            # Normalize investment data
-            normalized = self._normalize_investment(normalized)
-        elif schema_name == "asset":
-            # Normalize asset data
-            normalized = self._normalize_asset(normalized)
-        elif schema_name == "liability":
-            # Normalize liability data
-            normalized = self._normalize_liability(normalized)
+        normalizer = self._normalizers.get(schema_name)
+        if normalizer is not None:
+            normalized = normalizer(normalized)
         
         return normalized
     
@@ -296,42 +528,8 @@ class DataValidator:
     
     def _normalize_category(self, category: str) -> str:
         """Normalize transaction category"""
-        category_mapping = {
-            # Food related
-            "food": "food_dining",
-            "restaurant": "food_dining",
-            "dining": "food_dining",
-            "groceries": "food_dining",
-            "grocery": "food_dining",
-            
-            # Transport related
-            "transport": "transportation",
-            "taxi": "transportation",
-            "uber": "transportation",
-            "ola": "transportation",
-            "fuel": "transportation",
-            "petrol": "transportation",
-            
-            # Bills related
-            "utilities": "bills_utilities",
-            "electricity": "bills_utilities",
-            "phone": "bills_utilities",
-            "internet": "bills_utilities",
-            
-            # Entertainment
-            "entertainment": "entertainment",
-            "movies": "entertainment",
-            "gaming": "entertainment",
-            
-            # Shopping
-            "shopping": "shopping",
-            "retail": "shopping",
-            "clothes": "shopping",
-            "clothing": "shopping"
-        }
-        
         normalized = category.lower().strip()
-        return category_mapping.get(normalized, normalized)
+        return self.CATEGORY_MAPPING.get(normalized, normalized)
     
     def _calculate_depreciated_value(self, original_value: float, purchase_date: str, depreciation_rate: float) -> float:
         """Calculate current value after depreciation"""
@@ -376,45 +574,150 @@ class DataValidator:
         Returns:
             Bulk validation results
         """
-        results = {
-            "total_count": len(data_list),
-            "valid_count": 0,
-            "invalid_count": 0,
-            "valid_items": [],
-            "invalid_items": [],
-            "summary_errors": []
+        indexed = self.validate_bulk_indexed(data_list, schema_name)
+        
+        normalized = iter(indexed["normalized"])
+        valid_items = [
+            {"index": i, "data": next(normalized)}
+            for i in bitmap_indexes(indexed["valid_bitmap"], indexed["total_count"])
+        ]
+        invalid_items = [
+            {"index": i, "data": data_list[i], "errors": errors}
+            for i, errors in sorted(indexed["errors"].items())
+        ]
+        
+        return {
+            "total_count": indexed["total_count"],
+            "valid_count": indexed["valid_count"],
+            "invalid_count": indexed["invalid_count"],
+            "valid_items": valid_items,
+            "invalid_items": invalid_items,
+            "summary_errors": indexed["summary_errors"]
         }
+    
+    def validate_bulk_indexed(self, data_list: List[Dict[str, Any]], schema_name: str,
+                              parallel: Optional[bool] = None) -> Dict[str, Any]:
+        """
+        Validate multiple data items without copying them into per-item results
         
-        for i, item in enumerate(data_list):
-            validation_result = self.validate_data(item, schema_name)
+        Lists of at least ``parallel_threshold`` items are split into batches and
+        validated across a process pool; smaller lists are validated in process.
+        
+        Args:
+            data_list: List of data items to validate
+            schema_name: Schema to validate against
+            parallel: Force (True) or disable (False) the process pool
             
-            if validation_result["valid"]:
-                results["valid_count"] += 1
-                results["valid_items"].append({
-                    "index": i,
-                    "data": validation_result["normalized_data"]
-                })
+        Returns:
+            Bulk validation results with a ``valid_bitmap`` of item indexes, the
+            ``normalized`` valid items in index order and ``errors`` keyed by index
+        """
+        total = len(data_list)
+        if parallel is None:
+            parallel = total >= self.parallel_threshold and self.max_workers > 1
+        
+        if schema_name not in self.schemas:
+            errors = {i: [f"Schema '{schema_name}' not found"] for i in range(total)}
+            return self._bulk_result(total, bytes((total + 7) // 8), [], errors)
+        
+        if parallel and total > self.batch_size:
+            try:
+                return self._validate_parallel(data_list, schema_name)
+            except Exception as e:
+                logger.warning(f"Parallel validation unavailable, validating in process: {e}")
+                self.close()
+        
+        bitmap = bytearray((total + 7) // 8)
+        normalized: List[Dict[str, Any]] = []
+        errors: Dict[int, List[Any]] = {}
+        validate_item = self._validate_item
+        
+        for i, item in enumerate(data_list):
+            normalized_data, item_errors = validate_item(item, schema_name)
+            if item_errors:
+                errors[i] = item_errors
             else:
-                results["invalid_count"] += 1
-                results["invalid_items"].append({
-                    "index": i,
-                    "data": item,
-                    "errors": validation_result["errors"]
-                })
-        
-        # Generate summary
-        if results["invalid_count"] > 0:
-            error_summary = {}
-            for item in results["invalid_items"]:
-                for error in item["errors"]:
-                    field = error.get("field", "unknown") if isinstance(error, dict) else "general"
-                    error_summary[field] = error_summary.get(field, 0) + 1
-            
-            results["summary_errors"] = [
+                bitmap[i >> 3] |= 1 << (i & 7)
+                normalized.append(normalized_data)
+        
+        return self._bulk_result(total, bytes(bitmap), normalized, errors)
+    
+    def _validate_parallel(self, data_list: List[Dict[str, Any]], schema_name: str) -> Dict[str, Any]:
+        """Validate batches across the shared process pool and stitch the results in order"""
+        pool = _get_validation_pool(self.max_workers)
+        
+        # Batches are byte aligned, so their bitmaps concatenate directly
+        offsets = range(0, len(data_list), self.batch_size)
+        futures = [
+            pool.submit(_validate_batch, schema_name, data_list[offset:offset + self.batch_size])
+            for offset in offsets
+        ]
+        
+        bitmap = bytearray()
+        normalized: List[Dict[str, Any]] = []
+        errors: Dict[int, List[Any]] = {}
+        for offset, future in zip(offsets, futures):
+            batch = future.result()
+            bitmap += batch["valid_bitmap"]
+            normalized.extend(batch["normalized"])
+            for i, item_errors in batch["errors"].items():
+                errors[offset + i] = item_errors
+        
+        return self._bulk_result(len(data_list), bytes(bitmap), normalized, errors)
+    
+    def _bulk_result(self, total: int, bitmap: bytes, normalized: List[Dict[str, Any]],
+                     errors: Dict[int, List[Any]]) -> Dict[str, Any]:
+        """Assemble an indexed bulk result with its per-field error summary"""
+        error_summary = {}
+        for item_errors in errors.values():
+            for error in item_errors:
+                field = error.get("field", "unknown") if isinstance(error, dict) else "general"
+                error_summary[field] = error_summary.get(field, 0) + 1
+        
+        return {
+            "total_count": total,
+            "valid_count": len(normalized),
+            "invalid_count": len(errors),
+            "valid_bitmap": bitmap,
+            "normalized": normalized,
+            "errors": errors,
+            "summary_errors": [
                 {"field": field, "count": count} for field, count in error_summary.items()
             ]
+        }
+    
+    def close(self):
+        """Shut down the shared bulk validation pool, if one was started"""
+        shutdown_validation_pool()
+    
+    def _validate_records(self, records: List[Dict[str, Any]], schema_name: str) -> List[Dict[str, Any]]:
+        """
+        Validate records in one bulk pass, keeping invalid ones as flagged copies
         
-        return results
+        Args:
+            records: Records to validate; never modified
+            schema_name: Schema to validate against
+            
+        Returns:
+            Normalized valid records and copies of invalid ones carrying
+            ``validation_warnings``, in input order
+        """
+        indexed = self.validate_bulk_indexed(records, schema_name)
+        bitmap, errors = indexed["valid_bitmap"], indexed["errors"]
+        normalized = iter(indexed["normalized"])
+        validated = []
+        
+        for i, record in enumerate(records):
+            if bitmap[i >> 3] & (1 << (i & 7)):
+                validated.append(next(normalized))
+                continue
+            record_id = record.get("id", "unknown") if isinstance(record, dict) else "unknown"
+            logger.warning(f"Invalid {schema_name} {record_id}: {errors.get(i)}")
+            # Include a copy of the record with a warning flag; the input may be shared
+            validated.append({**record, "validation_warnings": errors.get(i, [])}
+                             if isinstance(record, dict) else record)
+        
+        return validated
     
     async def validate_transactions(self, transactions: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
         """
@@ -426,26 +729,7 @@ class DataValidator:
         Returns:
             List of validated and normalized transactions
         """
-        validated_transactions = []
-        
-        for transaction in transactions:
-            try:
-                # Validate transaction against schema
-                result = self.validate_data(transaction, "transaction")
-                
-                if result["valid"]:
-                    validated_transactions.append(result["normalized_data"])
-                else:
-                    logger.warning(f"Invalid transaction {transaction.get('id', 'unknown')}: {result['errors']}")
-                    # Include the transaction anyway with a warning flag
-                    transaction["validation_warnings"] = result["errors"]
-                    validated_transactions.append(transaction)
-            except Exception as e:
-                logger.error(f"Error validating transaction: {e}")
-                transaction["validation_error"] = str(e)
-                validated_transactions.append(transaction)
-        
-        return validated_transactions
+        return self._validate_records(transactions, "transaction")
     
     async def validate_accounts(self, accounts: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
         """
@@ -457,26 +741,7 @@ class DataValidator:
         Returns:
             List of validated and normalized accounts
         """
-        validated_accounts = []
-        
-        for account in accounts:
-            try:
-                # Validate account against schema
-                result = self.validate_data(account, "account")
-                
-                if result["valid"]:
-                    validated_accounts.append(result["normalized_data"])
-                else:
-                    logger.warning(f"Invalid account {account.get('id', 'unknown')}: {result['errors']}")
-                    # Include the account anyway with a warning flag
-                    account["validation_warnings"] = result["errors"]
-                    validated_accounts.append(account)
-            except Exception as e:
-                logger.error(f"Error validating account: {e}")
-                account["validation_error"] = str(e)
-                validated_accounts.append(account)
-        
-        return validated_accounts
+        return self._validate_records(accounts, "account")
     
     async def validate_liabilities(self, liabilities: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
         """
@@ -488,26 +753,7 @@ class DataValidator:
         Returns:
             List of validated and normalized liabilities
         """
-        validated_liabilities = []
-        
-        for liability in liabilities:
-            try:
-                # Validate liability against schema
-                result = self.validate_data(liability, "liability")
-                
-                if result["valid"]:
-                    validated_liabilities.append(result["normalized_data"])
-                else:
-                    logger.warning(f"Invalid liability {liability.get('id', 'unknown')}: {result['errors']}")
-                    # Include the liability anyway with a warning flag
-                    liability["validation_warnings"] = result["errors"]
-                    validated_liabilities.append(liability)
-            except Exception as e:
-                logger.error(f"Error validating liability: {e}")
-                liability["validation_error"] = str(e)
-                validated_liabilities.append(liability)
-        
-        return validated_liabilities
+        return self._validate_records(liabilities, "liability")
     
     async def validate_investments(self, investments: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
         """
@@ -519,26 +765,7 @@ class DataValidator:
         Returns:
             List of validated and normalized investments
         """
-        validated_investments = []
-        
-        for investment in investments:
-            try:
-                # Validate investment against schema
-                result = self.validate_data(investment, "investment")
-                
-                if result["valid"]:
-                    validated_investments.append(result["normalized_data"])
-                else:
-                    logger.warning(f"Invalid investment {investment.get('id', 'unknown')}: {result['errors']}")
-                    # Include the investment anyway with a warning flag
-                    investment["validation_warnings"] = result["errors"]
-                    validated_investments.append(investment)
-            except Exception as e:
-                logger.error(f"Error validating investment: {e}")
-                investment["validation_error"] = str(e)
-                validated_investments.append(investment)
-        
-        return validated_investments
+        return self._validate_records(investments, "investment")
 
 
 # Import math for loan calculations
@@ -1,20 +1,65 @@
 """
 Dataset Integration Service for MintelliFunds
 Handles custom dataset loading, processing, and LLM integration
+
+Registered datasets are converted once into memory-mapped Parquet files with
+fixed-size row groups; reads then project columns and push filters down to
+row group statistics, and training exports stream batch by batch instead of
+holding the whole dataset in memory
 """
 import logging
 import json
 import os
+import sys
+import threading
+from collections import OrderedDict
+from itertools import chain, islice
 from pathlib import Path
-from typing import Dict, Any, List, Optional, Union
+from typing import Dict, Any, List, Optional, Union, Iterator, Iterable, Sequence, Tuple
 from datetime import datetime
 import pandas as pd
 import numpy as np
 from dataclasses import dataclass, field
 from enum import Enum
 
+try:
+    import pyarrow as pa
+    import pyarrow.csv as pa_csv
+    import pyarrow.dataset as pa_dataset
+    import pyarrow.parquet as pq
+except ImportError:  # datasets are then read from their raw files
+    pa = None
+
+from .shared_snapshot import broadcast_invalidation, on_invalidation
+from .vector_index import VectorIndex, get_embedder, write_index, batched, EMBED_BATCH_SIZE
+from .retrieval_service import transaction_text
+
 logger = logging.getLogger(__name__)
 
+# Rows per Parquet row group; the unit of predicate pushdown and of streaming reads
+ROW_GROUP_SIZE = 65536
+
+# Rows per batch yielded by scans and training iterators
+SCAN_BATCH_SIZE = 10000
+
+# Memory budget for datasets kept loaded between calls
+DATASET_CACHE_MB = float(os.getenv("DATASET_CACHE_MB", "256"))
+
+# (column, op, value) filters, as accepted by pandas/pyarrow read_parquet
+Filters = Sequence[Tuple[str, str, Any]]
+
+_FILTER_OPS = {
+    "==": lambda a, b: a == b,
+    "=": lambda a, b: a == b,
+    "!=": lambda a, b: a != b,
+    "<": lambda a, b: a < b,
+    "<=": lambda a, b: a <= b,
+    ">": lambda a, b: a > b,
+    ">=": lambda a, b: a >= b,
+    "in": lambda a, b: a in b,
+    "not in": lambda a, b: a not in b,
+}
+
 class DatasetType(Enum):
     """Supported dataset types"""
     FINANCIAL_TRANSACTIONS = "financial_transactions"
@@ -48,6 +93,65 @@ class DatasetMetadata:
     schema: Dict[str, Any] = field(default_factory=dict)
     tags: List[str] = field(default_factory=list)
     preprocessing_config: Dict[str, Any] = field(default_factory=dict)
+    columnar_path: Optional[str] = None
+
+def _estimate_size(value: Any) -> int:
+    """Approximate in-memory size of loaded dataset contents in bytes"""
+    if isinstance(value, pd.DataFrame):
+        return int(value.memory_usage(index=True, deep=False).sum())
+    if isinstance(value, list):
+        # Sample rather than walk every record
+        sample = value[:100]
+        per_record = sum(sys.getsizeof(r) + sum(sys.getsizeof(v) for v in (r.values() if isinstance(r, dict) else ()))
+                         for r in sample) / max(1, len(sample))
+        return int(sys.getsizeof(value) + per_record * len(value))
+    return sys.getsizeof(value)
+
+class DatasetCache:
+    """LRU of loaded datasets bounded by estimated memory rather than entry count"""
+    
+    def __init__(self, max_bytes: int):
+        self.max_bytes = max_bytes
+        self.current_bytes = 0
+        self._entries: "OrderedDict[Any, Tuple[int, Dict[str, Any]]]" = OrderedDict()
+        self._lock = threading.Lock()
+    
+    def get(self, key: Any) -> Optional[Dict[str, Any]]:
+        with self._lock:
+            entry = self._entries.get(key)
+            if entry is None:
+                return None
+            self._entries.move_to_end(key)
+            return entry[1]
+    
+    def put(self, key: Any, value: Dict[str, Any]) -> None:
+        """Cache a loaded dataset; entries larger than the whole budget are not kept"""
+        size = _estimate_size(value.get("data"))
+        if size > self.max_bytes:
+            return
+        with self._lock:
+            previous = self._entries.pop(key, None)
+            if previous is not None:
+                self.current_bytes -= previous[0]
+            self._entries[key] = (size, value)
+            self.current_bytes += size
+            while self.current_bytes > self.max_bytes and self._entries:
+                evicted_size, _ = self._entries.popitem(last=False)[1]
+                self.current_bytes -= evicted_size
+    
+    def discard(self, name: str) -> None:
+        """Drop every cached load of a dataset"""
+        with self._lock:
+            for key in [k for k in self._entries if k[0] == name]:
+                self.current_bytes -= self._entries.pop(key)[0]
+    
+    def clear(self) -> None:
+        with self._lock:
+            self._entries.clear()
+            self.current_bytes = 0
+    
+    def __len__(self) -> int:
+        return len(self._entries)
 
 class DatasetService:
     """Service for managing custom datasets and LLM integration"""
@@ -62,14 +166,19 @@ class DatasetService:
         self.datasets_directory = Path(datasets_directory)
         self.datasets_directory.mkdir(parents=True, exist_ok=True)
         
-        self.loaded_datasets: Dict[str, Dict[str, Any]] = {}
+        self.loaded_datasets = DatasetCache(int(DATASET_CACHE_MB * 1024 * 1024))
         self.dataset_metadata: Dict[str, DatasetMetadata] = {}
+        self._embedding_indexes: Dict[str, VectorIndex] = {}
         
         # Initialize directories
         self._initialize_directories()
         
         # Load existing dataset metadata
         self._load_dataset_metadata()
+
+        # Datasets registered by another worker replace this worker's cached copy
+        on_invalidation("datasets", self._forget_dataset)
+        on_invalidation("embeddings", self._forget_embeddings)
         
     def _initialize_directories(self):
         """Initialize required directories for dataset management"""
@@ -111,7 +220,8 @@ class DatasetService:
                         updated_at=datetime.fromisoformat(meta["updated_at"]),
                         schema=meta.get("schema", {}),
                         tags=meta.get("tags", []),
-                        preprocessing_config=meta.get("preprocessing_config", {})
+                        preprocessing_config=meta.get("preprocessing_config", {}),
+                        columnar_path=meta.get("columnar_path")
                     )
                     
                 logger.info(f"Loaded metadata for {len(self.dataset_metadata)} datasets")
@@ -140,7 +250,8 @@ class DatasetService:
                     "updated_at": meta.updated_at.isoformat(),
                     "schema": meta.schema,
                     "tags": meta.tags,
-                    "preprocessing_config": meta.preprocessing_config
+                    "preprocessing_config": meta.preprocessing_config,
+                    "columnar_path": meta.columnar_path
                 }
             
             with open(metadata_file, 'w') as f:
@@ -188,8 +299,13 @@ class DatasetService:
             # Get file size
             size_mb = file_path_obj.stat().st_size / (1024 * 1024)
             
-            # Load and analyze dataset
-            columns, record_count, schema = self._analyze_dataset(file_path, dataset_format)
+            # Convert once to columnar form; its footer then gives the columns and
+            # record count without re-reading the source
+            columnar_path = self._convert_to_columnar(name, file_path, dataset_format)
+            if columnar_path:
+                columns, record_count, schema = self._analyze_columnar(columnar_path)
+            else:
+                columns, record_count, schema = self._analyze_dataset(file_path, dataset_format)
             
             # Create metadata
             metadata = DatasetMetadata(
@@ -206,11 +322,14 @@ class DatasetService:
                 updated_at=datetime.utcnow(),
                 schema=schema,
                 tags=tags or [],
-                preprocessing_config=preprocessing_config or {}
+                preprocessing_config=preprocessing_config or {},
+                columnar_path=columnar_path
             )
             
             self.dataset_metadata[name] = metadata
+            self.loaded_datasets.discard(name)
             self._save_dataset_metadata()
+            broadcast_invalidation("datasets", name)
             
             logger.info(f"Dataset '{name}' registered successfully")
             return True
@@ -219,6 +338,96 @@ class DatasetService:
             logger.error(f"Error registering dataset '{name}': {e}")
             return False
     
+    def _convert_to_columnar(self, name: str, file_path: str, dataset_format: DatasetFormat) -> Optional[str]:
+        """
+        Write a dataset to ``processed/<name>.parquet`` in fixed-size row groups
+        
+        CSV and JSONL sources are streamed, so conversion never holds more than
+        one row group in memory; JSON arrays have to be parsed whole once.
+        
+        Returns:
+            Path of the columnar file, or None if pyarrow is unavailable or conversion failed
+        """
+        if pa is None:
+            logger.info("pyarrow not installed, datasets are read from raw files")
+            return None
+        if dataset_format == DatasetFormat.PARQUET:
+            return str(file_path)
+        
+        target = self.datasets_directory / "processed" / f"{name}.parquet"
+        partial = target.with_suffix(".parquet.tmp")
+        writer = None
+        try:
+            if dataset_format == DatasetFormat.CSV:
+                batches = pa_csv.open_csv(
+                    file_path, read_options=pa_csv.ReadOptions(block_size=16 * 1024 * 1024)
+                )
+                tables = (pa.Table.from_batches([batch]) for batch in batches)
+            elif dataset_format in (DatasetFormat.JSONL, DatasetFormat.JSON):
+                tables = self._record_tables(self._iter_raw_records(file_path, dataset_format))
+            else:
+                return None
+            
+            for table in tables:
+                if writer is None:
+                    writer = pq.ParquetWriter(str(partial), table.schema)
+                elif table.schema != writer.schema:
+                    table = table.cast(writer.schema)
+                writer.write_table(table, row_group_size=ROW_GROUP_SIZE)
+            
+            if writer is None:
+                return None
+            writer.close()
+            writer = None
+            os.replace(partial, target)
+            logger.info(f"Dataset '{name}' converted to columnar format at {target}")
+            return str(target)
+            
+        except Exception as e:
+            logger.warning(f"Columnar conversion of '{name}' failed, using raw file: {e}")
+            return None
+        finally:
+            if writer is not None:
+                writer.close()
+            if partial.exists():
+                partial.unlink()
+    
+    def _record_tables(self, records: Iterable[Dict[str, Any]]) -> Iterator["pa.Table"]:
+        """
+        Group records into row-group-sized Arrow tables with the same columns
+        
+        Columns are every key seen in the first chunk, not just its first
+        record's, and column types are inferred from all of a chunk's values.
+        A later chunk introducing a new key raises ValueError, so conversion
+        falls back to the raw file instead of silently dropping that field.
+        """
+        columns = None
+        rows_seen = 0
+        iterator = iter(records)
+        while True:
+            chunk = list(islice(iterator, ROW_GROUP_SIZE))
+            if not chunk:
+                return
+            keys = list(dict.fromkeys(key for record in chunk for key in record))
+            if columns is None:
+                columns = keys
+            else:
+                new_keys = [key for key in keys if key not in columns]
+                if new_keys:
+                    raise ValueError(f"fields {new_keys} first appear after record {rows_seen}")
+            rows_seen += len(chunk)
+            yield pa.Table.from_pydict({col: [record.get(col) for record in chunk] for col in columns})
+    
+    def _analyze_columnar(self, columnar_path: str) -> tuple:
+        """Read columns, record count and schema from a Parquet footer"""
+        parquet_file = pq.ParquetFile(columnar_path, memory_map=True)
+        schema = parquet_file.schema_arrow
+        return (
+            list(schema.names),
+            parquet_file.metadata.num_rows,
+            {field_.name: str(field_.type) for field_ in schema}
+        )
+    
     def _analyze_dataset(self, file_path: str, dataset_format: DatasetFormat) -> tuple:
         """
         Analyze dataset to extract metadata
@@ -234,7 +443,10 @@ class DatasetService:
             if dataset_format == DatasetFormat.CSV:
                 df = pd.read_csv(file_path, nrows=1000)  # Sample first 1000 rows for analysis
                 columns = list(df.columns)
-                record_count = len(pd.read_csv(file_path))
+                # Count in chunks of one column rather than loading the whole file
+                record_count = sum(
+                    len(chunk) for chunk in pd.read_csv(file_path, usecols=[0], chunksize=SCAN_BATCH_SIZE * 10)
+                )
                 schema = {col: str(df[col].dtype) for col in df.columns}
                 
             elif dataset_format == DatasetFormat.JSON:
@@ -275,13 +487,18 @@ class DatasetService:
             logger.error(f"Error analyzing dataset: {e}")
             return [], 0, {}
     
-    def load_dataset(self, name: str, max_records: Optional[int] = None) -> Optional[Dict[str, Any]]:
+    def load_dataset(self, name: str, max_records: Optional[int] = None,
+                     columns: Optional[List[str]] = None,
+                     filters: Optional[Filters] = None) -> Optional[Dict[str, Any]]:
         """
         Load dataset into memory
         
         Args:
             name: Dataset name
             max_records: Maximum number of records to load
+            columns: Only load these columns
+            filters: (column, op, value) predicates; with the columnar format
+                they skip whole row groups using their statistics
             
         Returns:
             Loaded dataset or None
@@ -294,52 +511,52 @@ class DatasetService:
             metadata = self.dataset_metadata[name]
             
             # Check if already loaded
-            if name in self.loaded_datasets:
+            cache_key = (name, max_records, tuple(columns or ()), repr(filters))
+            cached = self.loaded_datasets.get(cache_key)
+            if cached is not None:
                 logger.info(f"Dataset '{name}' already loaded from cache")
-                return self.loaded_datasets[name]
+                return cached
             
-            # Load based on format
-            if metadata.format == DatasetFormat.CSV:
-                df = pd.read_csv(metadata.file_path, nrows=max_records)
+            if metadata.columnar_path and pa is not None:
                 data = {
-                    "data": df,
+                    "data": self._read_columnar(metadata, max_records, columns, filters),
                     "metadata": metadata,
                     "type": "dataframe"
                 }
-                
-            elif metadata.format == DatasetFormat.JSON:
-                with open(metadata.file_path, 'r') as f:
-                    json_data = json.load(f)
-                
-                if max_records and isinstance(json_data, list):
-                    json_data = json_data[:max_records]
-                
+            
+            # Load based on format
+            elif metadata.format == DatasetFormat.CSV:
+                # Filter columns are read even when not projected, and the row
+                # limit applies after filtering, as with the columnar path
+                read_columns = list(dict.fromkeys([*columns, *(f[0] for f in filters or ())])) if columns else None
+                df = pd.read_csv(metadata.file_path, nrows=None if filters else max_records, usecols=read_columns)
+                if filters:
+                    df = df[df.apply(lambda row: self._matches(row, filters), axis=1)]
+                    if max_records:
+                        df = df.head(max_records)
+                if columns:
+                    df = df[columns]
                 data = {
-                    "data": json_data,
+                    "data": df,
                     "metadata": metadata,
-                    "type": "json"
+                    "type": "dataframe"
                 }
                 
-            elif metadata.format == DatasetFormat.JSONL:
-                records = []
-                with open(metadata.file_path, 'r') as f:
-                    for i, line in enumerate(f):
-                        if max_records and i >= max_records:
-                            break
-                        records.append(json.loads(line.strip()))
-                
+            elif metadata.format in (DatasetFormat.JSON, DatasetFormat.JSONL):
+                records = self._iter_raw_records(metadata.file_path, metadata.format)
+                records = self._project(records, columns, filters)
                 data = {
-                    "data": records,
+                    "data": list(islice(records, max_records) if max_records else records),
                     "metadata": metadata,
-                    "type": "jsonl"
+                    "type": metadata.format.value
                 }
                 
             else:
                 logger.error(f"Unsupported dataset format: {metadata.format}")
                 return None
             
-            # Cache loaded dataset
-            self.loaded_datasets[name] = data
+            # Cache loaded dataset within the memory budget
+            self.loaded_datasets.put(cache_key, data)
             
             logger.info(f"Dataset '{name}' loaded successfully")
             return data
@@ -348,64 +565,193 @@ class DatasetService:
             logger.error(f"Error loading dataset '{name}': {e}")
             return None
     
+    def _read_columnar(self, metadata: DatasetMetadata, max_records: Optional[int],
+                       columns: Optional[List[str]], filters: Optional[Filters]) -> pd.DataFrame:
+        """Read a projection of the memory-mapped Parquet file as a DataFrame"""
+        if max_records is None:
+            table = pq.read_table(metadata.columnar_path, columns=columns, filters=filters or None,
+                                  memory_map=True)
+        else:
+            # Stop once enough rows are decoded instead of reading every row group
+            batches = []
+            remaining = max_records
+            for batch in self._columnar_batches(metadata, columns, filters, min(remaining, SCAN_BATCH_SIZE)):
+                batches.append(batch.slice(0, remaining))
+                remaining -= min(remaining, batch.num_rows)
+                if remaining <= 0:
+                    break
+            table = pa.Table.from_batches(batches) if batches else pq.read_schema(
+                metadata.columnar_path, memory_map=True
+            ).empty_table()
+            if columns and not batches:
+                table = table.select(columns)
+        return table.to_pandas()
+    
+    def _columnar_batches(self, metadata: DatasetMetadata, columns: Optional[List[str]],
+                          filters: Optional[Filters], batch_size: int) -> Iterator["pa.RecordBatch"]:
+        """Yield record batches with column projection and row-group-pruning filters"""
+        source = pa_dataset.dataset(metadata.columnar_path, format="parquet")
+        expression = pq.filters_to_expression(filters) if filters else None
+        yield from source.to_batches(columns=columns, filter=expression, batch_size=batch_size)
+    
+    def _iter_raw_records(self, file_path: str, dataset_format: DatasetFormat) -> Iterator[Dict[str, Any]]:
+        """Yield records from a raw JSON, JSONL or CSV file"""
+        if dataset_format == DatasetFormat.JSONL:
+            with open(file_path, 'r') as f:
+                for line in f:
+                    line = line.strip()
+                    if line:
+                        yield json.loads(line)
+        elif dataset_format == DatasetFormat.JSON:
+            with open(file_path, 'r') as f:
+                json_data = json.load(f)
+            yield from (json_data if isinstance(json_data, list) else [json_data])
+        elif dataset_format == DatasetFormat.CSV:
+            for chunk in pd.read_csv(file_path, chunksize=SCAN_BATCH_SIZE):
+                yield from chunk.to_dict("records")
+    
+    @staticmethod
+    def _matches(record: Any, filters: Filters) -> bool:
+        """Evaluate (column, op, value) predicates against one record"""
+        for column, op, value in filters:
+            try:
+                if not _FILTER_OPS[op](record[column], value):
+                    return False
+            except (KeyError, TypeError):
+                return False
+        return True
+    
+    def _project(self, records: Iterable[Dict[str, Any]], columns: Optional[List[str]],
+                 filters: Optional[Filters]) -> Iterator[Dict[str, Any]]:
+        """Apply filters and column projection to raw records"""
+        for record in records:
+            if filters and not self._matches(record, filters):
+                continue
+            yield {col: record.get(col) for col in columns} if columns else record
+    
+    def iter_records(self, name: str, columns: Optional[List[str]] = None,
+                     filters: Optional[Filters] = None,
+                     batch_size: int = SCAN_BATCH_SIZE) -> Iterator[List[Dict[str, Any]]]:
+        """
+        Stream a dataset in batches without loading it whole
+        
+        Args:
+            name: Dataset name
+            columns: Only read these columns
+            filters: (column, op, value) predicates
+            batch_size: Records per yielded batch
+            
+        Yields:
+            Lists of record dictionaries
+        """
+        metadata = self.dataset_metadata.get(name)
+        if metadata is None:
+            logger.error(f"Dataset '{name}' not found")
+            return
+        
+        if metadata.columnar_path and pa is not None:
+            for batch in self._columnar_batches(metadata, columns, filters, batch_size):
+                if batch.num_rows:
+                    yield batch.to_pylist()
+            return
+        
+        records = self._project(self._iter_raw_records(metadata.file_path, metadata.format), columns, filters)
+        while True:
+            batch = list(islice(records, batch_size))
+            if not batch:
+                return
+            yield batch
+    
+    def iter_llm_training_batches(self, dataset_name: str,
+                                  batch_size: int = SCAN_BATCH_SIZE) -> Iterator[List[Dict[str, Any]]]:
+        """
+        Stream LLM-ready examples in batches, converting each batch as it is read
+        
+        Args:
+            dataset_name: Name of dataset
+            batch_size: Source records per batch
+            
+        Yields:
+            Lists of training examples (or knowledge base records)
+        """
+        metadata = self.dataset_metadata.get(dataset_name)
+        if metadata is None:
+            logger.error(f"Dataset '{dataset_name}' not found")
+            return
+        
+        # Financial rows only need the fields the prompt template uses
+        columns = None
+        if metadata.type == DatasetType.FINANCIAL_TRANSACTIONS:
+            columns = [col for col in ("amount", "category", "date") if col in metadata.columns] or None
+        
+        for batch in self.iter_records(dataset_name, columns=columns, batch_size=batch_size):
+            if metadata.type == DatasetType.FINANCIAL_TRANSACTIONS:
+                yield self._convert_financial_to_training_data(batch)
+            else:
+                yield batch
+    
     def get_dataset_for_llm_training(self, dataset_name: str) -> Optional[Dict[str, Any]]:
         """
         Prepare dataset specifically for LLM training/fine-tuning
         
+        The examples are streamed from ``iter_llm_training_batches``; iterate
+        them once (or pass them to ``export_dataset_for_training``) rather than
+        materializing the whole dataset.
+        
         Args:
             dataset_name: Name of dataset
             
         Returns:
-            LLM-ready dataset
+            LLM-ready dataset whose data is a lazy iterator of examples
         """
-        try:
-            dataset = self.load_dataset(dataset_name)
-            if not dataset:
-                return None
-            
-            metadata = dataset["metadata"]
-            
-            if metadata.type == DatasetType.AI_TRAINING_DATA:
-                # Already formatted for AI training
-                return {
-                    "training_data": dataset["data"],
-                    "format": "conversation" if "prompt" in metadata.columns else "completion",
-                    "metadata": metadata
-                }
-            
-            elif metadata.type == DatasetType.FINANCIAL_TRANSACTIONS:
-                # Convert financial data to training format
-                training_data = self._convert_financial_to_training_data(dataset["data"])
-                return {
-                    "training_data": training_data,
-                    "format": "financial_qa",
-                    "metadata": metadata
-                }
-            
-            elif metadata.type == DatasetType.CUSTOM_FINANCIAL_KNOWLEDGE:
-                # Custom knowledge base for RAG
-                return {
-                    "knowledge_base": dataset["data"],
-                    "format": "knowledge_base",
-                    "metadata": metadata
-                }
-            
-            else:
-                logger.warning(f"Dataset type {metadata.type} not optimized for LLM training")
-                return dataset
-                
-        except Exception as e:
-            logger.error(f"Error preparing dataset for LLM: {e}")
+        metadata = self.dataset_metadata.get(dataset_name)
+        if metadata is None:
+            logger.error(f"Dataset '{dataset_name}' not found")
             return None
+        
+        examples = chain.from_iterable(self.iter_llm_training_batches(dataset_name))
+        
+        if metadata.type == DatasetType.AI_TRAINING_DATA:
+            # Already formatted for AI training
+            return {
+                "training_data": examples,
+                "format": "conversation" if "prompt" in metadata.columns else "completion",
+                "metadata": metadata
+            }
+        
+        elif metadata.type == DatasetType.FINANCIAL_TRANSACTIONS:
+            # Converted to training format batch by batch
+            return {
+                "training_data": examples,
+                "format": "financial_qa",
+                "metadata": metadata
+            }
+        
+        elif metadata.type == DatasetType.CUSTOM_FINANCIAL_KNOWLEDGE:
+            # Custom knowledge base for RAG
+            return {
+                "knowledge_base": examples,
+                "format": "knowledge_base",
+                "metadata": metadata
+            }
+        
+        else:
+            logger.warning(f"Dataset type {metadata.type} not optimized for LLM training")
+            return {
+                "data": examples,
+                "format": "records",
+                "metadata": metadata
+            }
     
     def _convert_financial_to_training_data(self, data) -> List[Dict[str, str]]:
         """Convert financial data to training format"""
         training_examples = []
         
         try:
-            if isinstance(data, pd.DataFrame):
+            rows = data.to_dict("records") if isinstance(data, pd.DataFrame) else data
+            if isinstance(rows, list):
                 # Convert transactions to Q&A format
-                for _, row in data.iterrows():
+                for row in rows:
                     # Example conversion - customize based on your data structure
                     prompt = f"Analyze this transaction: Amount: ${row.get('amount', 0)}, Category: {row.get('category', 'Unknown')}, Date: {row.get('date', 'Unknown')}"
                     completion = f"This is a {row.get('category', 'general')} transaction for ${row.get('amount', 0)}. " + \
@@ -416,7 +762,7 @@ class DatasetService:
                         "completion": completion
                     })
             
-            logger.info(f"Generated {len(training_examples)} training examples from financial data")
+            logger.debug(f"Generated {len(training_examples)} training examples from financial data")
             return training_examples
             
         except Exception as e:
@@ -425,43 +771,91 @@ class DatasetService:
     
     def create_embeddings(self, dataset_name: str, embedding_model: str = "default") -> bool:
         """
-        Create embeddings for dataset (placeholder for your custom implementation)
+        Embed a dataset into a quantized vector index
+        
+        Records are streamed, embedded in batches and written to
+        ``embeddings/<name>/`` as a memory-mapped vector file, so datasets
+        larger than memory can be indexed.
         
         Args:
             dataset_name: Name of dataset
-            embedding_model: Embedding model to use
+            embedding_model: Embedding model to use ("default" is the local hashing embedder)
             
         Returns:
             Success status
         """
         try:
-            dataset = self.load_dataset(dataset_name)
-            if not dataset:
+            metadata = self.dataset_metadata.get(dataset_name)
+            if metadata is None:
+                logger.error(f"Dataset '{dataset_name}' not found")
                 return False
             
             embeddings_dir = self.datasets_directory / "embeddings" / dataset_name
-            embeddings_dir.mkdir(parents=True, exist_ok=True)
             
-            # Placeholder - implement your custom embedding logic here
-            # This is where you would integrate with your LLM/embedding service
+            def pairs() -> Iterator[Tuple[str, Dict[str, Any]]]:
+                row = 0
+                for batch in self.iter_records(dataset_name, batch_size=EMBED_BATCH_SIZE):
+                    for record in batch:
+                        text = self._embedding_text(metadata.type, record)
+                        yield text, {"row": row, "text": text[:200]}
+                        row += 1
             
-            embedding_info = {
+            info = write_index(embeddings_dir, batched(pairs()), get_embedder(embedding_model), {
                 "dataset_name": dataset_name,
-                "embedding_model": embedding_model,
-                "created_at": datetime.utcnow().isoformat(),
-                "status": "ready_for_custom_implementation"
-            }
-            
-            with open(embeddings_dir / "info.json", 'w') as f:
-                json.dump(embedding_info, f, indent=2)
+                "dataset_version": metadata.version
+            })
+            self._forget_embeddings(dataset_name)
+            broadcast_invalidation("embeddings", dataset_name)
             
-            logger.info(f"Embeddings structure created for dataset '{dataset_name}'")
+            logger.info(f"Embedded {info['vectors']} records of dataset '{dataset_name}'")
             return True
             
         except Exception as e:
             logger.error(f"Error creating embeddings for '{dataset_name}': {e}")
             return False
     
+    def search_embeddings(self, dataset_name: str, query: str, k: int = 5) -> List[Dict[str, Any]]:
+        """
+        Find the records nearest to a query in a dataset's vector index
+        
+        Args:
+            dataset_name: Name of dataset (embedded with create_embeddings)
+            query: Search text
+            k: Number of results
+            
+        Returns:
+            Payloads (row number and text) with their similarity scores, best first
+        """
+        index = self._embedding_indexes.get(dataset_name)
+        if index is None:
+            index = VectorIndex.open(self.datasets_directory / "embeddings" / dataset_name)
+            if index is None:
+                logger.error(f"No embeddings for dataset '{dataset_name}'")
+                return []
+            self._embedding_indexes[dataset_name] = index
+        
+        embedder = get_embedder(index.info.get("embedding_model", "default"))
+        return [{**payload, "score": round(score, 4)}
+                for score, payload in index.search(embedder.embed_query(query), k)]
+    
+    def _embedding_text(self, dataset_type: DatasetType, record: Dict[str, Any]) -> str:
+        """Text embedded for one dataset record"""
+        if dataset_type == DatasetType.FINANCIAL_TRANSACTIONS:
+            return transaction_text(record)
+        if dataset_type == DatasetType.AI_TRAINING_DATA:
+            parts = [record.get(key) for key in ("prompt", "query", "completion", "response")]
+            if any(parts):
+                return " ".join(str(part) for part in parts if part)
+        return " ".join(str(value) for value in record.values() if isinstance(value, str))
+    
+    def _forget_embeddings(self, name: Optional[str]):
+        """Drop a mapped index that was rebuilt, here or in another worker"""
+        names = list(self._embedding_indexes) if name is None else [name]
+        for dataset_name in names:
+            index = self._embedding_indexes.pop(dataset_name, None)
+            if index is not None:
+                index.close()
+    
     def get_dataset_stats(self, dataset_name: str) -> Optional[Dict[str, Any]]:
         """Get comprehensive dataset statistics"""
         try:
@@ -534,25 +928,39 @@ class DatasetService:
             Path to exported file or None
         """
         try:
-            training_data = self.get_dataset_for_llm_training(dataset_name)
-            if not training_data:
+            if dataset_name not in self.dataset_metadata:
+                logger.error(f"Dataset '{dataset_name}' not found")
                 return None
             
             export_dir = self.datasets_directory / "exports"
             export_file = export_dir / f"{dataset_name}_training.{export_format}"
+            batches = self.iter_llm_training_batches(dataset_name)
             
+            # Written batch by batch so the export never holds the dataset in memory
             if export_format == "jsonl":
                 with open(export_file, 'w') as f:
-                    for item in training_data["training_data"]:
-                        f.write(json.dumps(item) + "\n")
+                    for batch in batches:
+                        f.writelines(json.dumps(item, default=str) + "\n" for item in batch)
             
             elif export_format == "json":
                 with open(export_file, 'w') as f:
-                    json.dump(training_data["training_data"], f, indent=2)
+                    f.write("[")
+                    first = True
+                    for batch in batches:
+                        for item in batch:
+                            f.write(("\n  " if first else ",\n  ") + json.dumps(item, default=str))
+                            first = False
+                    f.write("\n]\n" if not first else "]\n")
+            
+            elif export_format == "csv":
+                header = True
+                for batch in batches:
+                    pd.DataFrame(batch).to_csv(export_file, index=False, header=header, mode='w' if header else 'a')
+                    header = False
             
-            elif export_format == "csv" and isinstance(training_data["training_data"], list):
-                df = pd.DataFrame(training_data["training_data"])
-                df.to_csv(export_file, index=False)
+            else:
+                logger.error(f"Unsupported export format: {export_format}")
+                return None
             
             logger.info(f"Dataset exported to: {export_file}")
             return str(export_file)
@@ -564,7 +972,16 @@ class DatasetService:
     def cleanup_cache(self):
         """Clean up loaded datasets from memory"""
         self.loaded_datasets.clear()
+        broadcast_invalidation("datasets")
         logger.info("Dataset cache cleared")
+
+    def _forget_dataset(self, name: Optional[str]):
+        """Drop a dataset another worker re-registered and pick up its metadata"""
+        if name is None:
+            self.loaded_datasets.clear()
+        else:
+            self.loaded_datasets.discard(name)
+        self._load_dataset_metadata()
     
     def get_service_info(self) -> Dict[str, Any]:
         """Get dataset service information"""
@@ -572,6 +989,9 @@ class DatasetService:
             "datasets_directory": str(self.datasets_directory),
             "registered_datasets": len(self.dataset_metadata),
             "loaded_datasets": len(self.loaded_datasets),
+            "cache_mb": round(self.loaded_datasets.current_bytes / (1024 * 1024), 2),
+            "cache_budget_mb": DATASET_CACHE_MB,
+            "columnar_format": "parquet" if pa is not None else None,
             "supported_types": [t.value for t in DatasetType],
             "supported_formats": [f.value for f in DatasetFormat],
             "directories": {
@@ -1,17 +1,20 @@
 """
-Enhanced AI service with caching, real API integration, and performance optimizations
-"""
 Enhanced AI service for generating contextual financial responses
 Provides advanced context-aware response generation with conversation memory
 """
 import logging
 import json
-from typing import Dict, Any, Optional, List, Tuple
+from typing import Dict, Any, Optional, List, Tuple, AsyncIterator
 from datetime import datetime, timedelta
 from enum import Enum
 from dataclasses import dataclass, field
 import hashlib
 
+from .llm_client import generate_text, stream_text, stream_words
+from .response_cache import get_prompt_library, get_response_cache, response_key
+from .retrieval_service import format_headline_figures, format_retrieved_context
+from .context_store import ContextStore, get_context_spill
+
 logger = logging.getLogger(__name__)
 
 # Try to import Google Generative AI, fallback to mock if not available
@@ -53,6 +56,25 @@ class ResponseContext:
     financial_goals: List[str] = field(default_factory=list)
     risk_tolerance: str = "moderate"
     experience_level: str = "beginner"
+    
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "user_id": self.user_id,
+            "session_id": self.session_id,
+            "conversation_topic": self.conversation_topic,
+            "user_preferences": self.user_preferences,
+            "response_history": self.response_history,
+            "financial_goals": self.financial_goals,
+            "risk_tolerance": self.risk_tolerance,
+            "experience_level": self.experience_level
+        }
+    
+    @classmethod
+    def from_dict(cls, data: Dict[str, Any]) -> "ResponseContext":
+        fields = ("conversation_topic", "user_preferences", "response_history",
+                  "financial_goals", "risk_tolerance", "experience_level")
+        return cls(user_id=data["user_id"], session_id=data["session_id"],
+                   **{name: data[name] for name in fields if name in data})
 
 
 @dataclass
@@ -78,7 +100,10 @@ class EnhancedAIService:
         """
         self.api_key = api_key
         self.model = None
-        self.response_contexts: Dict[str, ResponseContext] = {}
+        self.response_contexts = ContextStore("ai_responses", spill=get_context_spill(),
+                                              from_dict=ResponseContext.from_dict)
+        self.response_cache = get_response_cache()
+        self.prompt_library = get_prompt_library()
         self._initialize_model()
         self._initialize_financial_knowledge()
         self._initialize_response_templates()
@@ -221,17 +246,9 @@ class EnhancedAIService:
         """
         try:
             logger.info("Generating enhanced AI response for financial analysis")
-            
-            # Get or create response context
-            context_key = f"{user_id}:{session_id or 'default'}"
-            context = self._get_or_create_response_context(context_key, user_id, session_id)
-            
-            # Analyze the query and results for insights
-            insights = self._extract_financial_insights(analysis_results, nlp_context)
-            
-            # Determine response characteristics
-            response_tone = self._determine_response_tone(insights, nlp_context)
-            response_complexity = self._determine_response_complexity(context, nlp_context)
+            context, insights, response_tone, response_complexity = self._prepare_response(
+                nlp_context, analysis_results, user_id, session_id
+            )
             
             # Generate response based on availability of AI model
             if self.model:
@@ -255,15 +272,133 @@ class EnhancedAIService:
             logger.error(f"Error generating enhanced AI response: {str(e)}")
             return self._generate_fallback_response(analysis_results, user_query, nlp_context)
     
+    async def generate_response_async(self, analysis_results: Dict[str, Any], user_query: str,
+                                      nlp_context: Optional[Dict[str, Any]] = None,
+                                      user_id: str = "default", session_id: Optional[str] = None) -> str:
+        """
+        Generate an enhanced contextual response without blocking the event loop
+        
+        Args:
+            analysis_results: Results from financial analysis services
+            user_query: Original user query for context
+            nlp_context: Enhanced NLP processing results
+            user_id: User identifier for context management
+            session_id: Session identifier
+            
+        Returns:
+            Enhanced contextual AI response
+        """
+        try:
+            context, insights, response_tone, response_complexity = self._prepare_response(
+                nlp_context, analysis_results, user_id, session_id
+            )
+            args = (analysis_results, user_query, nlp_context, context, insights,
+                    response_tone, response_complexity)
+            
+            if self.model:
+                response = await self._generate_ai_response_async(*args)
+            else:
+                response = self._generate_enhanced_mock_response(*args)
+            
+            self._update_response_context(context, user_query, response, insights)
+            logger.info(f"Enhanced AI response generated: {len(response)} characters")
+            return response
+            
+        except Exception as e:
+            logger.error(f"Error generating enhanced AI response: {str(e)}")
+            return self._generate_fallback_response(analysis_results, user_query, nlp_context)
+    
+    async def stream_response(self, analysis_results: Dict[str, Any], user_query: str,
+                              nlp_context: Optional[Dict[str, Any]] = None,
+                              user_id: str = "default", session_id: Optional[str] = None) -> AsyncIterator[str]:
+        """
+        Stream an enhanced contextual response as it is generated
+        
+        Args:
+            analysis_results: Results from financial analysis services
+            user_query: Original user query for context
+            nlp_context: Enhanced NLP processing results
+            user_id: User identifier for context management
+            session_id: Session identifier
+            
+        Yields:
+            Response text pieces in order
+        """
+        try:
+            context, insights, response_tone, response_complexity = self._prepare_response(
+                nlp_context, analysis_results, user_id, session_id
+            )
+        except Exception as e:
+            logger.error(f"Error preparing enhanced AI response: {str(e)}")
+            async for piece in stream_words(self._generate_fallback_response(analysis_results, user_query, nlp_context)):
+                yield piece
+            return
+        
+        args = (analysis_results, user_query, nlp_context, context, insights,
+                response_tone, response_complexity)
+        pieces: List[str] = []
+        
+        cache_key = self._response_key(analysis_results, nlp_context, context, response_tone, response_complexity)
+        cached = self.response_cache.get(cache_key) if self.model else None
+        
+        if cached:
+            async for piece in stream_words(cached):
+                pieces.append(piece)
+                yield piece
+        elif self.model:
+            try:
+                prompt = self._construct_enhanced_prompt(*args)
+                async for piece in stream_text(self.model, prompt):
+                    pieces.append(piece)
+                    yield piece
+            except Exception as e:
+                logger.error(f"Error streaming AI response: {str(e)}")
+            else:
+                if pieces:
+                    self.response_cache.put(cache_key, "".join(pieces).strip())
+        
+        if not pieces:
+            async for piece in stream_words(self._generate_enhanced_mock_response(*args)):
+                pieces.append(piece)
+                yield piece
+        
+        self._update_response_context(context, user_query, "".join(pieces), insights)
+    
+    def _response_key(self, analysis_results: Dict[str, Any], nlp_context: Optional[Dict[str, Any]],
+                      context: ResponseContext, tone: ResponseTone, complexity: ResponseComplexity) -> Tuple:
+        """
+        Response cache key: intent, normalized entities, results digest, tone,
+        complexity and the user profile fields written into the prompt
+        """
+        entities = (nlp_context or {}).get("entities")
+        intent_name = ((nlp_context or {}).get("intent") or {}).get("name")
+        return response_key("enhanced_ai_service", analysis_results, entities,
+                            intent_name, tone.value, complexity.value,
+                            context.experience_level, context.risk_tolerance, context.conversation_topic)
+    
+    def _prepare_response(self, nlp_context: Optional[Dict[str, Any]], analysis_results: Dict[str, Any],
+                          user_id: str, session_id: Optional[str]
+                          ) -> Tuple[ResponseContext, List[FinancialInsight], ResponseTone, ResponseComplexity]:
+        """Resolve the conversation context, insights, tone and complexity for a response"""
+        # Get or create response context
+        context_key = f"{user_id}:{session_id or 'default'}"
+        context = self._get_or_create_response_context(context_key, user_id, session_id)
+        
+        # Analyze the query and results for insights
+        insights = self._extract_financial_insights(analysis_results, nlp_context)
+        
+        # Determine response characteristics
+        response_tone = self._determine_response_tone(insights, nlp_context)
+        response_complexity = self._determine_response_complexity(context, nlp_context)
+        return context, insights, response_tone, response_complexity
+    
     def _get_or_create_response_context(self, context_key: str, user_id: str, 
                                       session_id: Optional[str]) -> ResponseContext:
         """Get existing or create new response context"""
-        if context_key not in self.response_contexts:
-            self.response_contexts[context_key] = ResponseContext(
-                user_id=user_id,
-                session_id=session_id or "default"
-            )
-        return self.response_contexts[context_key]
+        return self.response_contexts.get_or_create(
+            user_id, session_id,
+            lambda: ResponseContext(user_id=user_id, session_id=session_id or "default")
+        )
     
     def _extract_financial_insights(self, analysis_results: Dict[str, Any], 
                                   nlp_context: Optional[Dict[str, Any]]) -> List[FinancialInsight]:
@@ -431,6 +566,12 @@ class EnhancedAIService:
                             complexity: ResponseComplexity) -> str:
         """Generate response using the AI model"""
         try:
+            # Near-duplicate queries over unchanged data reuse an earlier answer
+            cache_key = self._response_key(analysis_results, nlp_context, context, tone, complexity)
+            cached = self.response_cache.get(cache_key)
+            if cached:
+                return cached
+            
             # Construct enhanced prompt
             prompt = self._construct_enhanced_prompt(
                 analysis_results, user_query, nlp_context, context, insights, tone, complexity
@@ -440,7 +581,9 @@ class EnhancedAIService:
             response = self.model.generate_content(prompt)
             
             if response and response.text:
-                return response.text.strip()
+                text = response.text.strip()
+                self.response_cache.put(cache_key, text)
+                return text
             else:
                 logger.warning("Empty response from AI model, using fallback")
                 return self._generate_enhanced_mock_response(
@@ -453,11 +596,39 @@ class EnhancedAIService:
                 analysis_results, user_query, nlp_context, context, insights, tone, complexity
             )
     
+    async def _generate_ai_response_async(self, analysis_results: Dict[str, Any], user_query: str,
+                                          nlp_context: Optional[Dict[str, Any]], context: ResponseContext,
+                                          insights: List[FinancialInsight], tone: ResponseTone, 
+                                          complexity: ResponseComplexity) -> str:
+        """Generate response using the AI model without blocking the event loop"""
+        try:
+            text = await self.response_cache.get_or_compute(
+                self._response_key(analysis_results, nlp_context, context, tone, complexity),
+                lambda: generate_text(self.model, self._construct_enhanced_prompt(
+                    analysis_results, user_query, nlp_context, context, insights, tone, complexity
+                )),
+                should_store=bool
+            )
+            
+            if text:
+                return text
+            logger.warning("Empty response from AI model, using fallback")
+                
+        except Exception as e:
+            logger.error(f"Error generating AI response: {str(e)}")
+        
+        return self._generate_enhanced_mock_response(
+            analysis_results, user_query, nlp_context, context, insights, tone, complexity
+        )
+    
     def _construct_enhanced_prompt(self, analysis_results: Dict[str, Any], user_query: str,
                                  nlp_context: Optional[Dict[str, Any]], context: ResponseContext,
                                  insights: List[FinancialInsight], tone: ResponseTone, 
                                  complexity: ResponseComplexity) -> str:
         """Construct enhanced prompt for AI model"""
+        # Shared static prefix first, so it is identical across calls
+        static_prefix = self.prompt_library.prefix(analysis_results.get("analysis_type", "unknown"))
+        
         # Base system instruction
         system_instruction = f"""You are an AI-powered financial advisor with expertise in personal finance. 
 
@@ -503,11 +674,21 @@ NLP PROCESSING RESULTS:
             for insight in sorted(insights, key=lambda x: x.priority, reverse=True):
                 insights_text += f"- {insight.type.upper()}: {insight.message}\n"
         
+        # Nearest examples and transactions instead of whole data categories;
+        # with them the analysis summary keeps only its headline figures
+        retrieved_context = format_retrieved_context(analysis_results.get("retrieved"))
+        if retrieved_context:
+            retrieved_context = f"RELEVANT CONTEXT:\n{retrieved_context}\n"
+        
         # Format analysis results
-        analysis_summary = self._format_enhanced_analysis_summary(analysis_results)
+        analysis_summary = self._format_enhanced_analysis_summary(
+            analysis_results, headline_only=bool(retrieved_context)
+        )
         
         # Construct full prompt
-        prompt = f"""{system_instruction}
+        prompt = f"""{static_prefix}
+
+{system_instruction}
 
 {nlp_info}
 
@@ -517,13 +698,14 @@ FINANCIAL ANALYSIS RESULTS:
 {analysis_summary}
 
 {insights_text}
-
+{retrieved_context}
 Please provide a helpful, personalized response that addresses the user's query, incorporates the analysis results, highlights the key insights, and offers actionable advice. Make it conversational and appropriate for the user's experience level."""
         
         return prompt
     
-    def _format_enhanced_analysis_summary(self, analysis_results: Dict[str, Any]) -> str:
-        """Format analysis results with enhanced context"""
+    def _format_enhanced_analysis_summary(self, analysis_results: Dict[str, Any],
+                                          headline_only: bool = False) -> str:
+        """Format analysis results with enhanced context, or just their headline figures"""
         results = analysis_results.get("results", {})
         analysis_type = analysis_results.get("analysis_type", "unknown")
         success = analysis_results.get("success", False)
@@ -533,6 +715,12 @@ Please provide a helpful, personalized response that addresses the user's query,
         
         summary_parts = [f"Analysis Type: {analysis_type}", f"Status: Successful"]
         
+        if headline_only:
+            headline = format_headline_figures(results)
+            if headline:
+                summary_parts.append(headline)
+            return "\n".join(summary_parts)
+        
         # Enhanced formatting based on analysis type
         if analysis_type == "spending_analysis":
             total = results.get("total_spending", 0)
@@ -936,16 +1124,16 @@ I'm here to help with your financial questions. Could you please rephrase your q
             # User has financial concerns, adjust tone to be more supportive
             if context.user_preferences.get("support_level", "normal") == "normal":
                 context.user_preferences["support_level"] = "high"
+        
+        self.response_contexts.save(context.user_id, context.session_id, context)
     
     def get_response_context_summary(self, user_id: str, session_id: str = "default") -> Dict[str, Any]:
         """Get summary of response context for a user session"""
-        context_key = f"{user_id}:{session_id}"
+        context = self.response_contexts.get(user_id, session_id)
         
-        if context_key not in self.response_contexts:
+        if context is None:
             return {"error": "No response context found"}
         
-        context = self.response_contexts[context_key]
-        
         return {
             "user_id": user_id,
             "session_id": session_id,
@@ -967,6 +1155,7 @@ I'm here to help with your financial questions. Could you please rephrase your q
             "ai_model_available": self.model is not None,
             "model_name": "gemini-pro" if self.model else "enhanced_mock",
             "provider": "Google Generative AI" if self.model else "Internal Enhanced Service",
+            "response_cache": self.response_cache.get_stats(),
             "features": [
                 "contextual_responses",
                 "financial_domain_expertise", 
@@ -12,6 +12,10 @@ from dataclasses import dataclass, field
 import json
 from collections import defaultdict
 
+from .pattern_matcher import PatternMatcher, ScanResult
+from .context_store import ContextStore, get_context_spill
+from .metrics import timed
+
 logger = logging.getLogger(__name__)
 
 
@@ -82,6 +86,32 @@ class ConversationContext:
     last_analysis_type: Optional[str] = None
     turn_count: int = 0
     created_at: datetime = field(default_factory=datetime.utcnow)
+    
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "user_id": self.user_id,
+            "session_id": self.session_id,
+            "previous_intents": self.previous_intents,
+            "mentioned_entities": {k: [e.to_dict() for e in v] for k, v in self.mentioned_entities.items()},
+            "conversation_topic": self.conversation_topic,
+            "last_analysis_type": self.last_analysis_type,
+            "turn_count": self.turn_count,
+            "created_at": self.created_at.isoformat()
+        }
+    
+    @classmethod
+    def from_dict(cls, data: Dict[str, Any]) -> "ConversationContext":
+        return cls(
+            user_id=data["user_id"],
+            session_id=data["session_id"],
+            previous_intents=list(data.get("previous_intents", [])),
+            mentioned_entities={k: [Entity(**e) for e in v]
+                                for k, v in data.get("mentioned_entities", {}).items()},
+            conversation_topic=data.get("conversation_topic"),
+            last_analysis_type=data.get("last_analysis_type"),
+            turn_count=int(data.get("turn_count", 0)),
+            created_at=datetime.fromisoformat(data["created_at"]) if data.get("created_at") else datetime.utcnow()
+        )
 
 
 class EnhancedNLPService:
@@ -89,10 +119,12 @@ class EnhancedNLPService:
     
     def __init__(self):
         """Initialize the enhanced NLP service"""
-        self.conversation_contexts: Dict[str, ConversationContext] = {}
+        self.conversation_contexts = ContextStore("nlp_conversations", spill=get_context_spill(),
+                                                  from_dict=ConversationContext.from_dict)
         self._initialize_patterns()
         self._initialize_entity_extractors()
         self._initialize_intent_classifiers()
+        self._compile_matchers()
     
     def _initialize_patterns(self):
         """Initialize enhanced pattern matching"""
@@ -279,6 +311,47 @@ class EnhancedNLPService:
                 r"(?:vs|versus|compared\s+to|against)"
             ]
         }
+        
+        # Patterns the extractors run, with the value each match maps to
+        self.extraction_rules = {
+            "monetary_amount": [
+                r"(?:\$|USD\s*)?(\d{1,3}(?:,\d{3})*(?:\.\d{2})?)\s*(?:dollars?|USD|usd|\$)?",
+                r"(\d+(?:\.\d{2})?)\s*(?:k|K|thousand)(?:\s*dollars?)?",
+                r"(\d+(?:\.\d{2})?)\s*(?:M|million)(?:\s*dollars?)?"
+            ],
+            "relative_period": [
+                (r"\b(?:this|current)\s+(month|week|year|quarter)\b", "current"),
+                (r"\b(?:last|previous)\s+(month|week|year|quarter)\b", "previous"),
+                (r"\b(?:next|upcoming)\s+(month|week|year|quarter)\b", "next")
+            ],
+            "month": [
+                r"\b(january|february|march|april|may|june|july|august|september|october|november|december)\b"
+            ],
+            "spending_category": [
+                (r"\b(?:groceries|food|dining|restaurant|eating)\b", "food"),
+                (r"\b(?:transport|transportation|gas|fuel|uber|taxi|car)\b", "transportation"),
+                (r"\b(?:housing|rent|mortgage|utilities|home)\b", "housing"),
+                (r"\b(?:entertainment|movies|games|subscriptions|fun)\b", "entertainment"),
+                (r"\b(?:health|medical|fitness|gym|healthcare)\b", "healthcare"),
+                (r"\b(?:shopping|clothes|clothing|retail|apparel)\b", "shopping"),
+                (r"\b(?:education|school|books|courses|learning)\b", "education"),
+                (r"\b(?:travel|vacation|hotel|flight|trip)\b", "travel"),
+                (r"\b(?:insurance)\b", "insurance")
+            ],
+            "financial_account": [
+                (r"\b(checking|savings|investment|retirement|401k|ira)\s*account\b", "account"),
+                (r"\b(credit\s+card|debit\s+card)\b", "card"),
+                (r"\b(portfolio|brokerage|trading)\s*account\b", "investment_account")
+            ],
+            "percentage": [
+                r"(\d+(?:\.\d+)?)\s*(?:%|percent|percentage)"
+            ],
+            "comparison": [
+                (r"\b(more|less|higher|lower|greater|smaller)\s*than\b", "comparative"),
+                (r"\b(above|below|over|under)\b", "threshold"),
+                (r"\b(vs|versus|compared\s+to|against)\b", "direct_comparison")
+            ]
+        }
     
     def _initialize_intent_classifiers(self):
         """Initialize ML-like intent classification weights"""
@@ -295,6 +368,28 @@ class EnhancedNLPService:
             "health": {"financial_health": 0.9}
         }
     
+    def _compile_matchers(self):
+        """Compile intent and extraction patterns into one single-scan matcher"""
+        self.matcher = PatternMatcher()
+        for intent_name, intent_data in self.intent_patterns.items():
+            self.matcher.add_group(f"intent:{intent_name}", intent_data["patterns"])
+            intent_data["keyword_set"] = frozenset(intent_data["keywords"])
+        for rule_name, patterns in self.extraction_rules.items():
+            self.matcher.add_group(rule_name, patterns)
+        self.matcher.compile()
+        
+        self.normalization_rules = [
+            (re.compile(pattern, re.IGNORECASE), replacement)
+            for pattern, replacement in {
+                r"\b(?:bucks?|dollars?)\b": "dollars",
+                r"\b(?:k|thousand)\b": "thousand",
+                r"\b(?:mil|million)\b": "million",
+                r"\b(?:yr|years?)\b": "year",
+                r"\b(?:mo|months?)\b": "month"
+            }.items()
+        ]
+    
+    @timed("nlp")
     def process_query(self, user_query: str, user_id: str = "default", 
                      session_id: Optional[str] = None) -> Dict[str, Any]:
         """
@@ -319,14 +414,18 @@ class EnhancedNLPService:
             # Normalize query
             normalized_query = self._advanced_normalize_query(user_query)
             
+            # One literal scan serves every intent and entity pattern
+            scan = self.matcher.scan(normalized_query)
+            
             # Extract entities first (for better intent classification)
-            entities = self._enhanced_entity_extraction(normalized_query, context)
+            entities = self._enhanced_entity_extraction(normalized_query, context, scan)
             
             # Classify intent with context
-            intent = self._advanced_intent_classification(normalized_query, entities, context)
+            intent = self._advanced_intent_classification(normalized_query, entities, context, scan)
             
             # Update context with new information
             self._update_conversation_context(context, intent, entities)
+            self.conversation_contexts.save(user_id, session_id, context)
             
             # Calculate overall confidence
             overall_confidence = self._calculate_overall_confidence(intent, entities)
@@ -373,12 +472,10 @@ class EnhancedNLPService:
     def _get_or_create_context(self, context_key: str, user_id: str, 
                               session_id: Optional[str]) -> ConversationContext:
         """Get existing or create new conversation context"""
-        if context_key not in self.conversation_contexts:
-            self.conversation_contexts[context_key] = ConversationContext(
-                user_id=user_id,
-                session_id=session_id or "default"
-            )
-        return self.conversation_contexts[context_key]
+        return self.conversation_contexts.get_or_create(
+            user_id, session_id,
+            lambda: ConversationContext(user_id=user_id, session_id=session_id or "default")
+        )
     
     def _advanced_normalize_query(self, query: str) -> str:
         """Advanced query normalization"""
@@ -399,26 +496,19 @@ class EnhancedNLPService:
             normalized = normalized.replace(contraction, expansion)
         
         # Normalize financial terms
-        financial_normalizations = {
-            r"\b(?:bucks?|dollars?)\b": "dollars",
-            r"\b(?:k|thousand)\b": "thousand",
-            r"\b(?:mil|million)\b": "million",
-            r"\b(?:yr|years?)\b": "year",
-            r"\b(?:mo|months?)\b": "month"
-        }
-        
-        for pattern, replacement in financial_normalizations.items():
-            normalized = re.sub(pattern, replacement, normalized, flags=re.IGNORECASE)
+        for pattern, replacement in self.normalization_rules:
+            normalized = pattern.sub(replacement, normalized)
         
         return normalized
     
-    def _enhanced_entity_extraction(self, query: str, 
-                                  context: ConversationContext) -> Dict[str, List[Entity]]:
+    def _enhanced_entity_extraction(self, query: str, context: ConversationContext,
+                                  scan: Optional[ScanResult] = None) -> Dict[str, List[Entity]]:
         """Enhanced entity extraction with context awareness"""
         entities = defaultdict(list)
+        scan = scan or self.matcher.scan(query)
         
         # Extract monetary amounts with enhanced processing
-        amounts = self._extract_monetary_amounts(query)
+        amounts = self._extract_monetary_amounts(query, scan)
         for amount_data in amounts:
             entity = Entity(
                 type="monetary_amount",
@@ -431,89 +521,76 @@ class EnhancedNLPService:
             entities["monetary_amount"].append(entity)
         
         # Extract time periods with context
-        time_periods = self._extract_time_periods(query, context)
+        time_periods = self._extract_time_periods(query, context, scan)
         entities["time_period"].extend(time_periods)
         
         # Extract spending categories
-        categories = self._extract_spending_categories(query)
+        categories = self._extract_spending_categories(query, scan)
         entities["spending_category"].extend(categories)
         
         # Extract financial accounts
-        accounts = self._extract_financial_accounts(query)
+        accounts = self._extract_financial_accounts(query, scan)
         entities["financial_account"].extend(accounts)
         
         # Extract percentages
-        percentages = self._extract_percentages(query)
+        percentages = self._extract_percentages(query, scan)
         entities["percentage"].extend(percentages)
         
         # Extract comparison operators
-        comparisons = self._extract_comparisons(query)
+        comparisons = self._extract_comparisons(query, scan)
         entities["comparison"].extend(comparisons)
         
         return dict(entities)
     
-    def _extract_monetary_amounts(self, query: str) -> List[Dict[str, Any]]:
+    def _extract_monetary_amounts(self, query: str, scan: Optional[ScanResult] = None) -> List[Dict[str, Any]]:
         """Extract monetary amounts with normalization"""
         amounts = []
+        scan = scan or self.matcher.scan(query)
         
-        # Pattern for various monetary formats
-        patterns = [
-            r"(?:\$|USD\s*)?(\d{1,3}(?:,\d{3})*(?:\.\d{2})?)\s*(?:dollars?|USD|usd|\$)?",
-            r"(\d+(?:\.\d{2})?)\s*(?:k|K|thousand)(?:\s*dollars?)?",
-            r"(\d+(?:\.\d{2})?)\s*(?:M|million)(?:\s*dollars?)?"
-        ]
-        
-        for pattern in patterns:
-            for match in re.finditer(pattern, query, re.IGNORECASE):
-                amount_str = match.group(1)
-                
-                # Normalize based on pattern
-                if 'k' in match.group(0).lower() or 'thousand' in match.group(0).lower():
-                    normalized = float(amount_str) * 1000
-                elif 'm' in match.group(0).lower() or 'million' in match.group(0).lower():
-                    normalized = float(amount_str) * 1000000
-                else:
-                    normalized = float(amount_str.replace(',', ''))
-                
-                amounts.append({
-                    "value": amount_str,
-                    "normalized": normalized,
-                    "confidence": 0.9,
-                    "start": match.start(),
-                    "end": match.end()
-                })
+        for _, match in scan.finditer("monetary_amount"):
+            amount_str = match.group(1)
+            
+            # Normalize based on pattern
+            if 'k' in match.group(0).lower() or 'thousand' in match.group(0).lower():
+                normalized = float(amount_str) * 1000
+            elif 'm' in match.group(0).lower() or 'million' in match.group(0).lower():
+                normalized = float(amount_str) * 1000000
+            else:
+                normalized = float(amount_str.replace(',', ''))
+            
+            amounts.append({
+                "value": amount_str,
+                "normalized": normalized,
+                "confidence": 0.9,
+                "start": match.start(),
+                "end": match.end()
+            })
         
         return amounts
     
-    def _extract_time_periods(self, query: str, context: ConversationContext) -> List[Entity]:
+    def _extract_time_periods(self, query: str, context: ConversationContext,
+                              scan: Optional[ScanResult] = None) -> List[Entity]:
         """Extract time periods with context awareness"""
         time_periods = []
+        scan = scan or self.matcher.scan(query)
         
         # Current time references
-        current_patterns = [
-            (r"\b(?:this|current)\s+(month|week|year|quarter)\b", "current"),
-            (r"\b(?:last|previous)\s+(month|week|year|quarter)\b", "previous"),
-            (r"\b(?:next|upcoming)\s+(month|week|year|quarter)\b", "next")
-        ]
-        
-        for pattern, time_type in current_patterns:
-            for match in re.finditer(pattern, query, re.IGNORECASE):
-                period = match.group(1).lower()
-                entity = Entity(
-                    type="time_period",
-                    value=f"{time_type}_{period}",
-                    confidence=0.95,
-                    context={
-                        "period_type": period,
-                        "relative_type": time_type,
-                        "resolved_date": self._resolve_time_period(time_type, period)
-                    }
-                )
-                time_periods.append(entity)
+        for time_type, match in scan.finditer("relative_period"):
+            period = match.group(1).lower()
+            entity = Entity(
+                type="time_period",
+                value=f"{time_type}_{period}",
+                confidence=0.95,
+                context={
+                    "period_type": period,
+                    "relative_type": time_type,
+                    "resolved_date": self._resolve_time_period(time_type, period)
+                }
+            )
+            time_periods.append(entity)
         
         # Specific months/years
-        month_pattern = r"\b(january|february|march|april|may|june|july|august|september|october|november|december)\b"
-        for match in re.finditer(month_pattern, query, re.IGNORECASE):
+        for _, match in scan.finditer("month"):
             month_name = match.group(1).lower()
             entity = Entity(
                 type="time_period",
@@ -559,30 +636,19 @@ class EnhancedNLPService:
             "end_date": end.isoformat()
         }
     
-    def _extract_spending_categories(self, query: str) -> List[Entity]:
+    def _extract_spending_categories(self, query: str, scan: Optional[ScanResult] = None) -> List[Entity]:
         """Extract spending categories"""
         categories = []
-        category_mapping = {
-            r"\b(?:groceries|food|dining|restaurant|eating)\b": "food",
-            r"\b(?:transport|transportation|gas|fuel|uber|taxi|car)\b": "transportation", 
-            r"\b(?:housing|rent|mortgage|utilities|home)\b": "housing",
-            r"\b(?:entertainment|movies|games|subscriptions|fun)\b": "entertainment",
-            r"\b(?:health|medical|fitness|gym|healthcare)\b": "healthcare",
-            r"\b(?:shopping|clothes|clothing|retail|apparel)\b": "shopping",
-            r"\b(?:education|school|books|courses|learning)\b": "education",
-            r"\b(?:travel|vacation|hotel|flight|trip)\b": "travel",
-            r"\b(?:insurance)\b": "insurance"
-        }
+        scan = scan or self.matcher.scan(query)
         
-        for pattern, category in category_mapping.items():
-            if re.search(pattern, query, re.IGNORECASE):
-                entity = Entity(
-                    type="spending_category",
-                    value=category,
-                    confidence=0.85,
-                    context={"category_group": self._get_category_group(category)}
-                )
-                categories.append(entity)
+        for category, _ in scan.search("spending_category"):
+            entity = Entity(
+                type="spending_category",
+                value=category,
+                confidence=0.85,
+                context={"category_group": self._get_category_group(category)}
+            )
+            categories.append(entity)
         
         return categories
     
@@ -602,33 +668,28 @@ class EnhancedNLPService:
         }
         return category_groups.get(category, "other")
     
-    def _extract_financial_accounts(self, query: str) -> List[Entity]:
+    def _extract_financial_accounts(self, query: str, scan: Optional[ScanResult] = None) -> List[Entity]:
         """Extract financial account references"""
         accounts = []
-        account_patterns = [
-            (r"\b(checking|savings|investment|retirement|401k|ira)\s*account\b", "account"),
-            (r"\b(credit\s+card|debit\s+card)\b", "card"),
-            (r"\b(portfolio|brokerage|trading)\s*account\b", "investment_account")
-        ]
+        scan = scan or self.matcher.scan(query)
         
-        for pattern, account_type in account_patterns:
-            for match in re.finditer(pattern, query, re.IGNORECASE):
-                entity = Entity(
-                    type="financial_account",
-                    value=match.group(1).lower().replace(" ", "_"),
-                    confidence=0.9,
-                    context={"account_type": account_type}
-                )
-                accounts.append(entity)
+        for account_type, match in scan.finditer("financial_account"):
+            entity = Entity(
+                type="financial_account",
+                value=match.group(1).lower().replace(" ", "_"),
+                confidence=0.9,
+                context={"account_type": account_type}
+            )
+            accounts.append(entity)
         
         return accounts
     
-    def _extract_percentages(self, query: str) -> List[Entity]:
+    def _extract_percentages(self, query: str, scan: Optional[ScanResult] = None) -> List[Entity]:
         """Extract percentages"""
         percentages = []
-        pattern = r"(\d+(?:\.\d+)?)\s*(?:%|percent|percentage)"
+        scan = scan or self.matcher.scan(query)
         
-        for match in re.finditer(pattern, query, re.IGNORECASE):
+        for _, match in scan.finditer("percentage"):
             value = float(match.group(1))
             entity = Entity(
                 type="percentage",
@@ -640,45 +701,39 @@ class EnhancedNLPService:
         
         return percentages
     
-    def _extract_comparisons(self, query: str) -> List[Entity]:
+    def _extract_comparisons(self, query: str, scan: Optional[ScanResult] = None) -> List[Entity]:
         """Extract comparison operators"""
         comparisons = []
-        comparison_patterns = [
-            (r"\b(more|less|higher|lower|greater|smaller)\s*than\b", "comparative"),
-            (r"\b(above|below|over|under)\b", "threshold"),
-            (r"\b(vs|versus|compared\s+to|against)\b", "direct_comparison")
-        ]
+        scan = scan or self.matcher.scan(query)
         
-        for pattern, comp_type in comparison_patterns:
-            for match in re.finditer(pattern, query, re.IGNORECASE):
-                entity = Entity(
-                    type="comparison",
-                    value=match.group(1).lower(),
-                    confidence=0.8,
-                    context={"comparison_type": comp_type}
-                )
-                comparisons.append(entity)
+        for comp_type, match in scan.finditer("comparison"):
+            entity = Entity(
+                type="comparison",
+                value=match.group(1).lower(),
+                confidence=0.8,
+                context={"comparison_type": comp_type}
+            )
+            comparisons.append(entity)
         
         return comparisons
     
     def _advanced_intent_classification(self, query: str, entities: Dict[str, List[Entity]], 
-                                      context: ConversationContext) -> Intent:
+                                      context: ConversationContext,
+                                      scan: Optional[ScanResult] = None) -> Intent:
         """Advanced intent classification with ML-like scoring"""
         intent_scores = defaultdict(float)
+        scan = scan or self.matcher.scan(query)
+        query_words = set(query.lower().split())
         
         # Pattern-based scoring
         for intent_name, intent_data in self.intent_patterns.items():
             score = 0
             
             # Pattern matching
-            for pattern in intent_data["patterns"]:
-                if re.search(pattern, query, re.IGNORECASE):
-                    score += 2.0
+            score += 2.0 * scan.count(f"intent:{intent_name}")
             
             # Keyword matching with TF-IDF-like scoring
-            query_words = set(query.lower().split())
-            intent_keywords = set(intent_data["keywords"])
-            keyword_overlap = len(query_words.intersection(intent_keywords))
+            keyword_overlap = len(query_words.intersection(intent_data["keyword_set"]))
             
             if keyword_overlap > 0:
                 score += keyword_overlap * 1.5
@@ -771,23 +826,23 @@ class EnhancedNLPService:
         parameters = {}
         
         if intent_name in ["analyze_spending", "spending_by_category"]:
-            if "time_period" in entities:
+            if entities.get("time_period"):
                 parameters["time_period"] = entities["time_period"][0].value
-            if "spending_category" in entities:
+            if entities.get("spending_category"):
                 parameters["categories"] = [e.value for e in entities["spending_category"]]
         
         elif intent_name == "affordability_check":
-            if "monetary_amount" in entities:
+            if entities.get("monetary_amount"):
                 parameters["target_amount"] = entities["monetary_amount"][0].context.get("normalized_value")
         
         elif intent_name == "future_projection":
-            if "time_period" in entities:
+            if entities.get("time_period"):
                 parameters["projection_period"] = entities["time_period"][0].value
         
         elif intent_name == "spending_comparison":
-            if "time_period" in entities and len(entities["time_period"]) >= 2:
+            if len(entities.get("time_period", ())) >= 2:
                 parameters["compare_periods"] = [e.value for e in entities["time_period"]]
-            if "comparison" in entities:
+            if entities.get("comparison"):
                 parameters["comparison_type"] = entities["comparison"][0].value
         
         return parameters
@@ -967,13 +1022,11 @@ class EnhancedNLPService:
     
     def get_conversation_summary(self, user_id: str, session_id: str = "default") -> Dict[str, Any]:
         """Get conversation summary for a user session"""
-        context_key = f"{user_id}:{session_id}"
+        context = self.conversation_contexts.get(user_id, session_id)
         
-        if context_key not in self.conversation_contexts:
+        if context is None:
             return {"error": "No conversation found"}
         
-        context = self.conversation_contexts[context_key]
-        
         return {
             "user_id": user_id,
             "session_id": session_id,
@@ -989,10 +1042,8 @@ class EnhancedNLPService:
     
     def clear_conversation_context(self, user_id: str, session_id: str = "default"):
         """Clear conversation context for a user session"""
-        context_key = f"{user_id}:{session_id}"
-        if context_key in self.conversation_contexts:
-            del self.conversation_contexts[context_key]
-            logger.info(f"Cleared conversation context for {context_key}")
+        if self.conversation_contexts.discard(user_id, session_id):
+            logger.info(f"Cleared conversation context for {user_id}:{session_id}")
     
     def get_supported_capabilities(self) -> Dict[str, Any]:
         """Get information about supported NLP capabilities"""
@@ -6,16 +6,41 @@ Provides comprehensive privacy controls, audit trails, and real-time enforcement
 import json
 import logging
 import asyncio
+import functools
 from datetime import datetime, timezone, timedelta
-from typing import Dict, Any, List, Optional, Set, Tuple
+from typing import Dict, Any, List, Mapping, NamedTuple, Optional, Set, Tuple
 from enum import Enum
 from dataclasses import dataclass, asdict
 from pathlib import Path
+from types import MappingProxyType
 import hashlib
 import uuid
 
+from .audit_log import AuditLogWriter
+from .result_cache import get_analysis_cache
+
 logger = logging.getLogger(__name__)
 
+# Bumped whenever a permission setting or a profile's filtering options change;
+# compiled permission masks are only reused while the revision is unchanged
+_permission_revision = 0
+
+# Categories filtered with an empty mapping rather than an empty list
+_MAPPING_CATEGORIES = frozenset({"credit_score", "epf_balance"})
+
+# Recent audit entries kept on each profile when the audit log is on disk
+AUDIT_MEMORY_LIMIT = 200
+
+
+def _touch_permissions() -> None:
+    global _permission_revision
+    _permission_revision += 1
+
+
+def _aware(value: datetime) -> datetime:
+    """Treat naive query bounds as UTC"""
+    return value if value.tzinfo else value.replace(tzinfo=timezone.utc)
+
 
 class PermissionLevel(Enum):
     """Permission levels for data access"""
@@ -75,6 +100,10 @@ class PermissionSetting:
             self.granted_at = datetime.now(timezone.utc)
         if self.updated_at is None:
             self.updated_at = datetime.now(timezone.utc)
+    
+    def __setattr__(self, name, value):
+        object.__setattr__(self, name, value)
+        _touch_permissions()
 
 
 @dataclass
@@ -111,6 +140,22 @@ class PrivacyProfile:
     def __post_init__(self):
         if not self.last_updated:
             self.last_updated = datetime.now(timezone.utc)
+    
+    def __setattr__(self, name, value):
+        object.__setattr__(self, name, value)
+        if name in ("permissions", "data_minimization", "privacy_level"):
+            _touch_permissions()
+
+
+class PermissionMask(NamedTuple):
+    """A privacy profile compiled for filtering, one bit per data category"""
+    revision: int
+    valid_until: Optional[datetime]  # earliest expiry among the settings
+    view: int                       # categories granted VIEW access
+    minimize: int                   # granted categories returned minimized
+    levels: Mapping[str, str]       # permission level of each granted category
+    data_minimization: bool
+    privacy_level: str
 
 
 class EnhancedPrivacyService:
@@ -126,11 +171,12 @@ class EnhancedPrivacyService:
         self.audit_storage_path = Path(audit_storage_path) if audit_storage_path else None
         self._data_categories = self._initialize_data_categories()
         self._privacy_profiles: Dict[str, PrivacyProfile] = {}
-        self._audit_cache: List[AuditEntry] = []
+        self._category_bits = {cat_id: 1 << bit for bit, cat_id in enumerate(self._data_categories)}
+        self._permission_masks: Dict[str, PermissionMask] = {}
+        self._minimized: Dict[str, Tuple[Any, int, List[Dict[str, Any]]]] = {}
         
-        # Initialize audit storage
-        if self.audit_storage_path:
-            self.audit_storage_path.mkdir(parents=True, exist_ok=True)
+        # Audit entries are written and indexed by a background writer
+        self.audit_log = AuditLogWriter(str(self.audit_storage_path)) if self.audit_storage_path else None
     
     def _initialize_data_categories(self) -> Dict[str, DataCategory]:
         """Initialize predefined data categories"""
@@ -294,9 +340,10 @@ class EnhancedPrivacyService:
             last_updated=current_time
         )
         
-        # Store profile and add audit entry to cache
+        # Store profile and log the consent entry
         self._privacy_profiles[user_id] = profile
-        self._audit_cache.append(initial_audit_entry)
+        if self.audit_log:
+            self.audit_log.submit(self._audit_record(initial_audit_entry))
         
         return profile
     
@@ -327,6 +374,12 @@ class EnhancedPrivacyService:
         # Update profile
         profile.last_updated = datetime.now(timezone.utc)
         
+        # Cached analyses and the compiled mask reflect the old permissions.
+        # Analyses are cached under the requester's id, not this profile's, so
+        # every result computed with a changed category is dropped
+        get_analysis_cache().invalidate_categories(self._permission_fields(permission_updates))
+        self._permission_masks.pop(user_id, None)
+        
         # Record audit entry
         await self._add_audit_entry(
             user_id=user_id,
@@ -342,6 +395,16 @@ class EnhancedPrivacyService:
         
         return await self.get_permission_summary(user_id)
     
+    def _permission_fields(self, category_ids) -> Set[str]:
+        """Request permission fields granting the data of privacy categories"""
+        fields = set()
+        for category_id in category_ids:
+            category = self._data_categories.get(category_id)
+            if category is not None:
+                # e.g. spending_patterns is granted as spending_trends and category_breakdown
+                fields.update([category.id, category.name, *category.data_types])
+        return fields
+    
     async def _apply_permission_updates(self, user_id: str, permissions: Dict[str, PermissionSetting],
                                       updates: Dict[str, Any]):
         """Apply permission updates to the permissions dictionary"""
@@ -426,105 +489,158 @@ class EnhancedPrivacyService:
         
         return has_access
     
-    async def filter_data_by_permissions(self, user_id: str, data: Dict[str, Any],
-                                       context: Optional[Dict[str, Any]] = None) -> Dict[str, Any]:
+    def _permission_mask(self, user_id: str) -> PermissionMask:
+        """
+        Get the user's compiled permission mask
+        
+        The mask is recompiled only after a permission or profile change, or
+        once a setting it granted has expired.
+        """
+        now = datetime.now(timezone.utc)
+        mask = self._permission_masks.get(user_id)
+        if (mask is not None and mask.revision == _permission_revision
+                and (mask.valid_until is None or now <= mask.valid_until)):
+            return mask
+        
+        profile = self._privacy_profiles[user_id]
+        revision = _permission_revision
+        view = minimize = 0
+        valid_until = None
+        levels = {}
+        for category_id, bit in self._category_bits.items():
+            permission = profile.permissions.get(category_id)
+            if permission is None:
+                continue
+            if permission.expires_at:
+                if permission.expires_at < now:
+                    continue
+                if valid_until is None or permission.expires_at < valid_until:
+                    valid_until = permission.expires_at
+            level = permission.permission_level
+            if level == PermissionLevel.NONE:
+                continue
+            if AccessType.VIEW in permission.access_types or level == PermissionLevel.ADMIN:
+                view |= bit
+                levels[category_id] = level.value
+                if profile.data_minimization and level == PermissionLevel.LIMITED:
+                    minimize |= bit
+        
+        mask = PermissionMask(revision, valid_until, view, minimize, MappingProxyType(levels),
+                              profile.data_minimization, profile.privacy_level)
+        self._permission_masks[user_id] = mask
+        return mask
+    
+    async def filter_data_by_permissions(self, user_id: str, data: Mapping[str, Any],
+                                       context: Optional[Dict[str, Any]] = None) -> Mapping[str, Any]:
         """
         Filter data based on user permissions with real-time enforcement
         
+        Access is decided from the compiled permission mask and recorded as one
+        audit entry per call. Granted categories reference the source data and
+        minimized categories are projected once per source list, so the result
+        is a read-only view that callers must not mutate.
+        
         Args:
             user_id: User identifier
             data: Complete data dictionary
             context: Optional context for filtering decisions
             
         Returns:
-            Filtered data dictionary
+            Read-only filtered data mapping
         """
-        logger.info(f"Filtering data for user: {user_id}")
+        logger.debug(f"Filtering data for user: {user_id}")
         
         if user_id not in self._privacy_profiles:
             await self.create_privacy_profile(user_id)
         
+        mask = self._permission_mask(user_id)
         filtered_data = {}
         access_log = {}
+        granted = []
         
-        for category_id, category in self._data_categories.items():
-            # Use category_id as the data key (test data uses category IDs as keys)
-            data_key = category_id
-            
-            # Check if data exists
-            if data_key not in data:
-                # Initialize with appropriate empty value based on expected data type
-                if data_key in ["credit_score", "epf_balance"]:
-                    filtered_data[data_key] = {}
-                else:
-                    filtered_data[data_key] = []
+        # Category IDs are the data keys (test data uses category IDs as keys)
+        for category_id, bit in self._category_bits.items():
+            if category_id not in data:
+                filtered_data[category_id] = {} if category_id in _MAPPING_CATEGORIES else []
                 access_log[category_id] = "no_data"
-                continue
-            
-            # Check permission
-            has_access = await self.check_permission(
-                user_id, category_id, AccessType.VIEW, log_access=True
-            )
-            
-            if has_access:
-                # Apply data minimization if enabled
-                if self._privacy_profiles[user_id].data_minimization:
-                    filtered_data[data_key] = await self._apply_data_minimization(
-                        data[data_key], category_id, user_id
-                    )
-                else:
-                    filtered_data[data_key] = data[data_key]
+            elif mask.view & bit:
+                value = data[category_id]
+                if mask.minimize & bit:
+                    value = self._minimized_view(category_id, value)
+                filtered_data[category_id] = value
                 access_log[category_id] = "granted"
+                granted.append(category_id)
             else:
-                # Initialize with appropriate empty value based on expected data type
-                if data_key in ["credit_score", "epf_balance"]:
-                    filtered_data[data_key] = {}
-                else:
-                    filtered_data[data_key] = []
+                filtered_data[category_id] = {} if category_id in _MAPPING_CATEGORIES else []
                 access_log[category_id] = "denied"
         
+        if granted:
+            await self._add_audit_entry(
+                user_id=user_id,
+                action=AuditAction.DATA_ACCESSED,
+                details={
+                    "access_type": AccessType.VIEW.value,
+                    "categories": granted,
+                    "permission_levels": {cat_id: mask.levels[cat_id] for cat_id in granted},
+                    "granted": True
+                }
+            )
+        
         # Add metadata
         filtered_data["_privacy_metadata"] = {
             "user_id": user_id,
             "filtered_at": datetime.now(timezone.utc).isoformat(),
             "access_log": access_log,
-            "data_minimization": self._privacy_profiles[user_id].data_minimization,
-            "privacy_level": self._privacy_profiles[user_id].privacy_level
+            "data_minimization": mask.data_minimization,
+            "privacy_level": mask.privacy_level
         }
         
-        return filtered_data
+        return MappingProxyType(filtered_data)
     
-    async def _apply_data_minimization(self, data: Any, category_id: str, user_id: str) -> Any:
-        """Apply data minimization rules based on category and user preferences"""
-        if not isinstance(data, list):
+    def _minimized_view(self, category_id: str, data: Any) -> Any:
+        """
+        Minimized form of a category's data for limited access
+        
+        The projection is computed once per source list and reused until the
+        data store publishes a different list.
+        """
+        if not isinstance(data, list) or category_id not in ("transactions", "accounts"):
             return data
         
-        category = self._data_categories[category_id]
+        cached = self._minimized.get(category_id)
+        if cached is not None and cached[0] is data and cached[1] == len(data):
+            return cached[2]
+        
+        if category_id == "transactions":
+            minimized = [
+                {
+                    "id": item.get("id", ""),
+                    "amount": item.get("amount", 0),
+                    "category": item.get("category", ""),
+                    "date": item.get("date", "")[:10]  # Date only, no time
+                }
+                for item in data[:50]  # Limit to 50 recent items
+            ]
+        else:
+            minimized = [
+                {
+                    "id": item.get("id", ""),
+                    "name": item.get("name", "").replace(item.get("name", "")[:-4], "****") if item.get("name") else "",
+                    "type": item.get("type", ""),
+                    "balance": round(item.get("balance", 0), -2)  # Round to nearest 100
+                }
+                for item in data
+            ]
+        self._minimized[category_id] = (data, len(data), minimized)
+        return minimized
+    
+    async def _apply_data_minimization(self, data: Any, category_id: str, user_id: str) -> Any:
+        """Apply data minimization rules based on category and user preferences"""
         permission = self._privacy_profiles[user_id].permissions[category_id]
         
         # Apply minimization based on permission level
         if permission.permission_level == PermissionLevel.LIMITED:
-            # For limited access, reduce sensitive fields
-            if category_id == "transactions":
-                return [
-                    {
-                        "id": item.get("id", ""),
-                        "amount": item.get("amount", 0),
-                        "category": item.get("category", ""),
-                        "date": item.get("date", "")[:10]  # Date only, no time
-                    }
-                    for item in data[:50]  # Limit to 50 recent items
-                ]
-            elif category_id == "accounts":
-                return [
-                    {
-                        "id": item.get("id", ""),
-                        "name": item.get("name", "").replace(item.get("name", "")[:-4], "****") if item.get("name") else "",
-                        "type": item.get("type", ""),
-                        "balance": round(item.get("balance", 0), -2)  # Round to nearest 100
-                    }
-                    for item in data
-                ]
+            return self._minimized_view(category_id, data)
         
         return data
     
@@ -663,47 +779,105 @@ class EnhancedPrivacyService:
         return recommendations
     
     async def get_audit_trail(self, user_id: str, limit: int = 100, 
-                            action_filter: Optional[List[AuditAction]] = None) -> List[Dict[str, Any]]:
+                            action_filter: Optional[List[AuditAction]] = None,
+                            offset: int = 0, since: Optional[datetime] = None,
+                            until: Optional[datetime] = None) -> List[Dict[str, Any]]:
         """
         Get user's audit trail
         
+        With an audit log on disk the page is read through its index, so
+        entries beyond the in-memory window are included.
+        
         Args:
             user_id: User identifier
             limit: Maximum number of entries to return
             action_filter: Optional filter for specific actions
+            offset: Entries skipped from the most recent one
+            since: Optional earliest timestamp, inclusive
+            until: Optional latest timestamp, inclusive
             
         Returns:
-            List of audit entries
+            List of audit entries, most recent first
         """
+        if self.audit_log:
+            await self.flush_audit_log()
+            actions = [action.value for action in action_filter] if action_filter else None
+            query = functools.partial(self.audit_log.query, user_id, limit, offset, actions, since, until)
+            return await asyncio.get_running_loop().run_in_executor(None, query)
+        
         if user_id not in self._privacy_profiles:
             return []
         
         profile = self._privacy_profiles[user_id]
         audit_entries = profile.audit_trail
         
-        # Apply filter if specified
+        # Apply filters if specified
         if action_filter:
             audit_entries = [
                 entry for entry in audit_entries
                 if entry.action in action_filter
             ]
+        if since is not None:
+            audit_entries = [entry for entry in audit_entries if entry.timestamp >= _aware(since)]
+        if until is not None:
+            audit_entries = [entry for entry in audit_entries if entry.timestamp <= _aware(until)]
         
-        # Sort by timestamp (most recent first) and limit
-        audit_entries = sorted(audit_entries, key=lambda x: x.timestamp, reverse=True)[:limit]
+        # Sort by timestamp (most recent first) and page
+        audit_entries = sorted(audit_entries, key=lambda x: x.timestamp, reverse=True)[offset:offset + limit]
         
         # Convert to dictionary format
-        return [
-            {
-                "id": entry.id,
-                "action": entry.action.value,
-                "category_id": entry.category_id,
-                "details": entry.details,
-                "timestamp": entry.timestamp.isoformat(),
-                "ip_address": entry.ip_address,
-                "session_id": entry.session_id
-            }
-            for entry in audit_entries
-        ]
+        return [self._audit_record(entry) for entry in audit_entries]
+    
+    async def get_audit_summary(self, user_id: str) -> Dict[str, Any]:
+        """
+        Summarize a user's whole audit trail
+        
+        Args:
+            user_id: User identifier
+            
+        Returns:
+            Total entries, per-action counts, last entry time and accessed categories
+        """
+        if self.audit_log:
+            await self.flush_audit_log()
+            loop = asyncio.get_running_loop()
+            return await loop.run_in_executor(None, self.audit_log.summary, user_id)
+        
+        trail = self._privacy_profiles[user_id].audit_trail if user_id in self._privacy_profiles else []
+        actions: Dict[str, int] = {}
+        categories = set()
+        for entry in trail:
+            actions[entry.action.value] = actions.get(entry.action.value, 0) + 1
+            categories.update(self._audit_categories(entry))
+        return {
+            "total_entries": len(trail),
+            "actions": actions,
+            "last_entry": max((entry.timestamp for entry in trail), default=None),
+            "categories_accessed": sorted(categories)
+        }
+    
+    @staticmethod
+    def _audit_categories(entry: AuditEntry) -> List[str]:
+        """Data categories a DATA_ACCESSED entry covers"""
+        if entry.action != AuditAction.DATA_ACCESSED:
+            return []
+        return [entry.category_id] if entry.category_id else list(entry.details.get("categories", []))
+    
+    @classmethod
+    def _audit_record(cls, entry: AuditEntry) -> Dict[str, Any]:
+        """Serializable form of an audit entry, as stored and as returned by queries"""
+        return {
+            "id": entry.id,
+            "user_id": entry.user_id,
+            "action": entry.action.value,
+            "category_id": entry.category_id,
+            "details": entry.details,
+            "timestamp": entry.timestamp.isoformat(),
+            "ip_address": entry.ip_address,
+            "user_agent": entry.user_agent,
+            "session_id": entry.session_id,
+            "categories": cls._audit_categories(entry)
+        }
     
     async def _add_audit_entry(self, user_id: str, action: AuditAction, 
                              category_id: Optional[str] = None, details: Optional[Dict[str, Any]] = None,
@@ -722,33 +896,21 @@ class EnhancedPrivacyService:
             timestamp=datetime.now(timezone.utc)
         )
         
-        # Add to user's profile
+        # Add to user's profile, keeping only a recent window once entries reach disk
         if user_id in self._privacy_profiles:
-            self._privacy_profiles[user_id].audit_trail.append(entry)
-        
-        # Add to cache for batch processing
-        self._audit_cache.append(entry)
-        
-        # Flush cache if it gets large
-        if len(self._audit_cache) >= 100:
-            await self._flush_audit_cache()
+            trail = self._privacy_profiles[user_id].audit_trail
+            trail.append(entry)
+            if self.audit_log and len(trail) > 2 * AUDIT_MEMORY_LIMIT:
+                del trail[:-AUDIT_MEMORY_LIMIT]
+        
+        # The writer batches and indexes entries off the event loop
+        if self.audit_log:
+            self.audit_log.submit(self._audit_record(entry))
     
-    async def _flush_audit_cache(self):
-        """Flush audit cache to storage"""
-        if not self.audit_storage_path or not self._audit_cache:
-            return
-        
-        # Write audit entries to daily log files
-        today = datetime.now(timezone.utc).date()
-        log_file = self.audit_storage_path / f"audit_{today.isoformat()}.jsonl"
-        
-        with open(log_file, 'a', encoding='utf-8') as f:
-            for entry in self._audit_cache:
-                json.dump(asdict(entry), f, default=str)
-                f.write('\n')
-        
-        logger.info(f"Flushed {len(self._audit_cache)} audit entries to {log_file}")
-        self._audit_cache.clear()
+    async def flush_audit_log(self):
+        """Wait until every submitted audit entry is written and indexed"""
+        if self.audit_log:
+            await asyncio.get_running_loop().run_in_executor(None, self.audit_log.flush)
     
     async def request_data_export(self, user_id: str, categories: List[str],
                                 format: str = "json") -> Dict[str, Any]:
@@ -881,12 +1043,7 @@ class EnhancedPrivacyService:
         profile = self._privacy_profiles[user_id]
         permission_summary = await self.get_permission_summary(user_id)
         recent_audit = await self.get_audit_trail(user_id, limit=10)
-        
-        # Calculate usage statistics
-        data_access_count = len([
-            entry for entry in profile.audit_trail
-            if entry.action == AuditAction.DATA_ACCESSED
-        ])
+        audit_summary = await self.get_audit_summary(user_id)
         
         return {
             "user_id": user_id,
@@ -899,21 +1056,15 @@ class EnhancedPrivacyService:
             "permission_summary": permission_summary["permission_summary"],
             "recent_activity": recent_audit,
             "usage_statistics": {
-                "total_data_accesses": data_access_count,
-                "categories_accessed": len(set(
-                    entry.category_id for entry in profile.audit_trail
-                    if entry.action == AuditAction.DATA_ACCESSED and entry.category_id
-                )),
-                "last_access": max(
-                    (entry.timestamp for entry in profile.audit_trail), 
-                    default=profile.consent_timestamp
-                ).isoformat()
+                "total_data_accesses": audit_summary["actions"].get(AuditAction.DATA_ACCESSED.value, 0),
+                "categories_accessed": len(audit_summary["categories_accessed"]),
+                "last_access": (audit_summary["last_entry"] or profile.consent_timestamp).isoformat()
             },
             "recommendations": await self._generate_privacy_recommendations(user_id),
             "compliance_status": {
                 "gdpr_compliant": True,
                 "consent_given": profile.consent_timestamp.isoformat(),
-                "audit_trail_available": len(profile.audit_trail) > 0
+                "audit_trail_available": audit_summary["total_entries"] > 0
             }
         }
     
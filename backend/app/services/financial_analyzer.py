@@ -9,6 +9,13 @@ from datetime import datetime, timedelta, timezone
 from collections import defaultdict
 import logging
 
+from .transaction_store import get_transaction_columns
+from .analysis_kernel import TransactionProfile, build_transaction_profile
+from .anomaly_engine import AnomalyEngine
+from .forecast_engine import MonteCarloForecaster
+from .debt_engine import DebtPayoffSimulator
+from .portfolio_engine import Portfolio, get_portfolio_engine
+
 logger = logging.getLogger(__name__)
 
 
@@ -18,6 +25,10 @@ class FinancialAnalyzer:
     def __init__(self):
         """Initialize the analyzer"""
         self.analysis_cache = {}
+        self.anomaly_engine = AnomalyEngine()
+        self.forecaster = MonteCarloForecaster()
+        self.debt_simulator = DebtPayoffSimulator()
+        self.portfolio_engine = get_portfolio_engine()
         self.risk_profiles = {
             "conservative": {"equity_pct": 30, "debt_pct": 70},
             "moderate": {"equity_pct": 60, "debt_pct": 40},
@@ -25,41 +36,40 @@ class FinancialAnalyzer:
         }
     
     def analyze_spending_patterns(self, transactions: List[Dict[str, Any]], 
-                                 timeframe_days: int = 30) -> Dict[str, Any]:
+                                 timeframe_days: int = 30,
+                                 profile: Optional[TransactionProfile] = None) -> Dict[str, Any]:
         """
         Comprehensive spending pattern analysis
         
         Args:
             transactions: List of transaction records
             timeframe_days: Analysis timeframe in days
+            profile: Precomputed single-pass profile to reuse
             
         Returns:
             Detailed spending analysis
         """
         try:
-            # Filter transactions by timeframe
-            cutoff_date = datetime.now(timezone.utc) - timedelta(days=timeframe_days)
-            recent_transactions = self._filter_transactions_by_date(transactions, cutoff_date)
-            
-            # Extract expense transactions
-            expenses = [t for t in recent_transactions if self._is_expense(t)]
+            # Window filtering, category totals, trend halves and amount stats come from one scan
+            if profile is None or profile.timeframe_days != timeframe_days:
+                profile = build_transaction_profile(transactions, timeframe_days)
             
-            if not expenses:
+            if not profile.window_count:
                 return self._empty_spending_analysis()
             
             # Core calculations
-            total_spending = sum(abs(t.get("amount", 0)) for t in expenses)
+            total_spending = profile.window_total
             daily_average = total_spending / timeframe_days
-            transaction_count = len(expenses)
+            transaction_count = profile.window_count
             
             # Category analysis
-            category_breakdown = self._analyze_spending_by_category(expenses)
+            category_breakdown = profile.category_breakdown()
             
             # Trend analysis
-            spending_trend = self._calculate_spending_trend(expenses, timeframe_days)
+            spending_trend = profile.spending_trend()
             
             # Anomaly detection
-            anomalies = self._detect_spending_anomalies(expenses)
+            anomalies = profile.spending_anomalies()
             
             # Insights generation
             insights = self._generate_spending_insights(
@@ -88,7 +98,8 @@ class FinancialAnalyzer:
     
     def forecast_future_balance(self, accounts: List[Dict[str, Any]], 
                                transactions: List[Dict[str, Any]], 
-                               months_ahead: int = 6) -> Dict[str, Any]:
+                               months_ahead: int = 6,
+                               profile: Optional[TransactionProfile] = None) -> Dict[str, Any]:
         """
         Forecast future account balances based on historical patterns
         
@@ -96,6 +107,7 @@ class FinancialAnalyzer:
             accounts: Account information
             transactions: Transaction history
             months_ahead: Number of months to forecast
+            profile: Precomputed single-pass profile to reuse
             
         Returns:
             Balance projection analysis
@@ -105,7 +117,7 @@ class FinancialAnalyzer:
             current_balance = sum(acc.get("balance", 0) for acc in accounts)
             
             # Calculate monthly cash flow patterns
-            monthly_patterns = self._analyze_monthly_cash_flow(transactions, 6)  # Last 6 months
+            monthly_patterns = self._monthly_flows(transactions, 6, profile)  # Last 6 months
             
             if not monthly_patterns:
                 return self._generate_conservative_forecast(current_balance, months_ahead)
@@ -119,29 +131,24 @@ class FinancialAnalyzer:
             net_flows = [month["income"] - month["expenses"] for month in monthly_patterns]
             volatility = statistics.stdev(net_flows) if len(net_flows) > 1 else 0
             
-            # Generate monthly projections
-            projections = []
-            projected_balance = current_balance
+            # Simulate balance paths from recurring items plus resampled residual flow
+            if profile is not None:
+                simulation = self.forecaster.forecast_columns(current_balance, profile.columns, months_ahead)
+            else:
+                simulation = self.forecaster.forecast(current_balance, transactions, months_ahead)
+            if simulation is None:
+                return self._generate_conservative_forecast(current_balance, months_ahead)
             
-            for month in range(1, months_ahead + 1):
-                # Apply trend with confidence intervals
-                projected_flow = avg_net_flow
-                
-                # Account for seasonal variations (simplified)
-                seasonal_factor = self._calculate_seasonal_factor(month)
-                projected_flow *= seasonal_factor
-                
-                projected_balance += projected_flow
-                
-                # Calculate confidence intervals
-                confidence_margin = 1.96 * volatility  # 95% confidence interval
-                
+            projections = []
+            for month in simulation["months"]:
+                bands = month["percentiles"]
                 projections.append({
-                    "month": month,
-                    "projected_balance": round(projected_balance, 2),
-                    "net_flow": round(projected_flow, 2),
-                    "confidence_low": round(projected_balance - confidence_margin, 2),
-                    "confidence_high": round(projected_balance + confidence_margin, 2)
+                    "month": month["month"],
+                    "projected_balance": bands["p50"],
+                    "net_flow": month["median_net_flow"],
+                    "confidence_low": bands["p2_5"],  # 95% of simulated paths lie in the band
+                    "confidence_high": bands["p97_5"],
+                    "percentiles": {key: bands[key] for key in ("p5", "p25", "p50", "p75", "p95")}
                 })
             
             # Generate insights
@@ -162,6 +169,13 @@ class FinancialAnalyzer:
                     "average_net_flow": round(avg_net_flow, 2),
                     "volatility": round(volatility, 2)
                 },
+                "simulation": {
+                    "method": simulation["method"],
+                    "paths": simulation["paths"],
+                    "history_months": simulation["history_months"],
+                    "probability_negative_balance": simulation["probability_negative_balance"],
+                    "recurring": simulation["recurring"]
+                },
                 "insights": insights,
                 "recommendations": self._generate_savings_recommendations(
                     avg_net_flow, volatility, projections
@@ -177,7 +191,8 @@ class FinancialAnalyzer:
                                    transactions: List[Dict[str, Any]], 
                                    liabilities: List[Dict[str, Any]],
                                    purchase_amount: float,
-                                   target_item: str = "purchase") -> Dict[str, Any]:
+                                   target_item: str = "purchase",
+                                   profile: Optional[TransactionProfile] = None) -> Dict[str, Any]:
         """
         Analyze affordability of a specific purchase
         
@@ -187,6 +202,7 @@ class FinancialAnalyzer:
             liabilities: Debt information
             purchase_amount: Amount of the intended purchase
             target_item: Description of the purchase
+            profile: Precomputed single-pass profile to reuse
             
         Returns:
             Affordability analysis
@@ -198,7 +214,7 @@ class FinancialAnalyzer:
             net_worth = total_balance - total_debt
             
             # Monthly cash flow analysis
-            monthly_patterns = self._analyze_monthly_cash_flow(transactions, 3)
+            monthly_patterns = self._monthly_flows(transactions, 3, profile)
             avg_monthly_income = statistics.mean([m["income"] for m in monthly_patterns]) if monthly_patterns else 0
             avg_monthly_expenses = statistics.mean([m["expenses"] for m in monthly_patterns]) if monthly_patterns else 0
             monthly_surplus = avg_monthly_income - avg_monthly_expenses
@@ -271,39 +287,26 @@ class FinancialAnalyzer:
             return {"error": str(e), "analysis_type": "affordability_check"}
     
     def detect_financial_anomalies(self, transactions: List[Dict[str, Any]], 
-                                  threshold_std: float = 2.0) -> Dict[str, Any]:
+                                  threshold_std: float = 2.0,
+                                  profile: Optional[TransactionProfile] = None) -> Dict[str, Any]:
         """
         Detect unusual transactions and spending patterns
         
         Args:
             transactions: Transaction history
             threshold_std: Standard deviation threshold for anomaly detection
+            profile: Precomputed single-pass profile whose columns to reuse
             
         Returns:
             Anomaly detection results
         """
         try:
-            # Separate income and expense transactions
-            expenses = [t for t in transactions if self._is_expense(t)]
-            incomes = [t for t in transactions if not self._is_expense(t)]
-            
-            # Detect expense anomalies
-            expense_anomalies = self._detect_amount_anomalies(expenses, threshold_std)
-            
-            # Detect income anomalies
-            income_anomalies = self._detect_amount_anomalies(incomes, threshold_std)
-            
-            # Detect frequency anomalies (unusual merchant activity)
-            merchant_anomalies = self._detect_merchant_anomalies(expenses)
-            
-            # Detect category anomalies
-            category_anomalies = self._detect_category_anomalies(expenses)
-            
-            # Time-based anomalies (weekend vs weekday, time of day)
-            temporal_anomalies = self._detect_temporal_anomalies(expenses)
-            
-            all_anomalies = (expense_anomalies + income_anomalies + 
-                           merchant_anomalies + category_anomalies + temporal_anomalies)
+            # Expense/income amount, merchant frequency, category-month and
+            # time-of-day anomalies, computed as array operations over the columns
+            if profile is not None:
+                all_anomalies = self.anomaly_engine.detect_columns(profile.columns, threshold_std)
+            else:
+                all_anomalies = self.anomaly_engine.detect(transactions, threshold_std)
             
             # Severity scoring
             scored_anomalies = self._score_anomalies(all_anomalies)
@@ -383,16 +386,17 @@ class FinancialAnalyzer:
             else:  # snowball
                 debts.sort(key=lambda x: x["balance"])
             
-            # Calculate payoff timeline
-            payoff_schedule = self._calculate_debt_payoff_schedule(debts, extra_payment)
-            
-            # Calculate savings from strategy
-            total_interest_saved = self._calculate_interest_savings(debts, payoff_schedule)
+            # Both strategies and the what-if sweep run as one simulation
+            plan = self.debt_simulator.plan(debts, extra_payment, strategy_type)
+            payoff_schedule = plan["schedule"]
+            total_interest_saved = plan["interest_saved"]
             
             # Generate insights
             insights = self._generate_debt_strategy_insights(
-                debts, payoff_schedule, total_interest_saved, strategy_type
+                debts, payoff_schedule if plan["months_to_payoff"] else [], total_interest_saved, strategy_type
             )
+            if plan["months_to_payoff"] is None:
+                insights.insert(0, "Current payments do not clear the debt within 50 years")
             
             return {
                 "analysis_type": "debt_strategy",
@@ -403,9 +407,14 @@ class FinancialAnalyzer:
                 "extra_payment_available": round(extra_payment, 2),
                 "debt_details": debts,
                 "payoff_schedule": payoff_schedule,
-                "projected_debt_free_date": payoff_schedule[-1]["date"] if payoff_schedule else None,
-                "total_months_to_payoff": len(payoff_schedule),
+                "projected_debt_free_date": plan["debt_free_date"],
+                "total_months_to_payoff": plan["months_to_payoff"],
+                "total_interest": plan["total_interest"],
                 "total_interest_saved": round(total_interest_saved, 2),
+                "payoff_order": plan["payoff_order"],
+                "minimum_payments_only": plan["baseline"],
+                "strategy_comparison": plan["strategy_comparison"],
+                "what_if": plan["what_if"],
                 "insights": insights,
                 "recommendations": self._generate_debt_recommendations(
                     strategy_type, payoff_schedule, total_interest_saved
@@ -418,13 +427,15 @@ class FinancialAnalyzer:
             return {"error": str(e), "analysis_type": "debt_strategy"}
     
     def analyze_investment_portfolio(self, investments: List[Dict[str, Any]], 
-                                   risk_profile: str = "moderate") -> Dict[str, Any]:
+                                   risk_profile: str = "moderate",
+                                   portfolio_id: str = "default") -> Dict[str, Any]:
         """
         Analyze investment portfolio and provide rebalancing recommendations
         
         Args:
             investments: Investment portfolio data
             risk_profile: User's risk profile (conservative, moderate, aggressive)
+            portfolio_id: Key of the user's live portfolio in the portfolio engine
             
         Returns:
             Portfolio analysis and recommendations
@@ -433,17 +444,21 @@ class FinancialAnalyzer:
             if not investments:
                 return self._empty_portfolio_analysis()
             
-            # Current portfolio analysis
-            total_value = sum(inv.get("current_value", 0) for inv in investments)
+            # Holdings and running totals live in the engine; only changed
+            # holdings are touched here. Stale prices of every held symbol are
+            # fetched in the background and the valuation uses cached ones meanwhile
+            portfolio = self.portfolio_engine.sync(portfolio_id, investments)
+            self.portfolio_engine.refresh_in_background()
+            total_value = portfolio.total_value
             
             # Asset allocation analysis
-            asset_allocation = self._analyze_asset_allocation(investments, total_value)
+            asset_allocation = portfolio.allocation()
             
             # Performance analysis
-            performance_metrics = self._analyze_portfolio_performance(investments)
+            performance_metrics = portfolio.performance()
             
             # Risk analysis
-            risk_metrics = self._analyze_portfolio_risk(investments, asset_allocation)
+            risk_metrics = self._analyze_portfolio_risk(portfolio, asset_allocation)
             
             # Target allocation based on risk profile
             target_allocation = self.risk_profiles.get(risk_profile, self.risk_profiles["moderate"])
@@ -454,7 +469,7 @@ class FinancialAnalyzer:
             )
             
             # Diversification analysis
-            diversification = self._analyze_diversification(investments, asset_allocation)
+            diversification = self._analyze_diversification(len(portfolio.holdings), asset_allocation)
             
             # Generate insights
             insights = self._generate_portfolio_insights(
@@ -485,7 +500,8 @@ class FinancialAnalyzer:
     def calculate_financial_health_score(self, accounts: List[Dict[str, Any]], 
                                        liabilities: List[Dict[str, Any]], 
                                        transactions: List[Dict[str, Any]], 
-                                       investments: List[Dict[str, Any]] = None) -> Dict[str, Any]:
+                                       investments: List[Dict[str, Any]] = None,
+                                       profile: Optional[TransactionProfile] = None) -> Dict[str, Any]:
         """
         Calculate comprehensive financial health score
         
@@ -494,6 +510,7 @@ class FinancialAnalyzer:
             liabilities: Debt information
             transactions: Transaction history
             investments: Investment portfolio (optional)
+            profile: Precomputed single-pass profile to reuse
             
         Returns:
             Financial health analysis with score
@@ -508,7 +525,7 @@ class FinancialAnalyzer:
             net_worth = total_assets + total_investments - total_debt
             
             # Monthly cash flow
-            monthly_patterns = self._analyze_monthly_cash_flow(transactions, 3)
+            monthly_patterns = self._monthly_flows(transactions, 3, profile)
             avg_monthly_income = statistics.mean([m["income"] for m in monthly_patterns]) if monthly_patterns else 0
             avg_monthly_expenses = statistics.mean([m["expenses"] for m in monthly_patterns]) if monthly_patterns else 0
             monthly_surplus = avg_monthly_income - avg_monthly_expenses
@@ -599,21 +616,58 @@ class FinancialAnalyzer:
             logger.error(f"Error in financial health calculation: {e}")
             return {"error": str(e), "analysis_type": "financial_health"}
     
+    def generate_comprehensive_insights(self, accounts: List[Dict[str, Any]], 
+                                      liabilities: List[Dict[str, Any]], 
+                                      transactions: List[Dict[str, Any]], 
+                                      investments: List[Dict[str, Any]] = None,
+                                      timeframe_days: int = 30,
+                                      months_ahead: int = 6) -> Dict[str, Any]:
+        """
+        Run spending, anomaly, forecast and health analyses over one shared scan
+        
+        Args:
+            accounts: Account information
+            liabilities: Debt information
+            transactions: Transaction history
+            investments: Investment portfolio (optional)
+            timeframe_days: Spending analysis timeframe in days
+            months_ahead: Number of months to forecast
+            
+        Returns:
+            Combined analysis results keyed by analysis
+        """
+        try:
+            profile = build_transaction_profile(transactions, timeframe_days)
+            
+            return {
+                "analysis_type": "comprehensive_insights",
+                "spending_analysis": self.analyze_spending_patterns(transactions, timeframe_days, profile),
+                "anomaly_detection": self.detect_financial_anomalies(transactions, profile=profile),
+                "balance_forecast": self.forecast_future_balance(accounts, transactions, months_ahead, profile),
+                "financial_health": self.calculate_financial_health_score(
+                    accounts, liabilities, transactions, investments, profile
+                ),
+                "transactions_scanned": profile.transaction_count,
+                "timestamp": datetime.now(timezone.utc).isoformat()
+            }
+            
+        except Exception as e:
+            logger.error(f"Error in comprehensive insights: {e}")
+            return {"error": str(e), "analysis_type": "comprehensive_insights"}
+    
     # Helper methods for data processing and calculations
+    def _monthly_flows(self, transactions: List[Dict[str, Any]], months_back: int,
+                       profile: Optional[TransactionProfile]) -> List[Dict[str, Any]]:
+        """Get monthly cash flow from a profile when one is shared"""
+        if profile is not None:
+            return profile.monthly_flows(months_back)
+        return self._analyze_monthly_cash_flow(transactions, months_back)
+    
     def _filter_transactions_by_date(self, transactions: List[Dict[str, Any]], 
                                    cutoff_date: datetime) -> List[Dict[str, Any]]:
         """Filter transactions by date"""
-        filtered = []
-        for t in transactions:
-            try:
-                trans_date_str = t.get("date", "")
-                if trans_date_str:
-                    trans_date = datetime.fromisoformat(trans_date_str.replace('Z', '+00:00'))
-                    if trans_date >= cutoff_date:
-                        filtered.append(t)
-            except (ValueError, TypeError):
-                continue
-        return filtered
+        columns = get_transaction_columns(transactions)
+        return columns.between(start=cutoff_date.timestamp())
     
     def _is_expense(self, transaction: Dict[str, Any]) -> bool:
         """Check if transaction is an expense"""
@@ -659,21 +713,11 @@ class FinancialAnalyzer:
         mid_point = timeframe_days // 2
         cutoff_date = datetime.now(timezone.utc) - timedelta(days=mid_point)
         
-        recent_expenses = []
-        older_expenses = []
-        
-        for expense in expenses:
-            try:
-                expense_date = datetime.fromisoformat(expense.get("date", "").replace('Z', '+00:00'))
-                if expense_date >= cutoff_date:
-                    recent_expenses.append(expense)
-                else:
-                    older_expenses.append(expense)
-            except (ValueError, TypeError):
-                continue
-        
-        recent_total = sum(abs(e.get("amount", 0)) for e in recent_expenses)
-        older_total = sum(abs(e.get("amount", 0)) for e in older_expenses)
+        # Columns are date-sorted, so the split is a single binary search
+        columns = get_transaction_columns(expenses)
+        split, _ = columns.bounds(start=cutoff_date.timestamp())
+        older_total = sum(abs(amount) for amount in columns.amounts[:split])
+        recent_total = sum(abs(amount) for amount in columns.amounts[split:])
         
         # Normalize by days (in case periods aren't exactly equal)
         recent_daily = recent_total / mid_point
@@ -701,61 +745,12 @@ class FinancialAnalyzer:
     def _detect_spending_anomalies(self, expenses: List[Dict[str, Any]], 
                                  threshold_std: float = 2.0) -> List[Dict[str, Any]]:
         """Detect anomalous spending transactions"""
-        if len(expenses) < 5:  # Need sufficient data
-            return []
-        
-        amounts = [abs(e.get("amount", 0)) for e in expenses]
-        mean_amount = statistics.mean(amounts)
-        std_amount = statistics.stdev(amounts) if len(amounts) > 1 else 0
-        
-        anomalies = []
-        for expense in expenses:
-            amount = abs(expense.get("amount", 0))
-            z_score = (amount - mean_amount) / std_amount if std_amount > 0 else 0
-            
-            if abs(z_score) > threshold_std:
-                anomalies.append({
-                    "transaction_id": expense.get("id", "unknown"),
-                    "description": expense.get("description", "Unknown"),
-                    "amount": amount,
-                    "z_score": round(z_score, 2),
-                    "date": expense.get("date", ""),
-                    "category": expense.get("category", "uncategorized"),
-                    "severity": "high" if abs(z_score) > 3 else "medium"
-                })
-        
-        return sorted(anomalies, key=lambda x: abs(x["z_score"]), reverse=True)
+        return self.anomaly_engine.spending_anomalies(expenses, threshold_std)
     
     def _analyze_monthly_cash_flow(self, transactions: List[Dict[str, Any]], 
                                  months_back: int) -> List[Dict[str, Any]]:
         """Analyze monthly cash flow patterns"""
-        monthly_data = defaultdict(lambda: {"income": 0, "expenses": 0})
-        
-        for transaction in transactions:
-            try:
-                trans_date = datetime.fromisoformat(transaction.get("date", "").replace('Z', '+00:00'))
-                month_key = trans_date.strftime("%Y-%m")
-                amount = transaction.get("amount", 0)
-                
-                if amount > 0:
-                    monthly_data[month_key]["income"] += amount
-                else:
-                    monthly_data[month_key]["expenses"] += abs(amount)
-            except (ValueError, TypeError):
-                continue
-        
-        # Get last N months
-        result = []
-        for month_key in sorted(monthly_data.keys())[-months_back:]:
-            data = monthly_data[month_key]
-            result.append({
-                "month": month_key,
-                "income": data["income"],
-                "expenses": data["expenses"],
-                "net_flow": data["income"] - data["expenses"]
-            })
-        
-        return result
+        return get_transaction_columns(transactions).monthly_flows(months_back)
     
     # Import helper functions
     def _calculate_seasonal_factor(self, month: int) -> float:
@@ -868,18 +863,6 @@ class FinancialAnalyzer:
             debts, monthly_surplus, total_minimum_payments
         )
     
-    def _calculate_debt_payoff_schedule(self, debts: List[Dict[str, Any]], 
-                                       extra_payment: float) -> List[Dict[str, Any]]:
-        """Calculate debt payoff schedule"""
-        from .financial_analyzer_helpers import FinancialAnalyzerHelpers
-        return FinancialAnalyzerHelpers.calculate_debt_payoff_schedule(debts, extra_payment)
-    
-    def _calculate_interest_savings(self, debts: List[Dict[str, Any]], 
-                                   payoff_schedule: List[Dict[str, Any]]) -> float:
-        """Calculate interest savings"""
-        from .financial_analyzer_helpers import FinancialAnalyzerHelpers
-        return FinancialAnalyzerHelpers.calculate_interest_savings(debts, payoff_schedule)
-    
     def _generate_debt_strategy_insights(self, debts: List[Dict[str, Any]], 
                                         payoff_schedule: List[Dict[str, Any]],
                                         interest_saved: float, 
@@ -899,8 +882,7 @@ class FinancialAnalyzer:
             strategy_type, payoff_schedule, interest_saved
         )
     
-    # Placeholder methods for investment and portfolio analysis
-    # These would be implemented with more sophisticated financial algorithms
+    # Investment and portfolio analysis helpers
     def _empty_portfolio_analysis(self) -> Dict[str, Any]:
         """Return empty portfolio analysis"""
         return {
@@ -910,62 +892,25 @@ class FinancialAnalyzer:
             "recommendations": ["Consider starting an investment portfolio"]
         }
     
-    def _analyze_asset_allocation(self, investments: List[Dict[str, Any]], 
-                                 total_value: float) -> Dict[str, Any]:
-        """Analyze asset allocation"""
-        allocation = {"equity": 0, "debt": 0, "other": 0}
-        
-        for inv in investments:
-            asset_type = inv.get("type", "other").lower()
-            value = inv.get("current_value", 0)
-            
-            if "equity" in asset_type or "stock" in asset_type:
-                allocation["equity"] += value
-            elif "debt" in asset_type or "bond" in asset_type:
-                allocation["debt"] += value
-            else:
-                allocation["other"] += value
-        
-        # Convert to percentages
-        if total_value > 0:
-            allocation = {k: (v / total_value) * 100 for k, v in allocation.items()}
-        
-        return allocation
-    
-    def _analyze_portfolio_performance(self, investments: List[Dict[str, Any]]) -> Dict[str, Any]:
-        """Analyze portfolio performance"""
-        total_invested = sum(inv.get("invested_amount", 0) for inv in investments)
-        current_value = sum(inv.get("current_value", 0) for inv in investments)
-        
-        if total_invested > 0:
-            returns = ((current_value - total_invested) / total_invested) * 100
-        else:
-            returns = 0
-        
-        return {
-            "total_invested": round(total_invested, 2),
-            "current_value": round(current_value, 2),
-            "absolute_returns": round(current_value - total_invested, 2),
-            "percentage_returns": round(returns, 2)
-        }
-    
-    def _analyze_portfolio_risk(self, investments: List[Dict[str, Any]], 
+    def _analyze_portfolio_risk(self, portfolio: Portfolio, 
                                asset_allocation: Dict[str, Any]) -> Dict[str, Any]:
-        """Analyze portfolio risk"""
-        # Simplified risk analysis based on asset allocation
-        equity_pct = asset_allocation.get("equity", 0)
+        """Analyze portfolio risk from the covariance of its holdings"""
+        risk = self.portfolio_engine.risk(portfolio)
+        volatility_pct = risk["volatility"] * 100
         
-        if equity_pct > 80:
+        if volatility_pct > 20:
             risk_level = "high"
-        elif equity_pct > 50:
+        elif volatility_pct > 10:
             risk_level = "medium"
         else:
             risk_level = "low"
         
         return {
             "risk_level": risk_level,
-            "equity_percentage": round(equity_pct, 1),
-            "volatility_estimate": "moderate"  # Placeholder
+            "equity_percentage": round(asset_allocation.get("equity", 0), 1),
+            "volatility_estimate": round(volatility_pct, 2),
+            "volatility_basis": "observed" if risk["measured_weight"] >= 0.5 else "asset_class_prior",
+            "risk_contributions": risk["contributions"][:5]
         }
     
     def _generate_rebalancing_recommendations(self, current_allocation: Dict[str, Any], 
@@ -994,12 +939,10 @@ class FinancialAnalyzer:
         
         return recommendations
     
-    def _analyze_diversification(self, investments: List[Dict[str, Any]], 
+    def _analyze_diversification(self, num_holdings: int, 
                                asset_allocation: Dict[str, Any]) -> Dict[str, Any]:
         """Analyze portfolio diversification"""
         # Simple diversification score based on number of holdings and allocation spread
-        num_holdings = len(investments)
-        
         # Calculate concentration (higher concentration = lower diversification)
         max_allocation = max(asset_allocation.values()) if asset_allocation else 0
         
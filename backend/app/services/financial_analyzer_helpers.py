@@ -5,7 +5,7 @@ Contains all supporting calculation and utility functions
 import math
 import statistics
 from typing import Dict, Any, List, Tuple, Optional
-from datetime import datetime, timedelta, timezone
+from datetime import datetime, timezone
 from collections import defaultdict
 import logging
 
@@ -540,72 +540,6 @@ class FinancialAnalyzerHelpers:
             "timestamp": datetime.now(timezone.utc).isoformat()
         }
     
-    @staticmethod
-    def calculate_debt_payoff_schedule(debts: List[Dict[str, Any]], 
-                                     extra_payment: float) -> List[Dict[str, Any]]:
-        """Calculate debt payoff schedule using debt avalanche/snowball strategy"""
-        schedule = []
-        remaining_debts = [debt.copy() for debt in debts]  # Don't modify original
-        month = 0
-        remaining_extra = extra_payment
-        
-        while any(debt["balance"] > 0 for debt in remaining_debts) and month < 600:  # Max 50 years
-            month += 1
-            current_date = datetime.now() + timedelta(days=30 * month)
-            
-            # Apply minimum payments to all debts
-            total_paid_this_month = 0
-            for debt in remaining_debts:
-                if debt["balance"] > 0:
-                    min_payment = min(debt["minimum_payment"], debt["balance"])
-                    debt["balance"] -= min_payment
-                    total_paid_this_month += min_payment
-            
-            # Apply extra payment to first debt in sorted order
-            if remaining_extra > 0:
-                for debt in remaining_debts:
-                    if debt["balance"] > 0:
-                        extra_applied = min(remaining_extra, debt["balance"])
-                        debt["balance"] -= extra_applied
-                        total_paid_this_month += extra_applied
-                        break
-            
-            # Record this month's progress
-            remaining_balance = sum(debt["balance"] for debt in remaining_debts)
-            schedule.append({
-                "month": month,
-                "date": current_date.strftime("%Y-%m"),
-                "total_payment": round(total_paid_this_month, 2),
-                "remaining_balance": round(remaining_balance, 2),
-                "debts_remaining": len([d for d in remaining_debts if d["balance"] > 0])
-            })
-            
-            if remaining_balance <= 0:
-                break
-        
-        return schedule
-    
-    @staticmethod
-    def calculate_interest_savings(debts: List[Dict[str, Any]], 
-                                 payoff_schedule: List[Dict[str, Any]]) -> float:
-        """Calculate interest savings from accelerated payoff strategy"""
-        # Simplified calculation - estimate interest saved vs minimum payments only
-        total_debt = sum(debt["balance"] for debt in debts)
-        avg_interest_rate = statistics.mean([debt["interest_rate"] for debt in debts if debt["interest_rate"] > 0])
-        
-        if not payoff_schedule or avg_interest_rate <= 0:
-            return 0
-        
-        # Estimate interest with strategy
-        months_to_payoff = len(payoff_schedule)
-        strategy_interest = total_debt * (avg_interest_rate / 100) * (months_to_payoff / 12) * 0.5  # Rough estimate
-        
-        # Estimate interest with minimum payments only (rough calculation)
-        min_payment_months = total_debt / sum(debt.get("minimum_payment", 0) for debt in debts) if sum(debt.get("minimum_payment", 0) for debt in debts) > 0 else 120
-        minimum_only_interest = total_debt * (avg_interest_rate / 100) * (min_payment_months / 12) * 0.7
-        
-        return max(0, minimum_only_interest - strategy_interest)
-    
     @staticmethod
     def generate_debt_strategy_insights(debts: List[Dict[str, Any]], 
                                       payoff_schedule: List[Dict[str, Any]],
@@ -0,0 +1,345 @@
+"""
+Monte Carlo balance forecasting
+Splits monthly cash flow into recurring items (salary, rent, subscriptions)
+projected as-is and a residual that is bootstrap-resampled from history, then
+simulates thousands of balance paths per user in one array operation and
+reports percentile bands. Forecasts for many users run as one batch.
+"""
+import math
+import os
+import random
+import re
+import statistics
+from dataclasses import dataclass, field
+from typing import Dict, Any, List, Optional, Sequence, Tuple, Mapping
+import logging
+
+try:
+    import numpy as np
+except ImportError:  # NumPy is optional; fall back to a pure Python simulation
+    np = None
+
+from .transaction_store import TransactionColumns, get_transaction_columns
+
+logger = logging.getLogger(__name__)
+
+# Simulated paths per forecast; the pure Python fallback caps this lower
+FORECAST_PATHS = int(os.getenv("FORECAST_PATHS", "2000"))
+FALLBACK_MAX_PATHS = 500
+
+# Calendar months of history the recurring detector and residuals look at
+HISTORY_MONTHS = 12
+
+# Percentiles reported per month; 2.5/97.5 form the 95% band
+PERCENTILES = (2.5, 5, 25, 50, 75, 95, 97.5)
+
+# An item is recurring if it shows up in this share of history months
+# (and at least RECURRING_MIN_MONTHS) with stable monthly totals
+RECURRING_MIN_MONTHS = 3
+RECURRING_MIN_SHARE = 0.6
+RECURRING_MAX_CV = 0.25
+
+# Upper bound on simulated cells (users x paths x months) held at once in batch mode
+BATCH_CELL_BUDGET = 4_000_000
+
+_REFERENCE = re.compile(r"\d{3,}|[#*]+")
+
+
+@dataclass
+class CashFlowModel:
+    """Per-user inputs to the simulation"""
+    current_balance: float
+    recurring_net: float
+    residuals: List[float]
+    recurring_items: List[Dict[str, Any]] = field(default_factory=list)
+    history_months: int = 0
+
+
+def _item_key(record: Dict[str, Any]) -> Optional[Tuple[str, bool]]:
+    """Group key for recurring detection: normalized payee and direction"""
+    name = record.get("merchant") or record.get("description")
+    if not isinstance(name, str) or not name.strip():
+        return None
+    # Reference numbers vary between occurrences of the same item
+    normalized = _REFERENCE.sub("", name.lower()).strip()
+    try:
+        is_income = float(record.get("amount", 0)) > 0
+    except (TypeError, ValueError):
+        return None
+    return normalized, is_income
+
+
+def build_cash_flow_model(columns: TransactionColumns, current_balance: float,
+                          history_months: int = HISTORY_MONTHS) -> Optional[CashFlowModel]:
+    """
+    Decompose recent monthly cash flow into recurring and residual parts
+
+    Args:
+        columns: Columnar transaction history
+        current_balance: Starting balance of every simulated path
+        history_months: Calendar months of history to use
+
+    Returns:
+        The model, or None with fewer than two months of history
+    """
+    if not len(columns):
+        return None
+
+    month_codes = columns.month_codes
+    last_month = max(month_codes)
+    first_month = max(min(month_codes), last_month - history_months + 1)
+    span = last_month - first_month + 1
+    if span < 2:
+        return None
+
+    # Months are dense: a month without transactions contributes a zero flow
+    monthly_net = [0.0] * span
+    item_months: Dict[Tuple[str, bool], Dict[int, float]] = {}
+    item_names: Dict[Tuple[str, bool], str] = {}
+
+    for position in range(len(columns) - 1, -1, -1):
+        month = month_codes[position]
+        if month < first_month:
+            break
+        amount = columns.amounts[position]
+        monthly_net[month - first_month] += amount
+
+        record = columns.records[position]
+        key = _item_key(record)
+        if key is None:
+            continue
+        totals = item_months.setdefault(key, {})
+        totals[month] = totals.get(month, 0.0) + amount
+        item_names.setdefault(key, record.get("merchant") or record.get("description"))
+
+    # Recurring items keep a stable monthly total in most months of the window
+    min_months = max(RECURRING_MIN_MONTHS, math.ceil(RECURRING_MIN_SHARE * span))
+    recurring_net = 0.0
+    recurring_by_month = [0.0] * span
+    recurring_items = []
+    for key, totals in item_months.items():
+        if len(totals) < min_months:
+            continue
+        values = list(totals.values())
+        mean_value = statistics.mean(values)
+        if mean_value == 0 or statistics.pstdev(values) / abs(mean_value) > RECURRING_MAX_CV:
+            continue
+        typical = statistics.median(values)
+        # Items missing from some months are projected at their observed frequency
+        recurring_net += typical * len(totals) / span
+        for month, value in totals.items():
+            recurring_by_month[month - first_month] += value
+        recurring_items.append({
+            "name": item_names[key],
+            "type": "income" if key[1] else "expense",
+            "monthly_amount": round(typical, 2),
+            "months_seen": len(totals)
+        })
+
+    # What is left after the recurring items is resampled as-is
+    residuals = [net - recurring for net, recurring in zip(monthly_net, recurring_by_month)]
+    recurring_items.sort(key=lambda item: abs(item["monthly_amount"]), reverse=True)
+
+    return CashFlowModel(
+        current_balance=float(current_balance),
+        recurring_net=recurring_net,
+        residuals=residuals,
+        recurring_items=recurring_items,
+        history_months=span
+    )
+
+
+class MonteCarloForecaster:
+    """
+    Bootstrap Monte Carlo simulation of future balances
+
+    Each path adds the recurring net flow plus a residual drawn with
+    replacement from the user's own history to every future month. Paths
+    for one user, or for a batch of users, are sampled and accumulated as a
+    single (users, paths, months) array.
+    """
+
+    def __init__(self, paths: int = FORECAST_PATHS, seed: Optional[int] = None):
+        """
+        Initialize the forecaster
+
+        Args:
+            paths: Simulated paths per user
+            seed: Random seed for reproducible forecasts
+        """
+        self.paths = max(1, paths)
+        self.seed = seed
+
+    @property
+    def vectorized(self) -> bool:
+        """Whether the NumPy backend is available"""
+        return np is not None
+
+    def forecast(self, current_balance: float, transactions: List[Dict[str, Any]],
+                 months_ahead: int = 6) -> Optional[Dict[str, Any]]:
+        """
+        Forecast one user's balance
+
+        Args:
+            current_balance: Current total balance
+            transactions: Transaction history
+            months_ahead: Months to simulate
+
+        Returns:
+            Simulation summary, or None when history is too short
+        """
+        return self.forecast_columns(current_balance, get_transaction_columns(transactions), months_ahead)
+
+    def forecast_columns(self, current_balance: float, columns: TransactionColumns,
+                         months_ahead: int = 6) -> Optional[Dict[str, Any]]:
+        """
+        Forecast one user's balance from an already built column set
+
+        Args:
+            current_balance: Current total balance
+            columns: Columnar view of the transactions, e.g. a profile's
+            months_ahead: Months to simulate
+
+        Returns:
+            Simulation summary, or None when history is too short
+        """
+        model = build_cash_flow_model(columns, current_balance)
+        if model is None:
+            return None
+        return self.simulate({"user": model}, months_ahead)["user"]
+
+    def forecast_batch(self, users: Mapping[str, Tuple[float, List[Dict[str, Any]]]],
+                       months_ahead: int = 6) -> Dict[str, Optional[Dict[str, Any]]]:
+        """
+        Forecast many users in one simulation batch (for nightly precomputation)
+
+        Args:
+            users: user_id -> (current balance, transaction history)
+            months_ahead: Months to simulate
+
+        Returns:
+            user_id -> simulation summary, or None when history is too short
+        """
+        models = {}
+        results: Dict[str, Optional[Dict[str, Any]]] = {}
+        for user_id, (balance, transactions) in users.items():
+            model = build_cash_flow_model(get_transaction_columns(transactions), balance)
+            if model is None:
+                results[user_id] = None
+            else:
+                models[user_id] = model
+        results.update(self.simulate(models, months_ahead))
+        return results
+
+    def simulate(self, models: Mapping[str, CashFlowModel], months_ahead: int) -> Dict[str, Dict[str, Any]]:
+        """
+        Run the simulation for prepared cash flow models
+
+        Args:
+            models: user_id -> model
+            months_ahead: Months to simulate
+
+        Returns:
+            user_id -> simulation summary
+        """
+        months_ahead = max(1, months_ahead)
+        if not models:
+            return {}
+        if np is None:
+            return self._simulate_python(models, months_ahead)
+
+        rng = np.random.default_rng(self.seed)
+        user_ids = list(models)
+        results = {}
+        chunk = max(1, BATCH_CELL_BUDGET // (self.paths * months_ahead))
+
+        for start in range(0, len(user_ids), chunk):
+            batch = [models[user_id] for user_id in user_ids[start:start + chunk]]
+            width = max(len(model.residuals) for model in batch)
+            residuals = np.zeros((len(batch), width))
+            for row, model in enumerate(batch):
+                residuals[row, :len(model.residuals)] = model.residuals
+            lengths = np.array([len(model.residuals) for model in batch])
+            recurring = np.array([model.recurring_net for model in batch])
+            balances = np.array([model.current_balance for model in batch])
+
+            # Draw a history month per (user, path, month); scaling by each
+            # user's own history length keeps draws inside their residuals
+            draws = (rng.random((len(batch), self.paths, months_ahead)) * lengths[:, None, None]).astype(np.int64)
+            flows = recurring[:, None, None] + residuals[np.arange(len(batch))[:, None, None], draws]
+            paths = balances[:, None, None] + np.cumsum(flows, axis=2)
+
+            balance_bands = np.percentile(paths, PERCENTILES, axis=1)
+            median_flows = np.median(flows, axis=1)
+            negative = (paths.min(axis=2) < 0).mean(axis=1)
+
+            for row, (user_id, model) in enumerate(zip(user_ids[start:start + chunk], batch)):
+                results[user_id] = self._summary(
+                    model, balance_bands[:, row, :].T.tolist(), median_flows[row].tolist(),
+                    float(negative[row]), self.paths
+                )
+        return results
+
+    def _simulate_python(self, models: Mapping[str, CashFlowModel], months_ahead: int) -> Dict[str, Dict[str, Any]]:
+        """Path-by-path simulation for environments without NumPy"""
+        rng = random.Random(self.seed)
+        paths_count = min(self.paths, FALLBACK_MAX_PATHS)
+        results = {}
+        for user_id, model in models.items():
+            columns: List[List[float]] = [[] for _ in range(months_ahead)]
+            flow_columns: List[List[float]] = [[] for _ in range(months_ahead)]
+            negative = 0
+            for _ in range(paths_count):
+                balance = model.current_balance
+                went_negative = False
+                for month in range(months_ahead):
+                    flow = model.recurring_net + rng.choice(model.residuals)
+                    balance += flow
+                    went_negative = went_negative or balance < 0
+                    columns[month].append(balance)
+                    flow_columns[month].append(flow)
+                negative += went_negative
+
+            bands = [[_percentile(sorted(values), q) for q in PERCENTILES] for values in columns]
+            median_flows = [statistics.median(values) for values in flow_columns]
+            results[user_id] = self._summary(model, bands, median_flows, negative / paths_count, paths_count)
+        return results
+
+    @staticmethod
+    def _summary(model: CashFlowModel, bands: Sequence[Sequence[float]], median_flows: Sequence[float],
+                 probability_negative: float, paths: int) -> Dict[str, Any]:
+        """Shape per-month percentile bands into the summary returned to callers"""
+        months = []
+        for month, (values, flow) in enumerate(zip(bands, median_flows), start=1):
+            months.append({
+                "month": month,
+                "median_net_flow": round(flow, 2),
+                "percentiles": {
+                    f"p{q:g}".replace(".", "_"): round(value, 2) for q, value in zip(PERCENTILES, values)
+                }
+            })
+        recurring_income = sum(item["monthly_amount"] for item in model.recurring_items if item["type"] == "income")
+        recurring_expenses = -sum(item["monthly_amount"] for item in model.recurring_items
+                                  if item["type"] == "expense")
+        return {
+            "method": "bootstrap_monte_carlo",
+            "paths": paths,
+            "history_months": model.history_months,
+            "months": months,
+            "probability_negative_balance": round(probability_negative, 4),
+            "recurring": {
+                "monthly_income": round(recurring_income, 2),
+                "monthly_expenses": round(recurring_expenses, 2),
+                "items": model.recurring_items[:10]
+            }
+        }
+
+
+def _percentile(sorted_values: Sequence[float], q: float) -> float:
+    """Linear-interpolated percentile matching numpy's default method"""
+    if len(sorted_values) == 1:
+        return sorted_values[0]
+    rank = (len(sorted_values) - 1) * q / 100
+    low = int(rank)
+    high = min(low + 1, len(sorted_values) - 1)
+    return sorted_values[low] + (sorted_values[high] - sorted_values[low]) * (rank - low)
@@ -0,0 +1,224 @@
+"""
+Streaming readers for bulk data imports
+Incremental JSON array and CSV readers that yield bounded chunks, plus an async
+bridge that runs the blocking reads on a worker thread with backpressure
+"""
+import asyncio
+import csv
+import json
+import threading
+from concurrent.futures import Executor
+from pathlib import Path
+from typing import Dict, Any, List, Optional, Iterable, Iterator, AsyncIterator, Callable, TextIO
+import logging
+
+logger = logging.getLogger(__name__)
+
+# Characters JSON treats as insignificant whitespace
+_WHITESPACE = " \t\n\r"
+
+# Characters that can legally follow an array element
+_DELIMITERS = _WHITESPACE + ",]"
+
+_DONE = object()
+
+
+def iter_json_array(fp: TextIO, block_size: int = 65536) -> Iterator[Any]:
+    """
+    Incrementally parse a top-level JSON array, yielding one element at a time
+
+    Only the current element and one read block are held in memory, so a
+    multi-gigabyte export streams in constant space.
+
+    Args:
+        fp: Text file positioned at the start of the array
+        block_size: Characters read per refill
+
+    Yields:
+        Decoded array elements in order
+
+    Raises:
+        ValueError: If the input is not a well-formed JSON array
+    """
+    decoder = json.JSONDecoder()
+    buffer = ""
+    pos = 0
+    eof = False
+
+    def fill() -> None:
+        nonlocal buffer, pos, eof
+        block = fp.read(block_size)
+        if not block:
+            eof = True
+        buffer = buffer[pos:] + block
+        pos = 0
+
+    def next_char() -> str:
+        """Skip whitespace and return the next significant character, '' at end"""
+        nonlocal pos
+        while True:
+            while pos < len(buffer) and buffer[pos] in _WHITESPACE:
+                pos += 1
+            if pos < len(buffer):
+                return buffer[pos]
+            if eof:
+                return ""
+            fill()
+
+    if next_char() != "[":
+        raise ValueError("Expected a JSON array")
+    pos += 1
+
+    if next_char() == "]":
+        return
+
+    while True:
+        if not next_char():
+            raise ValueError("Unexpected end of JSON array")
+
+        while True:
+            try:
+                value, end = decoder.raw_decode(buffer, pos)
+                # A number cut at the block edge ("-1." of "-1.5") decodes early,
+                # so only accept a value once a delimiter is visible after it
+                if eof or (end < len(buffer) and buffer[end] in _DELIMITERS):
+                    break
+            except json.JSONDecodeError as e:
+                if eof:
+                    raise ValueError(f"Invalid JSON array element: {e}")
+            fill()
+
+        pos = end
+        yield value
+
+        separator = next_char()
+        if separator == "]":
+            return
+        if separator != ",":
+            raise ValueError(f"Expected ',' or ']' in JSON array, found {separator!r}")
+        pos += 1
+
+
+def peek_json_array(fp: TextIO) -> bool:
+    """Check whether a JSON text stream starts with an array, without consuming it"""
+    start = fp.tell()
+    while True:
+        char = fp.read(1)
+        if not char or char not in _WHITESPACE:
+            break
+    fp.seek(start)
+    return char == "["
+
+
+def iter_csv_rows(fp: TextIO) -> Iterator[Dict[str, Any]]:
+    """
+    Yield CSV rows as dictionaries tagged with their source row number
+
+    Args:
+        fp: Text file opened with newline=''
+
+    Yields:
+        Row dictionaries, skipping empty rows
+    """
+    reader = csv.DictReader(fp)
+    for row_num, row in enumerate(reader, start=1):
+        if row:  # Skip empty rows
+            row['_source_row'] = row_num
+            yield row
+
+
+def chunked(items: Iterable[Any], size: int) -> Iterator[List[Any]]:
+    """Group an iterable into lists of at most ``size`` items"""
+    chunk = []
+    for item in items:
+        chunk.append(item)
+        if len(chunk) >= size:
+            yield chunk
+            chunk = []
+    if chunk:
+        yield chunk
+
+
+def iter_file_chunks(file_path: Path, file_format: str, chunk_size: int) -> Iterator[List[Any]]:
+    """
+    Stream a JSON array or CSV file as record chunks
+
+    Args:
+        file_path: File to read
+        file_format: "json" or "csv"
+        chunk_size: Maximum records per chunk
+
+    Yields:
+        Lists of raw records
+    """
+    if file_format == "csv":
+        with open(file_path, 'r', encoding='utf-8', newline='') as f:
+            yield from chunked(iter_csv_rows(f), chunk_size)
+        return
+
+    with open(file_path, 'r', encoding='utf-8') as f:
+        if not peek_json_array(f):
+            # Single-object documents are small; decode them whole
+            yield [json.load(f)]
+            return
+        yield from chunked(iter_json_array(f), chunk_size)
+
+
+async def stream_chunks(make_iterator: Callable[[], Iterator[Any]],
+                        max_pending: int = 2,
+                        executor: Optional[Executor] = None) -> AsyncIterator[Any]:
+    """
+    Run a blocking chunk iterator on a worker thread and yield its chunks
+
+    The reader thread blocks once ``max_pending`` chunks are waiting, so a slow
+    consumer bounds memory instead of letting the whole file pile up.
+
+    Args:
+        make_iterator: Factory for the blocking chunk iterator, called on the worker
+        max_pending: Maximum chunks read ahead of the consumer
+        executor: Executor running the reader; the loop's default when None
+
+    Yields:
+        Chunks in file order
+
+    Raises:
+        Exception: Any error raised by the reader, re-raised in the consumer
+    """
+    loop = asyncio.get_running_loop()
+    queue: asyncio.Queue = asyncio.Queue(maxsize=max_pending)
+    cancelled = threading.Event()
+
+    def produce() -> None:
+        def put(item: Any) -> None:
+            asyncio.run_coroutine_threadsafe(queue.put(item), loop).result()
+
+        try:
+            for chunk in make_iterator():
+                if cancelled.is_set():
+                    return
+                put(chunk)
+            put(_DONE)
+        except Exception as e:
+            if not cancelled.is_set():
+                put(e)
+
+    reader = loop.run_in_executor(executor, produce)
+    try:
+        while True:
+            item = await queue.get()
+            if item is _DONE:
+                break
+            if isinstance(item, Exception):
+                raise item
+            yield item
+    finally:
+        cancelled.set()
+        # Keep draining so a reader blocked on a full queue can observe the cancel and exit
+        while True:
+            while not queue.empty():
+                queue.get_nowait()
+            done, _ = await asyncio.wait({reader}, timeout=0.05)
+            if done:
+                break
+        if reader.exception() is not None:
+            logger.debug(f"Stream reader stopped: {reader.exception()}")
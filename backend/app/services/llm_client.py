@@ -0,0 +1,118 @@
+"""
+Non-blocking access to the generative model
+Uses the SDK's native async API when present and otherwise runs the blocking
+calls on a small dedicated thread pool, so a slow completion never stalls the
+event loop; streaming yields text pieces as the model produces them
+"""
+import asyncio
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from typing import Any, AsyncIterator, Iterator, Optional
+import logging
+
+from .ingestion_stream import stream_chunks
+from .metrics import span
+
+logger = logging.getLogger(__name__)
+
+# Concurrent blocking model calls; further requests queue instead of taking loop threads
+MAX_BLOCKING_CALLS = 4
+
+_executor: Optional[ThreadPoolExecutor] = None
+_executor_lock = threading.Lock()
+
+
+def get_llm_executor() -> ThreadPoolExecutor:
+    """
+    Get the bounded thread pool for blocking model calls
+
+    Returns:
+        Shared ThreadPoolExecutor instance
+    """
+    global _executor
+    if _executor is None:
+        with _executor_lock:
+            if _executor is None:
+                _executor = ThreadPoolExecutor(max_workers=MAX_BLOCKING_CALLS,
+                                               thread_name_prefix="llm")
+    return _executor
+
+
+def _chunk_text(chunk: Any) -> str:
+    """Text of a response or stream chunk; blocked or empty candidates give ''"""
+    try:
+        return chunk.text or ""
+    except (ValueError, AttributeError):
+        return ""
+
+
+async def generate_text(model: Any, prompt: str) -> str:
+    """
+    Generate a complete response without blocking the event loop
+
+    Args:
+        model: Generative model instance
+        prompt: Prompt text
+
+    Returns:
+        Response text, '' if the model returned nothing
+    """
+    with span("llm"):
+        if hasattr(model, "generate_content_async"):
+            response = await model.generate_content_async(prompt)
+        else:
+            loop = asyncio.get_running_loop()
+            response = await loop.run_in_executor(get_llm_executor(), model.generate_content, prompt)
+    return _chunk_text(response).strip() if response else ""
+
+
+async def stream_text(model: Any, prompt: str) -> AsyncIterator[str]:
+    """
+    Stream a response as the model produces it
+
+    Args:
+        model: Generative model instance
+        prompt: Prompt text
+
+    Yields:
+        Non-empty text pieces in order
+    """
+    # Covers the whole stream, including time the consumer spends between pieces
+    with span("llm_stream"):
+        if hasattr(model, "generate_content_async"):
+            response = await model.generate_content_async(prompt, stream=True)
+            async for chunk in response:
+                text = _chunk_text(chunk)
+                if text:
+                    yield text
+            return
+
+        def blocking_stream() -> Iterator[str]:
+            for chunk in model.generate_content(prompt, stream=True):
+                text = _chunk_text(chunk)
+                if text:
+                    yield text
+
+        async for text in stream_chunks(blocking_stream, max_pending=16, executor=get_llm_executor()):
+            yield text
+
+
+async def stream_words(text: str) -> AsyncIterator[str]:
+    """
+    Stream a locally generated response word by word
+
+    Keeps mock and fallback responses on the same incremental path as model output.
+
+    Args:
+        text: Complete response text
+
+    Yields:
+        Words with their trailing whitespace
+    """
+    start = 0
+    while start < len(text):
+        end = text.find(" ", start)
+        end = len(text) if end == -1 else end + 1
+        yield text[start:end]
+        start = end
+        await asyncio.sleep(0)
@@ -0,0 +1,309 @@
+"""
+Latency instrumentation and Prometheus exposition
+Request middleware records per-route latency histograms; ``span`` records
+per-stage histograms for the internal steps of a request (data load, privacy
+filter, NLP, analysis, LLM, serialization). Services expose their own cache
+and queue counters through collectors that are read only when /metrics is
+scraped, so the request path pays for a clock read and a locked increment.
+"""
+import bisect
+import inspect
+import os
+import threading
+import time
+from contextlib import contextmanager
+from functools import wraps
+from typing import Any, Callable, Dict, Iterable, Iterator, List, NamedTuple, Optional, Tuple
+import logging
+
+logger = logging.getLogger(__name__)
+
+ENABLED_ENV = "ENABLE_METRICS"
+
+# Latency bucket upper bounds in seconds (1 ms to 30 s)
+LATENCY_BUCKETS = (0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0)
+
+PROCESS_START = time.time()
+
+LabelSet = Tuple[Tuple[str, str], ...]
+
+# Metric families: name -> (type, help)
+FAMILIES = {
+    "http_request_duration_seconds": ("histogram", "HTTP request latency by route"),
+    "http_requests_in_progress": ("gauge", "HTTP requests currently being served"),
+    "app_stage_duration_seconds": ("histogram", "Latency of internal request stages"),
+    "app_stage_errors_total": ("counter", "Stage executions that raised"),
+    "app_stage_in_progress": ("gauge", "Stage executions currently running"),
+    "app_uptime_seconds": ("gauge", "Seconds since the process started"),
+    "app_cache_hits_total": ("counter", "Cache lookups served from the cache"),
+    "app_cache_misses_total": ("counter", "Cache lookups that had to compute"),
+    "app_cache_entries": ("gauge", "Entries currently held by a cache"),
+    "app_queue_depth": ("gauge", "Work items waiting or running in a bounded queue or pool"),
+    "app_events_total": ("counter", "Service event counters"),
+}
+
+
+class Sample(NamedTuple):
+    """One collected value"""
+    name: str
+    labels: Dict[str, str]
+    value: float
+
+
+def metrics_enabled() -> bool:
+    """Whether ``ENABLE_METRICS`` leaves instrumentation on (the default)"""
+    return os.getenv(ENABLED_ENV, "true").lower() not in ("0", "false", "no", "off")
+
+
+def _labels(labels: Dict[str, Any]) -> LabelSet:
+    return tuple(sorted((key, str(value)) for key, value in labels.items()))
+
+
+class Histogram:
+    """Fixed-bucket histogram (bucket counts are cumulated at exposition)"""
+
+    __slots__ = ("bounds", "counts", "total", "count")
+
+    def __init__(self, bounds: Tuple[float, ...] = LATENCY_BUCKETS):
+        self.bounds = bounds
+        self.counts = [0] * (len(bounds) + 1)
+        self.total = 0.0
+        self.count = 0
+
+    def observe(self, value: float) -> None:
+        self.counts[bisect.bisect_left(self.bounds, value)] += 1
+        self.total += value
+        self.count += 1
+
+    def quantile(self, q: float) -> Optional[float]:
+        """Upper bound of the bucket holding the q-quantile (None if empty or beyond the last bound)"""
+        if not self.count:
+            return None
+        rank = q * self.count
+        seen = 0
+        for bound, count in zip(self.bounds, self.counts):
+            seen += count
+            if seen >= rank:
+                return bound
+        return None
+
+
+class MetricsRegistry:
+    """In-process histograms, counters and gauges with scrape-time collectors"""
+
+    def __init__(self):
+        self._histograms: Dict[Tuple[str, LabelSet], Histogram] = {}
+        self._counters: Dict[Tuple[str, LabelSet], float] = {}
+        self._gauges: Dict[Tuple[str, LabelSet], float] = {}
+        self._collectors: List[Callable[[], Iterable[Sample]]] = []
+        self._lock = threading.Lock()
+
+    def observe(self, name: str, seconds: float, **labels: Any) -> None:
+        key = (name, _labels(labels))
+        with self._lock:
+            histogram = self._histograms.get(key)
+            if histogram is None:
+                histogram = self._histograms[key] = Histogram()
+            histogram.observe(seconds)
+
+    def inc(self, name: str, amount: float = 1.0, **labels: Any) -> None:
+        key = (name, _labels(labels))
+        with self._lock:
+            self._counters[key] = self._counters.get(key, 0.0) + amount
+
+    def add_gauge(self, name: str, delta: float, **labels: Any) -> None:
+        key = (name, _labels(labels))
+        with self._lock:
+            self._gauges[key] = self._gauges.get(key, 0.0) + delta
+
+    def register_collector(self, collect: Callable[[], Iterable[Sample]]) -> None:
+        """Add a callable returning samples, read on every scrape"""
+        with self._lock:
+            self._collectors.append(collect)
+
+    def histogram(self, name: str, **labels: Any) -> Optional[Histogram]:
+        with self._lock:
+            return self._histograms.get((name, _labels(labels)))
+
+    def stage_summary(self) -> Dict[str, Dict[str, Any]]:
+        """Count, mean and bucketed p50/p95 per stage, for the status endpoint"""
+        with self._lock:
+            items = [(dict(labels).get("stage"), h) for (name, labels), h in self._histograms.items()
+                     if name == "app_stage_duration_seconds"]
+            return {
+                stage: {
+                    "count": h.count,
+                    "mean_ms": round(h.total / h.count * 1000, 2) if h.count else 0.0,
+                    "p50_le_ms": None if h.quantile(0.5) is None else h.quantile(0.5) * 1000,
+                    "p95_le_ms": None if h.quantile(0.95) is None else h.quantile(0.95) * 1000
+                }
+                for stage, h in items
+            }
+
+    def collect(self) -> List[Sample]:
+        """Samples from every collector; failing collectors are logged and skipped"""
+        with self._lock:
+            collectors = list(self._collectors)
+        samples = [Sample("app_uptime_seconds", {}, time.time() - PROCESS_START)]
+        for collect in collectors:
+            try:
+                samples.extend(collect())
+            except Exception as e:
+                logger.warning(f"Metrics collector {getattr(collect, '__name__', collect)} failed: {e}")
+        return samples
+
+    def render(self) -> str:
+        """Prometheus text exposition format (version 0.0.4)"""
+        with self._lock:
+            histograms = [(name, labels, list(h.counts), h.total, h.count, h.bounds)
+                          for (name, labels), h in self._histograms.items()]
+            scalars = [(name, labels, value) for (name, labels), value in
+                       list(self._counters.items()) + list(self._gauges.items())]
+        scalars += [(s.name, _labels(s.labels), float(s.value)) for s in self.collect()]
+
+        families: Dict[str, List[str]] = {}
+        for name, labels, counts, total, count, bounds in sorted(histograms):
+            lines = families.setdefault(name, [])
+            cumulative = 0
+            for bound, bucket in zip(bounds + (float("inf"),), counts):
+                cumulative += bucket
+                le = "+Inf" if bound == float("inf") else repr(bound)
+                lines.append(f"{name}_bucket{_format_labels(labels + (('le', le),))} {cumulative}")
+            lines.append(f"{name}_sum{_format_labels(labels)} {total!r}")
+            lines.append(f"{name}_count{_format_labels(labels)} {count}")
+        for name, labels, value in sorted(scalars):
+            families.setdefault(name, []).append(f"{name}{_format_labels(labels)} {value!r}")
+
+        output = []
+        for name, lines in families.items():
+            kind, help_text = FAMILIES.get(name, ("untyped", name))
+            output.append(f"# HELP {name} {help_text}")
+            output.append(f"# TYPE {name} {kind}")
+            output.extend(lines)
+        return "\n".join(output) + "\n"
+
+
+def _format_labels(labels: LabelSet) -> str:
+    if not labels:
+        return ""
+    escaped = (value.replace("\\", "\\\\").replace("\n", "\\n").replace('"', '\\"') for _, value in labels)
+    return "{" + ",".join(f'{key}="{value}"' for (key, _), value in zip(labels, escaped)) + "}"
+
+
+@contextmanager
+def span(stage: str) -> Iterator[None]:
+    """
+    Time one stage of a request
+
+    Args:
+        stage: Stage name (data_load, privacy_filter, nlp, analysis, llm, serialization, ...)
+    """
+    registry = get_metrics_registry()
+    registry.add_gauge("app_stage_in_progress", 1, stage=stage)
+    start = time.perf_counter()
+    try:
+        yield
+    except Exception:
+        registry.inc("app_stage_errors_total", stage=stage)
+        raise
+    finally:
+        registry.observe("app_stage_duration_seconds", time.perf_counter() - start, stage=stage)
+        registry.add_gauge("app_stage_in_progress", -1, stage=stage)
+
+
+def timed(stage: str) -> Callable:
+    """Decorator form of ``span`` for sync and async functions"""
+    def decorate(func: Callable) -> Callable:
+        if inspect.iscoroutinefunction(func):
+            @wraps(func)
+            async def async_wrapper(*args, **kwargs):
+                with span(stage):
+                    return await func(*args, **kwargs)
+            return async_wrapper
+
+        @wraps(func)
+        def wrapper(*args, **kwargs):
+            with span(stage):
+                return func(*args, **kwargs)
+        return wrapper
+    return decorate
+
+
+def cache_samples(cache: str, stats: Dict[str, Any]) -> List[Sample]:
+    """Hit, miss and size samples from a service's ``get_stats`` output"""
+    labels = {"cache": cache}
+    samples = []
+    if "hits" in stats:
+        # Requests coalesced onto an in-flight computation did not compute either
+        samples.append(Sample("app_cache_hits_total", labels, stats["hits"] + stats.get("coalesced", 0)))
+    if "misses" in stats:
+        samples.append(Sample("app_cache_misses_total", labels, stats["misses"]))
+    if "entries" in stats:
+        samples.append(Sample("app_cache_entries", labels, stats["entries"]))
+    return samples
+
+
+def _route_label(scope: Dict[str, Any]) -> str:
+    """Route template of a handled request; unmatched paths share one label"""
+    route = scope.get("route")
+    path = getattr(route, "path", None)
+    if path:
+        return path
+    endpoint = scope.get("endpoint")
+    return getattr(endpoint, "__name__", None) or "unmatched"
+
+
+class MetricsMiddleware:
+    """ASGI middleware recording request latency per method, route and status class"""
+
+    def __init__(self, app: Callable, registry: Optional[MetricsRegistry] = None,
+                 exclude: Iterable[str] = ("/metrics",)):
+        """
+        Wrap an ASGI application
+
+        Args:
+            app: Downstream ASGI application
+            registry: Registry to record into; the process-wide one by default
+            exclude: Paths not recorded (the scrape endpoint itself)
+        """
+        self.app = app
+        self.registry = registry or get_metrics_registry()
+        self.exclude = frozenset(exclude)
+
+    async def __call__(self, scope, receive, send):
+        if scope["type"] != "http" or scope["path"] in self.exclude:
+            await self.app(scope, receive, send)
+            return
+
+        status = 500
+
+        async def recording_send(message):
+            nonlocal status
+            if message["type"] == "http.response.start":
+                status = message["status"]
+            await send(message)
+
+        self.registry.add_gauge("http_requests_in_progress", 1)
+        start = time.perf_counter()
+        try:
+            await self.app(scope, receive, recording_send)
+        finally:
+            self.registry.add_gauge("http_requests_in_progress", -1)
+            self.registry.observe(
+                "http_request_duration_seconds", time.perf_counter() - start,
+                method=scope.get("method", ""), route=_route_label(scope), status=f"{status // 100}xx"
+            )
+
+
+_registry: Optional[MetricsRegistry] = None
+_registry_lock = threading.Lock()
+
+
+def get_metrics_registry() -> MetricsRegistry:
+    """Get the process-wide metrics registry"""
+    global _registry
+    if _registry is None:
+        with _registry_lock:
+            if _registry is None:
+                _registry = MetricsRegistry()
+    return _registry
@@ -7,6 +7,9 @@ from typing import Dict, List, Any, Optional
 from datetime import datetime, timedelta
 from dateutil.relativedelta import relativedelta
 
+from .pattern_matcher import PatternMatcher, ScanResult
+from .metrics import timed
+
 logger = logging.getLogger(__name__)
 
 
@@ -106,7 +109,25 @@ class NLPService:
                 r"(?:increase|decrease|up|down|rise|fall)"
             ]
         }
+        
+        # Compile every pattern once; a query is scanned a single time for all of them
+        self.matcher = PatternMatcher()
+        for intent, patterns in self.intent_patterns.items():
+            self.matcher.add_group(f"intent:{intent}", patterns)
+        for entity_type, patterns in self.entity_patterns.items():
+            self.matcher.add_group(entity_type, patterns)
+        self.matcher.add_group("relative_period", [
+            (r"this\s+(month|week|year)", "current"),
+            (r"last\s+(month|week|year|quarter)", "previous"),
+            (r"next\s+(month|week|year|quarter)", "future")
+        ])
+        self.matcher.add_group("period_count", [
+            (r"past\s+(\d+)\s+(months?|weeks?|years?|quarters?)", "previous"),
+            (r"next\s+(\d+)\s+(months?|weeks?|years?|quarters?)", "future")
+        ])
+        self.matcher.compile()
     
+    @timed("nlp")
     def process_query(self, user_query: str) -> Dict[str, Any]:
         """
         Process a natural language query to extract intent and entities
@@ -122,15 +143,16 @@ class NLPService:
             
             # Clean and normalize the query
             normalized_query = self._normalize_query(user_query)
+            scan = self.matcher.scan(normalized_query)
             
             # Extract intent
-            intent = self._classify_intent(normalized_query)
+            intent = self._classify_intent(normalized_query, scan)
             
             # Extract entities
-            entities = self._extract_entities(normalized_query)
+            entities = self._extract_entities(normalized_query, scan)
             
             # Add confidence scores
-            intent_confidence = self._calculate_intent_confidence(normalized_query, intent)
+            intent_confidence = self._calculate_intent_confidence(normalized_query, intent, scan)
             entity_confidence = self._calculate_entity_confidence(normalized_query, entities)
             
             result = {
@@ -172,16 +194,14 @@ class NLPService:
         
         return normalized
     
-    def _classify_intent(self, query: str) -> str:
+    def _classify_intent(self, query: str, scan: Optional[ScanResult] = None) -> str:
         """Classify the intent of the query"""
         best_intent = "unknown"
         best_score = 0
+        scan = scan or self.matcher.scan(query)
         
-        for intent, patterns in self.intent_patterns.items():
-            score = 0
-            for pattern in patterns:
-                if re.search(pattern, query, re.IGNORECASE):
-                    score += 1
+        for intent in self.intent_patterns:
+            score = scan.count(f"intent:{intent}")
             
             if score > best_score:
                 best_score = score
@@ -206,37 +226,38 @@ class NLPService:
         else:
             return "get_financial_health"
     
-    def _extract_entities(self, query: str) -> Dict[str, Any]:
+    def _extract_entities(self, query: str, scan: Optional[ScanResult] = None) -> Dict[str, Any]:
         """Extract entities from the query"""
         entities = {}
+        scan = scan or self.matcher.scan(query)
         
         # Extract amounts
-        amounts = self._extract_amounts(query)
+        amounts = self._extract_amounts(query, scan)
         if amounts:
             entities["amounts"] = amounts
         
         # Extract categories
-        categories = self._extract_categories(query)
+        categories = self._extract_categories(query, scan)
         if categories:
             entities["categories"] = categories
         
         # Extract time periods
-        time_periods = self._extract_time_periods(query)
+        time_periods = self._extract_time_periods(query, scan)
         if time_periods:
             entities["time_periods"] = time_periods
         
         # Extract comparisons
-        comparisons = self._extract_comparisons(query)
+        comparisons = self._extract_comparisons(query, scan)
         if comparisons:
             entities["comparisons"] = comparisons
         
         return entities
     
-    def _extract_amounts(self, query: str) -> List[float]:
+    def _extract_amounts(self, query: str, scan: Optional[ScanResult] = None) -> List[float]:
         """Extract monetary amounts from the query"""
         amounts = []
-        for pattern in self.entity_patterns["amount"]:
-            matches = re.findall(pattern, query, re.IGNORECASE)
+        scan = scan or self.matcher.scan(query)
+        for _, matches in scan.findall("amount"):
             for match in matches:
                 try:
                     # Remove commas and convert to float
@@ -247,61 +268,48 @@ class NLPService:
                     continue
         return amounts
     
-    def _extract_categories(self, query: str) -> List[str]:
+    def _extract_categories(self, query: str, scan: Optional[ScanResult] = None) -> List[str]:
         """Extract spending categories from the query"""
         categories = []
-        for pattern in self.entity_patterns["category"]:
-            matches = re.findall(pattern, query, re.IGNORECASE)
+        scan = scan or self.matcher.scan(query)
+        for _, matches in scan.findall("category"):
             categories.extend(matches)
         return list(set(categories))  # Remove duplicates
     
-    def _extract_time_periods(self, query: str) -> List[Dict[str, Any]]:
+    def _extract_time_periods(self, query: str, scan: Optional[ScanResult] = None) -> List[Dict[str, Any]]:
         """Extract time periods from the query"""
         time_periods = []
+        scan = scan or self.matcher.scan(query)
         
-        # Relative time periods
-        if re.search(r"this\s+(month|week|year)", query, re.IGNORECASE):
-            time_periods.append({"type": "current", "period": "month"})
-        elif re.search(r"last\s+(month|week|year|quarter)", query, re.IGNORECASE):
-            time_periods.append({"type": "previous", "period": "month"})
-        elif re.search(r"next\s+(month|week|year|quarter)", query, re.IGNORECASE):
-            time_periods.append({"type": "future", "period": "month"})
+        # Relative time periods (first matching reference only)
+        relative = scan.search("relative_period")
+        if relative:
+            time_periods.append({"type": relative[0][0], "period": "month"})
         
         # Specific number of periods
-        past_match = re.search(r"past\s+(\d+)\s+(months?|weeks?|years?|quarters?)", query, re.IGNORECASE)
-        if past_match:
-            count = int(past_match.group(1))
-            period = past_match.group(2).rstrip('s')
-            time_periods.append({"type": "previous", "count": count, "period": period})
-        
-        future_match = re.search(r"next\s+(\d+)\s+(months?|weeks?|years?|quarters?)", query, re.IGNORECASE)
-        if future_match:
-            count = int(future_match.group(1))
-            period = future_match.group(2).rstrip('s')
-            time_periods.append({"type": "future", "count": count, "period": period})
+        for period_type, match in scan.search("period_count"):
+            count = int(match.group(1))
+            period = match.group(2).rstrip('s')
+            time_periods.append({"type": period_type, "count": count, "period": period})
         
         return time_periods
     
-    def _extract_comparisons(self, query: str) -> List[str]:
+    def _extract_comparisons(self, query: str, scan: Optional[ScanResult] = None) -> List[str]:
         """Extract comparison indicators from the query"""
         comparisons = []
-        for pattern in self.entity_patterns["comparison"]:
-            matches = re.findall(pattern, query, re.IGNORECASE)
+        scan = scan or self.matcher.scan(query)
+        for _, matches in scan.findall("comparison"):
             comparisons.extend(matches)
         return list(set(comparisons))
     
-    def _calculate_intent_confidence(self, query: str, intent: str) -> float:
+    def _calculate_intent_confidence(self, query: str, intent: str,
+                                     scan: Optional[ScanResult] = None) -> float:
         """Calculate confidence score for intent classification"""
         if intent == "unknown":
             return 0.0
         
-        patterns = self.intent_patterns.get(intent, [])
-        matches = 0
-        total_patterns = len(patterns)
-        
-        for pattern in patterns:
-            if re.search(pattern, query, re.IGNORECASE):
-                matches += 1
+        total_patterns = len(self.intent_patterns.get(intent, []))
+        matches = (scan or self.matcher.scan(query)).count(f"intent:{intent}")
         
         return matches / total_patterns if total_patterns > 0 else 0.0
     
@@ -0,0 +1,256 @@
+"""
+Precompiled pattern sets for query matching
+Every pattern is compiled once and indexed by the literal text any match must
+contain; one combined scan over the query finds which literals occur, and only
+patterns whose literals were found are run, in their original order
+"""
+import re
+from typing import Dict, Any, List, Optional, Iterable, Iterator, Set, Tuple, FrozenSet
+import logging
+
+try:
+    from re import _parser as _sre_parse, _constants as _sre_constants
+except ImportError:  # Python < 3.11
+    import sre_parse as _sre_parse
+    import sre_constants as _sre_constants
+
+logger = logging.getLogger(__name__)
+
+_LITERAL = _sre_constants.LITERAL
+_SUBPATTERN = _sre_constants.SUBPATTERN
+_BRANCH = _sre_constants.BRANCH
+_REPEATS = tuple(
+    getattr(_sre_constants, name)
+    for name in ("MAX_REPEAT", "MIN_REPEAT", "POSSESSIVE_REPEAT")
+    if hasattr(_sre_constants, name)
+)
+
+
+def required_literals(pattern: str, flags: int = 0) -> Optional[FrozenSet[str]]:
+    """
+    Find literal strings of which every match of a pattern contains at least one
+
+    Only consecutive literal characters, groups, alternations of such and
+    repeats with a non-zero minimum are considered, so the result is always
+    safe: a text containing none of the literals cannot match.
+
+    Args:
+        pattern: Regular expression source
+        flags: Flags the pattern is compiled with
+
+    Returns:
+        Alternative literals, or None if a match need not contain any literal
+    """
+    try:
+        parsed = _sre_parse.parse(pattern, flags)
+    except Exception:
+        return None
+    literals = _sequence_literals(list(parsed))
+    return frozenset(literals) if literals else None
+
+
+def _sequence_literals(items: List[Tuple[Any, Any]]) -> Optional[Set[str]]:
+    """Strongest literal alternative set required by a parsed sequence"""
+    best: Optional[Set[str]] = None
+    run: List[str] = []
+
+    def consider(candidate: Optional[Set[str]]) -> None:
+        nonlocal best
+        if candidate and (best is None or _strength(candidate) > _strength(best)):
+            best = candidate
+
+    for op, av in items:
+        if op is _LITERAL:
+            run.append(chr(av))
+            continue
+
+        consider({"".join(run)} if run else None)
+        run = []
+
+        if op is _SUBPATTERN:
+            consider(_sequence_literals(list(av[-1])))
+        elif op is _BRANCH:
+            alternatives = [_sequence_literals(list(branch)) for branch in av[1]]
+            if all(alternatives):
+                consider(set().union(*alternatives))
+        elif op in _REPEATS and av[0] >= 1:
+            consider(_sequence_literals(list(av[2])))
+        # Classes, assertions and optional repeats require nothing
+
+    consider({"".join(run)} if run else None)
+    return best
+
+
+def _strength(literals: Set[str]) -> Tuple[int, int]:
+    """Rank literal sets: longer shortest alternative first, then fewer alternatives"""
+    return (min(len(literal) for literal in literals), -len(literals))
+
+
+class ScanResult:
+    """Literals found in one text, used to run only the patterns that can match"""
+
+    def __init__(self, matcher: "PatternMatcher", text: str, present: Set[int]):
+        self.matcher = matcher
+        self.text = text
+        self._present = present
+        self._searched: Dict[str, List[Tuple[Any, "re.Match"]]] = {}
+
+    def _candidates(self, group: str) -> Iterator[Tuple[Any, "re.Pattern"]]:
+        for payload, compiled, literal_ids in self.matcher._groups.get(group, ()):
+            if literal_ids is None or not self._present.isdisjoint(literal_ids):
+                yield payload, compiled
+
+    def search(self, group: str) -> List[Tuple[Any, "re.Match"]]:
+        """
+        First match of every pattern in a group that matches
+
+        Args:
+            group: Pattern group name
+
+        Returns:
+            (payload, match) pairs in pattern order
+        """
+        results = self._searched.get(group)
+        if results is None:
+            results = []
+            for payload, compiled in self._candidates(group):
+                match = compiled.search(self.text)
+                if match:
+                    results.append((payload, match))
+            self._searched[group] = results
+        return results
+
+    def finditer(self, group: str) -> Iterator[Tuple[Any, "re.Match"]]:
+        """
+        All matches of every pattern in a group, pattern by pattern
+
+        Args:
+            group: Pattern group name
+
+        Yields:
+            (payload, match) pairs in pattern order, then text order
+        """
+        for payload, compiled in self._candidates(group):
+            for match in compiled.finditer(self.text):
+                yield payload, match
+
+    def findall(self, group: str) -> Iterator[Tuple[Any, List[Any]]]:
+        """
+        ``re.findall`` results of every pattern in a group that can match
+
+        Args:
+            group: Pattern group name
+
+        Yields:
+            (payload, findall list) pairs in pattern order
+        """
+        for payload, compiled in self._candidates(group):
+            yield payload, compiled.findall(self.text)
+
+    def count(self, group: str) -> int:
+        """Number of patterns in a group that match the text"""
+        return len(self.search(group))
+
+
+class PatternMatcher:
+    """
+    Named groups of regular expressions matched with a single literal prefilter
+
+    Patterns are added to groups with an arbitrary payload, then compiled once.
+    ``scan`` runs one combined regex over the text to find the required
+    literals present; group lookups on the result give exactly what running
+    each pattern with ``re.search``/``re.finditer`` would, in the same order.
+    """
+
+    def __init__(self, flags: int = re.IGNORECASE):
+        """
+        Initialize the matcher
+
+        Args:
+            flags: Flags every pattern and the literal scan are compiled with
+        """
+        self.flags = flags
+        self._pending: Dict[str, List[Tuple[Any, str]]] = {}
+        self._groups: Dict[str, List[Tuple[Any, "re.Pattern", Optional[FrozenSet[int]]]]] = {}
+        self._scanner: Optional["re.Pattern"] = None
+        self._implied: List[FrozenSet[int]] = []
+        self._compiled = False
+
+    def add(self, group: str, pattern: str, payload: Any = None) -> "PatternMatcher":
+        """Add one pattern to a group; payload defaults to the pattern source"""
+        self._pending.setdefault(group, []).append((pattern if payload is None else payload, pattern))
+        self._compiled = False
+        return self
+
+    def add_group(self, group: str, patterns: Iterable[Any]) -> "PatternMatcher":
+        """
+        Add several patterns to a group
+
+        Args:
+            group: Pattern group name
+            patterns: Pattern sources, or (pattern, payload) pairs
+        """
+        for entry in patterns:
+            if isinstance(entry, tuple):
+                self.add(group, entry[0], entry[1])
+            else:
+                self.add(group, entry)
+        return self
+
+    def compile(self) -> "PatternMatcher":
+        """Compile every pattern and build the combined literal scan"""
+        fold = str.lower if self.flags & re.IGNORECASE else str
+        literal_ids: Dict[str, int] = {}
+        groups = {}
+        for group, entries in self._pending.items():
+            compiled_entries = []
+            for payload, pattern in entries:
+                literals = required_literals(pattern, self.flags)
+                ids = None
+                if literals is not None:
+                    ids = frozenset(literal_ids.setdefault(fold(literal), len(literal_ids))
+                                    for literal in literals)
+                compiled_entries.append((payload, re.compile(pattern, self.flags), ids))
+            groups[group] = compiled_entries
+
+        literals = sorted(literal_ids, key=lambda literal: (-len(literal), literal))
+        self._groups = groups
+        self._implied = [frozenset()] * len(literals)
+        self._scanner = None
+        self._compiled = True
+        if literals:
+            # One group per literal, longest first: at each position the literal
+            # found is the longest there, and every shorter one there is its prefix
+            self._scanner = re.compile(
+                "(?=(?:" + "|".join(f"({re.escape(literal)})" for literal in literals) + "))",
+                self.flags
+            )
+            self._implied = [
+                frozenset(literal_ids[other] for other in literals if literal.startswith(other))
+                for literal in literals
+            ]
+
+        always = sum(1 for entries in groups.values() for entry in entries if entry[2] is None)
+        logger.debug(f"Compiled {sum(len(e) for e in groups.values())} patterns over "
+                     f"{len(literals)} literals ({always} without a literal prefilter)")
+        return self
+
+    def scan(self, text: str) -> ScanResult:
+        """
+        Scan a text once for every required literal
+
+        Args:
+            text: Text to match
+
+        Returns:
+            ScanResult answering group lookups for the text
+        """
+        if not self._compiled:
+            self.compile()
+
+        present: Set[int] = set()
+        if self._scanner is not None:
+            implied = self._implied
+            for match in self._scanner.finditer(text):
+                present |= implied[match.lastindex - 1]
+        return ScanResult(self, text, present)
@@ -0,0 +1,500 @@
+"""
+Incremental portfolio valuation
+Keeps every user's holdings keyed by symbol with running totals per asset
+class, so a price tick adjusts only the holdings of that symbol instead of
+re-summing whole portfolios. Prices come from a pluggable source through a
+TTL cache shared by all users, fetched in rate-limited batches of stale
+symbols on a background thread so requests value portfolios from cached
+prices. Risk uses an exponentially weighted covariance of time-normalized
+returns between price observations, seeded from asset-class priors.
+"""
+import json
+import math
+import os
+import threading
+import time
+import urllib.parse
+import urllib.request
+from concurrent.futures import Future, ThreadPoolExecutor
+from dataclasses import dataclass
+from typing import Dict, Any, List, Optional, Callable, Iterable, Set, Tuple
+import logging
+
+logger = logging.getLogger(__name__)
+
+# Seconds a fetched price stays fresh
+PRICE_TTL_SECONDS = float(os.getenv("PRICE_TTL_SECONDS", "900"))
+
+# Symbols per upstream request and the minimum gap between requests
+PRICE_BATCH_SIZE = int(os.getenv("PRICE_BATCH_SIZE", "50"))
+PRICE_MIN_INTERVAL_SECONDS = float(os.getenv("PRICE_MIN_INTERVAL_SECONDS", "0.5"))
+
+# JSON quote endpoint: GET <url>?symbols=A,B -> {"A": 101.5, "B": 20.1}
+PRICE_FEED_URL = os.getenv("PRICE_FEED_URL")
+
+# RiskMetrics decay for the covariance estimate
+EWMA_LAMBDA = 0.94
+
+# Observations before a symbol's volatility counts as measured rather than prior
+MIN_RISK_OBSERVATIONS = 5
+
+SECONDS_PER_YEAR = 365.25 * 24 * 3600
+
+# Annual volatility priors by investment type, and prior correlations
+TYPE_VOLATILITY = {
+    "stock": 0.25, "equity": 0.20, "etf": 0.16, "mutual_fund": 0.16, "elss": 0.18,
+    "bond": 0.05, "debt": 0.05, "fd": 0.01, "fixed_deposit": 0.01, "ppf": 0.01,
+    "cryptocurrency": 0.65, "crypto": 0.65
+}
+DEFAULT_VOLATILITY = 0.15
+SAME_CLASS_CORRELATION = 0.6
+CROSS_CLASS_CORRELATION = 0.2
+
+PriceSource = Callable[[List[str]], Dict[str, float]]
+
+
+def asset_class(investment_type: str) -> str:
+    """Map an investment type to the equity/debt/other allocation bucket"""
+    investment_type = (investment_type or "other").lower()
+    if "equity" in investment_type or "stock" in investment_type:
+        return "equity"
+    if "debt" in investment_type or "bond" in investment_type:
+        return "debt"
+    return "other"
+
+
+def http_price_source(url: str, timeout: float = 5.0) -> PriceSource:
+    """Price source backed by a JSON quote endpoint"""
+    def fetch(symbols: List[str]) -> Dict[str, float]:
+        query = urllib.parse.urlencode({"symbols": ",".join(symbols)})
+        with urllib.request.urlopen(f"{url}?{query}", timeout=timeout) as response:
+            quotes = json.load(response)
+        return {symbol: float(price) for symbol, price in quotes.items() if price is not None}
+    return fetch
+
+
+class PriceCache:
+    """Last known price per symbol with fetch time, shared across portfolios"""
+
+    def __init__(self, ttl_seconds: float = PRICE_TTL_SECONDS):
+        self.ttl_seconds = ttl_seconds
+        self._prices: Dict[str, Tuple[float, float]] = {}
+
+    def get(self, symbol: str) -> Optional[float]:
+        """Last known price, fresh or not"""
+        entry = self._prices.get(symbol)
+        return entry[0] if entry else None
+
+    def put(self, symbol: str, price: float, fetched_at: float) -> None:
+        self._prices[symbol] = (price, fetched_at)
+
+    def stale(self, symbols: Iterable[str], now: float) -> List[str]:
+        """Symbols with no price or one older than the TTL"""
+        return [s for s in symbols if s not in self._prices or now - self._prices[s][1] >= self.ttl_seconds]
+
+    def __len__(self) -> int:
+        return len(self._prices)
+
+
+class EwmaCovariance:
+    """
+    Exponentially weighted covariance of annualized returns
+
+    A return between two observations of a symbol is divided by the square root
+    of the elapsed years, so products of returns estimate annual covariance
+    whatever the refresh interval. Pairs update when both symbols move in the
+    same observation; everything else falls back to the asset-class prior.
+    """
+
+    def __init__(self, decay: float = EWMA_LAMBDA):
+        self.decay = decay
+        self._last: Dict[str, Tuple[float, float]] = {}
+        self._variance: Dict[str, float] = {}
+        self._covariance: Dict[Tuple[str, str], float] = {}
+        self._classes: Dict[str, str] = {}
+        self._observations: Dict[str, int] = {}
+
+    def register(self, key: str, investment_type: str) -> None:
+        """Seed a symbol's variance from its type prior"""
+        if key not in self._variance:
+            self._variance[key] = TYPE_VOLATILITY.get((investment_type or "").lower(), DEFAULT_VOLATILITY) ** 2
+            self._classes[key] = asset_class(investment_type)
+
+    def observe(self, prices: Dict[str, float], at: float) -> None:
+        """Fold one batch of price observations into the estimate"""
+        scaled: Dict[str, float] = {}
+        for symbol, price in prices.items():
+            last = self._last.get(symbol)
+            self._last[symbol] = (price, at)
+            if last is None or last[0] <= 0 or price <= 0 or at <= last[1]:
+                continue
+            scaled[symbol] = math.log(price / last[0]) / math.sqrt((at - last[1]) / SECONDS_PER_YEAR)
+
+        keep = self.decay
+        symbols = sorted(scaled)
+        for i, a in enumerate(symbols):
+            self._variance[a] = keep * self._variance.get(a, DEFAULT_VOLATILITY ** 2) + (1 - keep) * scaled[a] ** 2
+            self._observations[a] = self._observations.get(a, 0) + 1
+            for b in symbols[i + 1:]:
+                pair = (a, b)
+                prior = self._covariance.get(pair, self._prior_covariance(a, b))
+                self._covariance[pair] = keep * prior + (1 - keep) * scaled[a] * scaled[b]
+
+    def _prior_covariance(self, a: str, b: str) -> float:
+        correlation = SAME_CLASS_CORRELATION if self._classes.get(a) == self._classes.get(b) else CROSS_CLASS_CORRELATION
+        return correlation * math.sqrt(self._variance.get(a, 0.0) * self._variance.get(b, 0.0))
+
+    def covariance(self, a: str, b: str) -> float:
+        if a == b:
+            return self._variance.get(a, DEFAULT_VOLATILITY ** 2)
+        pair = (a, b) if a < b else (b, a)
+        return self._covariance.get(pair, self._prior_covariance(*pair))
+
+    def measured(self, key: str) -> bool:
+        return self._observations.get(key, 0) >= MIN_RISK_OBSERVATIONS
+
+
+@dataclass
+class Holding:
+    """One position; lots of the same symbol are merged"""
+    key: str
+    symbol: Optional[str]
+    name: str
+    investment_type: str
+    quantity: float = 0.0
+    invested: float = 0.0
+    static_value: float = 0.0
+    price: Optional[float] = None
+
+    @property
+    def asset_class(self) -> str:
+        return asset_class(self.investment_type)
+
+    @property
+    def value(self) -> float:
+        if self.symbol and self.quantity > 0 and self.price is not None:
+            return self.quantity * self.price
+        return self.static_value
+
+    def fingerprint(self) -> Tuple[Any, ...]:
+        return (self.symbol, self.investment_type, self.quantity, self.invested, self.static_value)
+
+
+def _number(value: Any) -> float:
+    try:
+        return float(value or 0)
+    except (TypeError, ValueError):
+        return 0.0
+
+
+def _holdings_from(investments: List[Dict[str, Any]]) -> Dict[str, Holding]:
+    """Group investment records into holdings keyed by symbol"""
+    holdings: Dict[str, Holding] = {}
+    for index, inv in enumerate(investments):
+        symbol = inv.get("symbol") or None
+        key = symbol or f"id:{inv.get('id', index)}"
+        quantity = _number(inv.get("quantity", inv.get("units")))
+        value = _number(inv.get("current_value", inv.get("total_value")))
+        invested = _number(inv.get("invested_amount")) or _number(inv.get("purchase_price")) * quantity
+
+        holding = holdings.get(key)
+        if holding is None:
+            holding = holdings[key] = Holding(key=key, symbol=symbol, name=inv.get("name", key),
+                                              investment_type=inv.get("type", "other"))
+        holding.quantity += quantity
+        holding.invested += invested
+        holding.static_value += value
+        price = _number(inv.get("current_price"))
+        if price > 0:
+            holding.price = price
+    for holding in holdings.values():
+        if holding.price is None and holding.symbol and holding.quantity > 0 and holding.static_value > 0:
+            holding.price = holding.static_value / holding.quantity
+    return holdings
+
+
+class Portfolio:
+    """One user's holdings with running totals"""
+
+    def __init__(self, portfolio_id: str):
+        self.portfolio_id = portfolio_id
+        self.holdings: Dict[str, Holding] = {}
+        self.total_value = 0.0
+        self.total_invested = 0.0
+        self.class_values = {"equity": 0.0, "debt": 0.0, "other": 0.0}
+        self.risk: Optional[Dict[str, Any]] = None
+
+    def add(self, holding: Holding) -> None:
+        self.holdings[holding.key] = holding
+        self._adjust(holding, 1)
+
+    def remove(self, key: str) -> None:
+        self._adjust(self.holdings.pop(key), -1)
+
+    def _adjust(self, holding: Holding, sign: int) -> None:
+        value = holding.value
+        self.total_value += sign * value
+        self.total_invested += sign * holding.invested
+        self.class_values[holding.asset_class] += sign * value
+        self.risk = None
+
+    def reprice(self, key: str, price: float) -> None:
+        """Apply a price tick to one holding"""
+        holding = self.holdings[key]
+        before = holding.value
+        holding.price = price
+        delta = holding.value - before
+        self.total_value += delta
+        self.class_values[holding.asset_class] += delta
+        self.risk = None
+
+    def allocation(self) -> Dict[str, float]:
+        """Allocation percentage per asset class"""
+        if self.total_value <= 0:
+            return dict(self.class_values)
+        return {name: value / self.total_value * 100 for name, value in self.class_values.items()}
+
+    def performance(self) -> Dict[str, Any]:
+        gain = self.total_value - self.total_invested
+        returns = gain / self.total_invested * 100 if self.total_invested > 0 else 0
+        return {
+            "total_invested": round(self.total_invested, 2),
+            "current_value": round(self.total_value, 2),
+            "absolute_returns": round(gain, 2),
+            "percentage_returns": round(returns, 2)
+        }
+
+
+class PortfolioEngine:
+    """Shared price cache, covariance estimate and per-user portfolios"""
+
+    def __init__(self, price_source: Optional[PriceSource] = None, ttl_seconds: float = PRICE_TTL_SECONDS,
+                 batch_size: int = PRICE_BATCH_SIZE, min_interval: float = PRICE_MIN_INTERVAL_SECONDS,
+                 clock: Callable[[], float] = time.time):
+        """
+        Initialize the engine
+
+        Args:
+            price_source: Callable returning prices for a list of symbols; None keeps record prices
+            ttl_seconds: Freshness window of cached prices
+            batch_size: Symbols per upstream request
+            min_interval: Minimum seconds between upstream requests
+            clock: Time source, injectable for tests
+        """
+        if price_source is None and PRICE_FEED_URL:
+            price_source = http_price_source(PRICE_FEED_URL)
+        self.price_source = price_source
+        self.prices = PriceCache(ttl_seconds)
+        self.covariance = EwmaCovariance()
+        self.batch_size = max(1, batch_size)
+        self.min_interval = min_interval
+        self.clock = clock
+        self._portfolios: Dict[str, Portfolio] = {}
+        self._holders: Dict[str, Set[str]] = {}
+        self._fetching: Set[str] = set()
+        self._revisions: Dict[str, int] = {}
+        self._refresher: Optional[ThreadPoolExecutor] = None
+        self._pending_refresh: Optional[Future] = None
+        self._last_fetch = float("-inf")
+        self._fetches = 0
+        self._lock = threading.RLock()
+
+    def sync(self, portfolio_id: str, investments: List[Dict[str, Any]]) -> Portfolio:
+        """
+        Bring a portfolio in line with its investment records
+
+        Only holdings whose quantity, cost or type changed are re-added; the
+        rest keep their running totals and live prices.
+        """
+        incoming = _holdings_from(investments)
+        with self._lock:
+            portfolio = self._portfolios.setdefault(portfolio_id, Portfolio(portfolio_id))
+            for key in [k for k in portfolio.holdings if k not in incoming]:
+                self._unhold(portfolio, key)
+            for key, holding in incoming.items():
+                current = portfolio.holdings.get(key)
+                if current is not None and current.fingerprint() == holding.fingerprint():
+                    # Without a live price the record's own price is the latest
+                    if holding.price is not None and self.prices.get(key) is None and holding.price != current.price:
+                        portfolio.reprice(key, holding.price)
+                    continue
+                if current is not None:
+                    self._unhold(portfolio, key)
+                if holding.symbol:
+                    cached = self.prices.get(holding.symbol)
+                    if cached is not None:
+                        holding.price = cached
+                    self._holders.setdefault(holding.symbol, set()).add(portfolio_id)
+                self.covariance.register(key, holding.investment_type)
+                portfolio.add(holding)
+            return portfolio
+
+    def _unhold(self, portfolio: Portfolio, key: str) -> None:
+        symbol = portfolio.holdings[key].symbol
+        portfolio.remove(key)
+        if symbol:
+            holders = self._holders.get(symbol, set())
+            holders.discard(portfolio.portfolio_id)
+            if not holders:
+                self._holders.pop(symbol, None)
+
+    def refresh_prices(self, symbols: Optional[Iterable[str]] = None) -> int:
+        """
+        Fetch stale prices in batches, within the rate limit
+
+        Symbols another caller is already fetching are skipped, and batches
+        that would exceed the rate limit are left for a later refresh, so
+        requests never wait on the upstream.
+
+        Args:
+            symbols: Symbols to consider (defaults to every held symbol)
+
+        Returns:
+            Number of price ticks applied
+        """
+        if self.price_source is None:
+            return 0
+        with self._lock:
+            wanted = list(self._holders) if symbols is None else [s for s in symbols if s]
+            stale = [s for s in self.prices.stale(wanted, self.clock()) if s not in self._fetching]
+            self._fetching.update(stale)
+
+        ticks = 0
+        try:
+            for start in range(0, len(stale), self.batch_size):
+                batch = stale[start:start + self.batch_size]
+                with self._lock:
+                    now = self.clock()
+                    if now - self._last_fetch < self.min_interval:
+                        break
+                    self._last_fetch = now
+                    self._fetches += 1
+                try:
+                    quotes = self.price_source(batch)
+                except Exception as e:
+                    logger.warning(f"Price fetch failed for {len(batch)} symbols: {e}")
+                    continue
+                ticks += self.apply_prices({s: p for s, p in quotes.items() if s in batch and p > 0})
+        finally:
+            with self._lock:
+                self._fetching.difference_update(stale)
+        return ticks
+
+    def refresh_in_background(self, symbols: Optional[Iterable[str]] = None) -> bool:
+        """
+        Queue ``refresh_prices`` on the engine's refresh thread and return at once
+
+        A refresh already queued or running absorbs the request; the ticks it
+        applies bump ``price_revision`` for the portfolios holding the symbols.
+
+        Args:
+            symbols: Symbols to consider (defaults to every held symbol)
+
+        Returns:
+            True if a refresh was queued
+        """
+        if self.price_source is None:
+            return False
+        symbols = None if symbols is None else list(symbols)
+        with self._lock:
+            if self._pending_refresh is not None and not self._pending_refresh.done():
+                return False
+            if self._refresher is None:
+                self._refresher = ThreadPoolExecutor(max_workers=1, thread_name_prefix="price-refresh")
+            self._pending_refresh = self._refresher.submit(self._refresh_logged, symbols)
+            return True
+
+    def _refresh_logged(self, symbols: Optional[List[str]]) -> None:
+        try:
+            self.refresh_prices(symbols)
+        except Exception as e:
+            logger.error(f"Background price refresh failed: {e}")
+
+    def price_revision(self, portfolio_id: str) -> int:
+        """Count of price ticks applied to a portfolio; changes whenever its valuation moved"""
+        with self._lock:
+            return self._revisions.get(portfolio_id, 0)
+
+    def close(self) -> None:
+        """Stop the refresh thread, letting a running refresh finish (call on shutdown)"""
+        with self._lock:
+            refresher, self._refresher = self._refresher, None
+        if refresher is not None:
+            refresher.shutdown(wait=True, cancel_futures=True)
+
+    def apply_prices(self, prices: Dict[str, float], at: Optional[float] = None) -> int:
+        """
+        Apply price ticks to every portfolio holding the symbols
+
+        Args:
+            prices: symbol -> new price
+            at: Observation time (defaults to now)
+
+        Returns:
+            Number of symbols applied
+        """
+        at = self.clock() if at is None else at
+        with self._lock:
+            for symbol, price in prices.items():
+                self.prices.put(symbol, price, at)
+                for portfolio_id in self._holders.get(symbol, ()):
+                    self._portfolios[portfolio_id].reprice(symbol, price)
+            self.covariance.observe(prices, at)
+            # Covariance moved for these symbols, so cached risk of their holders is stale
+            for portfolio_id in {p for symbol in prices for p in self._holders.get(symbol, ())}:
+                self._portfolios[portfolio_id].risk = None
+                self._revisions[portfolio_id] = self._revisions.get(portfolio_id, 0) + 1
+        return len(prices)
+
+    def risk(self, portfolio: Portfolio) -> Dict[str, Any]:
+        """Annualized volatility and per-holding risk contribution, cached until the next tick"""
+        with self._lock:
+            if portfolio.risk is not None:
+                return portfolio.risk
+            keys = [k for k, h in portfolio.holdings.items() if h.value > 0]
+            total = sum(portfolio.holdings[k].value for k in keys)
+            weights = [portfolio.holdings[k].value / total for k in keys] if total > 0 else []
+
+            # Marginal contribution (Σw)_i; portfolio variance is w·Σw
+            marginal = [sum(self.covariance.covariance(a, b) * w_b for b, w_b in zip(keys, weights)) for a in keys]
+            variance = sum(w * m for w, m in zip(weights, marginal))
+            volatility = math.sqrt(max(variance, 0.0))
+
+            contributions = sorted((
+                {"holding": portfolio.holdings[k].name, "symbol": portfolio.holdings[k].symbol,
+                 "weight": round(w * 100, 2),
+                 "risk_share": round(w * m / variance * 100, 2) if variance > 0 else 0.0}
+                for k, w, m in zip(keys, weights, marginal)
+            ), key=lambda item: item["risk_share"], reverse=True)
+
+            measured = sum(w for k, w in zip(keys, weights) if self.covariance.measured(k))
+            portfolio.risk = {
+                "volatility": volatility,
+                "measured_weight": measured,
+                "contributions": contributions
+            }
+            return portfolio.risk
+
+    def get_stats(self) -> Dict[str, Any]:
+        with self._lock:
+            return {
+                "portfolios": len(self._portfolios),
+                "symbols_held": len(self._holders),
+                "cached_prices": len(self.prices),
+                "upstream_fetches": self._fetches,
+                "price_source": self.price_source is not None
+            }
+
+
+# Global engine instance
+_engine: Optional[PortfolioEngine] = None
+_engine_lock = threading.Lock()
+
+
+def get_portfolio_engine() -> PortfolioEngine:
+    """Get the process-wide portfolio engine"""
+    global _engine
+    with _engine_lock:
+        if _engine is None:
+            _engine = PortfolioEngine()
+        return _engine
@@ -0,0 +1,399 @@
+"""
+Background precomputation of dashboard and insight results
+A scheduler task started with the application recomputes registered jobs
+(dashboard insights, spending trends, category breakdowns, comprehensive
+spending/health/forecast insights) for every known user when the data store
+version changes, and again on a cadence for results that depend on the
+current date. Jobs wait in a priority queue that coalesces repeated
+triggers. Results go into the analysis result cache under the same keys
+endpoints look up, so requests are served from the cache and compute only
+on a miss, off the event loop for offloaded jobs.
+"""
+import asyncio
+import heapq
+import inspect
+import itertools
+import os
+import threading
+import time
+from collections import OrderedDict
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, Hashable, List, Mapping, Optional, Tuple
+import logging
+
+from ..models.requests import Permissions
+from .data_store import DataStore, get_data_store
+from .privacy_service import PrivacyService, PERMISSION_CATEGORIES
+from .result_cache import AnalysisCacheScope, AnalysisResultCache, get_analysis_cache
+
+logger = logging.getLogger(__name__)
+
+ENABLED_ENV = "ENABLE_PRECOMPUTE"
+INTERVAL_ENV = "PRECOMPUTE_INTERVAL_SECONDS"
+POLL_ENV = "PRECOMPUTE_POLL_SECONDS"
+
+# Users whose results are kept warm; the least recently served are dropped first
+MAX_TRACKED_USERS = 256
+
+# Trigger priorities (lower runs first); each job adds its own priority
+PRIORITY_DATA_CHANGE = 0
+PRIORITY_CADENCE = 10
+
+DEFAULT_USER_ID = "default_user"
+
+JobKey = Tuple[str, str, Tuple[str, ...]]
+
+
+def precompute_enabled() -> bool:
+    """Whether ``ENABLE_PRECOMPUTE`` leaves the scheduler on (the default)"""
+    return os.getenv(ENABLED_ENV, "true").lower() not in ("0", "false", "no", "off")
+
+
+def _storable(result: Any) -> bool:
+    """Failed analyses report an error key instead of raising; never cache those"""
+    return not (isinstance(result, dict) and "error" in result)
+
+
+@dataclass(frozen=True)
+class PrecomputeJob:
+    """
+    A result the scheduler keeps warm
+
+    ``compute(context, **params)`` returns the result or an awaitable of it and
+    runs once per entry of ``variants``. Results are cached under
+    ``make_key(user_id, name, params, scope)``. Offloaded jobs run on a worker
+    thread and must only read ``context.data`` (an immutable snapshot); others
+    run on the event loop and may read store state such as the published
+    aggregates; their results are only cached while the store is still at the
+    job's data version.
+    """
+    name: str
+    compute: Callable[..., Any]
+    variants: Tuple[Dict[str, Any], ...] = ({},)
+    requires: Tuple[str, ...] = ()
+    priority: int = 0
+    offload: bool = False
+
+
+@dataclass
+class JobContext:
+    """Inputs of one job run"""
+    user_id: str
+    permissions: Permissions
+    data_version: int
+    data: Mapping[str, Any]
+    store: DataStore
+
+
+class JobQueue:
+    """
+    Priority queue of job keys with trigger coalescing
+
+    A key waits in the queue at most once. Triggering a queued key again only
+    raises its priority if the new trigger is more urgent.
+    """
+
+    def __init__(self):
+        self._heap: List[list] = []
+        self._pending: Dict[Hashable, list] = {}
+        self._sequence = itertools.count()
+        self.coalesced = 0
+
+    def push(self, key: Hashable, priority: int) -> bool:
+        """
+        Queue a key
+
+        Returns:
+            False if the key was already queued (the trigger was coalesced)
+        """
+        queued = self._pending.get(key)
+        if queued is not None:
+            self.coalesced += 1
+            if priority >= queued[0]:
+                return False
+            queued[2] = None  # Superseded by the more urgent entry; skipped when popped
+        entry = [priority, next(self._sequence), key]
+        self._pending[key] = entry
+        heapq.heappush(self._heap, entry)
+        return queued is None
+
+    def pop(self) -> Optional[Tuple[Hashable, int]]:
+        """Most urgent queued key and its priority, or None when empty"""
+        while self._heap:
+            priority, _, key = heapq.heappop(self._heap)
+            if key is not None:
+                del self._pending[key]
+                return key, priority
+        return None
+
+    def __len__(self) -> int:
+        return len(self._pending)
+
+
+class PrecomputeScheduler:
+    """Keeps registered job results warm in the analysis result cache"""
+
+    def __init__(self, store: Optional[DataStore] = None, cache: Optional[AnalysisResultCache] = None,
+                 privacy_service: Optional[PrivacyService] = None,
+                 interval: Optional[float] = None, poll_interval: Optional[float] = None):
+        """
+        Initialize the scheduler
+
+        Args:
+            store: Data store whose version drives recomputation
+            cache: Result cache to fill
+            privacy_service: Filter applied per user before computing
+            interval: Seconds between cadence recomputations of everything
+            poll_interval: Seconds between data version checks
+        """
+        self.store = store or get_data_store()
+        self.cache = cache or get_analysis_cache()
+        self.privacy_service = privacy_service or PrivacyService()
+        self.interval = interval if interval is not None else float(os.getenv(INTERVAL_ENV, "900"))
+        self.poll_interval = poll_interval if poll_interval is not None else float(os.getenv(POLL_ENV, "2"))
+        self.jobs: Dict[str, PrecomputeJob] = {}
+        self.queue = JobQueue()
+        self._users: "OrderedDict[Tuple[str, Tuple[str, ...]], Permissions]" = OrderedDict()
+        self._lock = threading.Lock()
+        self._seen_version: Optional[int] = None
+        self._task: Optional[asyncio.Task] = None
+        self._wake: Optional[asyncio.Event] = None
+        self._stats = {"triggers": 0, "runs": 0, "failures": 0, "dropped": 0, "inline_computes": 0}
+        self._last_run_ms: Dict[str, float] = {}
+        self.register_user(DEFAULT_USER_ID, Permissions(**{name: True for name in PERMISSION_CATEGORIES}))
+
+    def register_job(self, job: PrecomputeJob) -> None:
+        """Add a job; registering a name again replaces it"""
+        with self._lock:
+            self.jobs[job.name] = job
+
+    def register_user(self, user_id: str, permissions: Permissions) -> bool:
+        """
+        Track a user and permission set so their results are precomputed
+
+        Returns:
+            True if the pair was not tracked before
+        """
+        key = (user_id, tuple(name for name in PERMISSION_CATEGORIES if getattr(permissions, name, False)))
+        with self._lock:
+            known = key in self._users
+            self._users[key] = permissions
+            self._users.move_to_end(key)
+            while len(self._users) > MAX_TRACKED_USERS:
+                self._users.popitem(last=False)
+        if not known and self._task is not None:
+            self._trigger_user(key, PRIORITY_DATA_CHANGE)
+        return not known
+
+    def trigger(self, priority: int = PRIORITY_DATA_CHANGE, job_name: Optional[str] = None) -> int:
+        """
+        Queue jobs for every tracked user (call from the event loop)
+
+        Args:
+            priority: Trigger urgency, lower first
+            job_name: Only this job; None queues all of them
+
+        Returns:
+            Number of newly queued job runs (the rest were coalesced)
+        """
+        with self._lock:
+            users = list(self._users)
+            jobs = [job for name, job in self.jobs.items() if job_name in (None, name)]
+        queued = sum(self._queue_job(job, user, priority) for user in users for job in jobs)
+        self._stats["triggers"] += 1
+        if self._wake is not None:
+            self._wake.set()
+        return queued
+
+    def _trigger_user(self, user: Tuple[str, Tuple[str, ...]], priority: int) -> None:
+        with self._lock:
+            jobs = list(self.jobs.values())
+        for job in jobs:
+            self._queue_job(job, user, priority)
+        if self._wake is not None:
+            self._wake.set()
+
+    def _queue_job(self, job: PrecomputeJob, user: Tuple[str, Tuple[str, ...]], priority: int) -> bool:
+        if any(category not in user[1] for category in job.requires):
+            return False
+        return self.queue.push((job.name, user[0], user[1]), priority + job.priority)
+
+    async def serve(self, job_name: str, user_id: str, permissions: Permissions, data_version: int,
+                    data: Mapping[str, Any], **params: Any) -> Any:
+        """
+        Precomputed result of a job, computing it on a miss
+
+        Offloaded jobs compute a miss on a worker thread, as they do in the
+        background; the rest compute inline on the event loop.
+
+        Args:
+            job_name: Registered job
+            user_id: Requesting user
+            permissions: Request permissions (the user is tracked for precomputation)
+            data_version: Data store version ``data`` was taken from
+            data: Unfiltered snapshot of that version
+            params: Job variant parameters
+
+        Returns:
+            Job result
+        """
+        job = self.jobs[job_name]
+        self.register_user(user_id, permissions)
+        scope = AnalysisCacheScope.for_request(data_version, permissions)
+        key = self.cache.make_key(user_id, job.name, params, scope)
+
+        async def compute():
+            self._stats["inline_computes"] += 1
+            context = JobContext(user_id, permissions, data_version,
+                                 self.privacy_service.filter_data_by_permissions(data, permissions), self.store)
+            if job.offload:
+                return (await asyncio.to_thread(_compute_variants, job, context, (params,)))[0]
+            result = job.compute(context, **params)
+            return await result if inspect.isawaitable(result) else result
+
+        return await self.cache.get_or_compute(
+            key, compute, should_store=lambda result: _storable(result) and self._current(job, data_version)
+        )
+
+    def start(self) -> None:
+        """Start the scheduler task on the running event loop"""
+        if self._task is not None:
+            return
+        self._wake = asyncio.Event()
+        self._task = asyncio.get_running_loop().create_task(self._run())
+        logger.info(f"Precompute scheduler started with {len(self.jobs)} jobs "
+                    f"(cadence {self.interval:.0f}s, poll {self.poll_interval:.1f}s)")
+
+    async def stop(self) -> None:
+        """Cancel the scheduler task and wait for it to finish"""
+        task, self._task = self._task, None
+        if task is None:
+            return
+        task.cancel()
+        try:
+            await task
+        except asyncio.CancelledError:
+            pass
+
+    async def _run(self) -> None:
+        next_cadence = time.monotonic() + self.interval
+        while True:
+            try:
+                self._check_version()
+                now = time.monotonic()
+                if now >= next_cadence:
+                    # Forecasts and trailing windows move with the date even when data does not
+                    self.trigger(PRIORITY_CADENCE)
+                    next_cadence = now + self.interval
+
+                item = self.queue.pop()
+                if item is None:
+                    self._wake.clear()
+                    timeout = max(0.0, min(self.poll_interval, next_cadence - now))
+                    try:
+                        await asyncio.wait_for(self._wake.wait(), timeout)
+                    except asyncio.TimeoutError:
+                        pass
+                    continue
+                await self._execute(item[0])
+                await asyncio.sleep(0)  # Let requests run between jobs
+            except asyncio.CancelledError:
+                raise
+            except Exception as e:
+                logger.error(f"Precompute scheduler iteration failed: {str(e)}")
+                await asyncio.sleep(self.poll_interval)
+
+    def _current(self, job: PrecomputeJob, data_version: int) -> bool:
+        """Whether a result computed at data_version still matches the store state the job read"""
+        return job.offload or self.store.version == data_version
+
+    def _check_version(self) -> None:
+        version, _ = self.store.versioned_snapshot()
+        if version != self._seen_version:
+            self._seen_version = version
+            self.trigger(PRIORITY_DATA_CHANGE)
+
+    async def _execute(self, key: JobKey) -> None:
+        """Run one job for one user and store every variant's result"""
+        job_name, user_id, granted = key
+        job = self.jobs.get(job_name)
+        with self._lock:
+            permissions = self._users.get((user_id, granted))
+        if job is None or permissions is None:
+            return
+
+        data_version, data = self.store.versioned_snapshot()
+        context = JobContext(user_id, permissions, data_version,
+                             self.privacy_service.filter_data_by_permissions(data, permissions), self.store)
+        scope = AnalysisCacheScope.for_request(data_version, permissions)
+        start = time.perf_counter()
+        try:
+            if job.offload:
+                results = await asyncio.to_thread(_compute_variants, job, context)
+            else:
+                results = []
+                for params in job.variants:
+                    result = job.compute(context, **params)
+                    results.append(await result if inspect.isawaitable(result) else result)
+        except Exception as e:
+            self._stats["failures"] += 1
+            logger.error(f"Precompute job {job_name} for {user_id} failed: {str(e)}")
+            return
+
+        if not self._current(job, data_version):
+            # Store state moved on under the job; the version change re-triggers it
+            self._stats["dropped"] += 1
+            return
+        for params, result in zip(job.variants, results):
+            if _storable(result):
+                self.cache.put(self.cache.make_key(user_id, job.name, params, scope), result)
+        self._stats["runs"] += 1
+        self._last_run_ms[job_name] = round((time.perf_counter() - start) * 1000, 2)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Get scheduler counters
+
+        Returns:
+            Trigger, run and failure counts, queue depth and last run times
+        """
+        with self._lock:
+            stats = dict(self._stats)
+            stats["tracked_users"] = len(self._users)
+            stats["jobs"] = sorted(self.jobs)
+        stats["queued"] = len(self.queue)
+        stats["coalesced"] = self.queue.coalesced
+        stats["running"] = self._task is not None
+        stats["data_version"] = self._seen_version
+        stats["last_run_ms"] = dict(self._last_run_ms)
+        return stats
+
+
+def _compute_variants(job: PrecomputeJob, context: JobContext,
+                      variants: Optional[Tuple[Dict[str, Any], ...]] = None) -> List[Any]:
+    """Run an offloaded job's variants (all of them by default) on a worker thread with its own event loop"""
+    results = []
+    for params in job.variants if variants is None else variants:
+        result = job.compute(context, **params)
+        if inspect.isawaitable(result):
+            result = asyncio.run(_await(result))
+        results.append(result)
+    return results
+
+
+async def _await(awaitable: Any) -> Any:
+    return await awaitable
+
+
+_scheduler: Optional[PrecomputeScheduler] = None
+_scheduler_lock = threading.Lock()
+
+
+def get_precompute_scheduler() -> PrecomputeScheduler:
+    """Get the process-wide precompute scheduler"""
+    global _scheduler
+    if _scheduler is None:
+        with _scheduler_lock:
+            if _scheduler is None:
+                _scheduler = PrecomputeScheduler()
+    return _scheduler
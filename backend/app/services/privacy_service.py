@@ -1,77 +1,123 @@
 """
 Privacy service for filtering data based on user permissions
 """
-from typing import Dict, Any, List
+import threading
+from collections import OrderedDict
+from types import MappingProxyType
+from typing import Dict, Any, List, Mapping, Tuple
 from ..models.requests import Permissions
+from .metrics import timed
 import logging
 
 logger = logging.getLogger(__name__)
 
+# Permission fields, in bit order, and the data categories they grant
+PERMISSION_CATEGORIES = (
+    'transactions', 'assets', 'liabilities', 'epf_balance', 'credit_score',
+    'investments', 'accounts', 'spending_trends', 'category_breakdown', 'dashboard_insights'
+)
+
 
 class PrivacyService:
     """Service for filtering data based on user privacy permissions"""
     
-    def __init__(self):
-        """Initialize the privacy service"""
-        pass
+    def __init__(self, max_views: int = 8):
+        """
+        Initialize the privacy service
+        
+        Args:
+            max_views: Filtered views kept per service for repeated requests
+        """
+        self.max_views = max(1, max_views)
+        self._views: "OrderedDict[Tuple[int, int], Tuple[Mapping[str, Any], Mapping[str, Any]]]" = OrderedDict()
+        self._metadata: Dict[Tuple[int, int], Mapping[str, Any]] = {}
+        self._lock = threading.Lock()
+    
+    @staticmethod
+    def compile_mask(permissions: Permissions) -> int:
+        """
+        Compile permissions into a bitmask over PERMISSION_CATEGORIES
+        
+        Args:
+            permissions: User's data access permissions
+            
+        Returns:
+            Bitmask with one bit set per granted category
+        """
+        mask = 0
+        for bit, category in enumerate(PERMISSION_CATEGORIES):
+            if getattr(permissions, category, False):
+                mask |= 1 << bit
+        return mask
     
-    def filter_data_by_permissions(self, data: Dict[str, Any], permissions: Permissions) -> Dict[str, Any]:
+    @timed("privacy_filter")
+    def filter_data_by_permissions(self, data: Mapping[str, Any], permissions: Permissions) -> Mapping[str, Any]:
         """
         Filter financial data based on user permissions
         
+        Granted categories reference the source data instead of copying it, and
+        the result is a read-only mapping shared by every request filtering the
+        same data under the same permissions; callers must not mutate it.
+        
         Args:
             data: Complete financial data dictionary
             permissions: User's data access permissions
             
         Returns:
-            Filtered data dictionary containing only authorized data
+            Read-only filtered data containing only authorized data
         """
         try:
-            filtered_data = {}
-            
-            # Map permission fields to data categories
-            permission_mapping = {
-                'transactions': 'transactions',
-                'assets': 'assets',
-                'liabilities': 'liabilities',
-                'epf_balance': 'epf_balance',
-                'credit_score': 'credit_score',
-                'investments': 'investments',
-                'accounts': 'accounts',
-                'spending_trends': 'spending_trends',
-                'category_breakdown': 'category_breakdown',
-                'dashboard_insights': 'dashboard_insights'
-            }
+            mask = self.compile_mask(permissions)
+            key = (id(data), mask)
+            with self._lock:
+                cached = self._views.get(key)
+                if cached is not None and cached[0] is data:
+                    self._views.move_to_end(key)
+                    return cached[1]
             
-            # Filter data based on permissions
-            for permission_field, data_category in permission_mapping.items():
-                if hasattr(permissions, permission_field) and getattr(permissions, permission_field):
-                    if data_category in data:
-                        filtered_data[data_category] = data[data_category]
-                        logger.info(f"Granted access to {data_category} data")
-                    else:
-                        logger.warning(f"Data category {data_category} not found in source data")
-                        filtered_data[data_category] = []
+            filtered_data = {}
+            granted = 0
+            for bit, category in enumerate(PERMISSION_CATEGORIES):
+                if mask & (1 << bit) and category in data:
+                    filtered_data[category] = data[category]
+                    granted += 1 if data[category] else 0
                 else:
+                    if mask & (1 << bit):
+                        logger.warning(f"Data category {category} not found in source data")
                     # Include empty data for denied categories to maintain structure
-                    filtered_data[data_category] = []
-                    logger.info(f"Denied access to {data_category} data")
+                    filtered_data[category] = []
             
             # Add metadata about filtering
-            filtered_data['_metadata'] = {
-                'total_categories': len(permission_mapping),
-                'granted_categories': len([k for k, v in filtered_data.items() if v and k != '_metadata']),
-                'denied_categories': len([k for k, v in filtered_data.items() if not v and k != '_metadata']),
-                'permissions_applied': permissions.dict()
-            }
+            filtered_data['_metadata'] = self._filter_metadata(mask, permissions, granted)
+            view = MappingProxyType(filtered_data)
+            
+            with self._lock:
+                # Holding the source keeps its id from being reused while cached
+                self._views[key] = (data, view)
+                self._views.move_to_end(key)
+                while len(self._views) > self.max_views:
+                    self._views.popitem(last=False)
             
-            logger.info(f"Data filtering completed. Granted access to {filtered_data['_metadata']['granted_categories']} categories")
-            return filtered_data
+            logger.debug(f"Data filtering completed. Granted access to {granted} categories")
+            return view
             
         except Exception as e:
             logger.error(f"Error filtering data by permissions: {str(e)}")
             raise Exception(f"Failed to filter data by permissions: {str(e)}")
     
+    def _filter_metadata(self, mask: int, permissions: Permissions, granted: int) -> Mapping[str, Any]:
+        """Filtering metadata, built once per permission mask and granted count"""
+        metadata = self._metadata.get((mask, granted))
+        if metadata is None:
+            metadata = MappingProxyType({
+                'total_categories': len(PERMISSION_CATEGORIES),
+                'granted_categories': granted,
+                'denied_categories': len(PERMISSION_CATEGORIES) - granted,
+                'permissions_applied': permissions.dict()
+            })
+            self._metadata[(mask, granted)] = metadata
+        return metadata
+    
     def get_permission_summary(self, permissions: Permissions) -> Dict[str, Any]:
         """
         Get a summary of the user's permissions
@@ -107,13 +153,7 @@ class PrivacyService:
         """
         try:
             # Check if permissions object has the expected fields
-            expected_fields = [
-                'transactions', 'assets', 'liabilities', 'epf_balance',
-                'credit_score', 'investments', 'accounts', 'spending_trends',
-                'category_breakdown', 'dashboard_insights'
-            ]
-            
-            for field in expected_fields:
+            for field in PERMISSION_CATEGORIES:
                 if not hasattr(permissions, field):
                     logger.error(f"Missing permission field: {field}")
                     return False
@@ -0,0 +1,194 @@
+"""
+Response cache and static prompt prefixes for the AI services
+Near-duplicate queries over unchanged data share a model answer keyed by the
+intent, the normalized entities and a digest of the analysis results; the
+static system prompt text is assembled once per analysis type
+"""
+import hashlib
+import json
+import threading
+from pathlib import Path
+from typing import Dict, Any, Optional, Hashable, Tuple
+import logging
+
+from .result_cache import AnalysisResultCache, freeze
+
+logger = logging.getLogger(__name__)
+
+# Shared system prompts shipped with the AI dataset
+SYSTEM_PROMPTS_PATH = Path(__file__).resolve().parents[3] / "ai_dataset" / "prompts" / "system_prompts.json"
+
+# Analysis types answered with a specialised system prompt
+ANALYSIS_PROMPTS = {
+    "spending_analysis": "spending_analysis",
+    "investment_analysis": "investment_advisor",
+    "budget_analysis": "budget_planner",
+    "affordability_check": "affordability_checker",
+}
+
+# Result fields that change on every run without changing the answer
+_VOLATILE_KEYS = frozenset({"timestamp", "generated_at", "processing_info"})
+
+
+def _strip_volatile(value: Any) -> Any:
+    if isinstance(value, dict):
+        return {k: _strip_volatile(v) for k, v in value.items() if k not in _VOLATILE_KEYS}
+    if isinstance(value, (list, tuple)):
+        return [_strip_volatile(v) for v in value]
+    return value
+
+
+def results_digest(analysis_results: Dict[str, Any]) -> str:
+    """
+    Digest the analysis results a response is generated from
+
+    Args:
+        analysis_results: Analysis output passed to the AI service
+
+    Returns:
+        Hex digest independent of key order and volatile timestamps
+    """
+    encoded = json.dumps(_strip_volatile(analysis_results), sort_keys=True, default=str).encode()
+    return hashlib.blake2b(encoded, digest_size=16).hexdigest()
+
+
+def normalize_entities(entities: Optional[Dict[str, Any]]) -> Hashable:
+    """
+    Reduce extracted entities to the values that determine an answer
+
+    Enhanced NLP entities keep only their value and normalized value, dropping
+    positions, confidences and resolved dates; entity lists are deduplicated
+    and ordered so rephrasings of the same question share a key.
+
+    Args:
+        entities: Entities from NLPService or EnhancedNLPService
+
+    Returns:
+        Hashable normalized form
+    """
+    if not entities:
+        return ()
+
+    normalized = {}
+    for entity_type, values in entities.items():
+        if not isinstance(values, list):
+            normalized[entity_type] = freeze(values)
+            continue
+        items = set()
+        for value in values:
+            if isinstance(value, dict) and "value" in value:
+                context = value.get("context") or {}
+                value = (value["value"], context.get("normalized_value"))
+            items.add(freeze(value))
+        if items:
+            normalized[entity_type] = tuple(sorted(items, key=repr))
+    return freeze(normalized)
+
+
+class PromptLibrary:
+    """Static system prompt prefixes, loaded once and assembled per analysis type"""
+
+    def __init__(self, path: Path = SYSTEM_PROMPTS_PATH):
+        """
+        Initialize the library
+
+        Args:
+            path: System prompts JSON file
+        """
+        self.path = path
+        self._prompts: Optional[Dict[str, Any]] = None
+        self._prefixes: Dict[str, str] = {}
+        self._lock = threading.Lock()
+
+    def _load(self) -> Dict[str, Any]:
+        if self._prompts is None:
+            try:
+                with open(self.path, "r", encoding="utf-8") as f:
+                    self._prompts = json.load(f)
+            except (OSError, ValueError) as e:
+                logger.warning(f"System prompts unavailable ({e}); using built-in instructions only")
+                self._prompts = {}
+        return self._prompts
+
+    def prefix(self, analysis_type: str) -> str:
+        """
+        Static prompt prefix for an analysis type
+
+        Args:
+            analysis_type: Analysis type of the results being explained
+
+        Returns:
+            Assistant and analysis-specific instructions, '' if none are available
+        """
+        cached = self._prefixes.get(analysis_type)
+        if cached is not None:
+            return cached
+
+        with self._lock:
+            prompts = self._load()
+            parts = []
+            assistant = prompts.get("financial_assistant", {})
+            if assistant.get("system_prompt"):
+                parts.append(assistant["system_prompt"])
+            if assistant.get("constraints"):
+                parts.append("Constraints:\n" + "\n".join(f"- {c}" for c in assistant["constraints"]))
+            specialised = prompts.get(ANALYSIS_PROMPTS.get(analysis_type, ""), {})
+            if specialised.get("system_prompt"):
+                parts.append(specialised["system_prompt"])
+            prefix = "\n\n".join(parts)
+            self._prefixes[analysis_type] = prefix
+        return prefix
+
+
+def response_key(service: str, analysis_results: Dict[str, Any],
+                 entities: Optional[Dict[str, Any]] = None, *variant: Hashable) -> Tuple:
+    """
+    Build the response cache key for one generation
+
+    Args:
+        service: Name of the generating service
+        analysis_results: Analysis output the response explains
+        entities: Entities extracted from the query
+        variant: Further inputs that change the prompt (tone, complexity)
+
+    Returns:
+        Cache key tuple
+    """
+    return (service, analysis_results.get("intent", "unknown"),
+            analysis_results.get("analysis_type", "unknown"),
+            normalize_entities(entities), results_digest(analysis_results), variant)
+
+
+_response_cache: Optional[AnalysisResultCache] = None
+_prompt_library: Optional[PromptLibrary] = None
+_singleton_lock = threading.Lock()
+
+
+def get_response_cache() -> AnalysisResultCache:
+    """
+    Get the process-wide AI response cache
+
+    Returns:
+        Shared cache of model responses
+    """
+    global _response_cache
+    if _response_cache is None:
+        with _singleton_lock:
+            if _response_cache is None:
+                _response_cache = AnalysisResultCache(max_entries=256)
+    return _response_cache
+
+
+def get_prompt_library() -> PromptLibrary:
+    """
+    Get the process-wide prompt library
+
+    Returns:
+        Shared PromptLibrary instance
+    """
+    global _prompt_library
+    if _prompt_library is None:
+        with _singleton_lock:
+            if _prompt_library is None:
+                _prompt_library = PromptLibrary()
+    return _prompt_library
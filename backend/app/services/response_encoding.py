@@ -0,0 +1,270 @@
+"""
+Response encoding for the API
+Fast JSON rendering (orjson when installed), gzip/brotli compression above a
+size threshold, and strong ETags derived from the data store version so
+polling clients revalidate with If-None-Match and get 304 without the
+endpoint doing any work.
+"""
+import gzip
+import hashlib
+import json
+import os
+from typing import Any, Callable, Dict, List, Optional, Tuple
+import logging
+
+from fastapi import Request
+from fastapi.responses import JSONResponse, Response
+
+from .metrics import span
+
+try:
+    import orjson
+except ImportError:  # orjson is optional; fall back to compact stdlib json
+    orjson = None
+
+try:
+    import brotli
+except ImportError:  # brotli is optional; gzip is always available
+    brotli = None
+
+logger = logging.getLogger(__name__)
+
+# Bodies smaller than this are sent uncompressed
+COMPRESSION_MIN_BYTES = int(os.getenv("COMPRESSION_MIN_BYTES", "1024"))
+GZIP_LEVEL = 6
+BROTLI_QUALITY = 4
+
+COMPRESSIBLE_TYPES = ("application/json", "text/", "application/javascript")
+
+# Suffix appended inside the ETag quotes per content-coding (strong ETags differ per encoding)
+_CODING_SUFFIXES = {"br": "-br", "gzip": "-gzip"}
+
+
+def _default(value: Any) -> Any:
+    """Serialize types neither encoder handles natively"""
+    if hasattr(value, "items"):
+        return dict(value.items())
+    if isinstance(value, (set, frozenset, tuple)):
+        return list(value)
+    if hasattr(value, "tolist"):
+        return value.tolist()
+    return str(value)
+
+
+def dumps(content: Any) -> bytes:
+    """Encode content as compact UTF-8 JSON"""
+    with span("serialization"):
+        if orjson is not None:
+            return orjson.dumps(content, default=_default,
+                                option=orjson.OPT_NON_STR_KEYS | orjson.OPT_SERIALIZE_NUMPY)
+        return json.dumps(content, ensure_ascii=False, separators=(",", ":"), default=_default).encode("utf-8")
+
+
+class FastJSONResponse(JSONResponse):
+    """
+    JSON response rendered straight from plain dicts and lists
+
+    Endpoints return it directly to skip jsonable_encoder; content must already
+    be JSON-shaped (dicts, lists, numbers, strings, datetimes).
+    """
+
+    def render(self, content: Any) -> bytes:
+        return dumps(content)
+
+
+def data_etag(version: int, request: Request, scope: str = "") -> str:
+    """
+    Strong ETag for a representation of one data store version
+
+    Args:
+        version: Data store version the response is built from
+        request: Request whose path and query select the representation
+        scope: Extra inputs that change the response (e.g. permissions)
+
+    Returns:
+        Quoted ETag value
+    """
+    key = f"{version}|{request.url.path}|{request.url.query}|{scope}".encode()
+    return '"' + hashlib.blake2b(key, digest_size=12).hexdigest() + '"'
+
+
+def _base_tag(tag: str) -> str:
+    """Strip the weak prefix and any content-coding suffix from an entity tag"""
+    tag = tag.strip()
+    if tag.startswith("W/"):
+        tag = tag[2:]
+    for suffix in _CODING_SUFFIXES.values():
+        if tag.endswith(suffix + '"'):
+            return tag[:-len(suffix) - 1] + '"'
+    return tag
+
+
+def etag_matches(request: Request, etag: str) -> bool:
+    """Whether the request's If-None-Match names this ETag (any encoding, weak comparison)"""
+    header = request.headers.get("if-none-match")
+    if not header:
+        return False
+    if header.strip() == "*":
+        return True
+    return any(_base_tag(tag) == etag for tag in header.split(","))
+
+
+def not_modified(etag: str) -> Response:
+    """Empty 304 carrying the validator"""
+    return Response(status_code=304, headers={"ETag": etag, "Cache-Control": "no-cache"})
+
+
+def permission_scope(permissions: Any) -> str:
+    """ETag input naming the permission flags a response was filtered by"""
+    return ",".join(name for name, granted in sorted(vars(permissions).items()) if granted is True)
+
+
+def check_not_modified(request: Request, version: int, scope: str = "") -> Tuple[str, Optional[Response]]:
+    """
+    Compute the ETag for a data version and answer 304 if the client already has it
+
+    Args:
+        request: Incoming request
+        version: Data store version the endpoint reads
+        scope: Extra ETag inputs
+
+    Returns:
+        (ETag, 304 response or None when the endpoint should build its response)
+    """
+    etag = data_etag(version, request, scope)
+    return etag, not_modified(etag) if etag_matches(request, etag) else None
+
+
+def json_response(content: Any, etag: Optional[str] = None) -> FastJSONResponse:
+    """Fast JSON response, validated by the ETag when one is given"""
+    if etag is None:
+        return FastJSONResponse(content)
+    return FastJSONResponse(content, headers={"ETag": etag, "Cache-Control": "no-cache"})
+
+
+def _accepted_codings(headers: List[Tuple[bytes, bytes]]) -> Dict[str, float]:
+    """Parse Accept-Encoding into coding -> q value"""
+    accepted: Dict[str, float] = {}
+    for name, value in headers:
+        if name.lower() != b"accept-encoding":
+            continue
+        for part in value.decode("latin-1").split(","):
+            coding, _, params = part.strip().partition(";")
+            q = 1.0
+            params = params.strip()
+            if params.startswith("q="):
+                try:
+                    q = float(params[2:])
+                except ValueError:
+                    q = 0.0
+            if coding:
+                accepted[coding.strip().lower()] = q
+    return accepted
+
+
+def choose_coding(headers: List[Tuple[bytes, bytes]]) -> Optional[str]:
+    """Best supported content-coding the client accepts (brotli preferred)"""
+    accepted = _accepted_codings(headers)
+    wildcard = accepted.get("*", 0.0)
+    for coding in ("br", "gzip"):
+        if coding == "br" and brotli is None:
+            continue
+        if accepted.get(coding, wildcard) > 0:
+            return coding
+    return None
+
+
+def compress(body: bytes, coding: str) -> bytes:
+    if coding == "br":
+        return brotli.compress(body, quality=BROTLI_QUALITY)
+    return gzip.compress(body, compresslevel=GZIP_LEVEL)
+
+
+class CompressionMiddleware:
+    """
+    ASGI middleware compressing complete responses above a size threshold
+
+    Streaming responses (several body messages, e.g. server-sent events) and
+    already-encoded bodies pass through untouched. Compressed responses get a
+    coding-specific ETag so strong validators stay unique per encoding.
+    """
+
+    def __init__(self, app: Callable, minimum_size: int = COMPRESSION_MIN_BYTES):
+        """
+        Wrap an ASGI application
+
+        Args:
+            app: Downstream ASGI application
+            minimum_size: Smallest body worth compressing
+        """
+        self.app = app
+        self.minimum_size = minimum_size
+
+    async def __call__(self, scope, receive, send):
+        if scope["type"] != "http":
+            await self.app(scope, receive, send)
+            return
+        coding = choose_coding(scope.get("headers", []))
+        if coding is None:
+            await self.app(scope, receive, send)
+            return
+
+        start: Optional[Dict[str, Any]] = None
+        passthrough = False
+
+        async def encoding_send(message):
+            nonlocal start, passthrough
+            if message["type"] == "http.response.start":
+                start = message
+                return
+            if message["type"] != "http.response.body" or passthrough:
+                await send(message)
+                return
+
+            body = message.get("body", b"")
+            if start is not None and not message.get("more_body", False) and self._compressible(start, body):
+                compressed = compress(body, coding)
+                await send(self._encoded_start(start, coding, compressed))
+                await send({"type": "http.response.body", "body": compressed})
+                return
+
+            # Streaming or not worth compressing: forward as-is from here on
+            passthrough = True
+            if start is not None:
+                await send(self._with_vary(start))
+            await send(message)
+
+        await self.app(scope, receive, encoding_send)
+
+    def _compressible(self, start: Dict[str, Any], body: bytes) -> bool:
+        if start["status"] < 200 or start["status"] in (204, 304) or len(body) < self.minimum_size:
+            return False
+        headers = {name.lower(): value for name, value in start.get("headers", [])}
+        if b"content-encoding" in headers:
+            return False
+        content_type = headers.get(b"content-type", b"").decode("latin-1")
+        return content_type.startswith(COMPRESSIBLE_TYPES)
+
+    @staticmethod
+    def _with_vary(start: Dict[str, Any]) -> Dict[str, Any]:
+        headers = list(start.get("headers", []))
+        if not any(name.lower() == b"vary" for name, _ in headers):
+            headers.append((b"vary", b"Accept-Encoding"))
+        return {**start, "headers": headers}
+
+    @staticmethod
+    def _encoded_start(start: Dict[str, Any], coding: str, body: bytes) -> Dict[str, Any]:
+        headers = []
+        for name, value in start.get("headers", []):
+            lowered = name.lower()
+            if lowered == b"content-length":
+                continue
+            if lowered == b"etag" and value.endswith(b'"'):
+                value = value[:-1] + _CODING_SUFFIXES[coding].encode() + b'"'
+            headers.append((name, value))
+        headers += [
+            (b"content-encoding", coding.encode()),
+            (b"content-length", str(len(body)).encode()),
+            (b"vary", b"Accept-Encoding")
+        ]
+        return {**start, "headers": headers}
@@ -0,0 +1,307 @@
+"""
+Process-wide cache for analysis results
+LRU of computed analyses keyed by user, analysis type, parameters, data version
+and permission fingerprint, with single-flight deduplication of concurrent misses
+"""
+import asyncio
+import functools
+import inspect
+import threading
+from collections import OrderedDict
+from typing import Dict, Any, Optional, Callable, Hashable, Iterable, NamedTuple, Tuple
+import logging
+
+from .shared_snapshot import broadcast_invalidation, on_invalidation
+
+logger = logging.getLogger(__name__)
+
+
+def freeze(value: Any) -> Hashable:
+    """Convert entities and parameters into a hashable, order-independent key part"""
+    if isinstance(value, dict):
+        return tuple(sorted((str(k), freeze(v)) for k, v in value.items()))
+    if isinstance(value, (list, tuple)):
+        return tuple(freeze(v) for v in value)
+    if isinstance(value, set):
+        return tuple(sorted(freeze(v) for v in value))
+    if isinstance(value, (str, int, float, bool)) or value is None:
+        return value
+    return repr(value)
+
+
+def permission_fingerprint(permissions: Any) -> Tuple[str, ...]:
+    """
+    Fingerprint the data categories a set of permissions grants
+
+    Args:
+        permissions: Permissions model or mapping of category to granted flag
+
+    Returns:
+        Sorted tuple of granted category names
+    """
+    if hasattr(permissions, "dict"):
+        permissions = permissions.dict()
+    return tuple(sorted(name for name, granted in permissions.items() if granted))
+
+
+class AnalysisCacheScope(NamedTuple):
+    """
+    What an analysis input was derived from
+
+    Callers vouch that the data they pass was filtered from data store version
+    ``data_version`` with permissions matching ``permissions``; that pair stands
+    in for the data itself in the cache key.
+    """
+    data_version: int
+    permissions: Tuple[str, ...]
+
+    @classmethod
+    def for_request(cls, data_version: int, permissions: Any) -> "AnalysisCacheScope":
+        """Build a scope from a data store version and the request's permissions"""
+        return cls(data_version, permission_fingerprint(permissions))
+
+
+class AnalysisResultCache:
+    """
+    Bounded LRU of analysis results with single-flight misses
+
+    Results are shared between callers and must be treated as read-only.
+    Concurrent requests for a missing key wait on the first computation instead
+    of repeating it. Invalidation drops entries and stops in-flight computations
+    that started before it from being stored.
+    """
+
+    def __init__(self, max_entries: int = 512):
+        """
+        Initialize the cache
+
+        Args:
+            max_entries: Maximum results kept before the least recently used is evicted
+        """
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[Tuple, Any]" = OrderedDict()
+        self._inflight: Dict[Tuple, asyncio.Future] = {}
+        self._lock = threading.Lock()
+        self._generation = 0
+        self._stats = {"hits": 0, "misses": 0, "coalesced": 0, "evictions": 0, "invalidations": 0}
+
+    @staticmethod
+    def make_key(user_id: str, analysis_type: str, params: Any, scope: AnalysisCacheScope) -> Tuple:
+        """Build the cache key for one analysis request"""
+        return (user_id, analysis_type, freeze(params), scope.data_version, scope.permissions)
+
+    async def get_or_compute(self, key: Tuple, compute: Callable[[], Any],
+                             should_store: Optional[Callable[[Any], bool]] = None) -> Any:
+        """
+        Return the cached result for a key, computing it once if missing
+
+        Args:
+            key: Cache key from ``make_key``
+            compute: Zero-argument callable returning the result or an awaitable
+            should_store: Predicate deciding whether a computed result is cached
+
+        Returns:
+            Cached or freshly computed result
+        """
+        with self._lock:
+            if key in self._entries:
+                self._entries.move_to_end(key)
+                self._stats["hits"] += 1
+                return self._entries[key]
+            leader = self._inflight.get(key)
+            if leader is not None:
+                self._stats["coalesced"] += 1
+
+        if leader is not None:
+            try:
+                return await asyncio.shield(leader)
+            except asyncio.CancelledError:
+                if not leader.cancelled():
+                    raise
+                # The leading request was cancelled; compute for ourselves
+
+        future = asyncio.get_running_loop().create_future()
+        with self._lock:
+            self._stats["misses"] += 1
+            self._inflight[key] = future
+            generation = self._generation
+
+        try:
+            result = compute()
+            if inspect.isawaitable(result):
+                result = await result
+        except asyncio.CancelledError:
+            future.cancel()
+            raise
+        except Exception as e:
+            future.set_exception(e)
+            future.exception()  # Waiters re-raise it; mark it retrieved for the leader
+            raise
+        else:
+            future.set_result(result)
+            with self._lock:
+                if generation == self._generation and (should_store is None or should_store(result)):
+                    self._store(key, result)
+            return result
+        finally:
+            with self._lock:
+                if self._inflight.get(key) is future:
+                    del self._inflight[key]
+
+    def get(self, key: Tuple, default: Any = None) -> Any:
+        """Return a cached result without computing, counting the hit or miss"""
+        with self._lock:
+            if key in self._entries:
+                self._entries.move_to_end(key)
+                self._stats["hits"] += 1
+                return self._entries[key]
+            self._stats["misses"] += 1
+        return default
+
+    def put(self, key: Tuple, result: Any) -> None:
+        """Store a result computed outside ``get_or_compute``"""
+        with self._lock:
+            self._store(key, result)
+
+    def _store(self, key: Tuple, result: Any) -> None:
+        """Insert a result and evict beyond capacity (lock held)"""
+        self._entries[key] = result
+        self._entries.move_to_end(key)
+        while len(self._entries) > self.max_entries:
+            self._entries.popitem(last=False)
+            self._stats["evictions"] += 1
+
+    def invalidate(self, user_id: Optional[str] = None, broadcast: bool = True) -> int:
+        """
+        Drop cached results
+
+        Args:
+            user_id: Only drop this user's results; None drops everything
+            broadcast: Also drop them in the other workers' caches
+
+        Returns:
+            Number of entries removed
+        """
+        with self._lock:
+            self._generation += 1
+            if user_id is None:
+                removed = len(self._entries)
+                self._entries.clear()
+            else:
+                stale = [key for key in self._entries if key[0] == user_id]
+                for key in stale:
+                    del self._entries[key]
+                removed = len(stale)
+            self._stats["invalidations"] += 1
+
+        if broadcast:
+            broadcast_invalidation("analysis", user_id)
+        if removed:
+            logger.info(f"Invalidated {removed} cached analysis results" +
+                        (f" for {user_id}" if user_id else ""))
+        return removed
+
+    def invalidate_categories(self, categories: Iterable[str], broadcast: bool = True) -> int:
+        """
+        Drop every cached result computed with access to any of the categories
+
+        Used when a permission changes: whoever the result was cached for, its
+        permission fingerprint names the categories its inputs came from.
+
+        Args:
+            categories: Permission categories whose grants changed
+            broadcast: Also drop them in the other workers' caches
+
+        Returns:
+            Number of entries removed
+        """
+        categories = frozenset(categories)
+        if not categories:
+            return 0
+        with self._lock:
+            self._generation += 1
+            stale = [key for key in self._entries if categories.intersection(key[4])]
+            for key in stale:
+                del self._entries[key]
+            self._stats["invalidations"] += 1
+
+        if broadcast:
+            broadcast_invalidation("analysis_categories", ",".join(sorted(categories)))
+        if stale:
+            logger.info(f"Invalidated {len(stale)} cached analysis results using {', '.join(sorted(categories))}")
+        return len(stale)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Get cache hit/miss metrics
+
+        Returns:
+            Counters plus current size and hit rate
+        """
+        with self._lock:
+            stats = dict(self._stats)
+            stats["entries"] = len(self._entries)
+            stats["in_flight"] = len(self._inflight)
+        lookups = stats["hits"] + stats["misses"] + stats["coalesced"]
+        stats["hit_rate"] = round((stats["hits"] + stats["coalesced"]) / lookups, 4) if lookups else 0.0
+        return stats
+
+
+def cached_analysis(analysis_type: str, *param_names: str,
+                    revision: Optional[Callable[[Any, str], Hashable]] = None):
+    """
+    Cache an async ``AnalysisService`` method taking ``user_id`` first
+
+    The decorated method gains a ``cache_scope`` keyword. Only calls that pass a
+    scope are cached, keyed by the user, ``analysis_type`` and the named
+    parameters; data arguments are represented by the scope.
+
+    Args:
+        analysis_type: Name of the analysis in the cache key
+        param_names: Method parameters that change the result for the same data
+        revision: ``revision(service, user_id)`` for inputs that change outside
+            the data store (e.g. live prices); its value joins the key
+    """
+    def decorator(method):
+        signature = inspect.signature(method)
+
+        @functools.wraps(method)
+        async def wrapper(self, *args, cache_scope: Optional[AnalysisCacheScope] = None, **kwargs):
+            if cache_scope is None:
+                return await method(self, *args, **kwargs)
+
+            bound = signature.bind(self, *args, **kwargs)
+            bound.apply_defaults()
+            params = {name: bound.arguments[name] for name in param_names}
+            if revision is not None:
+                params["revision"] = revision(self, bound.arguments["user_id"])
+            return await self.cached_result(
+                analysis_type, bound.arguments["user_id"], params, cache_scope,
+                lambda: method(self, *args, **kwargs)
+            )
+
+        return wrapper
+
+    return decorator
+
+
+_cache: Optional[AnalysisResultCache] = None
+_cache_lock = threading.Lock()
+
+
+def get_analysis_cache() -> AnalysisResultCache:
+    """
+    Get the process-wide analysis result cache
+
+    Returns:
+        Shared AnalysisResultCache instance
+    """
+    global _cache
+    if _cache is None:
+        with _cache_lock:
+            if _cache is None:
+                _cache = AnalysisResultCache()
+                on_invalidation("analysis", lambda user_id: _cache.invalidate(user_id, broadcast=False))
+                on_invalidation("analysis_categories",
+                                lambda names: _cache.invalidate_categories((names or "").split(","), broadcast=False))
+    return _cache
@@ -0,0 +1,243 @@
+"""
+Retrieval of relevant examples and transactions for chat prompts
+Embeds the curated query examples once into a persisted vector index and the
+user's permitted transactions once per data version, so each chat turn adds
+only its nearest few examples and transactions to the prompt.
+"""
+import json
+import os
+import threading
+from collections import OrderedDict
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+import logging
+
+from .transaction_store import coerce_amount
+from .vector_index import VectorIndex, HashingEmbedder, write_index, batched
+
+logger = logging.getLogger(__name__)
+
+EXAMPLES_PATH = Path(__file__).resolve().parents[3] / "ai_dataset" / "examples" / "financial_queries.json"
+# Shared with DatasetService's default datasets directory
+EMBEDDINGS_DIRECTORY = Path(os.getenv(
+    "EMBEDDINGS_DIR", Path(__file__).resolve().parents[2] / "data" / "datasets" / "embeddings"
+))
+
+# Results added to the prompt per source
+EXAMPLE_RESULTS = 2
+TRANSACTION_RESULTS = 5
+
+# Cosine similarity below which a match is left out of the prompt
+MIN_EXAMPLE_SCORE = 0.3
+MIN_TRANSACTION_SCORE = 0.15
+
+# Figures kept from the analysis summary when retrieved context is in the prompt
+HEADLINE_FIGURES = 6
+
+# Transaction indexes kept for recent data versions
+TRANSACTION_INDEXES = 2
+
+
+def transaction_text(transaction: Dict[str, Any]) -> str:
+    """Text embedded for a transaction"""
+    kind = "income" if coerce_amount(transaction.get("amount", 0)) > 0 else "expense"
+    return " ".join(str(part) for part in (
+        transaction.get("description", ""), transaction.get("category", ""),
+        transaction.get("merchant", ""), kind
+    ) if part)
+
+
+class RetrievalService:
+    """Nearest examples and transactions for a chat query"""
+
+    def __init__(self, examples_path: Path = EXAMPLES_PATH,
+                 embeddings_directory: Path = EMBEDDINGS_DIRECTORY):
+        """
+        Initialize the service
+
+        Args:
+            examples_path: Curated query examples JSON file
+            embeddings_directory: Where the examples index is persisted
+        """
+        self.examples_path = Path(examples_path)
+        self.index_directory = Path(embeddings_directory) / "financial_queries"
+        self.embedder = HashingEmbedder()
+        self._examples: Optional[VectorIndex] = None
+        self._transactions: "OrderedDict[Tuple, VectorIndex]" = OrderedDict()
+        # Transaction id -> (embedded text, vector), so a new version re-embeds only changed rows
+        self._vectors: Dict[Any, Tuple[str, List[float]]] = {}
+        self._lock = threading.Lock()
+
+    def examples_index(self) -> Optional[VectorIndex]:
+        """Open the examples index, (re)building it when the corpus is newer"""
+        if self._examples is not None:
+            return self._examples
+
+        with self._lock:
+            if self._examples is None:
+                try:
+                    self._examples = self._load_examples()
+                except (OSError, ValueError) as e:
+                    logger.warning(f"Query examples unavailable for retrieval: {e}")
+        return self._examples
+
+    def _load_examples(self) -> Optional[VectorIndex]:
+        vectors_file = self.index_directory / "vectors.bin"
+        stale = (not vectors_file.exists()
+                 or vectors_file.stat().st_mtime < self.examples_path.stat().st_mtime)
+        if not stale:
+            index = VectorIndex.open(self.index_directory)
+            if index is not None and index.info.get("embedding_model") == self.embedder.name:
+                return index
+
+        with open(self.examples_path, "r", encoding="utf-8") as f:
+            corpus = json.load(f)
+        templates = corpus.get("response_templates", {})
+        pairs = []
+        for example in corpus.get("intent_examples", []):
+            analysis = example.get("expected_analysis", "")
+            template = templates.get(analysis) or templates.get(example.get("intent", "").replace("get_", "", 1))
+            pairs.append((example["query"], {
+                "query": example["query"],
+                "intent": example.get("intent"),
+                "expected_analysis": analysis,
+                "template": template.get("template") if template else None
+            }))
+
+        write_index(self.index_directory, batched(pairs), self.embedder, {"source": self.examples_path.name})
+        logger.info(f"Indexed {len(pairs)} query examples for retrieval")
+        return VectorIndex.open(self.index_directory)
+
+    def transaction_index(self, transactions: List[Dict[str, Any]], version: Any) -> Optional[VectorIndex]:
+        """
+        Index of the given transactions, built once per data version
+
+        Args:
+            transactions: Permission-filtered transactions
+            version: Data version they were read at
+
+        Returns:
+            VectorIndex, or None when there are no transactions
+        """
+        if not transactions:
+            return None
+        key = (version, len(transactions))
+        with self._lock:
+            index = self._transactions.get(key)
+            if index is not None:
+                self._transactions.move_to_end(key)
+                return index
+
+            vectors, payloads, seen = [], [], {}
+            for transaction in transactions:
+                text = transaction_text(transaction)
+                identity = transaction.get("id", text)
+                cached = self._vectors.get(identity)
+                if cached is None or cached[0] != text:
+                    cached = (text, self.embedder.embed(text))
+                seen[identity] = cached
+                vectors.append(cached[1])
+                payloads.append(transaction)
+            self._vectors = seen
+
+            index = VectorIndex.build(vectors, payloads, self.embedder.dim, {"version": version})
+            self._transactions[key] = index
+            while len(self._transactions) > TRANSACTION_INDEXES:
+                self._transactions.popitem(last=False)
+        return index
+
+    def retrieve(self, query: str, filtered_data: Dict[str, Any], version: Any = None) -> Dict[str, List[Dict[str, Any]]]:
+        """
+        Examples and transactions most relevant to a query
+
+        Args:
+            query: User's chat message
+            filtered_data: Permission-filtered financial data
+            version: Data version of filtered_data (keys the transaction index)
+
+        Returns:
+            ``examples`` and ``transactions`` lists, best match first
+        """
+        vector = self.embedder.embed_query(query)
+        retrieved = {"examples": [], "transactions": []}
+
+        examples = self.examples_index()
+        if examples is not None:
+            retrieved["examples"] = [
+                {**payload, "score": round(score, 3)}
+                for score, payload in examples.search(vector, EXAMPLE_RESULTS)
+                if score >= MIN_EXAMPLE_SCORE
+            ]
+
+        transactions = self.transaction_index(filtered_data.get("transactions") or [], version)
+        if transactions is not None:
+            retrieved["transactions"] = [
+                {key: payload.get(key) for key in ("date", "description", "category", "amount")}
+                for score, payload in transactions.search(vector, TRANSACTION_RESULTS)
+                if score >= MIN_TRANSACTION_SCORE
+            ]
+        return retrieved
+
+
+def format_retrieved_context(retrieved: Optional[Dict[str, Any]]) -> str:
+    """
+    Prompt section for retrieved examples and transactions
+
+    Args:
+        retrieved: Output of RetrievalService.retrieve
+
+    Returns:
+        Section text, '' when nothing was retrieved
+    """
+    if not retrieved:
+        return ""
+    parts = []
+    if retrieved.get("examples"):
+        parts.append("SIMILAR QUESTIONS:")
+        for example in retrieved["examples"]:
+            line = f"- \"{example['query']}\" -> {example.get('expected_analysis') or example.get('intent')}"
+            if example.get("template"):
+                line += f"; answer like: {example['template']}"
+            parts.append(line)
+    if retrieved.get("transactions"):
+        parts.append("RELEVANT TRANSACTIONS:")
+        for transaction in retrieved["transactions"]:
+            amount = transaction.get("amount") or 0
+            parts.append(f"- {str(transaction.get('date', ''))[:10]} {transaction.get('description', '')} "
+                         f"({transaction.get('category', '')}): {amount:,.2f}")
+    return "\n".join(parts)
+
+
+def format_headline_figures(results: Dict[str, Any], limit: int = HEADLINE_FIGURES) -> str:
+    """
+    Top-level figures of an analysis, used in place of the full summary when
+    retrieved context already carries the relevant detail
+
+    Args:
+        results: Analysis results dictionary
+        limit: Maximum figures listed
+
+    Returns:
+        One line per figure, '' when the results have none
+    """
+    lines = []
+    for key, value in (results or {}).items():
+        if isinstance(value, bool) or not isinstance(value, (int, float)):
+            continue
+        lines.append(f"- {key.replace('_', ' ').title()}: {value:,.2f}")
+        if len(lines) == limit:
+            break
+    return "\n".join(lines)
+
+
+_retrieval_service: Optional[RetrievalService] = None
+_retrieval_service_lock = threading.Lock()
+
+
+def get_retrieval_service() -> RetrievalService:
+    """Get the process-wide retrieval service"""
+    global _retrieval_service
+    with _retrieval_service_lock:
+        if _retrieval_service is None:
+            _retrieval_service = RetrievalService()
+    return _retrieval_service
@@ -0,0 +1,553 @@
+"""
+Shared-memory data snapshots for multi-worker deployments
+Publishes the data store's categories and aggregates as versioned, immutable
+snapshot files that every worker maps read-only, plus a small append-only
+channel that carries cache invalidations between workers
+"""
+import hashlib
+import inspect
+import json
+import mmap
+import os
+import struct
+import tempfile
+import threading
+import time
+import weakref
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterator, List, Mapping, Optional, Tuple
+import logging
+
+try:
+    import fcntl
+except ImportError:  # Windows runs a single worker; a process lock is enough there
+    fcntl = None
+
+try:
+    import orjson
+except ImportError:  # orjson is optional; fall back to compact stdlib json
+    orjson = None
+
+logger = logging.getLogger(__name__)
+
+ENABLE_ENV = "ENABLE_SHARED_SNAPSHOTS"
+DIRECTORY_ENV = "SHARED_SNAPSHOT_DIR"
+
+# File layout: magic, index length, JSON index, then the encoded sections
+MAGIC = b"MFSNAP01"
+_HEADER = struct.Struct("<8sQ")
+
+# Section holding the serialized transaction aggregates
+AGGREGATES_SECTION = "_aggregates"
+
+# Superseded snapshot files kept for workers that have not switched yet
+KEEP_SNAPSHOTS = 2
+
+# Size past which the invalidation log is truncated by the next writer
+CHANNEL_MAX_BYTES = 1 << 20
+
+# Invalidation log header: magic and a generation bumped on every truncation
+CHANNEL_MAGIC = b"MFINVL01"
+_CHANNEL_HEADER = struct.Struct("<8sQ")
+
+
+def shared_snapshots_enabled() -> bool:
+    """Whether data snapshots are shared between worker processes"""
+    return os.getenv(ENABLE_ENV, "false").lower() in ("1", "true", "yes", "on")
+
+
+def snapshot_root() -> Path:
+    """Directory holding the snapshots, preferring tmpfs so pages stay in memory"""
+    configured = os.getenv(DIRECTORY_ENV)
+    if configured:
+        return Path(configured)
+    shm = Path("/dev/shm")
+    base = shm if shm.is_dir() and os.access(shm, os.W_OK) else Path(tempfile.gettempdir())
+    return base / "mintellifunds-snapshots"
+
+
+def encode_section(value: Any) -> bytes:
+    """Encode one snapshot section as compact JSON"""
+    if orjson is not None:
+        return orjson.dumps(value, default=str, option=orjson.OPT_NON_STR_KEYS)
+    return json.dumps(value, separators=(",", ":"), default=str).encode("utf-8")
+
+
+def _decode(buffer: Any) -> Any:
+    """Decode JSON from bytes or a memoryview"""
+    if orjson is not None:
+        return orjson.loads(buffer)
+    return json.loads(bytes(buffer))
+
+
+def write_snapshot(path: Path, version: int, sections: Dict[str, bytes],
+                   file_stats: Mapping[str, Optional[Tuple[int, int]]]) -> int:
+    """
+    Write a snapshot file atomically
+
+    Args:
+        path: Final snapshot path; a temporary file is renamed onto it
+        version: Data version the snapshot publishes
+        sections: Encoded section bytes by name
+        file_stats: Data file signatures the sections were loaded from
+
+    Returns:
+        Size of the written file in bytes
+    """
+    offsets, position = {}, 0
+    for name, blob in sections.items():
+        offsets[name] = (position, len(blob))
+        position += len(blob)
+
+    index = encode_section({
+        "version": version,
+        "created_at": time.time(),
+        "pid": os.getpid(),
+        "file_stats": {key: list(stat) if stat else None for key, stat in file_stats.items()},
+        "sections": offsets
+    })
+
+    temporary = path.with_name(f".{path.name}.{os.getpid()}.tmp")
+    with open(temporary, "wb") as f:
+        f.write(_HEADER.pack(MAGIC, len(index)))
+        f.write(index)
+        for blob in sections.values():
+            f.write(blob)
+    os.replace(temporary, path)
+    return _HEADER.size + len(index) + position
+
+
+class SharedSnapshot:
+    """
+    One published snapshot, mapped read-only
+
+    The file never changes after it is renamed into place. Under /dev/shm its
+    pages live in shared memory, so every worker mapping the same version
+    shares one physical copy and sections are decoded only when read. The
+    mapping is released when the last reference to the snapshot goes away.
+    """
+
+    def __init__(self, path: Path):
+        """
+        Map a snapshot file
+
+        Args:
+            path: Snapshot file written by ``write_snapshot``
+
+        Raises:
+            ValueError: If the file is not a snapshot
+        """
+        self.path = Path(path)
+        with open(self.path, "rb") as f:
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, index_length = _HEADER.unpack_from(self._map, 0) if len(self._map) >= _HEADER.size else (b"", 0)
+        if magic != MAGIC:
+            self._map.close()
+            raise ValueError(f"Not a data snapshot: {path}")
+
+        index = _decode(self._map[_HEADER.size:_HEADER.size + index_length])
+        self._base = _HEADER.size + index_length
+        self.version: int = index["version"]
+        self.created_at: float = index["created_at"]
+        self.size = len(self._map)
+        self.file_stats: Dict[str, Optional[Tuple[int, int]]] = {
+            key: tuple(stat) if stat else None for key, stat in index["file_stats"].items()
+        }
+        self.sections: Dict[str, Tuple[int, int]] = {
+            name: (offset, length) for name, (offset, length) in index["sections"].items()
+        }
+
+    def categories(self) -> List[str]:
+        """Names of the data category sections"""
+        return [name for name in self.sections if not name.startswith("_")]
+
+    def raw(self, name: str) -> bytes:
+        """Copy a section's encoded bytes, for republishing it unchanged"""
+        offset, length = self.sections[name]
+        start = self._base + offset
+        return self._map[start:start + length]
+
+    def load(self, name: str) -> Any:
+        """Decode one section straight from the mapping"""
+        offset, length = self.sections[name]
+        start = self._base + offset
+        with memoryview(self._map) as whole, whole[start:start + length] as view:
+            return _decode(view)
+
+
+class SnapshotMapping(Mapping):
+    """
+    Read-only mapping of data categories decoded lazily from a snapshot
+
+    Values decoded in this worker are kept, so each category is decoded at
+    most once per published version. ``primed`` supplies values the worker
+    already holds, such as the ones it just wrote, so they are not decoded again.
+    """
+
+    def __init__(self, snapshot: SharedSnapshot, primed: Optional[Mapping[str, Any]] = None):
+        self._snapshot = snapshot
+        self._keys = snapshot.categories()
+        self._key_set = frozenset(self._keys)
+        self._decoded: Dict[str, Any] = {
+            key: value for key, value in (primed or {}).items() if key in snapshot.sections
+        }
+        self._lock = threading.Lock()
+
+    def __getitem__(self, key: str) -> Any:
+        try:
+            return self._decoded[key]
+        except KeyError:
+            pass
+        if key not in self._key_set:
+            raise KeyError(key)
+        with self._lock:
+            if key not in self._decoded:
+                self._decoded[key] = self._snapshot.load(key)
+            return self._decoded[key]
+
+    def __contains__(self, key: object) -> bool:
+        return key in self._key_set
+
+    def __iter__(self) -> Iterator[str]:
+        return iter(self._keys)
+
+    def __len__(self) -> int:
+        return len(self._keys)
+
+    def decoded(self) -> Dict[str, Any]:
+        """Categories this worker has decoded so far"""
+        return dict(self._decoded)
+
+
+def _channel_generation(header: bytes) -> Optional[int]:
+    """Generation stored in an invalidation log header, None if it has none"""
+    if len(header) < _CHANNEL_HEADER.size:
+        return None
+    magic, generation = _CHANNEL_HEADER.unpack(header)
+    return generation if magic == CHANNEL_MAGIC else None
+
+
+class InvalidationChannel:
+    """
+    Append-only log of cache invalidations shared by the workers
+
+    Each event is one short JSON line written with O_APPEND after a fixed
+    header holding the log's generation. Workers tail the log from their own
+    offset and run the handlers subscribed to the event's scope, skipping
+    events they sent themselves. The first writer to find the log past
+    ``max_bytes`` truncates it and bumps the generation under a file lock.
+    Readers compare generations rather than sizes, since the log may have
+    grown past their offset again by the time they look; on a change they
+    may have missed events, so they invalidate every subscribed scope in full.
+    """
+
+    def __init__(self, path: Path, max_bytes: int = CHANNEL_MAX_BYTES, poll_interval: float = 0.5):
+        """
+        Open the channel, skipping events sent before this worker started
+
+        Args:
+            path: Log file shared by all workers
+            max_bytes: Size past which the log is truncated
+            poll_interval: Minimum seconds between log reads
+        """
+        self.path = Path(path)
+        self.max_bytes = max_bytes
+        self.poll_interval = poll_interval
+        self._handlers: Dict[str, List[Callable[[], Optional[Callable]]]] = {}
+        self._lock = threading.Lock()
+        self._last_poll = 0.0
+        self._stats = {"sent": 0, "received": 0, "resets": 0}
+        self._generation: Optional[int] = None
+        self._offset = _CHANNEL_HEADER.size
+        try:
+            with open(self.path, "rb") as f:
+                self._generation = _channel_generation(f.read(_CHANNEL_HEADER.size))
+                self._offset = max(self._offset, os.fstat(f.fileno()).st_size)
+        except OSError:
+            pass
+
+    def subscribe(self, scope: str, handler: Callable[[Optional[str]], None]) -> None:
+        """
+        Run ``handler(key)`` for every event another worker sends on ``scope``
+
+        Bound methods are held weakly so short-lived services can be collected.
+        A key of None means the whole scope is invalid.
+        """
+        if inspect.ismethod(handler):
+            reference = weakref.WeakMethod(handler)
+        else:
+            reference = lambda: handler
+        with self._lock:
+            self._handlers.setdefault(scope, []).append(reference)
+
+    def publish(self, scope: str, key: Optional[str] = None) -> None:
+        """Tell the other workers that ``key`` (or all of ``scope``) is stale"""
+        line = encode_section({"scope": scope, "key": key, "pid": os.getpid()}) + b"\n"
+        try:
+            fd = os.open(self.path, os.O_RDWR | os.O_APPEND | os.O_CREAT, 0o644)
+            try:
+                if fcntl is not None:
+                    fcntl.flock(fd, fcntl.LOCK_EX)
+                os.lseek(fd, 0, os.SEEK_SET)
+                generation = _channel_generation(os.read(fd, _CHANNEL_HEADER.size))
+                if generation is None or os.fstat(fd).st_size > self.max_bytes:
+                    os.ftruncate(fd, 0)
+                    os.write(fd, _CHANNEL_HEADER.pack(CHANNEL_MAGIC, (generation or 0) + 1))
+                os.write(fd, line)
+            finally:
+                os.close(fd)  # Releases the lock
+            self._stats["sent"] += 1
+        except OSError as e:
+            logger.error(f"Error publishing invalidation for {scope}: {str(e)}")
+
+    def poll(self, force: bool = False) -> int:
+        """
+        Apply events other workers sent since the last poll
+
+        Args:
+            force: Read the log even if the poll interval has not elapsed
+
+        Returns:
+            Number of events applied
+        """
+        now = time.monotonic()
+        if not force and now - self._last_poll < self.poll_interval:
+            return 0
+
+        events: List[Tuple[str, Optional[str]]] = []
+        with self._lock:
+            self._last_poll = now
+            try:
+                with open(self.path, "rb") as f:
+                    generation = _channel_generation(f.read(_CHANNEL_HEADER.size))
+                    size = os.fstat(f.fileno()).st_size
+                    if generation is None:
+                        return 0  # Created or being truncated; the header is not written yet
+
+                    if generation != self._generation or size < self._offset:
+                        if self._generation is not None:
+                            self._stats["resets"] += 1
+                            events.extend((scope, None) for scope in self._handlers)
+                        self._generation = generation
+                        self._offset = _CHANNEL_HEADER.size
+                    chunk = b""
+                    if size > self._offset:
+                        f.seek(self._offset)
+                        chunk = f.read(size - self._offset)
+            except OSError:
+                return 0
+
+            if chunk:
+                # A writer may be mid-line; leave the partial tail for the next poll
+                complete = chunk.rfind(b"\n") + 1
+                self._offset += complete
+                pid = os.getpid()
+                for line in chunk[:complete].splitlines():
+                    try:
+                        event = _decode(line)
+                    except ValueError:
+                        continue
+                    if event.get("pid") != pid:
+                        events.append((event.get("scope"), event.get("key")))
+
+            handlers = {scope: list(references) for scope, references in self._handlers.items()}
+
+        for scope, key in events:
+            for reference in handlers.get(scope, ()):
+                handler = reference()
+                if handler is None:
+                    continue
+                try:
+                    handler(key)
+                except Exception as e:
+                    logger.error(f"Error applying invalidation for {scope}: {str(e)}")
+        self._stats["received"] += len(events)
+        return len(events)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """Get sent, received and reset counters"""
+        with self._lock:
+            stats = dict(self._stats)
+            stats["scopes"] = sorted(self._handlers)
+        return stats
+
+
+class SnapshotExchange:
+    """
+    Directory where the workers of one data directory publish and adopt snapshots
+
+    ``CURRENT`` names the newest snapshot and is replaced atomically, so a
+    reader sees either the previous or the next version, never a partial one.
+    Publishing happens under an exclusive file lock and always advances past
+    the newest published version, keeping versions monotonic across workers.
+    Superseded files beyond ``KEEP_SNAPSHOTS`` are unlinked; workers still
+    mapping one keep its pages until they release it.
+    """
+
+    def __init__(self, directory: Path):
+        """
+        Initialize the exchange
+
+        Args:
+            directory: Directory for this data directory's snapshots
+        """
+        self.directory = Path(directory)
+        self.directory.mkdir(parents=True, exist_ok=True)
+        self._pointer = self.directory / "CURRENT"
+        self._lock_path = self.directory / "publish.lock"
+        self._thread_lock = threading.RLock()
+        self._lock_depth = 0
+        self._lock_handle = None
+        self._stats = {"published": 0, "adopted": 0, "bytes_written": 0}
+
+    @contextmanager
+    def lock(self):
+        """Hold the cross-process publish lock; re-entrant within a process"""
+        with self._thread_lock:
+            if self._lock_depth == 0 and fcntl is not None:
+                self._lock_handle = open(self._lock_path, "a+")
+                fcntl.flock(self._lock_handle, fcntl.LOCK_EX)
+            self._lock_depth += 1
+            try:
+                yield
+            finally:
+                self._lock_depth -= 1
+                if self._lock_depth == 0 and self._lock_handle is not None:
+                    fcntl.flock(self._lock_handle, fcntl.LOCK_UN)
+                    self._lock_handle.close()
+                    self._lock_handle = None
+
+    def current(self) -> Optional[Tuple[int, str]]:
+        """The newest published (version, file name), or None before the first publish"""
+        try:
+            version, _, name = self._pointer.read_text().strip().partition(" ")
+            return int(version), name
+        except (OSError, ValueError):
+            return None
+
+    def open(self, pointer: Optional[Tuple[int, str]] = None) -> Optional[SharedSnapshot]:
+        """
+        Map a published snapshot
+
+        Args:
+            pointer: (version, file name) to open; defaults to the current one
+
+        Returns:
+            The snapshot, or None if nothing usable is published
+        """
+        pointer = pointer or self.current()
+        if pointer is None:
+            return None
+        try:
+            snapshot = SharedSnapshot(self.directory / pointer[1])
+        except (OSError, ValueError) as e:
+            logger.warning(f"Could not map data snapshot {pointer[1]}: {str(e)}")
+            return None
+        self._stats["adopted"] += 1
+        return snapshot
+
+    def publish(self, sections: Dict[str, bytes], file_stats: Mapping[str, Optional[Tuple[int, int]]],
+                after_version: int = 0) -> SharedSnapshot:
+        """
+        Publish a new snapshot (caller holds ``lock``)
+
+        Args:
+            sections: Encoded section bytes by name
+            file_stats: Data file signatures the sections reflect
+            after_version: Version the new snapshot must exceed besides the current one
+
+        Returns:
+            The published snapshot, mapped
+        """
+        current = self.current()
+        version = max(current[0] if current else 0, after_version) + 1
+        name = f"snapshot-{version:010d}.bin"
+        size = write_snapshot(self.directory / name, version, sections, file_stats)
+
+        temporary = self._pointer.with_name(f".CURRENT.{os.getpid()}.tmp")
+        temporary.write_text(f"{version} {name}")
+        os.replace(temporary, self._pointer)
+
+        for old in sorted(self.directory.glob("snapshot-*.bin"))[:-KEEP_SNAPSHOTS - 1]:
+            old.unlink(missing_ok=True)
+
+        self._stats["published"] += 1
+        self._stats["bytes_written"] += size
+        logger.info(f"Published data snapshot {version} ({size} bytes)")
+        return SharedSnapshot(self.directory / name)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """Get publish and adopt counters plus the current version"""
+        current = self.current()
+        return {
+            "directory": str(self.directory),
+            "current_version": current[0] if current else None,
+            **self._stats
+        }
+
+
+_exchanges: Dict[str, SnapshotExchange] = {}
+_channel: Optional[InvalidationChannel] = None
+_shared_lock = threading.Lock()
+
+
+def get_snapshot_exchange(data_dir: str) -> Optional[SnapshotExchange]:
+    """
+    Get the snapshot exchange for a data directory
+
+    Args:
+        data_dir: Resolved data directory of a data store
+
+    Returns:
+        Shared SnapshotExchange, or None when shared snapshots are disabled
+    """
+    if not shared_snapshots_enabled():
+        return None
+    digest = hashlib.sha1(str(data_dir).encode("utf-8")).hexdigest()[:12]
+    with _shared_lock:
+        exchange = _exchanges.get(digest)
+        if exchange is None:
+            exchange = SnapshotExchange(snapshot_root() / digest)
+            _exchanges[digest] = exchange
+        return exchange
+
+
+def get_invalidation_channel() -> Optional[InvalidationChannel]:
+    """
+    Get the cross-worker invalidation channel
+
+    Returns:
+        Shared InvalidationChannel, or None when shared snapshots are disabled
+    """
+    global _channel
+    if not shared_snapshots_enabled():
+        return None
+    if _channel is None:
+        with _shared_lock:
+            if _channel is None:
+                root = snapshot_root()
+                root.mkdir(parents=True, exist_ok=True)
+                _channel = InvalidationChannel(root / "invalidations.log")
+    return _channel
+
+
+def broadcast_invalidation(scope: str, key: Optional[str] = None) -> None:
+    """Tell other workers to drop ``key`` from their ``scope`` cache; no-op with one worker"""
+    channel = get_invalidation_channel()
+    if channel is not None:
+        channel.publish(scope, key)
+
+
+def on_invalidation(scope: str, handler: Callable[[Optional[str]], None]) -> None:
+    """Subscribe a local cache to invalidations sent by other workers"""
+    channel = get_invalidation_channel()
+    if channel is not None:
+        channel.subscribe(scope, handler)
+
+
+def poll_invalidations() -> int:
+    """Apply pending invalidations from other workers, at most every poll interval"""
+    channel = get_invalidation_channel()
+    return channel.poll() if channel is not None else 0
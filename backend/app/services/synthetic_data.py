@@ -0,0 +1,360 @@
+"""
+Deterministic synthetic financial data
+Scales the ingestion service's mock generators from a handful of records to
+users with millions of transactions: monthly salary and rent, recurring
+bills, and category-weighted discretionary spending with log-normal amounts.
+Records match the shapes in data/*.json and pass the validator's schemas.
+The same seed, user and end date always produce the same records, and
+transactions are produced lazily in date order so large datasets are
+streamed to disk without being held in memory.
+"""
+import json
+import math
+import random
+import zlib
+from datetime import datetime, timedelta, timezone
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional
+import logging
+
+logger = logging.getLogger(__name__)
+
+# Discretionary categories: (category, relative weight, median amount, merchants)
+SPENDING_CATEGORIES = (
+    ("food_dining", 0.34, 450.0, ("SuperMart", "Cafe Central", "Swiggy", "Zomato", "FreshBasket")),
+    ("transportation", 0.18, 300.0, ("Uber", "Ola", "Metro Card", "Indian Oil", "HP Petrol")),
+    ("shopping", 0.2, 1500.0, ("Amazon", "Flipkart", "Myntra", "Croma", "Decathlon")),
+    ("entertainment", 0.12, 700.0, ("PVR Cinemas", "BookMyShow", "Steam", "Spotify")),
+    ("healthcare", 0.06, 900.0, ("Apollo Pharmacy", "City Clinic", "Medplus")),
+    ("bills_utilities", 0.1, 1200.0, ("Airtel", "Jio", "BESCOM", "Tata Power")),
+)
+
+# Monthly fixed items: (day of month, category, description, merchant, share of salary)
+RECURRING_ITEMS = (
+    (1, "salary", "Salary credit", "Employer Pvt Ltd", 1.0),
+    (3, "housing", "Rent payment", "Landlord", -0.3),
+    (7, "bills_utilities", "Electricity bill", "BESCOM", -0.02),
+    (12, "bills_utilities", "Mobile and internet", "Airtel", -0.015),
+)
+
+ACCOUNT_NAMES = ("Primary Savings", "Current Account", "Salary Account", "Joint Savings")
+
+
+def _stable_seed(*parts: Any) -> int:
+    """Seed that is identical across processes (unlike hash() of a str)"""
+    return zlib.crc32("|".join(str(part) for part in parts).encode())
+
+
+def default_days(count: int) -> int:
+    """History length for a transaction count: 90 days to 10 years"""
+    return min(3650, max(90, count // 20))
+
+
+class SyntheticDataGenerator:
+    """Deterministic generator of complete user datasets"""
+
+    def __init__(self, seed: int = 42, end: Optional[datetime] = None, currency: str = "INR"):
+        """
+        Initialize the generator
+
+        Args:
+            seed: Base seed; each user and record type derives its own stream
+            end: Latest transaction time (midnight UTC today by default, so
+                the analyzer's trailing windows contain data)
+            currency: Currency code for accounts and holdings
+        """
+        if end is None:
+            end = datetime.now(timezone.utc).replace(hour=0, minute=0, second=0, microsecond=0)
+        self.seed = seed
+        self.end = end if end.tzinfo else end.replace(tzinfo=timezone.utc)
+        self.currency = currency
+
+    def _rng(self, user_id: str, kind: str) -> random.Random:
+        return random.Random(_stable_seed(self.seed, user_id, kind))
+
+    def monthly_salary(self, user_id: str = "user") -> float:
+        return round(self._rng(user_id, "salary").uniform(40000, 250000), -2)
+
+    def transactions(self, count: int, user_id: str = "user", days: Optional[int] = None,
+                     id_prefix: str = "txn") -> Iterator[Dict[str, Any]]:
+        """
+        Generate transactions in date order
+
+        Args:
+            count: Number of transactions, recurring items included
+            user_id: User whose stream to generate
+            days: History length (scaled from count by default)
+            id_prefix: Transaction id prefix
+
+        Yields:
+            Transaction records
+        """
+        rng = self._rng(user_id, "transactions")
+        days = days or default_days(count)
+        start = self.end - timedelta(days=days)
+        step = days * 86400.0 / max(count, 1)
+        salary = self.monthly_salary(user_id)
+
+        categories = [entry[0] for entry in SPENDING_CATEGORIES]
+        weights = [entry[1] for entry in SPENDING_CATEGORIES]
+        medians = {entry[0]: entry[2] for entry in SPENDING_CATEGORIES}
+        merchants = {entry[0]: entry[3] for entry in SPENDING_CATEGORIES}
+        account = ACCOUNT_NAMES[0]
+
+        # Recurring items not yet posted, in date order; each is emitted once the clock passes it
+        upcoming: List[tuple] = []
+        month = None
+        for index in range(count):
+            when = start + timedelta(seconds=(index + rng.random()) * step)
+            if (when.year, when.month) != month:
+                month = (when.year, when.month)
+                for day, category, description, merchant, share in RECURRING_ITEMS:
+                    posted = when.replace(day=day, hour=9, minute=0, second=0, microsecond=0)
+                    if posted >= start:
+                        upcoming.append((posted, category, description, merchant, share))
+
+            if upcoming and upcoming[0][0] <= when:
+                posted, category, description, merchant, share = upcoming.pop(0)
+                yield self._transaction(
+                    f"{id_prefix}_{index:08d}", posted, round(salary * share, 2),
+                    f"{description} {posted:%b %Y}", category, merchant, account
+                )
+                continue
+
+            category = rng.choices(categories, weights)[0]
+            # Log-normal spend around the category median, sigma 0.8
+            amount = medians[category] * math.exp(rng.gauss(0.0, 0.8))
+            merchant = rng.choice(merchants[category])
+            yield self._transaction(
+                f"{id_prefix}_{index:08d}", when, -round(amount, 2),
+                f"{merchant} {category.replace('_', ' ')}", category, merchant, account
+            )
+
+    @staticmethod
+    def _transaction(transaction_id: str, when: datetime, amount: float, description: str,
+                     category: str, merchant: str, account: str) -> Dict[str, Any]:
+        return {
+            "id": transaction_id,
+            "date": when.strftime("%Y-%m-%dT%H:%M:%SZ"),
+            "amount": amount,
+            "description": description,
+            "category": category,
+            "merchant": merchant,
+            "account": account,
+            "type": "income" if amount > 0 else "expense"
+        }
+
+    def transaction_batches(self, count: int, batch_size: int = 10000,
+                            **kwargs: Any) -> Iterator[List[Dict[str, Any]]]:
+        """Transactions in lists of at most batch_size"""
+        batch: List[Dict[str, Any]] = []
+        for transaction in self.transactions(count, **kwargs):
+            batch.append(transaction)
+            if len(batch) >= batch_size:
+                yield batch
+                batch = []
+        if batch:
+            yield batch
+
+    def accounts(self, user_id: str = "user", count: int = 2) -> List[Dict[str, Any]]:
+        rng = self._rng(user_id, "accounts")
+        salary = self.monthly_salary(user_id)
+        types = ("savings", "current", "savings", "checking")
+        return [
+            {
+                "id": f"acc_{index + 1:03d}",
+                "name": ACCOUNT_NAMES[index % len(ACCOUNT_NAMES)],
+                "type": types[index % len(types)],
+                "balance": round(salary * rng.uniform(0.5, 4.0), 2),
+                "currency": self.currency,
+                "bank": "Synthetic Bank",
+                "last_updated": self.end.strftime("%Y-%m-%dT%H:%M:%SZ")
+            }
+            for index in range(count)
+        ]
+
+    def investments(self, user_id: str = "user", count: int = 5) -> List[Dict[str, Any]]:
+        rng = self._rng(user_id, "investments")
+        universe = (("NIFTYBEES", "Nifty 50 ETF", "etf"), ("HDFCBANK", "HDFC Bank", "stock"),
+                    ("INFY", "Infosys", "stock"), ("PPFAS", "Parag Parikh Flexi Cap", "mutual_fund"),
+                    ("GSEC2033", "GOI 2033 Bond", "bond"), ("SBIFD", "SBI Fixed Deposit", "fd"))
+        holdings = []
+        for index in range(count):
+            symbol, name, kind = universe[index % len(universe)]
+            quantity = round(rng.uniform(10, 500), 2)
+            price = round(rng.uniform(50, 2500), 2)
+            holdings.append({
+                "id": f"inv_{index + 1:03d}",
+                "symbol": symbol if index < len(universe) else f"{symbol}{index}",
+                "name": name,
+                "type": kind,
+                "quantity": quantity,
+                "current_price": price,
+                "total_value": round(quantity * price, 2),
+                "current_value": round(quantity * price, 2),
+                "purchase_price": round(quantity * price * rng.uniform(0.7, 1.1), 2),
+                "currency": self.currency
+            })
+        return holdings
+
+    def liabilities(self, user_id: str = "user", count: int = 2) -> List[Dict[str, Any]]:
+        rng = self._rng(user_id, "liabilities")
+        kinds = (("Home Loan", "home_loan", 8.5, 3000000), ("Car Loan", "car_loan", 9.5, 600000),
+                 ("Credit Card", "credit_card", 36.0, 80000), ("Personal Loan", "personal_loan", 14.0, 300000))
+        result = []
+        for index in range(count):
+            name, kind, rate, principal = kinds[index % len(kinds)]
+            balance = round(principal * rng.uniform(0.2, 1.0), 2)
+            result.append({
+                "id": f"liab_{index + 1:03d}",
+                "name": name,
+                "type": kind,
+                "balance": balance,
+                "interest_rate": rate,
+                "monthly_payment": round(max(balance * 0.015, 1000.0), 2),
+                "currency": self.currency
+            })
+        return result
+
+    def assets(self, user_id: str = "user", count: int = 2) -> List[Dict[str, Any]]:
+        rng = self._rng(user_id, "assets")
+        kinds = (("Primary Residence", "property", 6000000), ("Family Car", "vehicle", 800000),
+                 ("Gold", "jewelry", 400000))
+        return [
+            {
+                "id": f"asset_{index + 1:03d}",
+                "name": kinds[index % len(kinds)][0],
+                "type": kinds[index % len(kinds)][1],
+                "value": round(kinds[index % len(kinds)][2] * rng.uniform(0.6, 1.4), 2),
+                "currency": self.currency,
+                "last_updated": self.end.strftime("%Y-%m-%dT%H:%M:%SZ")
+            }
+            for index in range(count)
+        ]
+
+    def supporting_data(self, user_id: str = "user") -> Dict[str, Any]:
+        """Every non-transaction category of a user's dataset"""
+        rng = self._rng(user_id, "profile")
+        salary = self.monthly_salary(user_id)
+        return {
+            "assets": self.assets(user_id),
+            "liabilities": self.liabilities(user_id),
+            "investments": self.investments(user_id),
+            "accounts": self.accounts(user_id),
+            "dashboard_insights": [],
+            "epf_balance": {
+                "current_balance": round(salary * rng.uniform(5, 40), 2),
+                "currency": self.currency,
+                "contribution_amount": round(salary * 0.12, 2),
+                "employer_match": round(salary * 0.12, 2),
+                "last_updated": self.end.strftime("%Y-%m-%dT%H:%M:%SZ")
+            },
+            "credit_score": {
+                "score": rng.randint(620, 820),
+                "range": "Good",
+                "last_updated": self.end.strftime("%Y-%m-%dT%H:%M:%SZ"),
+                "factors": []
+            }
+        }
+
+    def dataset(self, num_transactions: int, user_id: str = "user") -> Dict[str, Any]:
+        """
+        Complete in-memory dataset in the data store's category layout
+
+        Args:
+            num_transactions: Number of transactions
+            user_id: User to generate
+
+        Returns:
+            Mapping of data category to records
+        """
+        data = self.supporting_data(user_id)
+        data["transactions"] = list(self.transactions(num_transactions, user_id))
+        data["spending_trends"], data["category_breakdown"] = summarize(data["transactions"])
+        return data
+
+    def write_dataset(self, data_dir: str, num_transactions: int, user_id: str = "user",
+                      batch_size: int = 50000) -> Dict[str, int]:
+        """
+        Write a dataset as the data store's JSON files, streaming transactions
+
+        Args:
+            data_dir: Directory to write (created if missing)
+            num_transactions: Number of transactions
+            user_id: User to generate
+            batch_size: Transactions encoded per write
+
+        Returns:
+            Record count per written file
+        """
+        path = Path(data_dir)
+        path.mkdir(parents=True, exist_ok=True)
+        summary = _Summary()
+        written = 0
+        with open(path / "transactions.json", "w", encoding="utf-8") as f:
+            f.write("[")
+            for batch in self.transaction_batches(num_transactions, batch_size, user_id=user_id):
+                summary.add(batch)
+                f.write(("," if written else "") + ",".join(json.dumps(t, separators=(",", ":")) for t in batch))
+                written += len(batch)
+            f.write("]")
+
+        data = self.supporting_data(user_id)
+        data["spending_trends"], data["category_breakdown"] = summary.result()
+        counts = {"transactions": written}
+        for key, value in data.items():
+            with open(path / f"{key}.json", "w", encoding="utf-8") as f:
+                json.dump(value, f, indent=2)
+            counts[key] = len(value) if isinstance(value, list) else 1
+        logger.info(f"Wrote synthetic dataset for {user_id} to {path}: {written} transactions")
+        return counts
+
+
+class _Summary:
+    """Streaming monthly trend and category breakdown over expense transactions"""
+
+    def __init__(self):
+        self.months: Dict[str, float] = {}
+        self.month_days: Dict[str, set] = {}
+        self.categories: Dict[str, List[float]] = {}
+
+    def add(self, transactions: List[Dict[str, Any]]) -> None:
+        for transaction in transactions:
+            amount = transaction["amount"]
+            if amount >= 0:
+                continue
+            period = transaction["date"][:7]
+            self.months[period] = self.months.get(period, 0.0) - amount
+            self.month_days.setdefault(period, set()).add(transaction["date"][8:10])
+            totals = self.categories.setdefault(transaction["category"], [0.0, 0])
+            totals[0] -= amount
+            totals[1] += 1
+
+    def result(self):
+        trends = []
+        previous = None
+        for period in sorted(self.months):
+            total = self.months[period]
+            trends.append({
+                "period": period,
+                "total_spending": round(total, 2),
+                "average_daily": round(total / max(len(self.month_days[period]), 1), 2),
+                "trend_direction": "up" if previous is not None and total > previous else "down"
+            })
+            previous = total
+        trends.reverse()
+
+        total = sum(amount for amount, _ in self.categories.values()) or 1.0
+        breakdown = [
+            {"category": category, "amount": round(amount, 2),
+             "percentage": round(amount / total * 100, 1), "transaction_count": count}
+            for category, (amount, count) in sorted(self.categories.items(), key=lambda item: -item[1][0])
+        ]
+        return trends, breakdown
+
+
+def summarize(transactions: List[Dict[str, Any]]):
+    """(spending_trends, category_breakdown) for a list of transactions"""
+    summary = _Summary()
+    summary.add(transactions)
+    return summary.result()
@@ -0,0 +1,416 @@
+"""
+Columnar transaction store
+Ingests transaction records once into date-sorted columns with category indexes
+so date range and category filters become binary search plus slicing
+"""
+import base64
+import bisect
+import heapq
+import json
+import threading
+from array import array
+from collections import OrderedDict
+from functools import lru_cache
+from typing import Dict, Any, List, Optional, Tuple, Iterable, Sequence
+from datetime import datetime, timezone
+import logging
+
+logger = logging.getLogger(__name__)
+
+
+@lru_cache(maxsize=131072)
+def _parse_date(value: str) -> Optional[Tuple[float, int, int]]:
+    """
+    Parse an ISO date string into (epoch seconds, month code, UTC offset seconds)
+
+    The month code is year * 12 + (month - 1) in the timestamp's own offset,
+    matching the "%Y-%m" keys the analyzers group by. Naive dates are read as UTC.
+    """
+    try:
+        parsed = datetime.fromisoformat(value.replace('Z', '+00:00'))
+    except ValueError:
+        return None
+    month_code = parsed.year * 12 + parsed.month - 1
+    if parsed.tzinfo is None:
+        parsed = parsed.replace(tzinfo=timezone.utc)
+    return parsed.timestamp(), month_code, int(parsed.utcoffset().total_seconds())
+
+
+def parse_timestamp(value: Any) -> Optional[float]:
+    """
+    Parse a transaction date into epoch seconds
+
+    Args:
+        value: ISO formatted date string
+
+    Returns:
+        Epoch seconds, or None if the value is not a valid date
+    """
+    if not isinstance(value, str) or not value:
+        return None
+    parsed = _parse_date(value)
+    return parsed[0] if parsed else None
+
+
+def encode_cursor(key: Dict[str, Any]) -> str:
+    """Encode a pagination key as an opaque URL-safe cursor"""
+    raw = json.dumps(key, separators=(",", ":")).encode("utf-8")
+    return base64.urlsafe_b64encode(raw).decode("ascii").rstrip("=")
+
+
+def decode_cursor(cursor: str) -> Optional[Dict[str, Any]]:
+    """
+    Decode a cursor produced by ``encode_cursor``
+
+    Returns:
+        The pagination key, or None if the cursor is malformed
+    """
+    try:
+        raw = base64.urlsafe_b64decode(cursor + "=" * (-len(cursor) % 4))
+        key = json.loads(raw)
+    except (ValueError, TypeError):
+        return None
+    return key if isinstance(key, dict) else None
+
+
+def month_key(month_code: int) -> str:
+    """Convert a month code back to a "%Y-%m" key"""
+    return f"{month_code // 12:04d}-{month_code % 12 + 1:02d}"
+
+
+def coerce_amount(value: Any) -> float:
+    """Coerce a raw amount to float, treating bad values as 0"""
+    try:
+        return float(value)
+    except (TypeError, ValueError):
+        return 0.0
+
+
+class TransactionColumns:
+    """
+    Immutable columnar view over a list of transaction records
+
+    Rows with a parseable date are sorted by (timestamp, original position) and
+    stored as parallel arrays; rows without one are kept aside in
+    ``undated_records``. Categories are interned to integer codes with a
+    per-category position index, so every filter is a bisect over sorted arrays.
+    """
+
+    def __init__(self, transactions: Iterable[Dict[str, Any]]):
+        """
+        Build the columns from transaction records
+
+        Args:
+            transactions: Transaction records as loaded from the data store
+        """
+        rows = []
+        self.undated_records: List[Dict[str, Any]] = []
+
+        for position, transaction in enumerate(transactions):
+            date_value = transaction.get("date", "")
+            parsed = _parse_date(date_value) if isinstance(date_value, str) and date_value else None
+            if parsed is None:
+                self.undated_records.append(transaction)
+                continue
+            rows.append((parsed[0], position, parsed[1], transaction, parsed[2]))
+
+        rows.sort(key=lambda row: (row[0], row[1]))
+
+        self.records: List[Dict[str, Any]] = [row[3] for row in rows]
+        self.timestamps = array('d', (row[0] for row in rows))
+        self.month_codes = array('l', (row[2] for row in rows))
+        # Wall-clock seconds in each record's own offset, for hour and weekday checks
+        self.local_times = array('d', (row[0] + row[4] for row in rows))
+        self.amounts = array('d', (coerce_amount(row[3].get("amount", 0)) for row in rows))
+
+        # Intern categories; None marks records without a category field
+        self.categories: List[Optional[str]] = []
+        self._category_codes: Dict[Optional[str], int] = {}
+        self.category_codes = array('l')
+        self.category_index: Dict[int, array] = {}
+
+        for position, record in enumerate(self.records):
+            category = record.get("category")
+            code = self._category_codes.get(category)
+            if code is None:
+                code = len(self.categories)
+                self.categories.append(category)
+                self._category_codes[category] = code
+                self.category_index[code] = array('l')
+            self.category_codes.append(code)
+            self.category_index[code].append(position)
+
+        self._codes_by_lower: Dict[str, List[int]] = {}
+        for code, category in enumerate(self.categories):
+            if isinstance(category, str):
+                self._codes_by_lower.setdefault(category.lower(), []).append(code)
+
+        self._id_index: Optional[Dict[Any, Dict[str, Any]]] = None
+        self._monthly_flows: Optional[List[Tuple[int, float, float]]] = None
+
+    def __len__(self) -> int:
+        """Number of dated rows"""
+        return len(self.records)
+
+    def bounds(self, start: Optional[float] = None, end: Optional[float] = None) -> Tuple[int, int]:
+        """
+        Get the row range covering [start, end]
+
+        Args:
+            start: Inclusive lower timestamp bound, or None for unbounded
+            end: Inclusive upper timestamp bound, or None for unbounded
+
+        Returns:
+            (lo, hi) slice bounds into the sorted columns
+        """
+        lo = bisect.bisect_left(self.timestamps, start) if start is not None else 0
+        hi = bisect.bisect_right(self.timestamps, end) if end is not None else len(self.timestamps)
+        return lo, max(lo, hi)
+
+    def between(self, start: Optional[float] = None, end: Optional[float] = None) -> List[Dict[str, Any]]:
+        """Get the records dated within [start, end], oldest first"""
+        lo, hi = self.bounds(start, end)
+        return self.records[lo:hi]
+
+    def category_codes_for(self, category: str, ignore_case: bool = False) -> List[int]:
+        """
+        Resolve a category name to its interned codes
+
+        Args:
+            category: Category name to look up
+            ignore_case: Match category names case-insensitively
+
+        Returns:
+            Matching codes (several only when names differ by case)
+        """
+        if ignore_case:
+            return list(self._codes_by_lower.get(category.lower(), []))
+        code = self._category_codes.get(category)
+        return [code] if code is not None else []
+
+    def positions(self, category: Optional[str] = None, start: Optional[float] = None,
+                  end: Optional[float] = None, ignore_case: bool = False) -> Sequence[int]:
+        """
+        Get sorted row positions matching a category and date range
+
+        Args:
+            category: Category to filter by, or None for all categories
+            start: Inclusive lower timestamp bound
+            end: Inclusive upper timestamp bound
+            ignore_case: Match category names case-insensitively
+
+        Returns:
+            Ascending row positions (oldest first)
+        """
+        lo, hi = self.bounds(start, end)
+        if category is None:
+            return range(lo, hi)
+
+        slices = []
+        for code in self.category_codes_for(category, ignore_case):
+            index = self.category_index[code]
+            # Positions are ascending and so are timestamps, so bisect on positions directly
+            slices.append(index[bisect.bisect_left(index, lo):bisect.bisect_left(index, hi)])
+
+        if len(slices) == 1:
+            return slices[0].tolist()
+        return list(heapq.merge(*slices))
+
+    def select(self, category: Optional[str] = None, start: Optional[float] = None,
+               end: Optional[float] = None, ignore_case: bool = False) -> List[Dict[str, Any]]:
+        """Get the records matching a category and date range, oldest first"""
+        records = self.records
+        return [records[p] for p in self.positions(category, start, end, ignore_case)]
+
+    def latest(self, limit: int) -> List[Dict[str, Any]]:
+        """Get the most recent records, newest first"""
+        if limit <= 0:
+            return []
+        return self.records[:-limit - 1:-1] if limit < len(self.records) else self.records[::-1]
+
+    def key_at(self, position: int) -> Dict[str, Any]:
+        """Keyset pagination key of a dated row: its timestamp and id"""
+        return {"t": self.timestamps[position], "id": self.records[position].get("id")}
+
+    def position_of(self, key: Dict[str, Any]) -> int:
+        """
+        Resolve a keyset key to a row position
+
+        Args:
+            key: Key from ``key_at``
+
+        Returns:
+            Position of the keyed row, or of the first row at its timestamp
+            if that row no longer exists, so paging resumes strictly before it
+        """
+        timestamp = float(key["t"])
+        lo = bisect.bisect_left(self.timestamps, timestamp)
+        hi = bisect.bisect_right(self.timestamps, timestamp, lo)
+        for position in range(lo, hi):
+            if self.records[position].get("id") == key.get("id"):
+                return position
+        return lo
+
+    def page_before(self, positions: Sequence[int], undated: List[Dict[str, Any]], limit: int,
+                    key: Optional[Dict[str, Any]] = None) -> Tuple[List[Dict[str, Any]], Optional[Dict[str, Any]]]:
+        """
+        Get one newest-first page resuming after a keyset key
+
+        Dated rows come newest first, followed by undated ones. The key
+        names the last row of the previous page, so a page costs O(log n +
+        limit) however deep it is and stays stable under inserts.
+
+        Args:
+            positions: Ascending positions of the rows being paged
+            undated: Undated records being paged, in order
+            limit: Maximum records returned
+            key: Key of the previous page's last row, or None for the first page
+
+        Returns:
+            (records, key of the last record or None when nothing follows)
+        """
+        if limit <= 0:
+            return [], None
+        if key is None:
+            end, undated_start = len(positions), 0
+        elif "u" in key:
+            end, undated_start = 0, max(0, int(key["u"]))
+        else:
+            end, undated_start = bisect.bisect_left(positions, self.position_of(key)), 0
+
+        start = max(0, end - limit)
+        page = [self.records[positions[i]] for i in range(end - 1, start - 1, -1)]
+        undated_end = undated_start + limit - len(page)
+        page += undated[undated_start:undated_end]
+
+        if len(page) < limit or (start == 0 and undated_end >= len(undated)):
+            return page, None
+        if undated_end > undated_start:
+            return page, {"u": undated_end}
+        return page, self.key_at(positions[start])
+
+    def sum_amounts(self, lo: int = 0, hi: Optional[int] = None) -> float:
+        """Sum the signed amounts of rows in [lo, hi)"""
+        return sum(self.amounts[lo:hi])
+
+    def find(self, transaction_id: Any) -> Optional[Dict[str, Any]]:
+        """Look up a record by id, including undated records"""
+        if self._id_index is None:
+            index = {}
+            for record in self.undated_records:
+                index.setdefault(record.get("id"), record)
+            for record in self.records:
+                index.setdefault(record.get("id"), record)
+            self._id_index = index
+        return self._id_index.get(transaction_id)
+
+    def monthly_flows(self, months_back: Optional[int] = None) -> List[Dict[str, Any]]:
+        """
+        Get income and expense totals per calendar month
+
+        Args:
+            months_back: Keep only the most recent N months with activity
+
+        Returns:
+            Month dictionaries oldest first, shaped like the analyzers' cash flow rows
+        """
+        if self._monthly_flows is None:
+            totals: Dict[int, List[float]] = {}
+            for code, amount in zip(self.month_codes, self.amounts):
+                bucket = totals.get(code)
+                if bucket is None:
+                    bucket = totals[code] = [0.0, 0.0]
+                if amount > 0:
+                    bucket[0] += amount
+                else:
+                    bucket[1] -= amount
+            self._monthly_flows = [(code, values[0], values[1]) for code, values in sorted(totals.items())]
+
+        flows = self._monthly_flows
+        if months_back is not None:
+            flows = flows[-months_back:] if months_back > 0 else []
+
+        return [
+            {
+                "month": month_key(code),
+                "income": income,
+                "expenses": expenses,
+                "net_flow": income - expenses
+            }
+            for code, income, expenses in flows
+        ]
+
+
+# Column sets of the data store's published transaction lists, keyed by list
+# identity. Only the store registers lists: it never edits a published list in
+# place (every write publishes a new one) and drops the previous list's entry
+# when it does. Any other list may be edited by its owner, so it is not cached.
+_columns_cache: "OrderedDict[int, Tuple[list, Optional[TransactionColumns]]]" = OrderedDict()
+_columns_lock = threading.Lock()
+_COLUMNS_CACHE_SIZE = 16
+
+
+def share_transaction_columns(transactions: list) -> None:
+    """
+    Let every analysis of a published transaction list share one column view
+
+    The view is built on first use. The list must never be modified again.
+
+    Args:
+        transactions: Transaction list the data store just published
+    """
+    key = id(transactions)
+    with _columns_lock:
+        entry = _columns_cache.get(key)
+        if entry is None or entry[0] is not transactions:
+            # Holding the source list keeps its id from being reused while cached
+            _columns_cache[key] = (transactions, None)
+        _columns_cache.move_to_end(key)
+        while len(_columns_cache) > _COLUMNS_CACHE_SIZE:
+            _columns_cache.popitem(last=False)
+
+
+def forget_transaction_columns(transactions: list) -> None:
+    """
+    Drop the shared column view of a list the data store has replaced
+
+    Args:
+        transactions: Previously shared transaction list
+    """
+    key = id(transactions)
+    with _columns_lock:
+        entry = _columns_cache.get(key)
+        if entry is not None and entry[0] is transactions:
+            del _columns_cache[key]
+
+
+def get_transaction_columns(transactions: List[Dict[str, Any]]) -> TransactionColumns:
+    """
+    Get the columnar view for a transaction list
+
+    Lists the data store published are parsed at most once per version, so
+    every analysis over the same snapshot shares one parse; any other list
+    is parsed on each call.
+
+    Args:
+        transactions: Transaction records
+
+    Returns:
+        TransactionColumns for the list
+    """
+    key = id(transactions)
+    with _columns_lock:
+        entry = _columns_cache.get(key)
+        shared = entry is not None and entry[0] is transactions
+        if shared and entry[1] is not None:
+            _columns_cache.move_to_end(key)
+            return entry[1]
+
+    columns = TransactionColumns(transactions)
+
+    if shared:
+        with _columns_lock:
+            entry = _columns_cache.get(key)
+            if entry is not None and entry[0] is transactions and entry[1] is None:
+                _columns_cache[key] = (transactions, columns)
+    return columns
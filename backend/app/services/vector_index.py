@@ -0,0 +1,545 @@
+"""
+Embedding pipeline and quantized vector index
+Texts are embedded in batches and written to a memory-mapped vector file
+holding, per vector, an int8 code with its scale and the exact float32 vector,
+grouped into inverted lists around k-means centroids. Queries score only the
+probed lists' int8 codes, then rerank the best candidates with the exact
+vectors, so a search touches a few pages of the file instead of loading it.
+"""
+import io
+import json
+import math
+import mmap
+import os
+import random
+import re
+import struct
+import tempfile
+import zlib
+from array import array
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, Iterable, List, Optional, Sequence, Tuple
+import logging
+
+try:
+    import numpy as np
+except ImportError:  # NumPy is optional; fall back to pure Python builds and scans
+    np = None
+
+try:
+    import google.generativeai as genai
+except ImportError:
+    genai = None
+
+logger = logging.getLogger(__name__)
+
+# Dimensions of the default hashing embedder
+EMBEDDING_DIM = 256
+
+# Texts embedded per batch
+EMBED_BATCH_SIZE = 256
+
+# Smaller indexes are one flat list; larger ones get about sqrt(n) inverted lists
+IVF_MIN_VECTORS = 4096
+
+# Inverted lists scanned per query
+DEFAULT_NPROBE = 8
+
+# Approximate candidates reranked with the exact vectors, per requested result
+RERANK_FACTOR = 4
+
+# Vectors sampled to train the coarse centroids, and Lloyd iterations over them
+KMEANS_SAMPLE = 20000
+KMEANS_ITERATIONS = 8
+
+VECTORS_FILE = "vectors.bin"
+ITEMS_FILE = "items.json"
+INFO_FILE = "info.json"
+
+MAGIC = b"MFVEC001"
+# magic, dimensions, vector count, inverted lists; sections follow 8-byte aligned:
+# centroids f32[nlist, dim], offsets u32[nlist + 1], scales f32[count],
+# vectors f32[count, dim], codes i8[count, dim], rows grouped by list
+_HEADER = struct.Struct("<8sIII")
+
+_TOKEN = re.compile(r"[a-z0-9]+")
+
+
+def _normalize(vector: Sequence[float]) -> List[float]:
+    norm = math.sqrt(sum(v * v for v in vector))
+    return [v / norm for v in vector] if norm else list(vector)
+
+
+class HashingEmbedder:
+    """
+    Deterministic feature-hashing embedder
+
+    Words, word bigrams and character trigrams are hashed with CRC32 into
+    signed buckets, so vectors are stable across processes and need no model
+    download, and related wordings ("grocery", "groceries") land close in
+    cosine distance.
+    """
+
+    name = "hashing"
+
+    def __init__(self, dim: int = EMBEDDING_DIM):
+        self.dim = dim
+
+    def embed(self, text: str) -> List[float]:
+        """Embed one text as a unit vector"""
+        vector = [0.0] * self.dim
+        words = _TOKEN.findall(str(text).lower())
+        features = [(word, 1.0) for word in words]
+        features.extend((f"{a} {b}", 1.0) for a, b in zip(words, words[1:]))
+        for word in words:
+            padded = f"#{word}#"
+            features.extend((padded[i:i + 3], 0.5) for i in range(len(padded) - 2))
+
+        for feature, weight in features:
+            hashed = zlib.crc32(feature.encode())
+            vector[hashed % self.dim] += weight if hashed & 0x80000000 else -weight
+        return _normalize(vector)
+
+    def embed_batch(self, texts: Sequence[str]) -> List[List[float]]:
+        """Embed a batch of texts"""
+        return [self.embed(text) for text in texts]
+
+    def embed_query(self, text: str) -> List[float]:
+        """Embed a search query (same space as documents)"""
+        return self.embed(text)
+
+
+class GeminiEmbedder:
+    """Google embedding model, batched per request"""
+
+    def __init__(self, model: str = "models/embedding-001"):
+        self.name = model
+        self.dim: Optional[int] = None
+
+    def embed_batch(self, texts: Sequence[str]) -> List[List[float]]:
+        result = genai.embed_content(model=self.name, content=list(texts), task_type="retrieval_document")
+        vectors = [_normalize(vector) for vector in result["embedding"]]
+        self.dim = len(vectors[0]) if vectors else self.dim
+        return vectors
+
+    def embed_query(self, text: str) -> List[float]:
+        result = genai.embed_content(model=self.name, content=text, task_type="retrieval_query")
+        return _normalize(result["embedding"])
+
+
+def get_embedder(model: str = "default"):
+    """
+    Resolve an embedding model name
+
+    Args:
+        model: "default"/"hashing" for the local hashing embedder, or a Google
+               embedding model name (used when the SDK and an API key exist)
+
+    Returns:
+        Embedder with embed_batch and embed_query
+    """
+    if model in ("default", HashingEmbedder.name):
+        return HashingEmbedder()
+    if genai is not None and os.getenv("GOOGLE_AI_API_KEY"):
+        genai.configure(api_key=os.getenv("GOOGLE_AI_API_KEY"))
+        return GeminiEmbedder(model)
+    logger.warning(f"Embedding model '{model}' unavailable; using the hashing embedder")
+    return HashingEmbedder()
+
+
+def _pad(out: io.RawIOBase) -> None:
+    """Pad the output to the next 8-byte boundary"""
+    remainder = out.tell() % 8
+    if remainder:
+        out.write(b"\0" * (8 - remainder))
+
+
+class VectorIndexBuilder:
+    """
+    Accumulates embedded batches, then clusters, quantizes and writes an index
+
+    Vectors are spilled to a temporary file as they arrive so building an
+    index over a large dataset holds only its payloads in memory.
+    """
+
+    def __init__(self, dim: int, ivf_min_vectors: int = IVF_MIN_VECTORS):
+        """
+        Initialize the builder
+
+        Args:
+            dim: Vector dimensions
+            ivf_min_vectors: Vector count from which inverted lists are built
+        """
+        self.dim = dim
+        self.ivf_min_vectors = ivf_min_vectors
+        self.count = 0
+        self.payloads: List[Dict[str, Any]] = []
+        self._spill = tempfile.TemporaryFile()
+
+    def add(self, vectors: Sequence[Sequence[float]], payloads: Sequence[Dict[str, Any]]) -> None:
+        """Append one embedded batch and the payloads returned for its rows"""
+        for vector in vectors:
+            if len(vector) != self.dim:
+                raise ValueError(f"Expected {self.dim} dimensions, got {len(vector)}")
+            self._spill.write(array("f", vector).tobytes())
+        self.count += len(vectors)
+        self.payloads.extend(payloads)
+
+    def write(self, out: io.RawIOBase) -> List[Dict[str, Any]]:
+        """
+        Write the index file
+
+        Args:
+            out: Binary output positioned at the start of the index
+
+        Returns:
+            Payloads in the file's row order
+        """
+        self._spill.flush()
+        view = mmap.mmap(self._spill.fileno(), 0, access=mmap.ACCESS_READ) if self.count else None
+        try:
+            if np is not None:
+                return self._write_numpy(out, view)
+            return self._write_python(out, view)
+        finally:
+            if view is not None:
+                view.close()
+            self._spill.close()
+
+    def _nlist(self) -> int:
+        return max(1, int(math.sqrt(self.count))) if self.count >= self.ivf_min_vectors else 1
+
+    def _write_numpy(self, out: io.RawIOBase, view: Optional[mmap.mmap]) -> List[Dict[str, Any]]:
+        vectors = (np.frombuffer(view, dtype=np.float32).reshape(self.count, self.dim)
+                   if view is not None else np.zeros((0, self.dim), dtype=np.float32))
+        nlist = self._nlist()
+        if nlist > 1:
+            rng = np.random.default_rng(0)
+            sample = vectors[rng.choice(self.count, min(self.count, KMEANS_SAMPLE), replace=False)]
+            centroids = sample[rng.choice(len(sample), nlist, replace=False)].copy()
+            for _ in range(KMEANS_ITERATIONS):
+                nearest = np.argmax(sample @ centroids.T, axis=1)
+                for index in range(nlist):
+                    members = sample[nearest == index]
+                    if len(members):
+                        centroid = members.mean(axis=0)
+                        norm = np.linalg.norm(centroid)
+                        centroids[index] = centroid / norm if norm else centroid
+            assignment = np.concatenate([
+                np.argmax(vectors[start:start + 65536] @ centroids.T, axis=1)
+                for start in range(0, self.count, 65536)
+            ])
+        else:
+            centroids = np.zeros((1, self.dim), dtype=np.float32)
+            assignment = np.zeros(self.count, dtype=np.int64)
+
+        order = np.argsort(assignment, kind="stable")
+        offsets = np.searchsorted(assignment[order], np.arange(nlist + 1)).astype(np.uint32)
+        scales = np.abs(vectors).max(axis=1) / 127.0 if self.count else np.zeros(0)
+        scales = np.where(scales > 0, scales, 1.0).astype(np.float32)
+
+        out.write(_HEADER.pack(MAGIC, self.dim, self.count, nlist))
+        _pad(out)
+        out.write(centroids.astype(np.float32).tobytes())
+        _pad(out)
+        out.write(offsets.tobytes())
+        _pad(out)
+        out.write(scales[order].tobytes())
+        _pad(out)
+        for start in range(0, self.count, 65536):
+            out.write(vectors[order[start:start + 65536]].tobytes())
+        _pad(out)
+        for start in range(0, self.count, 65536):
+            rows = order[start:start + 65536]
+            codes = np.rint(vectors[rows] / scales[rows, None]).clip(-127, 127).astype(np.int8)
+            out.write(codes.tobytes())
+        return [self.payloads[row] for row in order.tolist()]
+
+    def _write_python(self, out: io.RawIOBase, view: Optional[mmap.mmap]) -> List[Dict[str, Any]]:
+        flat = memoryview(view).cast("f") if view is not None else memoryview(b"").cast("f")
+        dim = self.dim
+        rows = [flat[i * dim:(i + 1) * dim].tolist() for i in range(self.count)]
+        nlist = self._nlist()
+        if nlist > 1:
+            rng = random.Random(0)
+            sample = rng.sample(rows, min(self.count, KMEANS_SAMPLE))
+            centroids = [list(vector) for vector in rng.sample(sample, nlist)]
+            for _ in range(KMEANS_ITERATIONS):
+                sums = [[0.0] * dim for _ in range(nlist)]
+                counts = [0] * nlist
+                for vector in sample:
+                    index = _nearest(vector, centroids)
+                    counts[index] += 1
+                    sums[index] = [a + b for a, b in zip(sums[index], vector)]
+                centroids = [_normalize(total) if counts[i] else centroids[i] for i, total in enumerate(sums)]
+            assignment = [_nearest(vector, centroids) for vector in rows]
+        else:
+            centroids = [[0.0] * dim]
+            assignment = [0] * self.count
+
+        order = sorted(range(self.count), key=lambda row: assignment[row])
+        offsets = [0] * (nlist + 1)
+        for row in order:
+            offsets[assignment[row] + 1] += 1
+        for index in range(nlist):
+            offsets[index + 1] += offsets[index]
+        scales = [(max(abs(v) for v in rows[row]) / 127.0 if dim else 0.0) or 1.0 for row in order]
+
+        out.write(_HEADER.pack(MAGIC, dim, self.count, nlist))
+        _pad(out)
+        for centroid in centroids:
+            out.write(array("f", centroid).tobytes())
+        _pad(out)
+        out.write(array("I", offsets).tobytes())
+        _pad(out)
+        out.write(array("f", scales).tobytes())
+        _pad(out)
+        for row in order:
+            out.write(array("f", rows[row]).tobytes())
+        _pad(out)
+        for row, scale in zip(order, scales):
+            out.write(array("b", [max(-127, min(127, round(v / scale))) for v in rows[row]]).tobytes())
+        return [self.payloads[row] for row in order]
+
+
+def _dot(a: Sequence[float], b: Sequence[float]) -> float:
+    return sum(x * y for x, y in zip(a, b))
+
+
+def _nearest(vector: Sequence[float], centroids: Sequence[Sequence[float]]) -> int:
+    best, best_score = 0, -math.inf
+    for index, centroid in enumerate(centroids):
+        score = _dot(vector, centroid)
+        if score > best_score:
+            best, best_score = index, score
+    return best
+
+
+class VectorIndex:
+    """
+    Read side of a vector file: inverted lists of int8 codes with exact rerank
+
+    The buffer is usually a read-only mmap of ``vectors.bin``, so opening an
+    index costs nothing until a query touches its pages.
+    """
+
+    def __init__(self, buffer: Any, payloads: List[Dict[str, Any]], info: Optional[Dict[str, Any]] = None):
+        """
+        Initialize over an index buffer
+
+        Args:
+            buffer: Bytes or mmap holding a written index
+            payloads: Payloads in the file's row order
+            info: Index description (model, creation time, ...)
+        """
+        magic, dim, count, nlist = _HEADER.unpack_from(buffer, 0)
+        if magic != MAGIC:
+            raise ValueError("Not a vector index file")
+        if len(payloads) != count:
+            raise ValueError(f"Index holds {count} vectors but {len(payloads)} payloads")
+
+        self.dim, self.count, self.nlist = dim, count, nlist
+        self.payloads = payloads
+        self.info = info or {}
+        self._buffer = buffer
+
+        def section(offset: int, size: int) -> Tuple[int, int]:
+            start = offset + (-offset % 8)
+            return start, start + size
+
+        view = memoryview(buffer)
+        centroids = section(_HEADER.size, nlist * dim * 4)
+        offsets = section(centroids[1], (nlist + 1) * 4)
+        scales = section(offsets[1], count * 4)
+        vectors = section(scales[1], count * dim * 4)
+        codes = section(vectors[1], count * dim)
+
+        if np is not None:
+            self._centroids = np.frombuffer(buffer, np.float32, nlist * dim, centroids[0]).reshape(nlist, dim)
+            self._offsets = np.frombuffer(buffer, np.uint32, nlist + 1, offsets[0]).tolist()
+            self._scales = np.frombuffer(buffer, np.float32, count, scales[0])
+            self._vectors = np.frombuffer(buffer, np.float32, count * dim, vectors[0]).reshape(count, dim)
+            self._codes = np.frombuffer(buffer, np.int8, count * dim, codes[0]).reshape(count, dim)
+        else:
+            self._centroids = view[centroids[0]:centroids[1]].cast("f")
+            self._offsets = view[offsets[0]:offsets[1]].cast("I").tolist()
+            self._scales = view[scales[0]:scales[1]].cast("f")
+            self._vectors = view[vectors[0]:vectors[1]].cast("f")
+            self._codes = view[codes[0]:codes[1]].cast("b")
+
+    @classmethod
+    def build(cls, vectors: Sequence[Sequence[float]], payloads: Sequence[Dict[str, Any]],
+              dim: int, info: Optional[Dict[str, Any]] = None,
+              ivf_min_vectors: int = IVF_MIN_VECTORS) -> "VectorIndex":
+        """Build an in-memory index (for data that changes too often to persist)"""
+        builder = VectorIndexBuilder(dim, ivf_min_vectors)
+        builder.add(vectors, payloads)
+        out = io.BytesIO()
+        ordered = builder.write(out)
+        return cls(out.getvalue(), ordered, info)
+
+    @classmethod
+    def open(cls, directory: Path) -> Optional["VectorIndex"]:
+        """
+        Map an index written by ``write_index``
+
+        Args:
+            directory: Index directory
+
+        Returns:
+            VectorIndex, or None if the directory holds no complete index
+        """
+        directory = Path(directory)
+        try:
+            with open(directory / INFO_FILE, "r", encoding="utf-8") as f:
+                info = json.load(f)
+            with open(directory / ITEMS_FILE, "r", encoding="utf-8") as f:
+                payloads = json.load(f)
+            with open(directory / VECTORS_FILE, "rb") as f:
+                buffer = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (OSError, ValueError) as e:
+            logger.debug(f"No vector index in {directory}: {e}")
+            return None
+        return cls(buffer, payloads, info)
+
+    def search(self, query: Sequence[float], k: int = 5,
+               nprobe: int = DEFAULT_NPROBE) -> List[Tuple[float, Dict[str, Any]]]:
+        """
+        Approximate nearest neighbours by cosine similarity
+
+        Args:
+            query: Unit query vector
+            k: Results wanted
+            nprobe: Inverted lists scanned
+
+        Returns:
+            (score, payload) pairs, best first
+        """
+        if not self.count or k <= 0:
+            return []
+        if len(query) != self.dim:
+            raise ValueError(f"Expected {self.dim} dimensions, got {len(query)}")
+        if np is not None:
+            return self._search_numpy(query, k, nprobe)
+        return self._search_python(query, k, nprobe)
+
+    def _probed_lists(self, scores: Sequence[float], nprobe: int) -> List[int]:
+        ranked = sorted(range(self.nlist), key=lambda index: scores[index], reverse=True)
+        return [index for index in ranked if self._offsets[index + 1] > self._offsets[index]][:max(1, nprobe)]
+
+    def _search_numpy(self, query: Sequence[float], k: int, nprobe: int) -> List[Tuple[float, Dict[str, Any]]]:
+        q = np.asarray(query, dtype=np.float32)
+        lists = self._probed_lists((self._centroids @ q).tolist(), nprobe) if self.nlist > 1 else [0]
+
+        # Lists are contiguous row ranges, so scoring slices needs no gather
+        rows, approx = [], []
+        for index in lists:
+            start, end = self._offsets[index], self._offsets[index + 1]
+            rows.append(np.arange(start, end))
+            approx.append((self._codes[start:end] @ q) * self._scales[start:end])
+        rows, approx = np.concatenate(rows), np.concatenate(approx)
+
+        keep = min(len(rows), k * RERANK_FACTOR)
+        candidates = rows[np.argpartition(-approx, keep - 1)[:keep]] if keep < len(rows) else rows
+        exact = self._vectors[candidates] @ q
+        best = np.argsort(-exact)[:k]
+        return [(float(exact[i]), self.payloads[int(candidates[i])]) for i in best]
+
+    def _search_python(self, query: Sequence[float], k: int, nprobe: int) -> List[Tuple[float, Dict[str, Any]]]:
+        dim = self.dim
+        if self.nlist > 1:
+            scores = [_dot(query, self._centroids[i * dim:(i + 1) * dim]) for i in range(self.nlist)]
+            lists = self._probed_lists(scores, nprobe)
+        else:
+            lists = [0]
+
+        approx = []
+        for index in lists:
+            for row in range(self._offsets[index], self._offsets[index + 1]):
+                approx.append((_dot(query, self._codes[row * dim:(row + 1) * dim]) * self._scales[row], row))
+        approx.sort(reverse=True)
+
+        exact = [(_dot(query, self._vectors[row * dim:(row + 1) * dim]), row)
+                 for _, row in approx[:k * RERANK_FACTOR]]
+        exact.sort(reverse=True)
+        return [(score, self.payloads[row]) for score, row in exact[:k]]
+
+    def close(self) -> None:
+        """Release the mapping"""
+        if isinstance(self._buffer, mmap.mmap):
+            self._centroids = self._scales = self._vectors = self._codes = None
+            try:
+                self._buffer.close()
+            except BufferError:
+                # Arrays handed out by a search still reference the mapping
+                pass
+
+
+def write_index(directory: Path, texts: Iterable[Sequence[Tuple[str, Dict[str, Any]]]],
+                embedder: Any, info: Optional[Dict[str, Any]] = None,
+                ivf_min_vectors: int = IVF_MIN_VECTORS) -> Dict[str, Any]:
+    """
+    Embed batches of (text, payload) pairs and write an index directory
+
+    The vector file is written under a temporary name and renamed, so readers
+    mapping the previous index are never exposed to a partial file.
+
+    Args:
+        directory: Index directory to (re)write
+        texts: Batches of (text, payload) pairs
+        embedder: Embedder with embed_batch
+        info: Extra fields for info.json
+        ivf_min_vectors: Vector count from which inverted lists are built
+
+    Returns:
+        The info.json contents
+    """
+    directory = Path(directory)
+    directory.mkdir(parents=True, exist_ok=True)
+    builder: Optional[VectorIndexBuilder] = None
+
+    for batch in texts:
+        if not batch:
+            continue
+        vectors = embedder.embed_batch([text for text, _ in batch])
+        if builder is None:
+            builder = VectorIndexBuilder(len(vectors[0]), ivf_min_vectors)
+        builder.add(vectors, [payload for _, payload in batch])
+
+    if builder is None:
+        builder = VectorIndexBuilder(getattr(embedder, "dim", None) or EMBEDDING_DIM, ivf_min_vectors)
+
+    temporary = directory / (VECTORS_FILE + ".tmp")
+    with open(temporary, "wb") as out:
+        payloads = builder.write(out)
+    with open(directory / ITEMS_FILE, "w", encoding="utf-8") as f:
+        json.dump(payloads, f, default=str)
+    os.replace(temporary, directory / VECTORS_FILE)
+
+    index_info = {
+        **(info or {}),
+        "embedding_model": embedder.name,
+        "dimensions": builder.dim,
+        "vectors": builder.count,
+        "inverted_lists": builder._nlist(),
+        "quantization": "int8",
+        "created_at": datetime.utcnow().isoformat(),
+        "status": "ready"
+    }
+    with open(directory / INFO_FILE, "w", encoding="utf-8") as f:
+        json.dump(index_info, f, indent=2)
+    return index_info
+
+
+def batched(pairs: Iterable[Tuple[str, Dict[str, Any]]],
+            batch_size: int = EMBED_BATCH_SIZE) -> Iterable[List[Tuple[str, Dict[str, Any]]]]:
+    """Group (text, payload) pairs into embedding batches"""
+    batch: List[Tuple[str, Dict[str, Any]]] = []
+    for pair in pairs:
+        batch.append(pair)
+        if len(batch) >= batch_size:
+            yield batch
+            batch = []
+    if batch:
+        yield batch
@@ -0,0 +1,349 @@
+#!/usr/bin/env python3
+"""
+Benchmark and load-test suite for the MintelliFunds backend
+
+    python benchmark.py generate --transactions 1000000 --output bench_data
+    python benchmark.py micro --sizes 1000,10000,100000
+    python benchmark.py load --transactions 100000 --duration 20 --concurrency 8
+    python benchmark.py load --url http://localhost:8000
+    python benchmark.py micro --baseline benchmark_report.json
+
+micro times FinancialAnalyzer, DataValidator.validate_bulk_data and
+EnhancedNLPService.process_query on deterministic synthetic users. load drives
+/api/chat, /api/insights and /api/dashboard with concurrent clients. By default
+it starts its own server on a generated dataset with rate limiting off; --url
+targets a running server instead. Results go to a test_report.json-style
+report. With --baseline, a test fails when its p50 regresses by more than
+--tolerance, and the exit status is non-zero.
+"""
+import argparse
+import itertools
+import json
+import os
+import shutil
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.error
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+# Add the backend directory to Python path
+BACKEND_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(BACKEND_DIR, "app"))
+
+from services.synthetic_data import SyntheticDataGenerator
+
+DEFAULT_REPORT = "benchmark_report.json"
+
+ALL_PERMISSIONS = {category: True for category in (
+    "transactions", "assets", "liabilities", "epf_balance", "credit_score",
+    "investments", "accounts", "spending_trends", "category_breakdown", "dashboard_insights"
+)}
+
+NLP_QUERIES = (
+    "How much did I spend on food last month?",
+    "Can I afford a 50000 laptop?",
+    "What is my financial health score?",
+    "Show unusual transactions in the past 3 months",
+    "How should I pay off my debts faster?",
+    "Forecast my balance for the next 6 months",
+    "How is my investment portfolio doing?",
+    "Compare my transportation and shopping spending",
+)
+
+
+def percentile(samples: List[float], q: float) -> float:
+    """Nearest-rank percentile of a list of samples"""
+    ordered = sorted(samples)
+    if not ordered:
+        return 0.0
+    rank = min(len(ordered) - 1, max(0, int(round(q / 100 * len(ordered) + 0.5)) - 1))
+    return ordered[rank]
+
+
+def latency_summary(latencies: List[float], elapsed: float, units: int = 1) -> Dict[str, float]:
+    """p50/p99/mean in milliseconds and throughput per second"""
+    return {
+        "runs": len(latencies),
+        "p50_ms": round(percentile(latencies, 50) * 1000, 3),
+        "p99_ms": round(percentile(latencies, 99) * 1000, 3),
+        "mean_ms": round(statistics.fmean(latencies) * 1000, 3) if latencies else 0.0,
+        "throughput_per_s": round(len(latencies) * units / elapsed, 2) if elapsed > 0 else 0.0
+    }
+
+
+class BenchmarkReport:
+    """Results grouped by suite in the layout of test_report.json"""
+
+    def __init__(self):
+        self.results: Dict[str, Dict[str, Any]] = {}
+
+    def record(self, suite: str, name: str, metrics: Dict[str, Any], passed: bool = True, message: str = ""):
+        group = self.results.setdefault(suite, {"passed": 0, "failed": 0, "tests": []})
+        group["passed" if passed else "failed"] += 1
+        group["tests"].append({
+            "name": name,
+            "passed": passed,
+            "message": message or f"p50 {metrics.get('p50_ms')} ms, p99 {metrics.get('p99_ms')} ms, "
+                                  f"{metrics.get('throughput_per_s')}/s",
+            "timestamp": time.time(),
+            "metrics": metrics
+        })
+        status = "✅" if passed else "❌"
+        print(f"   {status} {name}: {group['tests'][-1]['message']}")
+
+    def compare(self, baseline_path: str, tolerance: float) -> int:
+        """Fail tests whose p50 exceeds the baseline by more than tolerance; returns the failure count"""
+        with open(baseline_path, "r", encoding="utf-8") as f:
+            baseline = json.load(f)
+        regressions = 0
+        for suite, group in self.results.items():
+            previous = {test["name"]: test.get("metrics", {}) for test in baseline.get(suite, {}).get("tests", [])}
+            for test in group["tests"]:
+                before = previous.get(test["name"], {}).get("p50_ms")
+                now = test["metrics"].get("p50_ms")
+                if not before or now is None:
+                    continue
+                change = (now - before) / before
+                test["metrics"]["baseline_p50_ms"] = before
+                if change > tolerance and test["passed"]:
+                    test["passed"] = False
+                    test["message"] = f"p50 regressed {change:+.0%}: {before} ms -> {now} ms"
+                    group["passed"] -= 1
+                    group["failed"] += 1
+                    regressions += 1
+                    print(f"   ❌ {suite}/{test['name']}: {test['message']}")
+        return regressions
+
+    def save(self, path: str) -> None:
+        with open(path, "w", encoding="utf-8") as f:
+            json.dump(self.results, f, indent=2, default=str)
+        print(f"\n📄 Report saved to: {path}")
+
+    @property
+    def failed(self) -> int:
+        return sum(group["failed"] for group in self.results.values())
+
+
+def time_runs(func: Callable[[], Any], repeat: int, budget_seconds: float) -> Tuple[List[float], float]:
+    """
+    Run func up to repeat times, stopping early once the time budget is spent
+
+    Returns:
+        (per-run latencies, total elapsed seconds)
+    """
+    latencies = []
+    started = time.perf_counter()
+    while len(latencies) < repeat:
+        start = time.perf_counter()
+        func()
+        latencies.append(time.perf_counter() - start)
+        if time.perf_counter() - started > budget_seconds:
+            break
+    return latencies, time.perf_counter() - started
+
+
+def run_micro(report: BenchmarkReport, sizes: List[int], repeat: int, seed: int) -> None:
+    """Micro-benchmarks of the analysis, validation and NLP hot paths"""
+    from services.financial_analyzer import FinancialAnalyzer
+    from services.data_validator import DataValidator
+    from services.enhanced_nlp_service import EnhancedNLPService
+
+    generator = SyntheticDataGenerator(seed=seed)
+    analyzer = FinancialAnalyzer()
+    validator = DataValidator()
+
+    for size in sizes:
+        print(f"\n📊 {size:,} transactions")
+        data = generator.dataset(size)
+        transactions = data["transactions"]
+        budget = max(5.0, size / 20000)
+        cases = {
+            "analyze_spending_patterns": lambda: analyzer.analyze_spending_patterns(transactions, 30),
+            "detect_financial_anomalies": lambda: analyzer.detect_financial_anomalies(transactions),
+            "generate_comprehensive_insights": lambda: analyzer.generate_comprehensive_insights(
+                data["accounts"], data["liabilities"], transactions, data["investments"]),
+            "validate_bulk_data": lambda: validator.validate_bulk_data(transactions, "transaction"),
+        }
+        for name, func in cases.items():
+            latencies, elapsed = time_runs(func, repeat, budget)
+            # The first run fills per-dataset caches; report it apart from the warm runs
+            cold = latencies[0]
+            warm = latencies[1:] or latencies
+            metrics = latency_summary(warm, elapsed - cold if len(latencies) > 1 else elapsed, units=size)
+            metrics.update({"cold_ms": round(cold * 1000, 3), "transactions": size})
+            report.record("micro", f"{name}[{size}]", metrics)
+
+    print("\n💬 NLP queries")
+    nlp = EnhancedNLPService()
+    queries = itertools.cycle(NLP_QUERIES)
+    latencies, elapsed = time_runs(lambda: nlp.process_query(next(queries), user_id="bench"), repeat * 50, 10.0)
+    report.record("micro", "enhanced_nlp_process_query", latency_summary(latencies, elapsed))
+
+
+def _request(url: str, method: str, body: Optional[Dict[str, Any]], timeout: float) -> int:
+    data = json.dumps(body).encode() if body is not None else None
+    request = urllib.request.Request(url, data=data, method=method,
+                                     headers={"Content-Type": "application/json",
+                                              "Accept-Encoding": "gzip"})
+    try:
+        with urllib.request.urlopen(request, timeout=timeout) as response:
+            response.read()
+            return response.status
+    except urllib.error.HTTPError as e:
+        return e.code
+
+
+def load_endpoint(base_url: str, method: str, path: str, bodies: List[Optional[Dict[str, Any]]],
+                  duration: float, concurrency: int, timeout: float) -> Dict[str, Any]:
+    """Closed-loop load: concurrency clients send back-to-back requests for duration seconds"""
+    latencies: List[float] = []
+    errors: Dict[str, int] = {}
+    lock = threading.Lock()
+    deadline = time.perf_counter() + duration
+
+    def client(worker: int) -> None:
+        sent = worker
+        while time.perf_counter() < deadline:
+            body = bodies[sent % len(bodies)]
+            sent += concurrency
+            start = time.perf_counter()
+            try:
+                status = _request(base_url + path, method, body, timeout)
+                failure = None if status < 400 else str(status)
+            except (OSError, urllib.error.URLError) as e:
+                failure = type(e).__name__
+            elapsed = time.perf_counter() - start
+            with lock:
+                if failure is None:
+                    latencies.append(elapsed)
+                else:
+                    errors[failure] = errors.get(failure, 0) + 1
+
+    started = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=concurrency) as pool:
+        list(pool.map(client, range(concurrency)))
+    metrics = latency_summary(latencies, time.perf_counter() - started)
+    metrics.update({"errors": errors, "concurrency": concurrency, "endpoint": f"{method} {path}"})
+    return metrics
+
+
+def run_load(report: BenchmarkReport, base_url: str, duration: float, concurrency: int, timeout: float) -> None:
+    """Load-test the chat, insights and dashboard endpoints"""
+    endpoints = (
+        ("dashboard", "GET", "/api/dashboard", [None]),
+        ("insights", "POST", "/api/insights",
+         [{"query": query, "permissions": ALL_PERMISSIONS} for query in NLP_QUERIES]),
+        ("chat", "POST", "/api/chat", [{"message": query, "context": {}} for query in NLP_QUERIES]),
+    )
+    for name, method, path, bodies in endpoints:
+        print(f"\n🔥 {method} {path} ({concurrency} clients, {duration:.0f}s)")
+        metrics = load_endpoint(base_url, method, path, bodies, duration, concurrency, timeout)
+        total = metrics["runs"] + sum(metrics["errors"].values())
+        error_rate = sum(metrics["errors"].values()) / total if total else 1.0
+        metrics["error_rate"] = round(error_rate, 4)
+        report.record("load", name, metrics, passed=metrics["runs"] > 0 and error_rate < 0.01,
+                      message="" if metrics["runs"] else f"no successful requests: {metrics['errors']}")
+
+
+def _free_port() -> int:
+    with socket.socket() as sock:
+        sock.bind(("127.0.0.1", 0))
+        return sock.getsockname()[1]
+
+
+def start_server(transactions: int, seed: int, workdir: str) -> Tuple[subprocess.Popen, str]:
+    """Generate a dataset and serve it from a fresh uvicorn process"""
+    print(f"🧪 Generating {transactions:,} synthetic transactions...")
+    SyntheticDataGenerator(seed=seed).write_dataset(os.path.join(workdir, "data"), transactions)
+
+    port = _free_port()
+    env = dict(os.environ, PYTHONPATH=BACKEND_DIR, ENABLE_RATE_LIMITING="false")
+    process = subprocess.Popen(
+        [sys.executable, "-m", "uvicorn", "app.main:app", "--host", "127.0.0.1", "--port", str(port),
+         "--log-level", "warning"],
+        cwd=workdir, env=env
+    )
+    base_url = f"http://127.0.0.1:{port}"
+    deadline = time.time() + 120
+    while time.time() < deadline:
+        if process.poll() is not None:
+            raise RuntimeError(f"Server exited with status {process.returncode}")
+        try:
+            if _request(base_url + "/api/health", "GET", None, 2.0) == 200:
+                return process, base_url
+        except OSError:
+            pass
+        time.sleep(0.5)
+    process.terminate()
+    raise RuntimeError("Server did not become healthy within 120 seconds")
+
+
+def main():
+    """Main benchmark runner"""
+    parser = argparse.ArgumentParser(description="MintelliFunds benchmarks and load tests")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    generate = sub.add_parser("generate", help="write a synthetic data directory")
+    generate.add_argument("--transactions", type=int, default=100000)
+    generate.add_argument("--output", default="bench_data")
+
+    micro = sub.add_parser("micro", help="micro-benchmark analysis, validation and NLP")
+    micro.add_argument("--sizes", default="1000,10000,100000")
+    micro.add_argument("--repeat", type=int, default=10)
+
+    load = sub.add_parser("load", help="load-test /api/chat, /api/insights and /api/dashboard")
+    load.add_argument("--url", help="running server to target instead of starting one")
+    load.add_argument("--transactions", type=int, default=100000)
+    load.add_argument("--duration", type=float, default=15.0)
+    load.add_argument("--concurrency", type=int, default=8)
+    load.add_argument("--timeout", type=float, default=30.0)
+
+    for command in (generate, micro, load):
+        command.add_argument("--seed", type=int, default=42)
+    for command in (micro, load):
+        command.add_argument("--report", default=DEFAULT_REPORT)
+        command.add_argument("--baseline", help="earlier report to compare p50 latencies against")
+        command.add_argument("--tolerance", type=float, default=0.25, help="allowed p50 regression (0.25 = 25%%)")
+    args = parser.parse_args()
+
+    if args.command == "generate":
+        counts = SyntheticDataGenerator(seed=args.seed).write_dataset(args.output, args.transactions)
+        print(f"✅ Wrote {counts['transactions']:,} transactions to {args.output}")
+        return 0
+
+    print("🚀 Starting MintelliFunds Benchmarks")
+    print("=" * 50)
+    report = BenchmarkReport()
+    if args.command == "micro":
+        run_micro(report, [int(size) for size in args.sizes.split(",")], args.repeat, args.seed)
+    else:
+        process, workdir = None, None
+        try:
+            base_url = args.url
+            if base_url is None:
+                workdir = tempfile.mkdtemp(prefix="mintellifunds_bench_")
+                process, base_url = start_server(args.transactions, args.seed, workdir)
+            run_load(report, base_url.rstrip("/"), args.duration, args.concurrency, args.timeout)
+        finally:
+            if process is not None:
+                process.terminate()
+                process.wait(timeout=10)
+            if workdir is not None:
+                shutil.rmtree(workdir, ignore_errors=True)
+
+    if args.baseline:
+        print(f"\n📏 Comparing against {args.baseline} (tolerance {args.tolerance:.0%})")
+        report.compare(args.baseline, args.tolerance)
+    report.save(args.report)
+    return 1 if report.failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
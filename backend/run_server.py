@@ -21,13 +21,19 @@ if __name__ == "__main__":
     print("API documentation: http://localhost:8000/docs")
     print("Alternative docs: http://localhost:8000/redoc")
     print("-" * 50)
+
+    workers = int(os.getenv("WORKERS", "1"))
+    if workers > 1:
+        # Workers map one shared copy of the data instead of each loading their own
+        os.environ.setdefault("ENABLE_SHARED_SNAPSHOTS", "true")
     
     # Run the server
     uvicorn.run(
         "app.main:app",
         host="0.0.0.0",
         port=8000,
-        reload=True,
+        reload=workers == 1,
+        workers=workers,
         log_level="info",
         access_log=True
     )
@@ -6,7 +6,7 @@ import asyncio
 import sys
 import os
 import json
-from datetime import datetime, timedelta
+from datetime import datetime, timedelta, timezone
 from typing import List, Dict, Any
 
 # Add the backend directory to Python path
@@ -16,6 +16,7 @@ sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
 from services.data_validator import DataValidator
 from services.financial_analyzer import FinancialAnalyzer
 from services.analysis_service import AnalysisService
+from services.analysis_kernel import build_transaction_profile
 
 
 def generate_sample_data() -> Dict[str, Any]:
@@ -271,6 +272,63 @@ async def test_financial_analyzer():
         return False
 
 
+async def test_kernel_parity():
+    """Test that the fused single-pass profile matches the per-analysis helpers"""
+    print("\n🧮 Testing fused analysis kernel parity...")
+    
+    analyzer = FinancialAnalyzer()
+    transactions = generate_sample_data()["transactions"]
+    # One outlier in the window so the anomaly paths have something to flag
+    transactions.append({
+        "id": "expense_outlier", "date": (datetime.now() - timedelta(days=2)).isoformat(),
+        "amount": -60000, "description": "New Laptop", "category": "shopping", "type": "expense"
+    })
+    
+    try:
+        now = datetime.now(timezone.utc)
+        profile = build_transaction_profile(transactions, 30, now)
+        window = [t for t in analyzer._filter_transactions_by_date(transactions, now - timedelta(days=30))
+                  if analyzer._is_expense(t)]
+        
+        assert profile.window_count == len(window)
+        assert round(profile.window_total, 2) == round(sum(abs(t["amount"]) for t in window), 2)
+        assert profile.category_breakdown() == analyzer._analyze_spending_by_category(window)
+        assert profile.spending_trend() == analyzer._calculate_spending_trend(window, 30)
+        
+        def anomaly_keys(anomalies):
+            return sorted((a["transaction_id"], a["z_score"], a["severity"]) for a in anomalies)
+        fused_anomalies = profile.spending_anomalies()
+        assert fused_anomalies and anomaly_keys(fused_anomalies) == anomaly_keys(
+            analyzer._detect_spending_anomalies(window))
+        
+        def rounded(flows):
+            return [{key: round(value, 2) if isinstance(value, float) else value for key, value in flow.items()}
+                    for flow in flows]
+        assert rounded(profile.monthly_flows(6)) == rounded(analyzer._analyze_monthly_cash_flow(transactions, 6))
+        assert {t["id"] for t in profile.expenses} == {t["id"] for t in transactions if analyzer._is_expense(t)}
+        assert {t["id"] for t in profile.incomes} == {t["id"] for t in transactions if not analyzer._is_expense(t)}
+        assert analyzer.detect_financial_anomalies(transactions, profile=profile)["anomalies"] == \
+            analyzer.detect_financial_anomalies(transactions)["anomalies"]
+        print(f"  ✓ {profile.window_count} window expenses: categories, trend, "
+              f"{len(fused_anomalies)} anomalies and monthly flows match")
+        
+        # Undated rows with string amounts are coerced like the columnar path
+        undated = build_transaction_profile([{"id": "cash", "amount": "-25.5", "description": "Cash"},
+                                             {"id": "refund", "amount": "bad", "description": "Refund"}])
+        assert undated.total_expenses == 25.5 and [t["id"] for t in undated.expenses] == ["cash"]
+        assert undated.total_income == 0 and [t["id"] for t in undated.incomes] == ["refund"]
+        print("  ✓ Undated string amounts coerced")
+        
+        print("✅ Analysis kernel parity tests passed!")
+        return True
+        
+    except Exception as e:
+        print(f"❌ Analysis kernel parity tests failed: {e!r}")
+        import traceback
+        traceback.print_exc()
+        return False
+
+
 async def test_analysis_service():
     """Test the integrated analysis service"""
     print("\n🔧 Testing Analysis Service Integration...")
@@ -453,6 +511,7 @@ async def main():
     # Run all tests
     test_results.append(await test_data_validation())
     test_results.append(await test_financial_analyzer())
+    test_results.append(await test_kernel_parity())
     test_results.append(await test_analysis_service())
     test_results.append(await run_performance_test())
     
@@ -467,6 +526,7 @@ async def main():
     test_names = [
         "Data Validation",
         "Financial Analyzer",
+        "Analysis Kernel Parity",
         "Analysis Service Integration", 
         "Performance Test"
     ]
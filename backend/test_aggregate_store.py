@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Test script for incrementally maintained transaction aggregates
+Verifies that store writes keep the rollups equal to a full rebuild
+"""
+import sys
+import os
+import json
+import shutil
+import tempfile
+from pathlib import Path
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.data_store import DataStore, DATA_FILES
+from services.aggregate_store import TransactionAggregates
+
+TRANSACTIONS = [
+    {"id": "txn_1", "date": "2024-01-15T09:30:00Z", "amount": -450.0, "category": "Food & Dining"},
+    {"id": "txn_2", "date": "2024-01-10T12:00:00Z", "amount": 75000.0, "category": "Income"},
+    {"id": "txn_3", "date": "2023-12-28T18:45:00Z", "amount": -1200.0, "category": "Shopping"},
+    {"id": "txn_4", "date": "2023-12-05T08:00:00Z", "amount": -300.0, "category": "Food & Dining"},
+]
+
+
+def create_data_dir() -> Path:
+    """Create a temporary data directory with sample transactions"""
+    data_dir = Path(tempfile.mkdtemp())
+    for key, filename in DATA_FILES.items():
+        value = TRANSACTIONS if key == "transactions" else []
+        with open(data_dir / filename, "w", encoding="utf-8") as f:
+            json.dump(value, f)
+    return data_dir
+
+
+def assert_matches_rebuild(store: DataStore):
+    """Incremental aggregates must equal aggregates rebuilt from the snapshot"""
+    incremental = store.aggregates()
+    rebuilt = TransactionAggregates(store.snapshot()["transactions"])
+
+    assert incremental.summary() == rebuilt.summary()
+    assert incremental.monthly_flows() == rebuilt.monthly_flows()
+    assert incremental.category_expenses() == rebuilt.category_expenses()
+
+
+def test_initial_rollups(store: DataStore):
+    """Loading builds monthly-by-category rollups"""
+    print("\n📊 Testing initial rollups...")
+    aggregates = store.aggregates()
+
+    flows = aggregates.monthly_flows()
+    assert [f["month"] for f in flows] == ["2023-12", "2024-01"]
+    assert flows[1]["income"] == 75000.0 and flows[1]["expenses"] == 450.0
+    assert aggregates.category_expenses() == {"Food & Dining": 750.0, "Shopping": 1200.0}
+    print(f"   ✅ {len(flows)} months, {aggregates.summary()['transaction_count']} transactions")
+
+
+def test_writes_update_incrementally(store: DataStore):
+    """Add, update and delete adjust only the affected buckets"""
+    print("\n✏️  Testing incremental writes...")
+    version = store.version
+
+    store.add_transaction({"id": "txn_5", "date": "2024-02-01T10:00:00Z", "amount": -99.5, "category": "Travel"})
+    assert_matches_rebuild(store)
+
+    store.update_transaction("txn_3", {"category": "Food & Dining", "amount": -200.0})
+    assert_matches_rebuild(store)
+    assert store.aggregates().category_expenses(end_month=2023 * 12 + 11) == {"Food & Dining": 500.0}
+
+    assert store.delete_transaction("txn_1") is not None
+    assert store.delete_transaction("missing") is None
+    assert_matches_rebuild(store)
+
+    assert store.version == version + 3
+    print(f"   ✅ Rollups match a full rebuild at version {store.version}")
+
+
+def test_daily_window(store: DataStore):
+    """Day-range reads sum only the requested days"""
+    print("\n📅 Testing daily windows...")
+    aggregates = store.aggregates()
+    day = int(aggregates.latest_timestamp // 86400)
+
+    assert aggregates.expenses_between_days(day, day) == 99.5
+    assert aggregates.expenses_between_days(day - 1, day - 1) == 0.0
+    print("   ✅ Daily buckets resolve single days")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Aggregate Store Tests")
+    print("=" * 50)
+
+    data_dir = create_data_dir()
+    try:
+        store = DataStore(str(data_dir), refresh_interval=0)
+        store.load()
+        test_initial_rollups(store)
+        test_writes_update_incrementally(store)
+        test_daily_window(store)
+        print("\n🎉 All aggregate store tests passed")
+    finally:
+        shutil.rmtree(data_dir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    main()
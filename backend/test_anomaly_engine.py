@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""
+Test script for the vectorized anomaly engine
+Checks the engine against the reference FinancialAnalyzerHelpers detectors
+"""
+import sys
+import os
+import random
+import statistics
+from datetime import datetime, timedelta, timezone
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.anomaly_engine import AnomalyEngine, RollingAnomalyDetector, _RollingWindow
+from services.financial_analyzer_helpers import FinancialAnalyzerHelpers
+
+
+def create_transactions(count: int = 600):
+    """Create a reproducible transaction history with outliers"""
+    rng = random.Random(7)
+    now = datetime.now(timezone.utc)
+    transactions = []
+    for i in range(count):
+        date = now - timedelta(days=rng.uniform(0, 180), hours=rng.uniform(0, 24))
+        if rng.random() < 0.85:
+            amount = -round(rng.expovariate(1 / 500), 2)
+        else:
+            amount = round(rng.uniform(1000, 80000), 2)
+        transactions.append({
+            "id": f"txn_{i}",
+            "date": date.isoformat().replace("+00:00", "Z"),
+            "amount": amount,
+            "category": rng.choice(["Food & Dining", "Shopping", "Travel", "Bills"]),
+            "description": "Coffee Shop" if i % 4 == 0 else f"Merchant {rng.randint(1, 30)}"
+        })
+    return transactions
+
+
+def reference_anomalies(transactions, threshold_std=2.0):
+    """Run the original pure Python detectors"""
+    expenses = [t for t in transactions if t.get("amount", 0) < 0]
+    incomes = [t for t in transactions if not t.get("amount", 0) < 0]
+    return (FinancialAnalyzerHelpers.detect_amount_anomalies(expenses, threshold_std) +
+            FinancialAnalyzerHelpers.detect_amount_anomalies(incomes, threshold_std) +
+            FinancialAnalyzerHelpers.detect_merchant_anomalies(expenses) +
+            FinancialAnalyzerHelpers.detect_category_anomalies(expenses) +
+            FinancialAnalyzerHelpers.detect_temporal_anomalies(expenses))
+
+
+def anomaly_key(anomaly):
+    """Identity of an anomaly independent of output order"""
+    return (anomaly["type"], anomaly.get("transaction_id"), anomaly.get("merchant"),
+            anomaly.get("category") if anomaly["type"] == "category_spending_anomaly" else None,
+            anomaly.get("month"), anomaly.get("z_score"))
+
+
+def test_matches_reference(transactions):
+    """Engine output equals the reference detectors"""
+    engine = AnomalyEngine()
+    print(f"\n🔍 Testing batch detection ({'numpy' if engine.vectorized else 'pure python'})...")
+
+    expected = sorted(map(anomaly_key, reference_anomalies(transactions)), key=repr)
+    actual = sorted(map(anomaly_key, engine.detect(transactions)), key=repr)
+
+    assert actual == expected, f"{len(actual)} anomalies vs {len(expected)} expected"
+    print(f"   ✅ {len(actual)} anomalies match the reference detectors")
+
+
+def test_rolling_mode(transactions):
+    """A new outlier is flagged against the rolling baseline; a typical one is not"""
+    print("\n🌊 Testing rolling detection...")
+    detector = RollingAnomalyDetector()
+    detector.seed(transactions)
+
+    now = datetime.now(timezone.utc).isoformat()
+    outlier = detector.observe({"id": "new_1", "amount": -95000, "category": "Food & Dining", "date": now})
+    typical = detector.observe({"id": "new_2", "amount": -350, "category": "Food & Dining", "date": now})
+
+    assert outlier is not None and outlier["severity"] == "high"
+    assert typical is None
+    print(f"   ✅ Outlier flagged with z-score {outlier['z_score']}")
+
+
+def test_rolling_window_moments():
+    """Welford add/remove matches a direct computation over the window"""
+    print("\n📏 Testing rolling window moments...")
+    rng = random.Random(3)
+    window = _RollingWindow(50)
+    for _ in range(1000):
+        window.push(1e6 + rng.uniform(0, 5))
+    values = list(window.values)
+    expected = (values[-1] - statistics.mean(values)) / statistics.stdev(values)
+    assert abs(window.z_score(values[-1]) - expected) < 1e-6
+    print(f"   ✅ z-score {expected:.4f} after 950 evictions around a large offset")
+
+
+class FakeStore:
+    """Just the listener hook of the data store"""
+
+    def __init__(self):
+        self.listeners = []
+
+    def add_listener(self, listener):
+        self.listeners.append(listener)
+
+    def publish(self, categories, change):
+        for listener in self.listeners:
+            listener(0, categories, change)
+
+
+def test_attached_detector(transactions):
+    """Store writes feed the baselines; anything but an add forces a reseed"""
+    print("\n🔗 Testing store-attached rolling detection...")
+    store = FakeStore()
+    detector = RollingAnomalyDetector(min_history=2)
+    detector.attach(store)
+    detector.seed(transactions[:1])
+
+    now = datetime.now(timezone.utc).isoformat()
+    typical = {"id": "db_1", "amount": "-300", "category": "Travel", "date": now}
+    assert detector.score(typical) is None
+    store.publish(["transactions"], {"added": typical})
+    store.publish(["transactions"], {"added": dict(typical, id="db_2", amount=-310)})
+    store.publish(["transactions"], {"added": dict(typical, id="db_3", amount=-290)})
+    assert detector.score(dict(typical, id="new", amount=-90000))["type"] == "category_amount_anomaly"
+
+    store.publish(["accounts"], None)
+    assert detector.seeded
+    store.publish(["transactions"], {"deleted": typical})
+    assert not detector.seeded and detector.score(dict(typical, amount=-90000)) is None
+    print("   ✅ Added rows joined the baselines; a delete reset them for reseeding")
+
+
+def test_string_amounts(engine):
+    """Unparseable and string amounts are coerced, not compared raw"""
+    print("\n🔢 Testing amount coercion...")
+    now = datetime.now(timezone.utc)
+    rows = [{"id": f"s_{i}", "amount": "-120.5" if i % 2 else -130, "description": "Shop",
+             "category": "Shopping", "date": (now - timedelta(days=i)).isoformat()} for i in range(20)]
+    rows.append({"id": "bad", "amount": "n/a", "description": "Shop", "category": "Shopping",
+                 "date": now.isoformat()})
+    engine.detect(rows)
+    assert rows[1]["amount"] == "-120.5"
+    print("   ✅ Mixed amount types detected without touching the input")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Anomaly Engine Tests")
+    print("=" * 50)
+
+    transactions = create_transactions()
+    test_matches_reference(transactions)
+    test_rolling_mode(transactions)
+    test_rolling_window_moments()
+    test_attached_detector(transactions)
+    test_string_amounts(AnomalyEngine())
+    print("\n🎉 All anomaly engine tests passed")
+
+
+if __name__ == "__main__":
+    main()
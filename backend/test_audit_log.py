@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Test script for the background audit log writer
+Covers batched writes, daily rotation, indexed paging by user and time and
+concurrent writer processes sharing one directory
+"""
+import sys
+import os
+import asyncio
+import multiprocessing
+import tempfile
+import shutil
+import time
+from datetime import datetime, timezone, timedelta
+from pathlib import Path
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.audit_log import AuditLogWriter
+from services.enhanced_privacy_service import EnhancedPrivacyService, AuditAction, AUDIT_MEMORY_LIMIT
+
+START = datetime(2024, 3, 1, 23, 0, tzinfo=timezone.utc)
+
+
+def _record(user_id, index, action="data_accessed"):
+    return {
+        "id": f"{user_id}_{index}",
+        "user_id": user_id,
+        "action": action,
+        "timestamp": (START + timedelta(minutes=index)).isoformat(),
+        "categories": ["transactions"] if action == "data_accessed" else [],
+    }
+
+
+def test_batching_and_rotation(temp_dir):
+    """Records are written in batches, rotated by day and paged from the index"""
+    print("\n📝 Testing batched audit writes...")
+    writer = AuditLogWriter(temp_dir, batch_size=50, flush_interval=60)
+    for index in range(120):
+        writer.submit(_record("user_1", index))
+        writer.submit(_record("user_2", index, "permission_changed"))
+    assert writer.flush(timeout=10)
+    stats = writer.get_stats()
+    assert stats["written"] == 240 and stats["pending"] == 0 and stats["batches"] <= 6
+
+    days = sorted(path.name for path in Path(temp_dir).glob("audit_*.jsonl"))
+    assert days == [f"audit_2024-03-01_{os.getpid()}.jsonl", f"audit_2024-03-02_{os.getpid()}.jsonl"]
+
+    page = writer.query("user_1", limit=10, offset=5)
+    assert [record["id"] for record in page] == [f"user_1_{i}" for i in range(114, 104, -1)]
+
+    window = writer.query("user_1", limit=100, since=START + timedelta(minutes=30),
+                          until=START + timedelta(minutes=69, seconds=59))
+    assert len(window) == 40 and writer.count("user_1", since=START + timedelta(minutes=60)) == 60
+    assert writer.query("user_2", actions=["data_accessed"]) == []
+
+    summary = writer.summary("user_1")
+    assert summary["total_entries"] == 120 and summary["categories_accessed"] == ["transactions"]
+    assert summary["last_entry"] == START + timedelta(minutes=119)
+    writer.close()
+    print(f"   ✅ 240 records in {stats['batches']} batches across {len(days)} daily files")
+
+
+def test_time_based_flush(temp_dir):
+    """A partial batch is written once the flush interval elapses"""
+    print("\n⏲️  Testing time-based flushing...")
+    writer = AuditLogWriter(temp_dir, batch_size=1000, flush_interval=0.05)
+    writer.submit(_record("user_3", 0))
+    time.sleep(0.3)
+    assert writer.get_stats()["written"] == 1
+    writer.close()
+
+    # A new writer reads the same index
+    reopened = AuditLogWriter(temp_dir)
+    assert reopened.count("user_3") == 1
+    reopened.close()
+    print("   ✅ Partial batch flushed on time and visible after reopening")
+
+
+def _write_from_worker(temp_dir, user_id):
+    writer = AuditLogWriter(temp_dir, batch_size=7, flush_interval=60)
+    for index in range(200):
+        writer.submit(_record(user_id, index))
+    writer.close()
+
+
+def test_concurrent_workers(temp_dir):
+    """Writer processes sharing a directory index offsets into their own files"""
+    print("\n👥 Testing concurrent writer processes...")
+    workers = [multiprocessing.Process(target=_write_from_worker, args=(temp_dir, f"worker_{index}"))
+               for index in range(3)]
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join(timeout=30)
+        assert worker.exitcode == 0
+
+    reader = AuditLogWriter(temp_dir)
+    for index in range(3):
+        records = reader.query(f"worker_{index}", limit=500)
+        assert [record["id"] for record in records] == [f"worker_{index}_{i}" for i in range(199, -1, -1)]
+    reader.close()
+    files = len(list(Path(temp_dir).glob("audit_*.jsonl")))
+    print(f"   ✅ 600 records from 3 processes read back intact from {files} files")
+
+
+async def test_service_paging(temp_dir):
+    """The privacy service keeps a bounded trail in memory and pages from disk"""
+    print("\n📚 Testing audit trail paging...")
+    service = EnhancedPrivacyService(audit_storage_path=temp_dir)
+    await service.create_privacy_profile("user_4")
+    for index in range(3 * AUDIT_MEMORY_LIMIT):
+        await service._add_audit_entry("user_4", AuditAction.DATA_ACCESSED, category_id="accounts",
+                                       details={"index": index})
+
+    assert len(service._privacy_profiles["user_4"].audit_trail) <= 2 * AUDIT_MEMORY_LIMIT
+    newest = await service.get_audit_trail("user_4", limit=5)
+    assert [entry["details"]["index"] for entry in newest] == [599, 598, 597, 596, 595]
+    oldest = await service.get_audit_trail("user_4", limit=4, offset=3 * AUDIT_MEMORY_LIMIT - 4)
+    assert [entry["details"]["index"] for entry in oldest] == [3, 2, 1, 0]
+    consent = await service.get_audit_trail("user_4", action_filter=[AuditAction.CONSENT_GIVEN])
+    assert len(consent) == 1
+
+    dashboard = await service.get_privacy_dashboard("user_4")
+    assert dashboard["usage_statistics"]["total_data_accesses"] == 3 * AUDIT_MEMORY_LIMIT
+    assert dashboard["usage_statistics"]["categories_accessed"] == 1
+    service.audit_log.close()
+    print(f"   ✅ {3 * AUDIT_MEMORY_LIMIT} entries paged from disk with a bounded in-memory trail")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Audit Log Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        test_batching_and_rotation(os.path.join(temp_dir, "batched"))
+        test_time_based_flush(os.path.join(temp_dir, "timed"))
+        test_concurrent_workers(os.path.join(temp_dir, "workers"))
+        asyncio.run(test_service_paging(os.path.join(temp_dir, "service")))
+        print("\n🎉 All audit log tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
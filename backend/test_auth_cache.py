@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Test script for the authentication hot path
+Covers the verified-token cache and password hashing on the bounded worker pool
+"""
+import sys
+import os
+import asyncio
+import time
+from datetime import timedelta
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from fastapi import HTTPException
+from security import auth
+from security.auth import SecurityManager, TokenCache, MOCK_USERS, authenticate_user_async
+
+
+def test_token_cache():
+    """Repeat presentations of a token skip signature verification"""
+    print("\n🎟️  Testing verified-token cache...")
+    manager = SecurityManager()
+    token = manager.create_access_token({"sub": "user_1", "username": "user_1"})
+
+    calls = []
+    original_decode = auth.jwt.decode
+
+    def counting_decode(*args, **kwargs):
+        calls.append(1)
+        return original_decode(*args, **kwargs)
+
+    auth.jwt.decode = counting_decode
+    try:
+        for _ in range(50):
+            assert manager.decode_token(token)["sub"] == "user_1"
+        assert len(calls) == 1
+
+        # Callers cannot corrupt the cached payload
+        manager.decode_token(token)["sub"] = "someone_else"
+        assert manager.decode_token(token)["sub"] == "user_1"
+
+        # Tampered tokens never match a cached digest
+        try:
+            manager.decode_token(token[:-2] + "xx")
+            raise AssertionError("tampered token accepted")
+        except HTTPException as e:
+            assert e.status_code == 401
+    finally:
+        auth.jwt.decode = original_decode
+
+    stats = manager.token_cache.get_stats()
+    assert stats["entries"] == 1 and stats["hits"] >= 50
+    print(f"   ✅ 1 signature check for {stats['hits'] + 1} lookups")
+
+
+def test_cache_respects_expiry():
+    """Entries are dropped at the token's own expiry and the LRU stays bounded"""
+    print("\n⌛ Testing token expiry and bounds...")
+    cache = TokenCache(max_entries=3)
+    cache.put(b"short", {"sub": "a", "exp": time.time() + 0.05})
+    cache.put(b"none", {"sub": "b"})
+    assert cache.get(b"short")["sub"] == "a" and cache.get(b"none") is None
+    time.sleep(0.1)
+    assert cache.get(b"short") is None
+
+    for index in range(5):
+        cache.put(bytes([index]), {"sub": str(index), "exp": time.time() + 60})
+    assert cache.get_stats()["entries"] == 3 and cache.get(bytes([0])) is None
+
+    manager = SecurityManager()
+    expired = manager.create_access_token({"sub": "user_2"}, expires_delta=timedelta(seconds=-1))
+    try:
+        manager.decode_token(expired)
+        raise AssertionError("expired token accepted")
+    except HTTPException as e:
+        assert e.detail == "Token has expired"
+    print("   ✅ Expired entries evicted, cache capped at 3")
+
+
+async def test_hashing_off_loop():
+    """bcrypt work runs on the pool while the event loop keeps ticking"""
+    print("\n🔐 Testing password hashing pool...")
+    manager = auth.security_manager
+    original_verify = manager.pwd_context.verify
+
+    def slow_verify(password, hashed):
+        time.sleep(0.05)
+        return original_verify(password, hashed)
+
+    manager.pwd_context.verify = slow_verify
+    try:
+        ticks = 0
+
+        async def ticker():
+            nonlocal ticks
+            while True:
+                ticks += 1
+                await asyncio.sleep(0.005)
+
+        ticking = asyncio.create_task(ticker())
+        users = await asyncio.gather(*[authenticate_user_async("demo_user", "demo_password") for _ in range(8)])
+        ticking.cancel()
+        assert all(user and user["user_id"] == "demo_user" for user in users)
+        assert await authenticate_user_async("demo_user", "wrong") is None
+        assert ticks >= 10, ticks
+
+        # Past the pending cap requests are shed instead of queueing
+        limit = auth.PASSWORD_HASH_MAX_PENDING
+        auth.PASSWORD_HASH_MAX_PENDING = 2
+        results = await asyncio.gather(
+            *[manager.verify_password_async("demo_password", MOCK_USERS["demo_user"]["hashed_password"])
+              for _ in range(5)],
+            return_exceptions=True
+        )
+        auth.PASSWORD_HASH_MAX_PENDING = limit
+        shed = [r for r in results if isinstance(r, HTTPException)]
+        assert len(shed) == 3 and shed[0].status_code == 503
+        assert results.count(True) == 2 and manager._hash_pending == 0
+    finally:
+        manager.pwd_context.verify = original_verify
+    print(f"   ✅ 8 logins verified off-loop ({ticks} loop ticks), 3 of 5 shed past the cap")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Auth Cache Tests")
+    print("=" * 50)
+
+    test_token_cache()
+    test_cache_respects_expiry()
+    asyncio.run(test_hashing_off_loop())
+    print("\n🎉 All auth cache tests passed")
+
+
+if __name__ == "__main__":
+    main()
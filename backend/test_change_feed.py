@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+Test script for the data change feed and the update stream
+Covers transaction deltas with their aggregates, reload events, backlog
+catch-up and resyncs, subscriber fan-out and the server-sent event stream
+"""
+import sys
+import os
+import asyncio
+import json
+import shutil
+import tempfile
+
+# Add the backend directory to Python path; the feed and router use the
+# app package's relative imports
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from app.services.data_store import DataStore
+from app.services.change_feed import ChangeFeed
+from app.models.requests import Permissions
+
+NEW_TRANSACTION = {"id": "txn_feed", "date": "2024-01-25T09:00:00Z", "amount": -42.0,
+                   "description": "Feed test", "category": "Food & Dining"}
+
+
+def test_transaction_deltas(temp_dir):
+    """Writes become deltas carrying the rows and the aggregates they touched"""
+    print("\n🧾 Testing transaction deltas...")
+    store = DataStore(temp_dir)
+    feed = ChangeFeed(store)
+    store.load()
+    assert feed.since(0)[0]["type"] == "reload" and feed.since(0)[0]["categories"]
+
+    store.add_transaction(NEW_TRANSACTION)
+    event = feed.since(store.version - 1)[0]
+    assert event["type"] == "transactions" and event["version"] == store.version
+    assert event["added"] == [NEW_TRANSACTION] and not event["updated"] and not event["removed"]
+
+    month = store.aggregates().monthly_flows()
+    january = next(row for row in month if row["month"] == "2024-01")
+    assert event["months"] == [{"month": "2024-01", "income": round(january["income"], 2),
+                                "expenses": round(january["expenses"], 2),
+                                "net_flow": round(january["net_flow"], 2)}]
+    assert event["days"][0]["date"] == "2024-01-25" and event["days"][0]["expenses"] >= 42.0
+    assert event["categories"] == {
+        "Food & Dining": round(store.aggregates().category_expenses()["Food & Dining"], 2)
+    }
+    assert event["summary"] == store.aggregates().summary()
+
+    store.update_transaction("txn_feed", {"category": "Shopping", "date": "2024-02-02T09:00:00Z"})
+    moved = feed.since(store.version - 1)[0]
+    assert [row["month"] for row in moved["months"]] == ["2024-01", "2024-02"]
+    assert set(moved["categories"]) == {"Food & Dining", "Shopping"}
+
+    store.delete_transaction("txn_feed")
+    removed = feed.since(store.version - 1)[0]
+    assert removed["removed"] == ["txn_feed"]
+    print(f"   ✅ Add, move and delete each produced one delta ({len(json.dumps(event))} bytes)")
+    return store
+
+
+def test_backlog_and_resync(temp_dir):
+    """Clients catch up from the backlog, or are told to refetch when it is gone"""
+    print("\n⏪ Testing backlog catch-up and resync...")
+    store = DataStore(temp_dir)
+    store.load()
+    feed = ChangeFeed(store, max_backlog=3)
+    start = store.version
+    assert feed.since(start) == [] and feed.since(start - 1) is None
+
+    for index in range(5):
+        store.add_transaction({**NEW_TRANSACTION, "id": f"txn_backlog_{index}"})
+    assert [event["version"] for event in feed.since(start + 2)] == [start + 3, start + 4, start + 5]
+    assert feed.since(start + 1) is None and feed.since(store.version + 1) is None
+    print("   ✅ Last 3 versions replayed; older and future versions resync")
+
+
+async def fan_out(store, feed):
+    queue = feed.subscribe()
+    await asyncio.to_thread(store.add_transaction, {**NEW_TRANSACTION, "id": "txn_thread"})
+    event = await asyncio.wait_for(queue.get(), 2)
+    assert event["added"][0]["id"] == "txn_thread"
+
+    for index in range(300):
+        store.add_transaction({**NEW_TRANSACTION, "id": f"txn_burst_{index}"})
+    await asyncio.sleep(0)
+    items = []
+    while not queue.empty():
+        items.append(queue.get_nowait())
+    feed.unsubscribe(queue)
+    assert None in items
+    assert feed.get_stats()["overflows"] >= 1 and feed.get_stats()["subscribers"] == 0
+
+
+def test_fan_out(temp_dir):
+    """Writes from worker threads reach loop-bound subscribers; a slow one resyncs"""
+    print("\n📡 Testing subscriber fan-out...")
+    store = DataStore(temp_dir)
+    store.load()
+    asyncio.run(fan_out(store, ChangeFeed(store)))
+    print("   ✅ Cross-thread delivery works; overflowing subscriber got a resync marker")
+
+
+class _Request:
+    def __init__(self, headers):
+        self.headers = headers
+        self.polls = 0
+
+    async def is_disconnected(self):
+        self.polls += 1
+        return self.polls > 2
+
+
+async def read_stream(updates, request, since, permissions):
+    response = await updates.stream_updates(request, since=since, permissions=permissions)
+    chunks = []
+    async for chunk in response.body_iterator:
+        chunks.append(chunk)
+        if len(chunks) == 2:
+            # A write while the stream is open arrives as the next event
+            updates.change_feed.store.add_transaction({**NEW_TRANSACTION, "id": "txn_live"})
+    return response, "".join(chunks)
+
+
+def test_update_stream():
+    """The SSE endpoint replays from Last-Event-ID, streams live deltas and honours permissions"""
+    print("\n🌊 Testing update stream endpoint...")
+    from app.routers import updates
+
+    store = updates.change_feed.store
+    store.load()
+    base = store.version
+    store.add_transaction({**NEW_TRANSACTION, "id": "txn_stream"})
+    everything = updates.get_default_permissions()
+
+    response, body = asyncio.run(read_stream(updates, _Request({"last-event-id": str(base)}), None, everything))
+    assert response.media_type == "text/event-stream"
+    blocks = [block for block in body.split("\n\n") if block]
+    assert blocks[0].startswith("event: hello")
+    assert blocks[1] == f"id: {base + 1}\nevent: transactions\ndata: " + blocks[1].split("data: ", 1)[1]
+    assert json.loads(blocks[1].split("data: ", 1)[1])["added"][0]["id"] == "txn_stream"
+    assert json.loads(blocks[2].split("data: ", 1)[1])["added"][0]["id"] == "txn_live"
+
+    restricted = Permissions(accounts=True)
+    _, body = asyncio.run(read_stream(updates, _Request({}), base, restricted))
+    hidden_block = body.split("\n\n")[1]
+    hidden = json.loads(hidden_block.split("data: ", 1)[1])
+    assert hidden["type"] == "version" and "added" not in hidden
+    assert "\nevent: version\n" in hidden_block, hidden_block
+
+    rows_only = Permissions(transactions=True)
+    _, body = asyncio.run(read_stream(updates, _Request({}), base, rows_only))
+    partial = json.loads(body.split("\n\n")[1].split("data: ", 1)[1])
+    assert partial["added"][0]["id"] == "txn_stream"
+    assert partial["months"] == [] and partial["days"] == [] and partial["categories"] == {}
+    trends = updates._visible(updates.change_feed.since(base)[0],
+                              Permissions(transactions=True, spending_trends=True))
+    assert trends["months"] and trends["days"] and trends["categories"] == {}
+
+    _, body = asyncio.run(read_stream(updates, _Request({}), store.version + 10, everything))
+    assert "event: resync" in body
+    print("   ✅ Replayed from Last-Event-ID, live delta streamed, rows and aggregates hidden without permission")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Change Feed Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        data_dir = os.path.join(temp_dir, "data")
+        shutil.copytree(os.path.join(os.path.dirname(__file__), "data"), data_dir)
+        test_transaction_deltas(data_dir)
+        test_backlog_and_resync(data_dir)
+        test_fan_out(data_dir)
+        test_update_stream()
+        print("\n🎉 All change feed tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
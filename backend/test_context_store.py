@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Test script for the bounded conversation context store
+Covers LRU/TTL eviction, ring-buffer history, the SQLite spill and its
+JSON write-through
+"""
+import sys
+import os
+import tempfile
+import shutil
+import json
+import sqlite3
+import time
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from services.context_store import ContextStore, ChatHistoryStore, SQLiteSpill
+
+
+class Session:
+    def __init__(self, user_id):
+        self.user_id = user_id
+        self.turns = 0
+
+    def to_dict(self):
+        return {"user_id": self.user_id, "turns": self.turns}
+
+    @classmethod
+    def from_dict(cls, data):
+        session = cls(data["user_id"])
+        session.turns = data["turns"]
+        return session
+
+
+def test_lru_and_ttl():
+    """The session budget holds and idle sessions expire"""
+    print("\n🗂️  Testing context eviction...")
+    store = ContextStore("test", max_sessions=3, ttl_seconds=3600)
+    for index in range(5):
+        store.get_or_create(f"user_{index}", None, lambda: Session(index)).turns += 1
+    assert len(store) == 3
+    assert store.get("user_0") is None and store.get("user_4").turns == 1
+
+    expiring = ContextStore("test", max_sessions=10, ttl_seconds=0.05)
+    expiring.get_or_create("user_1", "s1", lambda: Session("user_1"))
+    time.sleep(0.1)
+    assert expiring.get("user_1", "s1") is None
+    assert expiring.get_stats()["expirations"] == 1
+    print(f"   ✅ {store.get_stats()['evictions']} LRU evictions, idle session expired")
+
+
+def test_spill_and_history(temp_dir):
+    """Evicted sessions and chat history come back from SQLite"""
+    print("\n💽 Testing SQLite spill...")
+    path = os.path.join(temp_dir, "contexts.db")
+    spill = SQLiteSpill(path)
+    store = ContextStore("test", max_sessions=2, spill=spill, from_dict=Session.from_dict)
+    first = store.get_or_create("user_1", "s1", lambda: Session("user_1"))
+    first.turns = 7
+    store.get_or_create("user_2", None, lambda: Session("user_2"))
+    store.get_or_create("user_3", None, lambda: Session("user_3"))
+    assert len(store) == 2
+
+    reloaded = store.get("user_1", "s1")
+    assert reloaded is not None and reloaded.turns == 7
+    assert store.get_stats()["reloads"] == 1
+    store.discard("user_1", "s1")
+    assert store.get("user_1", "s1") is None
+
+    history = ChatHistoryStore(limit=3, spill=spill)
+    for index in range(5):
+        history.append("user_1", {"id": index})
+    history.append("user_2", {"id": "other"})
+    assert [entry["id"] for entry in history.recent("user_1", 10)] == [2, 3, 4]
+    assert history.recent("user_1", 2) == [{"id": 3}, {"id": 4}]
+
+    store.flush()
+    spill.close()
+
+    # A new process sees the same state
+    spill = SQLiteSpill(path)
+    restored = ContextStore("test", spill=spill, from_dict=Session.from_dict)
+    assert restored.get("user_2").user_id == "user_2"
+    history = ChatHistoryStore(limit=3, spill=spill)
+    assert [entry["id"] for entry in history.recent("user_1")] == [2, 3, 4]
+    assert history.count("user_2") == 1
+    history.clear("user_1")
+    assert ChatHistoryStore(limit=3, spill=spill).count("user_1") == 0
+    spill.close()
+    print("   ✅ Sessions and history survive eviction and restart")
+
+
+def test_write_through(temp_dir):
+    """Saved contexts reach SQLite as JSON without a flush, and bad rows are dropped"""
+    print("\n✍️  Testing context write-through...")
+    path = os.path.join(temp_dir, "write_through.db")
+    spill = SQLiteSpill(path)
+    store = ContextStore("test", spill=spill, from_dict=Session.from_dict)
+    session = store.get_or_create("user_1", None, lambda: Session("user_1"))
+    session.turns = 3
+    store.save("user_1", None, session)
+
+    # A crashed worker never flushes; the next one still sees the update
+    restarted = ContextStore("test", spill=SQLiteSpill(path), from_dict=Session.from_dict)
+    assert restarted.get("user_1").turns == 3
+
+    conn = sqlite3.connect(path)
+    state = conn.execute("SELECT state FROM contexts WHERE key = 'user_1:default'").fetchone()[0]
+    assert state == '{"user_id": "user_1", "turns": 3}', state
+    conn.execute("INSERT INTO contexts VALUES ('test', 'user_2:default', ?, 0)", (b"\x80\x04not json",))
+    conn.commit()
+    conn.close()
+    assert restarted.get("user_2") is None and spill.load_context("test", "user_2:default") is None
+
+    try:
+        ContextStore("test", spill=spill)
+        raise AssertionError("a spilled store without from_dict was accepted")
+    except ValueError:
+        pass
+
+    try:
+        from app.services.enhanced_nlp_service import ConversationContext, Entity
+        from app.services.enhanced_ai_service import ResponseContext
+    except ImportError as e:
+        print(f"   ⚠️ Skipped service contexts: {e}")
+    else:
+        conversation = ConversationContext("user_1", "s1", previous_intents=["spending_analysis"],
+                                           mentioned_entities={"category": [Entity("category", "food", 0.9)]},
+                                           turn_count=2)
+        restored = ConversationContext.from_dict(json.loads(json.dumps(conversation.to_dict())))
+        assert restored == conversation
+        response = ResponseContext("user_1", "s1", risk_tolerance="high", response_history=[{"query": "q"}])
+        assert ResponseContext.from_dict(json.loads(json.dumps(response.to_dict()))) == response
+    spill.close()
+    print("   ✅ Updates persist immediately as JSON; unreadable rows are discarded")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Context Store Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        test_lru_and_ttl()
+        test_spill_and_history(temp_dir)
+        test_write_through(temp_dir)
+        print("\n🎉 All context store tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
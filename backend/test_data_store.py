@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Test script for the shared, change-aware data store
+Verifies single load, per-file change detection, read-only snapshots,
+categories served from another source than their file and per-version
+column views
+"""
+import sys
+import os
+import json
+import time
+import shutil
+import tempfile
+from pathlib import Path
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.data_store import DataStore, DATA_FILES, get_data_store
+from services.transaction_store import get_transaction_columns
+
+
+def create_data_dir() -> Path:
+    """Create a temporary data directory with every data file"""
+    data_dir = Path(tempfile.mkdtemp())
+    for key, filename in DATA_FILES.items():
+        value = {} if key in ("epf_balance", "credit_score") else []
+        if key == "transactions":
+            value = [{"id": "txn_1", "date": "2024-01-01T00:00:00Z", "amount": -100, "category": "food"}]
+        with open(data_dir / filename, "w", encoding="utf-8") as f:
+            json.dump(value, f)
+    return data_dir
+
+
+def test_initial_load(data_dir: Path):
+    """Loading publishes every category and version 1"""
+    print("\n📂 Testing initial load...")
+    store = DataStore(str(data_dir), refresh_interval=0)
+    snapshot = store.load()
+
+    assert set(snapshot.keys()) == set(DATA_FILES.keys())
+    assert store.version == 1
+    assert len(snapshot["transactions"]) == 1
+    print(f"   ✅ Loaded {len(snapshot)} categories at version {store.version}")
+    return store
+
+
+def test_unchanged_files_not_reloaded(store: DataStore):
+    """Refreshing without changes keeps the same snapshot object"""
+    print("\n♻️  Testing unchanged refresh...")
+    before = store.snapshot()
+    changed = store.refresh(force=True)
+
+    assert not changed
+    assert store.snapshot() is before
+    assert store.version == 1
+    print("   ✅ No files re-parsed when nothing changed")
+
+
+def test_changed_file_reloaded(store: DataStore, data_dir: Path):
+    """Only the modified file is reloaded and the version bumps"""
+    print("\n📝 Testing per-file reload...")
+    before = store.snapshot()
+
+    # Ensure the mtime or size changes even on coarse filesystem clocks
+    time.sleep(0.01)
+    with open(data_dir / "transactions.json", "w", encoding="utf-8") as f:
+        json.dump([{"id": "txn_1"}, {"id": "txn_2"}], f)
+
+    assert store.refresh(force=True)
+    after = store.snapshot()
+
+    assert store.version == 2
+    assert len(after["transactions"]) == 2
+    assert after["accounts"] is before["accounts"]
+    assert len(before["transactions"]) == 1
+    print("   ✅ Only transactions.json re-parsed; old snapshot unaffected")
+
+
+def test_snapshot_is_read_only(store: DataStore):
+    """Snapshots reject top-level writes"""
+    print("\n🔒 Testing read-only snapshot...")
+    snapshot = store.snapshot()
+    try:
+        snapshot["transactions"] = []
+        raise AssertionError("Snapshot accepted a write")
+    except TypeError:
+        pass
+    print("   ✅ Snapshot is immutable")
+
+
+def test_external_source(data_dir: Path):
+    """A category loaded from another source stops following its file"""
+    print("\n🗄️ Testing externally sourced transactions...")
+    store = DataStore(str(data_dir))
+    store.load()
+    store.load_external("transactions", [{"id": "db_1", "amount": -30.0, "date": "2024-01-05"}], "database")
+    assert [t["id"] for t in store.snapshot()["transactions"]] == ["db_1"]
+    assert store.aggregates().summary()["transaction_count"] == 1
+
+    time.sleep(0.01)
+    with open(data_dir / "transactions.json", "w", encoding="utf-8") as f:
+        json.dump([{"id": "file_1"}, {"id": "file_2"}, {"id": "file_3"}], f)
+    version = store.version
+    store.refresh(force=True)
+    assert store.version == version and [t["id"] for t in store.snapshot()["transactions"]] == ["db_1"]
+    print("   ✅ Database rows served; transactions.json changes ignored")
+
+
+def test_columns_follow_versions(data_dir: Path):
+    """Analyses share one column view per version; a write retires the old one"""
+    print("\n🧮 Testing column views per version...")
+    store = DataStore(str(data_dir))
+    store.load_external("transactions", [{"id": "db_1", "amount": -30.0, "date": "2024-01-05"}], "database")
+    old_list = store.snapshot()["transactions"]
+    columns = store.transaction_columns()
+    assert get_transaction_columns(old_list) is columns and store.transaction_columns() is columns
+
+    store.add_transaction({"id": "db_2", "amount": -12.0, "date": "2024-01-06"})
+    assert [t["id"] for t in store.transaction_columns().records] == ["db_1", "db_2"]
+    assert get_transaction_columns(old_list) is not columns
+    print("   ✅ Columns shared within a version and rebuilt after a write")
+
+
+def test_shared_instance(data_dir: Path):
+    """The same directory always maps to one store"""
+    print("\n🔗 Testing shared store registry...")
+    assert get_data_store(str(data_dir)) is get_data_store(str(data_dir) + "/")
+    print("   ✅ One store per data directory")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Data Store Tests")
+    print("=" * 50)
+
+    data_dir = create_data_dir()
+    try:
+        store = test_initial_load(data_dir)
+        test_unchanged_files_not_reloaded(store)
+        test_changed_file_reloaded(store, data_dir)
+        test_snapshot_is_read_only(store)
+        test_external_source(data_dir)
+        test_columns_follow_versions(data_dir)
+        test_shared_instance(data_dir)
+        print("\n🎉 All data store tests passed")
+    finally:
+        shutil.rmtree(data_dir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    main()
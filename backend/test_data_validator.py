@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Test script for compiled and parallel bulk validation
+Checks that the process pool path matches in-process validation and that
+validation never mutates the records it is given
+"""
+import sys
+import os
+import asyncio
+import copy
+import random
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services import data_validator
+from services.data_validator import DataValidator, bitmap_indexes
+
+
+def create_transactions(count: int = 5000):
+    """Create transactions with a reproducible share of invalid records"""
+    rng = random.Random(11)
+    transactions = []
+    for i in range(count):
+        transactions.append({
+            "id": f"txn_{i}",
+            "date": "2023-12-01T10:00:00Z",
+            "amount": rng.choice([-1500.0, -250.5, 42000, "not_a_number"]),
+            "description": rng.choice(["Grocery Shopping", "Salary Credit", ""]),
+            "category": rng.choice(["Groceries", "fuel", "Shopping"])
+        })
+    return transactions
+
+
+def strip_timestamps(records):
+    """Drop the per-record processing timestamp before comparing"""
+    return [{k: v for k, v in record.items() if k != "processed_at"} for record in records]
+
+
+def test_parallel_matches_serial(validator, transactions):
+    """Pool validation returns the same bitmap, records and errors"""
+    print("\n⚙️ Testing parallel bulk validation...")
+    serial = validator.validate_bulk_indexed(transactions, "transaction", parallel=False)
+    parallel = validator.validate_bulk_indexed(transactions, "transaction", parallel=True)
+
+    assert serial["valid_bitmap"] == parallel["valid_bitmap"]
+    assert serial["errors"] == parallel["errors"]
+    assert strip_timestamps(serial["normalized"]) == strip_timestamps(parallel["normalized"])
+
+    # Every validator submits to the one spawned pool
+    pool = data_validator._pool
+    assert pool is not None and pool._mp_context.get_start_method() == "spawn"
+    DataValidator(max_workers=2).validate_bulk_indexed(transactions, "transaction", parallel=True)
+    assert data_validator._pool is pool
+    print(f"   ✅ {parallel['valid_count']}/{parallel['total_count']} valid in both modes")
+
+
+def test_bitmap_and_legacy_results(validator, transactions):
+    """The bitmap marks exactly the valid items and validate_bulk_data agrees"""
+    print("\n🗺️ Testing index bitmap...")
+    indexed = validator.validate_bulk_indexed(transactions, "transaction")
+    expected = [i for i, t in enumerate(transactions)
+                if isinstance(t["amount"], (int, float)) and t["description"]]
+
+    assert list(bitmap_indexes(indexed["valid_bitmap"], indexed["total_count"])) == expected
+    assert all(item["category"] in ("food_dining", "transportation", "shopping")
+               for item in indexed["normalized"])
+
+    legacy = validator.validate_bulk_data(transactions, "transaction")
+    assert [item["index"] for item in legacy["valid_items"]] == expected
+    assert legacy["invalid_count"] == len(transactions) - len(expected)
+    print(f"   ✅ Bitmap matches {len(expected)} valid items")
+
+
+def test_inputs_not_mutated(validator, transactions):
+    """Warnings go on copies, so shared snapshot records stay untouched"""
+    print("\n🧊 Testing that validation leaves its input alone...")
+    records = transactions[:200]
+    original = copy.deepcopy(records)
+    validated = asyncio.run(validator.validate_transactions(records))
+
+    assert records == original
+    flagged = [item for item in validated if "validation_warnings" in item]
+    assert flagged and all(item is not record for item in flagged for record in records)
+
+    # The per-type helpers are built from the bulk result, in input order
+    bulk = validator.validate_bulk_indexed(records, "transaction")
+    assert len(validated) == len(records) and len(flagged) == bulk["invalid_count"]
+    assert strip_timestamps([item for item in validated if "validation_warnings" not in item]) == \
+        strip_timestamps(bulk["normalized"])
+    assert [item["id"] for item in validated] == [record["id"] for record in records]
+    print(f"   ✅ {len(flagged)} invalid records flagged on copies")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Data Validator Tests")
+    print("=" * 50)
+
+    validator = DataValidator(max_workers=2, parallel_threshold=1000, batch_size=512)
+    transactions = create_transactions()
+    try:
+        test_parallel_matches_serial(validator, transactions)
+        test_bitmap_and_legacy_results(validator, transactions)
+        test_inputs_not_mutated(validator, transactions)
+    finally:
+        data_validator.shutdown_validation_pool()
+    print("\n🎉 All data validator tests passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Test script for the batched debt payoff simulator
+Covers closed-form amortization, strategy ordering and the what-if sweep
+"""
+import sys
+import os
+import time
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services import debt_engine
+from services.debt_engine import DebtPayoffSimulator, amortize, build_debt_set, simulate_payoff
+from services.financial_analyzer import FinancialAnalyzer
+
+
+DEBTS = [
+    {"id": "cc", "name": "Credit Card", "balance": 80000, "interest_rate": 36, "minimum_payment": 4000},
+    {"id": "pl", "name": "Personal Loan", "balance": 200000, "interest_rate": 14, "minimum_payment": 6000},
+    {"id": "sl", "name": "Store Loan", "balance": 15000, "interest_rate": 0, "minimum_payment": 1000},
+]
+
+
+def test_closed_form_matches_simulation():
+    """The amortization formula agrees with a month-by-month run of one debt"""
+    print("\n🧮 Testing closed-form amortization...")
+    debt_set = build_debt_set([{"balance": 100000, "interest_rate": 12, "minimum_payment": 3000}])
+    simulated = simulate_payoff(debt_set, [3000], [[0]])
+    months, interest = amortize(100000, 0.01, 3000)
+    assert months == simulated.months[0] == 41, (months, simulated.months)
+    assert abs(interest - simulated.interest[0]) < 0.05
+    assert abs(simulated.total_paid[0] - 100000 - interest) < 0.05
+
+    # Payments at or below the monthly interest never clear the debt
+    assert amortize(100000, 0.01, 1000)[0] is None
+    assert amortize(12000, 0, 1000) == (12, 0)
+    print(f"   ✅ 41 months, ₹{interest:,.2f} interest both ways")
+
+
+def test_strategy_ordering():
+    """Avalanche pays less interest, snowball clears the smallest debt first"""
+    print("\n🏔️  Testing avalanche vs snowball...")
+    simulator = DebtPayoffSimulator()
+    avalanche = simulator.plan(DEBTS, 5000, "avalanche")
+    snowball = simulator.plan(DEBTS, 5000, "snowball")
+
+    assert avalanche["total_interest"] < snowball["total_interest"]
+    assert snowball["payoff_order"][0]["id"] == "sl"
+    assert avalanche["strategy_comparison"] == snowball["strategy_comparison"]
+    assert avalanche["interest_saved"] > 0
+    assert avalanche["baseline"]["months_to_payoff"] > avalanche["months_to_payoff"]
+
+    schedule = avalanche["schedule"]
+    assert len(schedule) == avalanche["months_to_payoff"] and schedule[-1]["remaining_balance"] == 0
+    # Freed-up minimums roll over, so every month but the last pays the full budget
+    assert all(abs(month["total_payment"] - 16000) < 0.01 for month in schedule[:-1])
+    print(f"   ✅ Avalanche ₹{avalanche['total_interest']:,.0f} vs snowball "
+          f"₹{snowball['total_interest']:,.0f} interest")
+
+
+def test_what_if_curve():
+    """More extra payment never takes longer or costs more interest"""
+    print("\n📉 Testing what-if sweep...")
+    simulator = DebtPayoffSimulator()
+    start = time.perf_counter()
+    plan = simulator.plan(DEBTS, 5000, "avalanche")
+    elapsed_ms = (time.perf_counter() - start) * 1000
+
+    for strategy in debt_engine.STRATEGIES:
+        curve = [point for point in plan["what_if"] if point["strategy"] == strategy]
+        assert len(curve) == len(debt_engine.EXTRA_PAYMENT_SWEEP)
+        assert [p["extra_payment"] for p in curve] == sorted(p["extra_payment"] for p in curve)
+        assert [p["months_to_payoff"] for p in curve] == sorted((p["months_to_payoff"] for p in curve), reverse=True)
+        assert [p["total_interest"] for p in curve] == sorted((p["total_interest"] for p in curve), reverse=True)
+    backend = "NumPy" if simulator.vectorized else "pure Python"
+    print(f"   ✅ {len(plan['what_if'])} scenarios in {elapsed_ms:.1f} ms ({backend})")
+
+
+def test_analyzer_integration():
+    """The analyzer keeps its response keys and adds the curve"""
+    print("\n💳 Testing analyzer debt strategy...")
+    liabilities = [{"id": d["id"], "name": d["name"], "balance": d["balance"], "interest_rate": d["interest_rate"],
+                    "monthly_payment": d["minimum_payment"]} for d in DEBTS]
+    result = FinancialAnalyzer().recommend_debt_repayment_strategy(liabilities, 16000, "avalanche")
+    assert "error" not in result, result
+    assert result["total_months_to_payoff"] == len(result["payoff_schedule"])
+    assert result["projected_debt_free_date"] == result["payoff_schedule"][-1]["date"]
+    assert result["what_if"] and result["strategy_comparison"]["snowball"]["months_to_payoff"]
+
+    stuck = FinancialAnalyzer().recommend_debt_repayment_strategy(
+        [{"balance": 1000000, "interest_rate": 24, "monthly_payment": 15000}], 16000)
+    assert stuck["total_months_to_payoff"] is None and stuck["projected_debt_free_date"] is None
+    print("   ✅ Existing keys kept, what-if curve attached")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Debt Engine Tests")
+    print("=" * 50)
+
+    test_closed_form_matches_simulation()
+    test_strategy_ordering()
+    test_what_if_curve()
+    test_analyzer_integration()
+    print("\n🎉 All debt engine tests passed")
+
+
+if __name__ == "__main__":
+    main()
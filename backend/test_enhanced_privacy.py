@@ -511,17 +511,18 @@ class TestEnhancedPrivacySystem:
                     details={"test_entry": i}
                 )
             
-            # Cache should have been flushed
-            cache_size = len(self.privacy_service._audit_cache)
-            assert cache_size < 150, f"Cache should have been flushed, but has {cache_size} entries"
+            # The background writer should catch up with every entry
+            await self.privacy_service.flush_audit_log()
+            pending = self.privacy_service.audit_log.get_stats()["pending"]
+            assert pending == 0, f"Audit log should have been flushed, but has {pending} pending entries"
             
             # Check if audit files were created
             audit_files = list(self.temp_audit_dir.glob("audit_*.jsonl"))
             assert len(audit_files) > 0, "Audit files should have been created"
             
-            print(f"   ✅ Audit cache flushed successfully")
+            print(f"   ✅ Audit log flushed successfully")
             print(f"   ✅ Created {len(audit_files)} audit log files")
-            print(f"   ✅ Current cache size: {cache_size} entries")
+            print(f"   ✅ Pending entries: {pending}")
             
             # Verify audit file content
             if audit_files:
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+Test script for non-blocking, streaming and cached AI responses
+Uses fake models so no API key or network is needed
+"""
+import sys
+import os
+import asyncio
+import time
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.ai_service import AIService
+from services.response_cache import normalize_entities, results_digest
+
+ANALYSIS = {
+    "intent": "get_spending_summary",
+    "analysis_type": "spending_analysis",
+    "results": {"total_spending": 1234.5},
+    "success": True
+}
+
+
+class _Chunk:
+    def __init__(self, text):
+        self.text = text
+
+
+class BlockingModel:
+    """Synchronous SDK surface that sleeps like a slow completion"""
+
+    def __init__(self):
+        self.calls = 0
+        self.prompts = []
+
+    def generate_content(self, prompt, stream=False):
+        self.calls += 1
+        self.prompts.append(prompt)
+        if stream:
+            def chunks():
+                for word in ("Your ", "spending ", "looks ", "fine."):
+                    time.sleep(0.05)
+                    yield _Chunk(word)
+            return chunks()
+        time.sleep(0.3)
+        return _Chunk("  Your spending looks fine.  ")
+
+
+class AsyncModel:
+    """Native async SDK surface"""
+
+    async def generate_content_async(self, prompt, stream=False):
+        if stream:
+            async def chunks():
+                for word in ("Saved ", "", "well."):
+                    await asyncio.sleep(0.01)
+                    yield _Chunk(word)
+            return chunks()
+        return _Chunk("Saved well.")
+
+
+async def _ticks_during(awaitable):
+    """Run an awaitable and count event loop ticks that happened meanwhile"""
+    ticks = 0
+
+    async def ticker():
+        nonlocal ticks
+        while True:
+            await asyncio.sleep(0.01)
+            ticks += 1
+
+    task = asyncio.create_task(ticker())
+    try:
+        result = await awaitable
+    finally:
+        task.cancel()
+    return result, ticks
+
+
+async def test_non_blocking_generation():
+    """A blocking SDK call runs off the event loop"""
+    print("\n⏱️  Testing non-blocking generation...")
+    service = AIService()
+    service.response_cache.invalidate()
+    service.model = BlockingModel()
+
+    response, ticks = await _ticks_during(service.generate_response_async(ANALYSIS, "How much did I spend?"))
+    assert response == "Your spending looks fine."
+    assert ticks >= 10, f"event loop stalled ({ticks} ticks)"
+
+    service.response_cache.invalidate()
+    service.model = AsyncModel()
+    assert await service.generate_response_async(ANALYSIS, "Savings?") == "Saved well."
+    print(f"   ✅ Loop ticked {ticks} times during a 300 ms blocking call")
+
+
+async def test_streaming():
+    """Streams yield pieces in order and fall back without a model"""
+    print("\n📡 Testing streaming responses...")
+    service = AIService()
+
+    service.response_cache.invalidate()
+    service.model = BlockingModel()
+    pieces = [piece async for piece in service.stream_response(ANALYSIS, "How much did I spend?")]
+    assert pieces == ["Your ", "spending ", "looks ", "fine."]
+
+    service.response_cache.invalidate()
+    service.model = AsyncModel()
+    pieces = [piece async for piece in service.stream_response(ANALYSIS, "Savings?")]
+    assert pieces == ["Saved ", "well."]
+
+    service.model = None
+    text = "".join([piece async for piece in service.stream_response(ANALYSIS, "How much did I spend?")])
+    assert text == service._generate_mock_response(ANALYSIS, "How much did I spend?")
+    print("   ✅ Blocking, async and mock models all stream in order")
+
+
+async def test_response_cache():
+    """Near-duplicate queries over unchanged data make one model call"""
+    print("\n💾 Testing response cache...")
+    service = AIService()
+    service.response_cache.invalidate()
+    model = service.model = BlockingModel()
+    food = {"categories": ["food"], "time_periods": [{"type": "current", "period": "month"}]}
+
+    first = await service.generate_response_async(ANALYSIS, "how much did I spend on food this month", food)
+    start = time.perf_counter()
+    again = await service.generate_response_async(
+        dict(ANALYSIS, timestamp="later"), "what did I spend on food this month?",
+        {"time_periods": [{"period": "month", "type": "current"}], "categories": ["food", "food"]}
+    )
+    hit_ms = (time.perf_counter() - start) * 1000
+    assert again == first and model.calls == 1
+
+    streamed = "".join([piece async for piece in service.stream_response(ANALYSIS, "food spend?", food)])
+    assert streamed == first and model.calls == 1
+
+    changed = dict(ANALYSIS, results={"total_spending": 99.0})
+    await service.generate_response_async(changed, "how much did I spend on food this month", food)
+    assert model.calls == 2
+    assert model.prompts[0].split("USER QUERY")[0] == model.prompts[1].split("USER QUERY")[0]
+
+    assert results_digest({"a": 1, "b": [1, 2]}) == results_digest({"b": [1, 2], "a": 1})
+    assert normalize_entities({"percentage": [
+        {"value": 30.0, "confidence": 0.95, "context": {"normalized_value": 0.3}}
+    ]}) == normalize_entities({"percentage": [{"value": 30.0, "context": {"normalized_value": 0.3}}]})
+    print(f"   ✅ 2 model calls for 4 requests; cache hit in {hit_ms:.2f} ms")
+
+
+def test_enhanced_response_key():
+    """Profile fields written into the enhanced prompt separate cached answers"""
+    print("\n🔑 Testing enhanced response cache key...")
+    from services.enhanced_ai_service import EnhancedAIService, ResponseContext, ResponseTone, ResponseComplexity
+
+    service = EnhancedAIService()
+    nlp = {"intent": {"name": "spending_analysis"}, "entities": {"categories": ["food"]}}
+
+    def key(**profile):
+        context = ResponseContext(user_id="u", session_id="s", **profile)
+        return service._response_key(ANALYSIS, nlp, context, ResponseTone.INFORMATIVE, ResponseComplexity.SIMPLE)
+
+    beginner = key()
+    assert key(response_history=["earlier answer"]) == beginner
+    assert key(experience_level="expert") != beginner
+    assert key(risk_tolerance="aggressive") != beginner
+    assert key(conversation_topic="investing") != beginner
+    print("   ✅ Experience level, risk tolerance and topic each change the key")
+
+
+async def main():
+    """Main test runner"""
+    print("🚀 Starting LLM Streaming and Cache Tests")
+    print("=" * 50)
+
+    await test_non_blocking_generation()
+    await test_streaming()
+    await test_response_cache()
+    test_enhanced_response_key()
+    print("\n🎉 All LLM streaming tests passed")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
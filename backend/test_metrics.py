@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+Test script for latency instrumentation and Prometheus exposition
+Drives the metrics middleware with a fake downstream application
+"""
+import sys
+import os
+import asyncio
+import time
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.metrics import (MetricsRegistry, MetricsMiddleware, Sample, cache_samples,
+                              get_metrics_registry, span, timed)
+
+
+class Route:
+    def __init__(self, path):
+        self.path = path
+
+
+async def routed_app(scope, receive, send):
+    """Downstream app that matches /api/items/{item_id} like the router does"""
+    if scope["path"].startswith("/api/items/"):
+        scope["route"] = Route("/api/items/{item_id}")
+        await asyncio.sleep(0.01)
+        status = 200
+    elif scope["path"] == "/api/fail":
+        raise RuntimeError("handler crashed")
+    else:
+        status = 404
+    await send({"type": "http.response.start", "status": status, "headers": []})
+    await send({"type": "http.response.body", "body": b"{}"})
+
+
+async def call(middleware, path):
+    async def receive():
+        return {"type": "http.request", "body": b""}
+
+    async def send(message):
+        pass
+
+    await middleware({"type": "http", "method": "GET", "path": path, "headers": []}, receive, send)
+
+
+def test_route_histograms():
+    """Requests are labelled by route template and status class"""
+    print("\n⏱️  Testing per-route histograms...")
+    registry = MetricsRegistry()
+    middleware = MetricsMiddleware(routed_app, registry=registry)
+
+    async def run():
+        await asyncio.gather(*[call(middleware, f"/api/items/{i}") for i in range(5)])
+        await call(middleware, "/nowhere")
+        await call(middleware, "/metrics")
+        try:
+            await call(middleware, "/api/fail")
+        except RuntimeError:
+            pass
+
+    asyncio.run(run())
+    items = registry.histogram("http_request_duration_seconds", method="GET",
+                               route="/api/items/{item_id}", status="2xx")
+    assert items.count == 5 and items.total >= 0.05
+    assert registry.histogram("http_request_duration_seconds", method="GET",
+                              route="unmatched", status="4xx").count == 1
+    assert registry.histogram("http_request_duration_seconds", method="GET",
+                              route="unmatched", status="5xx").count == 1
+    assert "route=\"/metrics\"" not in registry.render()
+    assert "http_requests_in_progress 0.0" in registry.render()
+    print("   ✅ 5 item requests under one route label, 404 and crash counted, /metrics excluded")
+
+
+def test_stage_spans():
+    """Spans and the decorator record durations and errors per stage"""
+    print("\n🧩 Testing stage spans...")
+    registry = get_metrics_registry()
+
+    with span("test_stage"):
+        time.sleep(0.002)
+    try:
+        with span("test_stage"):
+            raise ValueError("boom")
+    except ValueError:
+        pass
+
+    @timed("test_async_stage")
+    async def slow():
+        await asyncio.sleep(0.01)
+        return 42
+
+    assert asyncio.run(slow()) == 42
+    histogram = registry.histogram("app_stage_duration_seconds", stage="test_stage")
+    assert histogram.count == 2 and histogram.total >= 0.002
+    assert registry.histogram("app_stage_duration_seconds", stage="test_async_stage").total >= 0.01
+
+    text = registry.render()
+    assert 'app_stage_errors_total{stage="test_stage"} 1.0' in text
+    assert 'app_stage_in_progress{stage="test_stage"} 0.0' in text
+    summary = registry.stage_summary()["test_async_stage"]
+    assert summary["count"] == 1 and summary["p50_le_ms"] >= 10
+    print(f"   ✅ 2 sync spans, 1 error, async p50 <= {summary['p50_le_ms']:.0f} ms")
+
+
+def test_exposition_format():
+    """Cumulative buckets, +Inf, escaping and scrape-time collectors"""
+    print("\n📄 Testing Prometheus text format...")
+    registry = MetricsRegistry()
+    for seconds in (0.0005, 0.003, 0.003, 0.2, 60):
+        registry.observe("app_stage_duration_seconds", seconds, stage="x")
+    registry.register_collector(lambda: cache_samples("analysis", {"hits": 3, "coalesced": 1, "misses": 2,
+                                                                   "entries": 4}))
+    registry.register_collector(lambda: [Sample("app_queue_depth", {"queue": 'a"b'}, 7)])
+
+    def broken():
+        raise RuntimeError("collector down")
+    registry.register_collector(broken)
+
+    lines = registry.render().splitlines()
+    assert '# TYPE app_stage_duration_seconds histogram' in lines
+    assert 'app_stage_duration_seconds_bucket{stage="x",le="0.001"} 1' in lines
+    assert 'app_stage_duration_seconds_bucket{stage="x",le="0.005"} 3' in lines
+    assert 'app_stage_duration_seconds_bucket{stage="x",le="30.0"} 4' in lines
+    assert 'app_stage_duration_seconds_bucket{stage="x",le="+Inf"} 5' in lines
+    assert 'app_stage_duration_seconds_count{stage="x"} 5' in lines
+    assert 'app_cache_hits_total{cache="analysis"} 4.0' in lines
+    assert 'app_queue_depth{queue="a\\"b"} 7.0' in lines
+    assert any(line.startswith("app_uptime_seconds ") for line in lines)
+    print("   ✅ Buckets cumulative, labels escaped, failing collector skipped")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Metrics Tests")
+    print("=" * 50)
+
+    test_route_histograms()
+    test_stage_spans()
+    test_exposition_format()
+    print("\n🎉 All metrics tests passed")
+
+
+if __name__ == "__main__":
+    main()
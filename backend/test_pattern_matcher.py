@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Test script for the precompiled NLP pattern matcher
+Checks the single-scan matcher against plain re.search/re.finditer
+"""
+import sys
+import os
+import re
+import random
+import time
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.pattern_matcher import PatternMatcher, required_literals
+from services.nlp_service import NLPService
+from services.enhanced_nlp_service import EnhancedNLPService
+
+QUERIES = [
+    "How much did I spend on groceries last month?",
+    "Can I afford a $2,500 vacation next year?",
+    "Show my investment portfolio performance vs last quarter",
+    "what's my savings rate this month",
+    "Am I spending more than 30% on housing?",
+    "where did my money go in march",
+    "Give me a financial health overview",
+    "alert me when dining goes over 500 dollars",
+    "project my balance for the next 6 months",
+    "hello there",
+    "",
+]
+
+
+def _vocabulary(patterns):
+    """Words drawn from the patterns themselves, so random queries hit them often"""
+    words = set()
+    for pattern in patterns:
+        words.update(re.findall(r"[a-z0-9$%]+", pattern.lower()))
+    return sorted(words) + ["the", "my", "on", "2024", "$1,200", "15%", "5k"]
+
+
+def test_required_literals():
+    """Literal extraction on representative patterns"""
+    print("\n🔤 Testing required literal extraction...")
+    assert required_literals(r"spending\s+(?:patterns?|trends?)") == {"spending"}
+    assert required_literals(r"how much.*spent|total.*income") == {"how much", "income"}
+    assert required_literals(r"\b(?:vs|versus|against)\b") == {"vs", "versus", "against"}
+    assert required_literals(r"(\d+)\s*(?:%|percent)") == {"%", "percent"}
+    assert required_literals(r"\$?(\d+(?:,\d{3})*)") is None
+    assert required_literals(r"(?:past\s+)?budget|plan") == {"budget", "plan"}
+    print("   ✅ Literal sets are minimal and safe")
+
+
+def test_matches_plain_regex():
+    """Every group lookup equals running each pattern directly"""
+    print("\n🔍 Testing matcher equivalence...")
+    legacy = NLPService()
+    enhanced = EnhancedNLPService()
+    tables = {f"intent:{name}": patterns for name, patterns in legacy.intent_patterns.items()}
+    tables.update({f"enhanced:{name}": data["patterns"] for name, data in enhanced.intent_patterns.items()})
+    tables.update({name: [rule[0] if isinstance(rule, tuple) else rule for rule in rules]
+                   for name, rules in enhanced.extraction_rules.items()})
+
+    matcher = PatternMatcher()
+    for group, patterns in tables.items():
+        matcher.add_group(group, patterns)
+    matcher.compile()
+
+    words = _vocabulary(p for patterns in tables.values() for p in patterns)
+    rng = random.Random(7)
+    queries = QUERIES + [" ".join(rng.choice(words) for _ in range(rng.randint(1, 12)))
+                         for _ in range(400)]
+
+    for query in queries:
+        scan = matcher.scan(query)
+        for group, patterns in tables.items():
+            expected = [m.span() for p in patterns for m in re.finditer(p, query, re.IGNORECASE)]
+            assert [m.span() for _, m in scan.finditer(group)] == expected, (group, query)
+            expected_count = sum(1 for p in patterns if re.search(p, query, re.IGNORECASE))
+            assert scan.count(group) == expected_count, (group, query)
+    print(f"   ✅ {len(queries)} queries x {len(tables)} groups identical to re")
+
+
+def test_services_use_single_scan():
+    """Both NLP services return stable results through the matcher"""
+    print("\n🧠 Testing NLP services...")
+    legacy = NLPService()
+    enhanced = EnhancedNLPService()
+
+    result = legacy.process_query("How much did I spend on groceries last month?")
+    assert result["intent"] == "get_spending_by_category", result["intent"]
+    assert result["entities"]["time_periods"][0]["type"] == "previous"
+
+    result = enhanced.process_query("Am I spending more than 30% on dining this month?")
+    entities = result["entities"]
+    assert entities["percentage"][0]["value"] == 30.0
+    assert entities["spending_category"][0]["value"] == "food"
+    assert entities["comparison"][0]["value"] == "more"
+    assert entities["time_period"][0]["value"] == "current_month"
+
+    start = time.perf_counter()
+    for query in QUERIES * 50:
+        enhanced.process_query(query)
+    elapsed = (time.perf_counter() - start) * 1000 / (len(QUERIES) * 50)
+    print(f"   ✅ Intents and entities match; {elapsed:.3f} ms per enhanced query")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Pattern Matcher Tests")
+    print("=" * 50)
+
+    test_required_literals()
+    test_matches_plain_regex()
+    test_services_use_single_scan()
+    print("\n🎉 All pattern matcher tests passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+Test script for incremental portfolio valuation
+Covers symbol-keyed holdings, batched rate-limited price refresh, background
+refresh with cached valuations following price revisions, and covariance risk
+"""
+import sys
+import os
+import json
+import math
+import random
+import asyncio
+import threading
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.portfolio_engine import PortfolioEngine, SECONDS_PER_YEAR
+from services.financial_analyzer import FinancialAnalyzer
+from services.result_cache import AnalysisCacheScope, AnalysisResultCache, cached_analysis
+
+
+def load_investments():
+    """Sample holdings shipped with the backend"""
+    with open(os.path.join(os.path.dirname(__file__), "data", "investments.json")) as f:
+        return json.load(f)
+
+
+class Clock:
+    """Manually advanced time source"""
+
+    def __init__(self):
+        self.now = 1_700_000_000.0
+
+    def __call__(self):
+        return self.now
+
+
+def test_incremental_valuation():
+    """Ticks adjust totals by the holding's delta; re-syncs keep live prices"""
+    print("\n💹 Testing incremental valuation...")
+    investments = load_investments()
+    engine = PortfolioEngine()
+    portfolio = engine.sync("user_a", investments)
+    expected = sum(inv["total_value"] for inv in investments)
+    assert abs(portfolio.total_value - expected) < 1e-6
+
+    engine.apply_prices({"AAPL": 160.25})
+    assert abs(portfolio.total_value - (expected + 100 * 10)) < 1e-6
+    assert abs(sum(portfolio.class_values.values()) - portfolio.total_value) < 1e-6
+
+    # Same records again: holdings are kept and the live price survives
+    assert engine.sync("user_a", investments) is portfolio
+    assert portfolio.holdings["AAPL"].price == 160.25
+
+    # Lots of one symbol merge; removed holdings leave the totals
+    extra_lot = dict(investments[0], id="inv_100", quantity=10.0, total_value=1502.5)
+    engine.sync("user_a", investments[1:] + [investments[0], extra_lot])
+    assert portfolio.holdings["AAPL"].quantity == 110
+    engine.sync("user_a", investments[1:])
+    assert "AAPL" not in portfolio.holdings
+    assert abs(portfolio.total_value - (expected - 15025.0)) < 1e-6
+    print(f"   ✅ Totals tracked incrementally (₹{portfolio.total_value:,.2f})")
+
+
+def test_batched_shared_refresh():
+    """Stale symbols are fetched once in batches, shared by every holder, within the rate limit"""
+    print("\n📡 Testing batched price refresh...")
+    calls = []
+
+    def source(symbols):
+        calls.append(list(symbols))
+        return {symbol: 100.0 + len(calls) for symbol in symbols}
+
+    clock = Clock()
+    engine = PortfolioEngine(price_source=source, ttl_seconds=60, batch_size=3, min_interval=1.0, clock=clock)
+    investments = load_investments()
+    for user in range(50):
+        engine.sync(f"user_{user}", investments)
+
+    # One batch per call until the rate limit allows the next
+    assert engine.refresh_prices() == 3 and len(calls) == 1
+    assert engine.refresh_prices() == 0
+    clock.now += 1
+    assert engine.refresh_prices() == 3
+    clock.now += 1
+    assert engine.refresh_prices() == 1 and [len(c) for c in calls] == [3, 3, 1]
+
+    # Fresh prices are served from the shared cache
+    assert engine.refresh_prices() == 0 and len(calls) == 3
+    first = calls[0][0]
+    assert all(engine._portfolios[f"user_{u}"].holdings[first].price == 101.0 for u in range(50))
+
+    upstream_calls = len(calls)
+    clock.now += 61
+    assert engine.refresh_prices() == 3
+    print(f"   ✅ 7 symbols for 50 users in {upstream_calls} upstream calls")
+
+
+class _PortfolioService:
+    """Minimal AnalysisService stand-in caching a valuation by price revision"""
+
+    def __init__(self, engine):
+        self.engine = engine
+        self.result_cache = AnalysisResultCache()
+        self.computed = 0
+
+    async def cached_result(self, analysis_type, user_id, params, cache_scope, compute):
+        key = self.result_cache.make_key(user_id, analysis_type, params, cache_scope)
+        return await self.result_cache.get_or_compute(key, compute)
+
+    @cached_analysis("investment_portfolio", revision=lambda service, user_id: service.engine.price_revision(user_id))
+    async def value(self, user_id, investments):
+        self.computed += 1
+        portfolio = self.engine.sync(user_id, investments)
+        self.engine.refresh_in_background()
+        return round(portfolio.total_value, 2)
+
+
+def test_background_refresh():
+    """Requests never wait on the upstream, and cached valuations follow price ticks"""
+    print("\n🧵 Testing background price refresh...")
+    release = threading.Event()
+
+    def source(symbols):
+        release.wait(5)
+        return {symbol: 1000.0 for symbol in symbols}
+
+    engine = PortfolioEngine(price_source=source, min_interval=0)
+    service = _PortfolioService(engine)
+    investments = load_investments()
+    scope = AnalysisCacheScope(1, ("investments",))
+
+    # The upstream is blocked, so these return only because the fetch is off-thread
+    first = asyncio.run(service.value("user_bg", investments, cache_scope=scope))
+    assert first == round(sum(inv["total_value"] for inv in investments), 2)
+    assert not engine.refresh_in_background() and engine.price_revision("user_bg") == 0
+    assert asyncio.run(service.value("user_bg", investments, cache_scope=scope)) == first
+    assert service.computed == 1
+
+    release.set()
+    engine._pending_refresh.result(5)
+    assert engine.price_revision("user_bg") == 1
+    repriced = asyncio.run(service.value("user_bg", investments, cache_scope=scope))
+    assert repriced != first and service.computed == 2
+    engine.close()
+    print(f"   ✅ Served ₹{first:,.2f} while fetching, then ₹{repriced:,.2f} after the tick")
+
+
+def test_covariance_risk():
+    """Observed returns replace the prior; diversification lowers volatility"""
+    print("\n📊 Testing covariance risk...")
+    clock = Clock()
+    engine = PortfolioEngine(clock=clock)
+    holdings = [
+        {"id": "a", "symbol": "A", "name": "A Corp", "type": "stock", "quantity": 100, "current_price": 100.0},
+        {"id": "b", "symbol": "B", "name": "B Corp", "type": "stock", "quantity": 100, "current_price": 100.0},
+    ]
+    mixed = engine.sync("mixed", holdings)
+    single = engine.sync("single", holdings[:1] + [dict(holdings[0], id="a2")])
+    prior = engine.risk(mixed)["volatility"]
+    assert 0.2 < prior < 0.25
+
+    # Independent daily moves of ~1.26% (20% annual) on each symbol
+    rng = random.Random(3)
+    prices = {"A": 100.0, "B": 100.0}
+    for _ in range(300):
+        clock.now += 86400
+        prices = {s: p * math.exp(rng.gauss(0, 0.20 * math.sqrt(86400 / SECONDS_PER_YEAR))) for s, p in prices.items()}
+        engine.apply_prices(prices)
+
+    mixed_risk, single_risk = engine.risk(mixed), engine.risk(single)
+    assert mixed_risk["measured_weight"] == 1
+    assert 0.1 < single_risk["volatility"] < 0.3
+    assert mixed_risk["volatility"] < single_risk["volatility"]
+    assert engine.risk(mixed) is mixed_risk
+    print(f"   ✅ Two uncorrelated stocks {mixed_risk['volatility']:.1%} vs one {single_risk['volatility']:.1%}")
+
+
+def test_analyzer_integration():
+    """The analyzer reports engine totals and numeric volatility"""
+    print("\n🧺 Testing analyzer portfolio shape...")
+    investments = load_investments()
+    result = FinancialAnalyzer().analyze_investment_portfolio(investments, "moderate", portfolio_id="analyzer_user")
+    assert "error" not in result, result
+    assert result["total_portfolio_value"] == round(sum(inv["total_value"] for inv in investments), 2)
+    assert abs(sum(result["current_allocation"].values()) - 100) < 1e-6
+    assert isinstance(result["risk_metrics"]["volatility_estimate"], float)
+    print(f"   ✅ Volatility {result['risk_metrics']['volatility_estimate']}% "
+          f"({result['risk_metrics']['volatility_basis']})")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Portfolio Engine Tests")
+    print("=" * 50)
+
+    test_incremental_valuation()
+    test_batched_shared_refresh()
+    test_background_refresh()
+    test_covariance_risk()
+    test_analyzer_integration()
+    print("\n🎉 All portfolio engine tests passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+Test script for the background precompute scheduler
+Covers queue priorities and coalescing, recomputation on data changes,
+offloaded jobs and serving precomputed results, computing misses on request
+(on a worker thread for offloaded jobs)
+"""
+import sys
+import os
+import asyncio
+import shutil
+import tempfile
+import threading
+
+# Add the backend directory to Python path; the scheduler imports the
+# privacy service, which needs the app package for its relative imports
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from app.services.precompute_scheduler import (PrecomputeScheduler, PrecomputeJob, JobQueue,
+                                               DEFAULT_USER_ID, PRIORITY_CADENCE)
+from app.services.data_store import DataStore
+from app.services.result_cache import AnalysisResultCache
+from app.services.privacy_service import PERMISSION_CATEGORIES
+from app.models.requests import Permissions
+
+ALL = Permissions(**{name: True for name in PERMISSION_CATEGORIES})
+
+
+def test_job_queue():
+    """Most urgent first; repeated triggers coalesce and can only raise priority"""
+    print("\n📥 Testing prioritized, coalescing queue...")
+    queue = JobQueue()
+    assert queue.push("trends", 10) and queue.push("health", 2) and queue.push("forecast", 5)
+    assert not queue.push("trends", 12) and not queue.push("trends", 1)
+    assert not queue.push("health", 2)
+    assert len(queue) == 3 and queue.coalesced == 3
+
+    order = [queue.pop()[0] for _ in range(3)]
+    assert order == ["trends", "health", "forecast"] and queue.pop() is None
+    print("   ✅ 6 triggers ran as 3 jobs, bumped job first")
+
+
+async def wait_for(predicate, timeout=5.0):
+    deadline = asyncio.get_running_loop().time() + timeout
+    while not predicate():
+        assert asyncio.get_running_loop().time() < deadline, "condition not reached"
+        await asyncio.sleep(0.01)
+
+
+async def scheduler_flow(temp_dir):
+    store = DataStore(temp_dir)
+    store.load()
+    cache = AnalysisResultCache()
+    scheduler = PrecomputeScheduler(store=store, cache=cache, interval=3600, poll_interval=0.02)
+    calls = {"count": 0, "threads": set()}
+
+    def count_transactions(context, category):
+        calls["count"] += 1
+        return sum(1 for t in context.data.get("transactions", []) if category in (None, t.get("category")))
+
+    async def slow_forecast(context):
+        calls["threads"].add(threading.current_thread().name)
+        await asyncio.sleep(0.01)
+        return {"version": context.data_version, "accounts": len(context.data.get("accounts", []))}
+
+    scheduler.register_job(PrecomputeJob("counts", count_transactions,
+                                         variants=({"category": None}, {"category": "Food & Dining"}),
+                                         requires=("transactions",)))
+    scheduler.register_job(PrecomputeJob("forecast", slow_forecast, priority=2, offload=True))
+    scheduler.start()
+    try:
+        await wait_for(lambda: scheduler.get_stats()["runs"] == 2)
+        assert calls["count"] == 2 and threading.current_thread().name not in calls["threads"]
+
+        # Served from the cache without recomputing
+        version, data = store.versioned_snapshot()
+        total = await scheduler.serve("counts", DEFAULT_USER_ID, ALL, version, data, category=None)
+        food = await scheduler.serve("counts", DEFAULT_USER_ID, ALL, version, data, category="Food & Dining")
+        forecast = await scheduler.serve("forecast", DEFAULT_USER_ID, ALL, version, data)
+        assert total == len(data["transactions"]) and 0 < food < total and forecast["version"] == version
+        assert calls["count"] == 2 and scheduler.get_stats()["inline_computes"] == 0
+        print(f"   ✅ Precomputed on start (offloaded job ran on {sorted(calls['threads'])[0]}), served from cache")
+
+        # A data change recomputes for the new version
+        store.add_transaction({"id": "txn_new", "date": "2024-01-20T10:00:00Z", "amount": -10.0,
+                               "description": "Snack", "category": "Food & Dining"})
+        await wait_for(lambda: scheduler.get_stats()["runs"] == 4)
+        version, data = store.versioned_snapshot()
+        assert await scheduler.serve("counts", DEFAULT_USER_ID, ALL, version, data, category=None) == total + 1
+        assert calls["count"] == 4 and scheduler.get_stats()["inline_computes"] == 0
+        print("   ✅ Data change recomputed every job for the new version")
+
+        # Unknown variants and new users compute on request, then get tracked;
+        # the offloaded job's miss still runs off the event loop
+        restricted = Permissions(accounts=True)
+        assert await scheduler.serve("counts", DEFAULT_USER_ID, ALL, version, data, category="Housing") >= 0
+        calls["threads"].clear()
+        forecast = await scheduler.serve("forecast", "alice", restricted, version, data)
+        assert forecast["accounts"] > 0 and scheduler.get_stats()["inline_computes"] == 2
+        assert calls["threads"] and threading.current_thread().name not in calls["threads"]
+        await wait_for(lambda: scheduler.get_stats()["runs"] == 5)
+        assert scheduler.get_stats()["tracked_users"] == 2
+        print("   ✅ Misses computed on request, offloaded one on a worker thread; "
+              "new user precomputed, transaction job skipped without permission")
+
+        # A burst of triggers coalesces into one run per job and user
+        runs = scheduler.get_stats()["runs"]
+        queued = [scheduler.trigger(PRIORITY_CADENCE) for _ in range(20)]
+        assert queued[0] == 3 and sum(queued[1:]) == 0
+        await wait_for(lambda: scheduler.get_stats()["runs"] == runs + 3)
+        print(f"   ✅ 20 triggers coalesced into 3 runs ({scheduler.get_stats()['coalesced']} coalesced so far)")
+
+        # A job reading store state is not cached once the store moves past its version
+        moves = []
+
+        def rollup(context):
+            if moves:
+                store.add_transaction(moves.pop())
+            return context.data_version
+
+        scheduler.register_job(PrecomputeJob("rollup", rollup))
+        version, data = store.versioned_snapshot()
+        inline = scheduler.get_stats()["inline_computes"]
+        moves.append({"id": "txn_moved", "date": "2024-01-21T10:00:00Z", "amount": -5.0,
+                      "description": "Coffee", "category": "Food & Dining"})
+        assert await scheduler.serve("rollup", DEFAULT_USER_ID, ALL, version, data) == version
+        assert await scheduler.serve("rollup", DEFAULT_USER_ID, ALL, version, data) == version
+        assert scheduler.get_stats()["inline_computes"] == inline + 2
+        print("   ✅ Result computed while the store moved on was served but not cached")
+    finally:
+        await scheduler.stop()
+    assert not scheduler.get_stats()["running"]
+
+
+def test_scheduler(temp_dir):
+    """Jobs run on start and on data changes; endpoints read the cache"""
+    print("\n🗓️ Testing precompute scheduler...")
+    asyncio.run(scheduler_flow(temp_dir))
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Precompute Scheduler Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        data_dir = os.path.join(temp_dir, "data")
+        shutil.copytree(os.path.join(os.path.dirname(__file__), "data"), data_dir)
+        test_job_queue()
+        test_scheduler(data_dir)
+        print("\n🎉 All precompute scheduler tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Test script for compiled permission masks in the enhanced privacy service
+Covers mask reuse and recompilation, aggregated access auditing,
+read-only filtered views over shared data and dropping cached analyses
+computed with a category whose permission changed
+"""
+import sys
+import os
+import asyncio
+from datetime import datetime, timezone, timedelta
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.enhanced_privacy_service import EnhancedPrivacyService, PermissionLevel, AuditAction
+from services.result_cache import AnalysisCacheScope, get_analysis_cache
+
+DATA = {
+    "transactions": [
+        {"id": f"txn_{i}", "amount": -100 - i, "category": "food",
+         "date": "2024-01-05T10:00:00", "description": "lunch"}
+        for i in range(80)
+    ],
+    "accounts": [{"id": "acc_1", "name": "Savings Account", "balance": 50123, "type": "savings"}],
+    "credit_score": {"score": 750},
+}
+
+
+async def test_mask_reuse_and_recompile():
+    """Masks are reused until permissions change or a grant expires"""
+    print("\n🎭 Testing permission mask compilation...")
+    service = EnhancedPrivacyService()
+    await service.update_permissions("user_1", {"transactions": True, "accounts": True})
+
+    first = await service.filter_data_by_permissions("user_1", DATA)
+    mask = service._permission_masks["user_1"]
+    await service.filter_data_by_permissions("user_1", DATA)
+    assert service._permission_masks["user_1"] is mask
+    assert first["transactions"] is DATA["transactions"]
+    assert first["credit_score"] == {}
+
+    await service.update_permissions("user_1", {"transactions": False})
+    denied = await service.filter_data_by_permissions("user_1", DATA)
+    assert denied["transactions"] == [] and denied["_privacy_metadata"]["access_log"]["transactions"] == "denied"
+
+    await service.update_permissions("user_1", {"transactions": {
+        "level": "full", "access_types": ["view"],
+        "expires_at": (datetime.now(timezone.utc) + timedelta(milliseconds=50)).isoformat()
+    }})
+    assert len((await service.filter_data_by_permissions("user_1", DATA))["transactions"]) == 80
+    await asyncio.sleep(0.1)
+    assert (await service.filter_data_by_permissions("user_1", DATA))["transactions"] == []
+    print("   ✅ Mask reused between requests, rebuilt on update and expiry")
+
+
+async def test_views_and_audit():
+    """Filtered data is a read-only view and each call audits once"""
+    print("\n👁️  Testing filtered views...")
+    service = EnhancedPrivacyService()
+    await service.update_permissions("user_2", {
+        "transactions": {"level": "limited", "access_types": ["view"]},
+        "accounts": {"level": "limited", "access_types": ["view"]},
+    })
+    profile = service._privacy_profiles["user_2"]
+    audit_before = len(profile.audit_trail)
+
+    first = await service.filter_data_by_permissions("user_2", DATA)
+    second = await service.filter_data_by_permissions("user_2", DATA)
+    assert len(first["transactions"]) == 50 and len(first["transactions"][0]) == 4
+    assert first["transactions"] is second["transactions"]
+    assert first["accounts"][0]["balance"] == 50100
+
+    try:
+        first["transactions"] = []
+        raise AssertionError("filtered data should be read-only")
+    except TypeError:
+        pass
+
+    accesses = [entry for entry in profile.audit_trail[audit_before:] if entry.action == AuditAction.DATA_ACCESSED]
+    assert len(accesses) == 2
+    assert accesses[0].details["categories"] == ["transactions", "accounts"]
+
+    # Direct edits to a setting are picked up without update_permissions
+    profile.permissions["transactions"].permission_level = PermissionLevel.FULL
+    assert (await service.filter_data_by_permissions("user_2", DATA))["transactions"] is DATA["transactions"]
+
+    dashboard = await service.get_privacy_dashboard("user_2")
+    assert dashboard["usage_statistics"]["categories_accessed"] == 2
+    print("   ✅ Shared read-only views, one audit entry per filter call")
+
+
+async def test_cached_analyses_invalidated():
+    """A permission change drops cached results that used the category, whoever they were cached for"""
+    print("\n🗑️ Testing cached analysis invalidation...")
+    cache = get_analysis_cache()
+    cache.invalidate(broadcast=False)
+    trends = cache.make_key("default_user", "spending", {}, AnalysisCacheScope(1, ("spending_trends", "transactions")))
+    breakdown = cache.make_key("default_user", "categories", {}, AnalysisCacheScope(1, ("category_breakdown",)))
+    accounts = cache.make_key("default_user", "balance", {}, AnalysisCacheScope(1, ("accounts",)))
+    for key in (trends, breakdown, accounts):
+        cache.put(key, {"cached": True})
+
+    # The privacy profile id differs from the id results are cached under
+    await EnhancedPrivacyService().update_permissions("user_3", {"spending_patterns": False})
+    assert cache.get(trends) is None and cache.get(breakdown) is None
+    assert cache.get(accounts) == {"cached": True}
+    cache.invalidate(broadcast=False)
+    print("   ✅ Revoking spending patterns dropped trend and breakdown results only")
+
+
+async def main():
+    """Main test runner"""
+    print("🚀 Starting Privacy Mask Tests")
+    print("=" * 50)
+
+    await test_mask_reuse_and_recompile()
+    await test_views_and_audit()
+    await test_cached_analyses_invalidated()
+    print("\n🎉 All privacy mask tests passed")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Test script for token-bucket rate limiting and load shedding
+Drives the ASGI middleware directly with a fake downstream application
+"""
+import sys
+import os
+import asyncio
+import json
+import tempfile
+import shutil
+import threading
+import time
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from security.rate_limit import RateLimiter, RateLimitMiddleware, MemoryBucketStore, SQLiteBucketStore
+
+
+async def ok_app(scope, receive, send):
+    """Downstream app answering 200, slowly for /api/chat"""
+    if scope["path"].startswith("/api/chat"):
+        await asyncio.sleep(0.05)
+    await send({"type": "http.response.start", "status": 200, "headers": []})
+    await send({"type": "http.response.body", "body": b"{}"})
+
+
+async def call(middleware, path, client="10.0.0.1"):
+    """Send one request through the middleware and return (status, headers, body)"""
+    messages = []
+
+    async def receive():
+        return {"type": "http.request", "body": b""}
+
+    async def send(message):
+        messages.append(message)
+
+    scope = {"type": "http", "method": "POST", "path": path, "headers": [], "client": (client, 5000)}
+    await middleware(scope, receive, send)
+    headers = dict(messages[0]["headers"])
+    return messages[0]["status"], headers, json.loads(messages[1]["body"] or b"{}")
+
+
+def test_bucket_math():
+    """Buckets allow bursts up to capacity and refill over time"""
+    print("\n🪣 Testing token buckets...")
+    store = MemoryBucketStore()
+    results = [store.take("k", 1, 3, 10.0)[0] for _ in range(4)]
+    assert results == [True, True, True, False]
+    allowed, _, retry_after = store.take("k", 1, 3, 10.0)
+    assert not allowed and 0 < retry_after <= 0.1
+    time.sleep(0.12)
+    assert store.take("k", 1, 3, 10.0)[0]
+    print("   ✅ Burst of 3 allowed, 4th limited, refilled after 100 ms")
+
+
+def test_shared_store(temp_dir):
+    """Two workers sharing a SQLite store draw from the same bucket"""
+    print("\n🔗 Testing shared SQLite buckets...")
+    path = os.path.join(temp_dir, "buckets.db")
+    worker_a, worker_b = SQLiteBucketStore(path), SQLiteBucketStore(path)
+    assert worker_a.take("user:1:chat", 5, 10, 0.01)[0]
+    assert worker_b.take("user:1:chat", 5, 10, 0.01)[0]
+    assert not worker_a.take("user:1:chat", 5, 10, 0.01)[0]
+    assert worker_b.take("user:2:chat", 5, 10, 0.01)[0]
+    print("   ✅ Second worker sees the first worker's spend")
+
+
+async def test_shared_store_off_loop(temp_dir):
+    """The limiter draws from SQLite buckets on a worker thread, not the event loop"""
+    print("\n🧵 Testing SQLite buckets off the event loop...")
+    store = SQLiteBucketStore(os.path.join(temp_dir, "async_buckets.db"))
+    threads = []
+    take = store.take
+
+    def recording_take(*args):
+        threads.append(threading.get_ident())
+        return take(*args)
+
+    store.take = recording_take
+    limiter = RateLimiter(requests=2, period=60, store=store)
+    results = [(await limiter.acquire("10.0.0.9", "/api/other"))[0] for _ in range(3)]
+    assert results == [True, True, False], results
+    assert len(threads) == 3 and threading.get_ident() not in threads
+    assert limiter.get_stats()["store_errors"] == 0
+    print("   ✅ 3 bucket draws ran on worker threads")
+
+
+async def test_route_costs():
+    """Expensive routes exhaust a client's budget sooner and per route"""
+    print("\n💸 Testing route cost weights...")
+    middleware = RateLimitMiddleware(ok_app, RateLimiter(requests=20, period=60))
+
+    statuses = [(await call(middleware, "/api/insights/generate"))[0] for _ in range(3)]
+    assert statuses == [200, 200, 429]
+    status, headers, body = await call(middleware, "/api/insights/generate")
+    assert status == 429 and int(headers[b"retry-after"]) >= 1 and body["error"] == "Rate limit exceeded"
+
+    # Other routes and other clients keep their own buckets
+    assert (await call(middleware, "/api/accounts"))[0] == 200
+    assert (await call(middleware, "/api/insights/generate", client="10.0.0.2"))[0] == 200
+    assert (await call(middleware, "/health"))[0] == 200
+    print("   ✅ Cost-10 route limited after 2 calls; other routes and clients unaffected")
+
+
+async def test_load_shedding():
+    """Requests beyond the in-flight budget are shed with 503 immediately"""
+    print("\n🚦 Testing load shedding...")
+    limiter = RateLimiter(requests=1000, period=1, max_in_flight=12)
+    middleware = RateLimitMiddleware(ok_app, limiter)
+
+    start = time.perf_counter()
+    results = await asyncio.gather(*[
+        call(middleware, "/api/chat", client=f"10.0.1.{i}") for i in range(5)
+    ])
+    elapsed_ms = (time.perf_counter() - start) * 1000
+    statuses = sorted(status for status, _, _ in results)
+    assert statuses == [200, 200, 503, 503, 503], statuses
+    assert limiter.in_flight == 0 and limiter.get_stats()["shed"] == 3
+    print(f"   ✅ 2 of 5 concurrent chats admitted, 3 shed; finished in {elapsed_ms:.0f} ms")
+
+
+async def test_streams_not_in_flight():
+    """Open update streams are rate limited on connect but never shed other requests"""
+    print("\n🌊 Testing long-lived update streams...")
+    limiter = RateLimiter(requests=1000, period=1, max_in_flight=4)
+    disconnect = asyncio.Event()
+
+    async def stream_app(scope, receive, send):
+        await send({"type": "http.response.start", "status": 200,
+                    "headers": [(b"content-type", b"text/event-stream")]})
+        if scope["path"] == "/api/updates/stream":
+            await disconnect.wait()
+        await send({"type": "http.response.body", "body": b"{}"})
+
+    middleware = RateLimitMiddleware(stream_app, limiter)
+    streams = [asyncio.ensure_future(call(middleware, "/api/updates/stream", client=f"10.0.2.{i}"))
+               for i in range(limiter.max_in_flight + 4)]
+    await asyncio.sleep(0.01)
+    assert limiter.in_flight == 0
+    assert (await call(middleware, "/api/accounts"))[0] == 200
+    disconnect.set()
+    assert all(status == 200 for status, _, _ in await asyncio.gather(*streams))
+
+    # Connecting still draws from the client's bucket
+    tight = RateLimitMiddleware(stream_app, RateLimiter(requests=2, period=60))
+    statuses = [(await call(tight, "/api/updates/stream"))[0] for _ in range(3)]
+    assert statuses == [200, 200, 429], statuses
+    print(f"   ✅ {len(streams)} open streams left the in-flight budget free; connects still limited")
+
+
+async def main():
+    """Main test runner"""
+    print("🚀 Starting Rate Limit Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        test_bucket_math()
+        test_shared_store(temp_dir)
+        await test_shared_store_off_loop(temp_dir)
+        await test_route_costs()
+        await test_load_shedding()
+        await test_streams_not_in_flight()
+        print("\n🎉 All rate limit tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""
+Test script for API response encoding
+Covers fast JSON rendering, data-version ETags with 304s and the compression middleware
+"""
+import sys
+import os
+import asyncio
+import gzip
+import json
+from types import SimpleNamespace
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services import response_encoding
+from services.response_encoding import (
+    CompressionMiddleware, check_not_modified, choose_coding, dumps, json_response
+)
+
+
+def fake_request(path="/api/dashboard", query="", if_none_match=None):
+    """Minimal stand-in for a Starlette request"""
+    headers = {"if-none-match": if_none_match} if if_none_match else {}
+    return SimpleNamespace(url=SimpleNamespace(path=path, query=query), headers=headers)
+
+
+async def run(minimum_size, messages, accept_encoding="gzip, deflate"):
+    """Send downstream messages through the middleware and collect what reaches the client"""
+    sent = []
+
+    async def app(scope, receive, send):
+        for message in messages:
+            await send(message)
+
+    async def receive():
+        return {"type": "http.request", "body": b""}
+
+    async def send(message):
+        sent.append(message)
+
+    scope = {"type": "http", "method": "GET", "path": "/api/transactions",
+             "headers": [(b"accept-encoding", accept_encoding.encode())]}
+    await CompressionMiddleware(app, minimum_size=minimum_size)(scope, receive, send)
+    return sent
+
+
+def response_messages(body, status=200, etag=b'"abc"', content_type=b"application/json", more_body=False):
+    headers = [(b"content-type", content_type), (b"content-length", str(len(body)).encode()), (b"etag", etag)]
+    return [{"type": "http.response.start", "status": status, "headers": headers},
+            {"type": "http.response.body", "body": body, "more_body": more_body}]
+
+
+def test_fast_json():
+    """Output matches stdlib JSON for the shapes the routers return"""
+    print("\n⚡ Testing fast JSON rendering...")
+    content = {"transactions": [{"id": "t1", "amount": -250.5, "merchant": "Café"}],
+               "pagination": {"total": 1, "next_cursor": None}, "tags": ("a", "b")}
+    assert json.loads(dumps(content)) == json.loads(json.dumps(content))
+    assert json.loads(json_response(content).body)["transactions"][0]["merchant"] == "Café"
+    backend = "orjson" if response_encoding.orjson is not None else "stdlib json"
+    print(f"   ✅ Equivalent output via {backend}")
+
+
+def test_etag_revalidation():
+    """Same data version and URL -> 304; a new version or query -> full response"""
+    print("\n🏷️  Testing data-version ETags...")
+    etag, cached = check_not_modified(fake_request(), 7, "transactions")
+    assert etag.startswith('"') and cached is None
+
+    _, cached = check_not_modified(fake_request(if_none_match=etag), 7, "transactions")
+    assert cached is not None and cached.status_code == 304 and cached.headers["etag"] == etag
+
+    # Compressed variants and weak forms of the tag still revalidate
+    gzip_tag = etag[:-1] + '-gzip"'
+    for header in (gzip_tag, f'W/{etag}', f'"other", {gzip_tag}', "*"):
+        assert check_not_modified(fake_request(if_none_match=header), 7, "transactions")[1] is not None
+
+    assert check_not_modified(fake_request(if_none_match=etag), 8, "transactions")[1] is None
+    assert check_not_modified(fake_request(query="limit=20", if_none_match=etag), 7, "transactions")[1] is None
+    assert check_not_modified(fake_request(if_none_match=etag), 7, "accounts")[1] is None
+    assert json_response({}, etag).headers["etag"] == etag
+    print("   ✅ 304 only for the same version, URL and permissions")
+
+
+def test_compression():
+    """Large JSON bodies are compressed with a coding-specific ETag; small, 304 and streamed ones are not"""
+    print("\n🗜️  Testing compression middleware...")
+    body = dumps({"transactions": [{"id": f"t{i}", "amount": i * 1.5, "category": "Food"} for i in range(400)]})
+    sent = asyncio.run(run(1024, response_messages(body)))
+    headers = dict(sent[0]["headers"])
+    assert headers[b"content-encoding"] == b"gzip" and headers[b"etag"] == b'"abc-gzip"'
+    assert headers[b"vary"] == b"Accept-Encoding"
+    assert int(headers[b"content-length"]) == len(sent[1]["body"]) < len(body) // 5
+    assert gzip.decompress(sent[1]["body"]) == body
+
+    small = asyncio.run(run(1024, response_messages(b'{"ok":true}')))
+    assert b"content-encoding" not in dict(small[0]["headers"]) and small[1]["body"] == b'{"ok":true}'
+
+    not_modified = asyncio.run(run(0, response_messages(b"", status=304)))
+    assert b"content-encoding" not in dict(not_modified[0]["headers"])
+
+    streamed = response_messages(b"data: one\n\n" * 200, content_type=b"text/event-stream", more_body=True)
+    streamed.append({"type": "http.response.body", "body": b"data: two\n\n", "more_body": False})
+    out = asyncio.run(run(16, streamed))
+    assert len(out) == 3 and b"content-encoding" not in dict(out[0]["headers"])
+
+    assert asyncio.run(run(16, response_messages(body), accept_encoding="identity"))[1]["body"] == body
+    assert choose_coding([(b"accept-encoding", b"gzip;q=0, *;q=0")]) is None
+    print(f"   ✅ {len(body):,} -> {len(sent[1]['body']):,} bytes; small, 304 and streamed bodies untouched")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Response Encoding Tests")
+    print("=" * 50)
+
+    test_fast_json()
+    test_etag_revalidation()
+    test_compression()
+    print("\n🎉 All response encoding tests passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Test script for the shared analysis result cache
+Covers LRU hits, single-flight deduplication and invalidation
+"""
+import sys
+import os
+import asyncio
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.result_cache import AnalysisResultCache, AnalysisCacheScope
+
+
+async def test_hits_and_versions():
+    """Identical requests hit; a new data version or permission set misses"""
+    print("\n💾 Testing cache hits and keys...")
+    cache = AnalysisResultCache()
+    calls = []
+
+    def compute():
+        calls.append(1)
+        return {"total": len(calls)}
+
+    scope = AnalysisCacheScope.for_request(1, {"transactions": True, "accounts": False})
+    key = cache.make_key("user_1", "spending", {"time_periods": [{"days": 30}]}, scope)
+    same_key = cache.make_key("user_1", "spending", {"time_periods": [{"days": 30}]},
+                              AnalysisCacheScope.for_request(1, {"accounts": False, "transactions": True}))
+    assert key == same_key
+
+    first = await cache.get_or_compute(key, compute)
+    second = await cache.get_or_compute(same_key, compute)
+    assert first is second and len(calls) == 1
+
+    newer = cache.make_key("user_1", "spending", {"time_periods": [{"days": 30}]},
+                           AnalysisCacheScope.for_request(2, {"transactions": True}))
+    await cache.get_or_compute(newer, compute)
+    assert len(calls) == 2
+
+    stats = cache.get_stats()
+    assert stats["hits"] == 1 and stats["misses"] == 2
+    print(f"   ✅ Hit rate {stats['hit_rate']} after {len(calls)} computations")
+
+
+async def test_single_flight():
+    """Concurrent identical misses compute once"""
+    print("\n🛫 Testing single-flight deduplication...")
+    cache = AnalysisResultCache()
+    calls = []
+
+    async def compute():
+        calls.append(1)
+        await asyncio.sleep(0.05)
+        return {"value": 42}
+
+    key = cache.make_key("user_1", "forecast", {}, AnalysisCacheScope(1, ("accounts",)))
+    results = await asyncio.gather(*(cache.get_or_compute(key, compute) for _ in range(10)))
+
+    assert len(calls) == 1
+    assert all(result is results[0] for result in results)
+    assert cache.get_stats()["coalesced"] == 9
+    print("   ✅ 10 concurrent requests shared one computation")
+
+
+async def test_invalidation_and_eviction():
+    """Invalidation is per user, errors are not stored and the LRU is bounded"""
+    print("\n🧹 Testing invalidation and eviction...")
+    cache = AnalysisResultCache(max_entries=2)
+    scope = AnalysisCacheScope(1, ("transactions",))
+
+    for user_id in ("user_1", "user_2"):
+        await cache.get_or_compute(cache.make_key(user_id, "health", {}, scope), lambda: {"score": 70})
+    assert cache.invalidate("user_1") == 1
+    assert cache.get_stats()["entries"] == 1
+
+    error_key = cache.make_key("user_3", "health", {}, scope)
+    await cache.get_or_compute(error_key, lambda: {"error": "failed"},
+                               should_store=lambda result: "error" not in result)
+    assert cache.get_stats()["entries"] == 1
+
+    for index in range(3):
+        await cache.get_or_compute(cache.make_key("user_4", "health", {"n": index}, scope), lambda: {})
+    stats = cache.get_stats()
+    assert stats["entries"] == 2 and stats["evictions"] == 2
+    print(f"   ✅ {stats['invalidations']} invalidation, {stats['evictions']} evictions")
+
+
+async def main():
+    """Main test runner"""
+    print("🚀 Starting Analysis Result Cache Tests")
+    print("=" * 50)
+
+    await test_hits_and_versions()
+    await test_single_flight()
+    await test_invalidation_and_eviction()
+    print("\n🎉 All analysis result cache tests passed")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+Test script for shared data snapshots across worker processes
+Covers publishing and lazy adoption, writes and file changes seen by every
+worker, aggregate round trips and the cross-worker invalidation channel
+"""
+import sys
+import os
+import json
+import shutil
+import tempfile
+import multiprocessing
+from pathlib import Path
+
+# Add the backend directory to Python path; the data store pulls in the
+# metrics and snapshot modules through the app package's relative imports
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from app.services.data_store import DataStore
+from app.services.aggregate_store import TransactionAggregates
+from app.services.shared_snapshot import SnapshotExchange, InvalidationChannel
+
+CONTEXT = multiprocessing.get_context("fork")
+
+
+def worker(data_dir, snapshot_dir):
+    """A fresh worker process for the same data and snapshot directories"""
+    return DataStore(data_dir, exchange=SnapshotExchange(snapshot_dir))
+
+
+def _child_read(data_dir, snapshot_dir, results):
+    store = worker(data_dir, snapshot_dir)
+    store.load()
+    stats = store.get_file_stats()["shared"]
+    results.put((store.version, len(store.get_category("transactions")), stats["published"]))
+
+
+def _child_publish(path, events):
+    channel = InvalidationChannel(path, max_bytes=4096)
+    for scope, key in events:
+        channel.publish(scope, key)
+
+
+def test_publish_and_adopt(data_dir, snapshot_dir):
+    """The first worker parses and publishes; the others map the snapshot lazily"""
+    print("\n🗺️ Testing snapshot publish and adoption...")
+    first, second = worker(data_dir, snapshot_dir), worker(data_dir, snapshot_dir)
+    data = first.load()
+    assert first.version == 1 and first.get_file_stats()["shared"]["published"] == 1
+
+    second.load()
+    assert second.version == 1 and second.get_file_stats()["shared"]["published"] == 0
+    assert second._snapshot.decoded() == {}
+    assert second.get_category("transactions") == data["transactions"]
+    assert list(second._snapshot.decoded()) == ["transactions"]
+    assert second.aggregates().monthly_flows() == first.aggregates().monthly_flows()
+    assert second.aggregates().summary() == first.aggregates().summary()
+
+    results = CONTEXT.Queue()
+    process = CONTEXT.Process(target=_child_read, args=(data_dir, snapshot_dir, results))
+    process.start()
+    process.join(30)
+    version, count, published = results.get(timeout=5)
+    assert (version, count, published) == (1, len(data["transactions"]), 0)
+    print(f"   ✅ Version 1 parsed once; second worker and a child process mapped it lazily")
+    return first, second
+
+
+def test_writes_and_file_changes(first, second, data_dir, snapshot_dir):
+    """A write or file change in one worker becomes the next version everywhere"""
+    print("\n✍️ Testing cross-worker writes and reloads...")
+    count = len(first.get_category("transactions"))
+    first.add_transaction({"id": "txn_shared", "date": "2024-01-25T09:00:00Z", "amount": -42.0,
+                           "description": "Shared", "category": "Food & Dining"})
+    assert first.version == 2
+    assert second.refresh(force=True) and second.version == 2
+    assert len(second.get_category("transactions")) == count + 1
+    assert second.aggregates().summary() == first.aggregates().summary()
+
+    assert second.delete_transaction("txn_shared")["id"] == "txn_shared"
+    assert first.refresh(force=True) and first.version == 3
+    assert len(first.get_category("transactions")) == count
+
+    accounts_file = Path(data_dir) / "accounts.json"
+    accounts = json.loads(accounts_file.read_text())
+    accounts_file.write_text(json.dumps(accounts[:1]))
+    assert second.refresh(force=True) and second.version == 4
+    assert first.refresh(force=True) and first.version == 4
+    assert len(first.get_category("accounts")) == 1
+    assert first.get_file_stats()["shared"]["published"] == 2
+    assert not first.refresh(force=True) and not second.refresh(force=True)
+
+    snapshots = sorted(p.name for p in Path(snapshot_dir).glob("snapshot-*.bin"))
+    assert snapshots == [f"snapshot-{v:010d}.bin" for v in (2, 3, 4)]
+    print(f"   ✅ Write, delete and file reload published versions 2-4; old files pruned to {len(snapshots)}")
+
+
+def test_aggregate_state():
+    """Aggregates survive export and import unchanged"""
+    print("\n🧮 Testing aggregate state round trip...")
+    transactions = [
+        {"date": "2024-01-05T10:00:00Z", "amount": -20.0, "category": "Groceries"},
+        {"date": "2024-02-03T10:00:00Z", "amount": 1000.0, "category": "Salary"},
+        {"date": "", "amount": -5.0},
+        {"date": "2024-02-04T10:00:00Z", "amount": -7.5, "category": None}
+    ]
+    original = TransactionAggregates(transactions)
+    restored = TransactionAggregates.from_state(json.loads(json.dumps(original.to_state())))
+    assert restored.summary() == original.summary()
+    assert restored.monthly_flows() == original.monthly_flows()
+    assert restored.category_expenses() == original.category_expenses()
+    assert restored.as_of() == original.as_of()
+    restored.remove(transactions[0])
+    assert restored.summary()["total_expenses"] == 12.5
+    print("   ✅ Restored aggregates match and keep accepting deltas")
+
+
+def test_invalidation_channel(snapshot_dir):
+    """Other workers' events reach subscribers; a truncated log resets every scope"""
+    print("\n📣 Testing invalidation channel...")
+    path = Path(snapshot_dir) / "invalidations.log"
+    channel = InvalidationChannel(path, max_bytes=4096, poll_interval=0)
+    received = []
+    channel.subscribe("analysis", received.append)
+    channel.subscribe("context", lambda key: received.append(f"context:{key}"))
+
+    channel.publish("analysis", "self")
+    process = CONTEXT.Process(target=_child_publish,
+                              args=(path, [("analysis", "alice"), ("context", "nlp/bob:default"), ("other", None)]))
+    process.start()
+    process.join(30)
+    assert channel.poll() == 3 and received == ["alice", "context:nlp/bob:default"]
+
+    with open(path, "ab") as f:
+        f.write(b" " * 8192 + b"\n")
+    channel.poll()
+    received.clear()
+    process = CONTEXT.Process(target=_child_publish, args=(path, [("analysis", "carol")]))
+    process.start()
+    process.join(30)
+    channel.poll()
+    assert sorted(map(str, received)) == ["None", "carol", "context:None"]
+    assert channel.get_stats()["resets"] == 1
+
+    # A log that regrew past this reader's offset since the truncation is still caught
+    received.clear()
+    process = CONTEXT.Process(target=_child_publish,
+                              args=(path, [("analysis", f"key_{i}") for i in range(150)]))
+    process.start()
+    process.join(30)
+    assert path.stat().st_size > 200 and channel.poll() < 150
+    assert received[0] is None and channel.get_stats()["resets"] == 2
+    print("   ✅ Remote events applied, own events skipped, truncation invalidated every scope")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Shared Snapshot Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        data_dir = os.path.join(temp_dir, "data")
+        snapshot_dir = os.path.join(temp_dir, "snapshots")
+        shutil.copytree(os.path.join(os.path.dirname(__file__), "data"), data_dir)
+        first, second = test_publish_and_adopt(data_dir, snapshot_dir)
+        test_writes_and_file_changes(first, second, data_dir, snapshot_dir)
+        test_aggregate_state()
+        test_invalidation_channel(snapshot_dir)
+        print("\n🎉 All shared snapshot tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+Test script for the synthetic data generator and benchmark harness
+Covers determinism, schema validity, streamed dataset files and the
+load-test and regression-report plumbing
+"""
+import sys
+import os
+import json
+import shutil
+import tempfile
+import threading
+from datetime import datetime
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.synthetic_data import SyntheticDataGenerator
+from services.data_validator import DataValidator
+from services.data_store import DataStore
+from benchmark import BenchmarkReport, load_endpoint, percentile
+
+END = datetime(2024, 6, 1)
+
+
+def test_deterministic_stream():
+    """Same seed and end date give the same ordered records"""
+    print("\n🎲 Testing deterministic generation...")
+    first = list(SyntheticDataGenerator(seed=7, end=END).transactions(5000))
+    again = list(SyntheticDataGenerator(seed=7, end=END).transactions(5000))
+    other = list(SyntheticDataGenerator(seed=8, end=END).transactions(5000))
+
+    assert first == again and first != other
+    assert len(first) == 5000 and len({t["id"] for t in first}) == 5000
+    dates = [t["date"] for t in first]
+    assert dates == sorted(dates) and dates[-1] < "2024-06-01"
+    salaries = [t for t in first if t["category"] == "salary"]
+    assert len(salaries) == len({t["date"][:7] for t in salaries}) >= 8
+    print(f"   ✅ 5000 records reproducible, date ordered, {len(salaries)} monthly salaries")
+
+
+def test_schema_validity():
+    """Every generated category passes the validator's schemas"""
+    print("\n📐 Testing schema validity...")
+    data = SyntheticDataGenerator(seed=3, end=END).dataset(3000)
+    validator = DataValidator()
+    for key, schema in (("transactions", "transaction"), ("accounts", "account"),
+                        ("investments", "investment"), ("liabilities", "liability"), ("assets", "asset")):
+        result = validator.validate_bulk_data(data[key], schema)
+        assert result["valid_count"] == result["total_count"] == len(data[key]), (key, result["invalid_items"][:1])
+    assert sum(row["transaction_count"] for row in data["category_breakdown"]) == \
+        sum(1 for t in data["transactions"] if t["amount"] < 0)
+    print("   ✅ Transactions, accounts, investments, liabilities and assets all valid")
+
+
+def test_streamed_dataset(temp_dir):
+    """write_dataset produces files the data store loads unchanged"""
+    print("\n💾 Testing streamed dataset files...")
+    generator = SyntheticDataGenerator(seed=11, end=END)
+    counts = generator.write_dataset(temp_dir, 25000, batch_size=4000)
+    assert counts["transactions"] == 25000
+
+    data = DataStore(temp_dir).load()
+    assert data["transactions"] == list(generator.transactions(25000))
+    assert data["spending_trends"][0]["period"] == "2024-05"
+    assert data["accounts"] == generator.accounts()
+    print(f"   ✅ {counts['transactions']} transactions in {len(counts)} files loaded by the data store")
+
+
+class _Handler(BaseHTTPRequestHandler):
+    def do_GET(self):
+        status = 500 if self.path == "/api/broken" else 200
+        self.send_response(status)
+        self.send_header("Content-Length", "2")
+        self.end_headers()
+        self.wfile.write(b"{}")
+
+    def do_POST(self):
+        self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        self.do_GET()
+
+    def log_message(self, *args):
+        pass
+
+
+def test_load_harness():
+    """Load clients record latencies and errors; baselines flag p50 regressions"""
+    print("\n🔥 Testing load harness and regression report...")
+    server = ThreadingHTTPServer(("127.0.0.1", 0), _Handler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    base_url = f"http://127.0.0.1:{server.server_address[1]}"
+    try:
+        ok = load_endpoint(base_url, "POST", "/api/chat", [{"message": "hi"}], 0.5, 4, 5.0)
+        broken = load_endpoint(base_url, "GET", "/api/broken", [None], 0.2, 2, 5.0)
+    finally:
+        server.shutdown()
+    assert ok["runs"] > 10 and not ok["errors"] and ok["p50_ms"] <= ok["p99_ms"]
+    assert broken["runs"] == 0 and broken["errors"]["500"] > 0
+
+    assert percentile([1, 2, 3, 4], 50) == 2 and percentile([1, 2, 3, 4], 99) == 4
+    baseline = BenchmarkReport()
+    baseline.record("micro", "fast", {"p50_ms": 10.0})
+    baseline.record("micro", "steady", {"p50_ms": 10.0})
+    path = os.path.join(tempfile.mkdtemp(), "baseline.json")
+    baseline.save(path)
+
+    current = BenchmarkReport()
+    current.record("micro", "fast", {"p50_ms": 14.0})
+    current.record("micro", "steady", {"p50_ms": 11.0})
+    assert current.compare(path, tolerance=0.25) == 1
+    assert current.results["micro"]["failed"] == 1 and current.failed == 1
+    shutil.rmtree(os.path.dirname(path))
+    print(f"   ✅ {ok['runs']} requests at p50 {ok['p50_ms']} ms; 40% regression flagged, 10% tolerated")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Synthetic Data Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        test_deterministic_stream()
+        test_schema_validity()
+        test_streamed_dataset(temp_dir)
+        test_load_harness()
+        print("\n🎉 All synthetic data tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
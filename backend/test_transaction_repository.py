@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""
+Test script for the async database engine and the transaction repository
+Covers the connection pool gauges reported by get_connection_info, keyset
+and offset pages, filters, recent transactions and single-row writes on
+in-memory aiosqlite databases, and the transaction API in database mode
+"""
+import sys
+import os
+import asyncio
+import json
+import shutil
+import tempfile
+from contextlib import contextmanager
+from datetime import datetime, timedelta, timezone
+
+# Testing settings default to an in-memory database and skip the import-time connect
+os.environ.setdefault("ENVIRONMENT", "testing")
+
+# Add the backend directory to Python path; the database module uses the
+# app package's relative imports
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+try:
+    import aiosqlite  # noqa: F401  (driver of the async SQLite engine)
+    from sqlalchemy import text
+    from app.database import connection
+    from app.database.connection import DatabaseManager
+    from app.database.models import User, Account
+    from app.database.repository import TransactionRepository
+except ImportError as e:
+    connection = None
+    IMPORT_ERROR = e
+
+START = datetime(2024, 1, 1, 9, 0, 0)
+CATEGORIES = ["Food & Dining", "Shopping", "Utilities"]
+
+
+@contextmanager
+def database_url(url):
+    """Point new managers at another database"""
+    previous = connection.settings.DATABASE_URL
+    connection.settings.DATABASE_URL = url
+    try:
+        yield
+    finally:
+        connection.settings.DATABASE_URL = previous
+
+
+def epoch(value):
+    return value.replace(tzinfo=timezone.utc).timestamp()
+
+
+async def test_pool_gauges():
+    """get_connection_info reports both engines' pools and live checkouts"""
+    print("\n🏊 Testing connection pool gauges...")
+    manager = DatabaseManager()
+    manager.initialize()
+    assert manager.get_connection_info()["pools"] == {"sync": {"pool_class": "StaticPool"}}
+
+    await manager.initialize_async()
+    info = manager.get_connection_info()
+    assert info["status"] == "connected" and info["type"] == "sqlite" and info["version"]
+    # In-memory databases share one connection, so there are no size gauges
+    assert info["pools"]["async"] == {"pool_class": "StaticPool"}
+    assert await manager.health_check_async()
+    await manager.dispose_async()
+    assert "async" not in manager.get_connection_info()["pools"]
+
+    # File databases get a fixed-size queue pool whose gauges track checkouts
+    temp_dir = tempfile.mkdtemp()
+    with database_url(f"sqlite:///{os.path.join(temp_dir, 'pool.db')}"):
+        pooled = DatabaseManager()
+        pooled.initialize()
+        await pooled.initialize_async()
+        async with pooled.get_async_session() as first, pooled.get_async_session() as second:
+            await first.execute(text("SELECT 1"))
+            await second.execute(text("SELECT 1"))
+            busy = pooled.get_connection_info()["pools"]["async"]
+        idle = pooled.get_connection_info()["pools"]["async"]
+        await pooled.dispose_async()
+        pooled.engine.dispose()
+    shutil.rmtree(temp_dir)
+
+    assert busy["pool_class"] == "AsyncAdaptedQueuePool" and busy["size"] == 5
+    assert busy["checked_out"] == 2 and {"checked_in", "overflow", "timeout"} <= set(busy)
+    assert idle["checked_out"] == 0 and idle["checked_in"] >= 2
+    print(f"   ✅ StaticPool in memory; queue pool of {busy['size']} showed 2 checked out, then 0")
+
+
+async def seed(manager):
+    """One user with an account and 25 daily transactions; txn_14 and txn_15 share a timestamp"""
+    async with manager.get_async_session() as session:
+        user = User(username="pager", email="pager@example.com", hashed_password="x")
+        session.add(user)
+        await session.flush()
+        session.add(Account(user_id=user.id, account_name="Primary", account_type="checking"))
+        await session.commit()
+        user_id = user.id
+
+    repository = TransactionRepository(manager)
+    created = []
+    for index in range(25):
+        when = START + timedelta(days=14 if index == 15 else index)
+        created.append(await repository.create(user_id, {
+            "id": f"txn_{index:02d}", "date": when.isoformat() + "Z", "amount": -10.0 - index,
+            "description": f"Purchase {index}", "category": CATEGORIES[index % len(CATEGORIES)],
+            "account": "Primary"
+        }))
+    return repository, user_id, created
+
+
+def newest_first(records):
+    return [record["id"] for record in sorted(records, key=lambda r: r["date"], reverse=True)]
+
+
+async def test_pages(manager):
+    """Keyset and offset pages walk every row once, newest first"""
+    print("\n📄 Testing paged and recent transaction queries...")
+    repository, user_id, created = await seed(manager)
+    assert await repository.user_id_for("pager") == user_id
+    assert await repository.user_id_for("nobody") is None
+
+    pages, key, total = [], None, None
+    while True:
+        records, key, page_total = await repository.page(user_id, 10, key=key)
+        total = page_total if total is None else total
+        pages.append(records)
+        if key is None:
+            break
+    ids = [record["id"] for page in pages for record in page]
+    assert total == 25 and [len(page) for page in pages] == [10, 10, 5]
+    assert len(set(ids)) == 25 and set(ids) == {record["id"] for record in created}
+    dates = [record["date"] for page in pages for record in page]
+    assert dates == sorted(dates, reverse=True)
+    # The tied rows straddle the first page boundary; the id tie-break keeps both
+    assert set(ids[9:11]) == {"txn_14", "txn_15"}
+
+    offset_page, _, no_total = await repository.page(user_id, 10, offset=10, with_total=False)
+    assert [record["id"] for record in offset_page] == ids[10:20] and no_total is None
+
+    recent = await repository.recent(user_id, 5)
+    assert [record["id"] for record in recent] == ids[:5]
+    assert recent[0]["account"] and recent[0]["type"] == "expense"
+    print("   ✅ 3 keyset pages covered 25 rows, ties included; offset page and recent(5) agree")
+    return repository, user_id, created
+
+
+async def test_filters(repository, user_id, created):
+    """Category and date filters narrow pages and their totals"""
+    print("\n🔍 Testing page filters...")
+    food = [record for record in created if record["category"] == "Food & Dining"]
+    records, key, total = await repository.page(user_id, 100, category="food & DINING")
+    assert total == len(food) and key is None
+    assert [record["id"] for record in records] == newest_first(food)
+
+    start, end = START + timedelta(days=5), START + timedelta(days=9)
+    records, _, total = await repository.page(user_id, 100, start=epoch(start), end=epoch(end))
+    assert total == 5 and all(start.isoformat() <= record["date"][:19] <= end.isoformat() for record in records)
+
+    assert (await repository.page("someone-else", 10))[0] == []
+    assert (await repository.page(user_id, 0))[0] == []
+    print(f"   ✅ {len(food)} food rows by case-insensitive category, 5 rows in a date window")
+
+
+async def test_single_rows(repository, user_id):
+    """Rows are read, updated and deleted by their JSON id"""
+    print("\n✏️ Testing single-row reads and writes...")
+    assert (await repository.get(user_id, "txn_03"))["description"] == "Purchase 3"
+    updated = await repository.update(user_id, "txn_03", {"amount": 99.0, "category": "Income"})
+    assert updated["amount"] == 99.0 and updated["type"] == "income" and updated["category"] == "Income"
+    assert await repository.update(user_id, "missing", {"amount": 1}) is None
+
+    assert await repository.delete(user_id, "txn_03")
+    assert await repository.get(user_id, "txn_03") is None and not await repository.delete(user_id, "txn_03")
+    assert (await repository.page(user_id, 1))[2] == 24
+    print("   ✅ Get, update and delete round-trip through the async session")
+
+
+async def test_database_mode_publishes(manager):
+    """In database mode the data store is loaded from the table and API writes reach the dashboard and feed"""
+    print("\n🗄️ Testing API writes in database mode...")
+    from starlette.requests import Request
+    from app.routers import transactions, dashboard, updates
+
+    async with manager.get_async_session() as session:
+        user = User(username=transactions.DEFAULT_USERNAME, email="demo@example.com", hashed_password="x")
+        session.add(user)
+        await session.flush()
+        session.add(Account(user_id=user.id, account_name="Primary", account_type="checking"))
+        await session.commit()
+        user_id = user.id
+
+    async def monthly_spending():
+        request = Request({"type": "http", "method": "GET", "path": "/api/dashboard",
+                           "query_string": b"", "headers": []})
+        response = await dashboard.get_dashboard_data(request, permissions=dashboard.get_default_permissions())
+        return json.loads(response.body)["monthly_spending"]
+
+    previous = (transactions.TRANSACTION_STORE, transactions._repository)
+    transactions.TRANSACTION_STORE = "database"
+    transactions._repository = TransactionRepository(manager)
+    try:
+        # Rows already in the table replace transactions.json for every reader
+        existing = await transactions._repository.create(user_id, {
+            "amount": -75.0, "description": "Already stored", "category": "Food & Dining",
+            "account": "Primary", "date": (datetime.utcnow() - timedelta(days=1)).isoformat() + "Z"
+        })
+        assert await transactions.load_repository_transactions() == 1
+        assert [t["id"] for t in transactions.data_store.get_category("transactions")] == [existing["id"]]
+        transactions.data_store.refresh(force=True)
+        assert len(transactions.data_store.get_category("transactions")) == 1
+
+        permissions = transactions.get_default_permissions()
+        spending = await monthly_spending()
+        since = transactions.data_store.version
+        created = (await transactions.create_transaction({
+            "amount": -250.0, "description": "Database mode", "category": "Shopping",
+            "account": "Primary", "date": (datetime.utcnow() - timedelta(hours=1)).isoformat() + "Z"
+        }, permissions=permissions))["transaction"]
+        assert round(await monthly_spending() - spending, 2) == 250.0
+
+        feed = await updates.get_updates(since=since, permissions=updates.get_default_permissions())
+        assert not feed["resync"] and feed["events"][-1]["added"][0]["id"] == created["id"]
+
+        await transactions.update_transaction(created["id"], {"amount": -100.0}, permissions=permissions)
+        assert round(await monthly_spending() - spending, 2) == 100.0
+        await transactions.delete_transaction(created["id"], permissions=permissions)
+        assert round(await monthly_spending() - spending, 2) == 0.0
+        feed = await updates.get_updates(since=since, permissions=updates.get_default_permissions())
+        assert [event["type"] for event in feed["events"]] == ["transactions"] * 3
+        assert feed["events"][-1]["removed"] == [created["id"]]
+    finally:
+        transactions.TRANSACTION_STORE, transactions._repository = previous
+    print("   ✅ Store loaded from the table; create, update and delete moved /dashboard and /updates")
+
+
+async def run():
+    await test_pool_gauges()
+
+    manager = DatabaseManager()
+    try:
+        repository, user_id, created = await test_pages(manager)
+        await test_filters(repository, user_id, created)
+        await test_single_rows(repository, user_id)
+        await test_database_mode_publishes(manager)
+    finally:
+        await manager.dispose_async()
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Transaction Repository Tests")
+    print("=" * 50)
+    if connection is None:
+        print(f"⚠️ Skipped: database dependencies unavailable ({IMPORT_ERROR})")
+        return
+
+    asyncio.run(run())
+    print("\n🎉 All transaction repository tests passed")
+
+
+if __name__ == "__main__":
+    main()
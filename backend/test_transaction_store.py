@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Test script for the columnar transaction store
+Checks date-sorted columns, category indexes and monthly cash flow rollups
+"""
+import sys
+import os
+from datetime import datetime, timezone
+
+# Add the backend directory to Python path
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "app"))
+
+from services.transaction_store import (
+    TransactionColumns, get_transaction_columns, share_transaction_columns, forget_transaction_columns,
+    parse_timestamp, encode_cursor, decode_cursor
+)
+from services.financial_analyzer import FinancialAnalyzer
+
+
+def sample_transactions():
+    """Unsorted transactions spanning three months, plus one undated record"""
+    return [
+        {"id": "t1", "date": "2024-03-05T10:00:00Z", "amount": -200.0, "category": "Food & Dining"},
+        {"id": "t2", "date": "2024-01-01T09:00:00Z", "amount": 5000.0, "category": "Income"},
+        {"id": "t3", "date": "2024-02-10T12:00:00Z", "amount": -50.0, "category": "food & dining"},
+        {"id": "t4", "date": "2024-02-11T12:00:00", "amount": -75.0, "category": "Shopping"},
+        {"id": "t5", "date": "not-a-date", "amount": -10.0, "category": "Shopping"},
+        {"id": "t6", "date": "2024-03-01T00:00:00Z", "amount": 5000.0, "category": "Income"},
+    ]
+
+
+def test_sorted_columns():
+    """Dated rows are sorted and undated rows set aside"""
+    print("\n📊 Testing column layout...")
+    columns = TransactionColumns(sample_transactions())
+
+    assert [r["id"] for r in columns.records] == ["t2", "t3", "t4", "t6", "t1"]
+    assert list(columns.timestamps) == sorted(columns.timestamps)
+    assert [r["id"] for r in columns.undated_records] == ["t5"]
+    assert columns.latest(2)[0]["id"] == "t1"
+    assert columns.find("t5")["id"] == "t5"
+    print("   ✅ Columns sorted by date with undated records kept aside")
+
+
+def test_range_and_category_filters():
+    """Range and category filters agree with a linear scan"""
+    print("\n🔎 Testing range and category filters...")
+    columns = TransactionColumns(sample_transactions())
+    start = parse_timestamp("2024-02-01T00:00:00Z")
+    end = parse_timestamp("2024-03-02T00:00:00Z")
+
+    assert [r["id"] for r in columns.between(start, end)] == ["t3", "t4", "t6"]
+    assert [r["id"] for r in columns.select("Food & Dining")] == ["t1"]
+    assert [r["id"] for r in columns.select("FOOD & DINING", ignore_case=True)] == ["t3", "t1"]
+    assert [r["id"] for r in columns.select("food & dining", start, end, ignore_case=True)] == ["t3"]
+    assert columns.select("Missing") == []
+    print("   ✅ Binary-search filters match expected rows")
+
+
+def test_monthly_flows_match_analyzer():
+    """Monthly rollups keep the analyzer's cash flow shape"""
+    print("\n📅 Testing monthly cash flow rollups...")
+    transactions = sample_transactions()
+    flows = FinancialAnalyzer()._analyze_monthly_cash_flow(transactions, 2)
+
+    assert [m["month"] for m in flows] == ["2024-02", "2024-03"]
+    assert flows[0]["expenses"] == 125.0 and flows[0]["income"] == 0
+    assert flows[1]["net_flow"] == 4800.0
+    print("   ✅ Monthly flows computed from columns")
+
+
+def test_column_cache_scope():
+    """Shared (published) lists are ingested once; other lists are never cached"""
+    print("\n♻️  Testing column cache...")
+    transactions = sample_transactions()
+    assert get_transaction_columns(transactions) is not get_transaction_columns(transactions)
+
+    # An owner editing its list in place is never served a stale view
+    transactions[0] = {**transactions[0], "amount": -999.0}
+    assert -999.0 in get_transaction_columns(transactions).amounts
+
+    share_transaction_columns(transactions)
+    assert get_transaction_columns(transactions) is get_transaction_columns(transactions)
+    forget_transaction_columns(transactions)
+    assert get_transaction_columns(transactions) is not get_transaction_columns(transactions)
+    print("   ✅ Columns reused only for a shared list, until it is replaced")
+
+
+def test_keyset_pages():
+    """Cursor pages walk every row once, newest first, even across inserts"""
+    print("\n📑 Testing keyset pagination...")
+    transactions = [
+        {"id": f"k{i}", "date": f"2024-01-{1 + i // 3:02d}T00:00:00Z", "amount": -1.0, "category": "Food"}
+        for i in range(20)
+    ] + [{"id": "undated", "date": "", "amount": -1.0}]
+    columns = TransactionColumns(transactions)
+    positions = columns.positions()
+
+    seen, key = [], None
+    while True:
+        page, key = columns.page_before(positions, columns.undated_records, 6, key)
+        seen += [record["id"] for record in page]
+        if key is None:
+            break
+        key = decode_cursor(encode_cursor(key))
+    expected = [r["id"] for r in reversed(columns.records)] + ["undated"]
+    assert seen == expected, seen
+
+    # A page resumes after its key even once newer rows are added
+    first, key = columns.page_before(positions, [], 4, None)
+    grown = TransactionColumns(transactions + [{"id": "new", "date": "2024-02-01T00:00:00Z", "amount": 1.0}])
+    second, _ = grown.page_before(grown.positions(), [], 4, key)
+    assert [r["id"] for r in second] == expected[4:8]
+
+    # Category positions page the same way
+    page, key = columns.page_before(columns.positions("food", ignore_case=True), [], 25, None)
+    assert len(page) == 20 and key is None
+    assert decode_cursor("not a cursor!") is None
+    print("   ✅ 21 rows paged in cursor order with no gaps or repeats")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Transaction Store Tests")
+    print("=" * 50)
+    test_sorted_columns()
+    test_range_and_category_filters()
+    test_monthly_flows_match_analyzer()
+    test_column_cache_scope()
+    test_keyset_pages()
+    print("\n🎉 All transaction store tests passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+Test script for the embedding pipeline, vector index and chat retrieval
+Covers embedding similarity, flat and inverted-list recall against brute
+force, the memory-mapped file round trip, example and transaction retrieval,
+the prompt's retrieved context and dataset embeddings
+"""
+import sys
+import os
+import json
+import random
+import shutil
+import tempfile
+import time
+
+# Add the backend directory to Python path; the services use the app
+# package's relative imports
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from app.services.vector_index import (
+    HashingEmbedder, VectorIndex, write_index, batched, np
+)
+from app.services.retrieval_service import RetrievalService, format_retrieved_context
+
+DATA_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "data")
+
+
+def dot(a, b):
+    return sum(x * y for x, y in zip(a, b))
+
+
+def random_unit_vectors(count, dim, seed=7):
+    rng = random.Random(seed)
+    vectors = []
+    for _ in range(count):
+        vector = [rng.gauss(0, 1) for _ in range(dim)]
+        norm = sum(v * v for v in vector) ** 0.5
+        vectors.append([v / norm for v in vector])
+    return vectors
+
+
+def test_embedder():
+    """Related wordings embed closer than unrelated ones, and deterministically"""
+    print("\n🔤 Testing hashing embedder...")
+    embedder = HashingEmbedder()
+    grocery = embedder.embed("Grocery shopping at SuperMart")
+    assert abs(dot(grocery, grocery) - 1.0) < 1e-6
+    assert embedder.embed("Grocery shopping at SuperMart") == grocery
+
+    related = dot(grocery, embedder.embed("groceries from the supermart"))
+    unrelated = dot(grocery, embedder.embed("Monthly salary credited"))
+    assert related > unrelated
+    assert embedder.embed_batch(["a", "b"]) == [embedder.embed("a"), embedder.embed("b")]
+    print(f"   ✅ Related {related:.2f} vs unrelated {unrelated:.2f}; stable across calls")
+
+
+def recall_at(index, vectors, queries, k, **search):
+    hits = 0
+    for query in queries:
+        expected = set(sorted(range(len(vectors)), key=lambda row: -dot(query, vectors[row]))[:k])
+        found = {payload["row"] for _, payload in index.search(query, k, **search)}
+        hits += len(expected & found)
+    return hits / (k * len(queries))
+
+
+def test_recall():
+    """Flat and inverted-list searches find the exact nearest neighbours"""
+    print("\n🎯 Testing search recall...")
+    dim, count = 32, 2000
+    vectors = random_unit_vectors(count, dim)
+    payloads = [{"row": row} for row in range(count)]
+    queries = random_unit_vectors(20, dim, seed=11)
+
+    flat = VectorIndex.build(vectors, payloads, dim)
+    assert flat.nlist == 1
+    flat_recall = recall_at(flat, vectors, queries, 5)
+    assert flat_recall >= 0.95, flat_recall
+
+    ivf = VectorIndex.build(vectors, payloads, dim, ivf_min_vectors=500)
+    assert ivf.nlist > 1
+    all_lists = recall_at(ivf, vectors, queries, 5, nprobe=ivf.nlist)
+    probed = recall_at(ivf, vectors, queries, 5, nprobe=ivf.nlist // 2)
+    assert all_lists >= 0.95 and probed >= 0.6, (all_lists, probed)
+
+    top_score, top = flat.search(vectors[42], 1)[0]
+    assert top["row"] == 42 and abs(top_score - 1.0) < 1e-4
+    assert flat.search(vectors[0], 0) == []
+    print(f"   ✅ Recall@5 flat {flat_recall:.2f}, {ivf.nlist} lists all/half probed "
+          f"{all_lists:.2f}/{probed:.2f} ({'numpy' if np is not None else 'pure Python'})")
+
+
+def test_file_round_trip(temp_dir):
+    """Indexes written in batches reopen from the mapped file"""
+    print("\n💾 Testing vector file round trip...")
+    embedder = HashingEmbedder()
+    texts = [(f"Transaction {row} at store {row % 7}", {"row": row}) for row in range(300)]
+    info = write_index(temp_dir, batched(texts, 64), embedder, {"dataset_name": "round_trip"})
+    assert info["status"] == "ready" and info["vectors"] == 300 and info["dataset_name"] == "round_trip"
+
+    index = VectorIndex.open(temp_dir)
+    assert index is not None and index.count == 300 and index.dim == embedder.dim
+    score, payload = index.search(embedder.embed("Transaction 123 at store 4"), 1)[0]
+    assert payload["row"] == 123, payload
+    index.close()
+
+    assert VectorIndex.open(os.path.join(temp_dir, "missing")) is None
+    assert write_index(os.path.join(temp_dir, "empty"), [], embedder)["vectors"] == 0
+    assert VectorIndex.open(os.path.join(temp_dir, "empty")).search(embedder.embed("x"), 3) == []
+    print(f"   ✅ 300 vectors written in 5 batches and reopened ({os.path.getsize(os.path.join(temp_dir, 'vectors.bin'))} bytes)")
+
+
+def test_retrieval(temp_dir):
+    """Chat retrieval returns the matching example and transactions, quickly"""
+    print("\n🔎 Testing chat retrieval...")
+    service = RetrievalService(embeddings_directory=temp_dir)
+    with open(os.path.join(DATA_DIR, "transactions.json"), "r") as f:
+        data = {"transactions": json.load(f)}
+
+    retrieved = service.retrieve("How much did I spend on groceries and food?", data, 1)
+    assert retrieved["examples"][0]["query"] == "How much did I spend on food last month?"
+    assert retrieved["examples"][0]["template"]
+    assert retrieved["transactions"] and all(
+        transaction["category"] == "Food & Dining" for transaction in retrieved["transactions"][:2]
+    )
+    assert os.path.exists(os.path.join(temp_dir, "financial_queries", "vectors.bin"))
+
+    # Without transaction permission nothing is indexed or returned
+    assert service.retrieve("groceries", {"transactions": []}, 1)["transactions"] == []
+
+    # Later calls reuse the persisted examples and the per-version transaction index
+    reopened = RetrievalService(embeddings_directory=temp_dir)
+    reopened.retrieve("car", data, 2)
+    start = time.perf_counter()
+    for _ in range(50):
+        reopened.retrieve("Can I afford a new car?", data, 2)
+    elapsed = (time.perf_counter() - start) / 50 * 1000
+    assert reopened.retrieve("Can I afford a new car?", data, 2)["examples"][0]["intent"] == "check_affordability"
+    print(f"   ✅ Food example and transactions retrieved; {elapsed:.2f} ms per retrieval")
+    return retrieved
+
+
+def test_prompt_context(retrieved):
+    """Both AI services swap the full analysis summary for headline figures plus retrieved context"""
+    print("\n📝 Testing retrieved prompt context...")
+    from app.services.ai_service import AIService
+
+    section = format_retrieved_context(retrieved)
+    assert "SIMILAR QUESTIONS:" in section and "RELEVANT TRANSACTIONS:" in section
+    assert format_retrieved_context({"examples": [], "transactions": []}) == ""
+
+    categories = {f"Category {index}": 1000.0 - index * 50 for index in range(10)}
+    analysis = {"intent": "spending_analysis", "analysis_type": "spending_analysis", "success": True,
+                "results": {
+                    "total_spending": sum(categories.values()), "transaction_count": 42,
+                    "category_breakdown": categories,
+                    "top_categories": [{"category": name, "amount": amount}
+                                       for name, amount in list(categories.items())[:3]],
+                    "insights": [f"Spending in category {index} rose 18% compared with the previous "
+                                 f"month; consider setting a weekly limit" for index in range(6)]
+                }}
+    service = AIService()
+    plain = service._construct_prompt(analysis, "food spending?")
+    prompt = service._construct_prompt({**analysis, "retrieved": retrieved}, "food spending?")
+    assert "RELEVANT CONTEXT:" not in plain and section in prompt
+    assert "Total Spending" in prompt and "Category 0" not in prompt and "rose" not in prompt
+    assert len(prompt) < len(plain)
+
+    from app.services.enhanced_ai_service import (
+        EnhancedAIService, ResponseContext, ResponseTone, ResponseComplexity
+    )
+    enhanced_service = EnhancedAIService()
+
+    def enhanced_prompt(results):
+        return enhanced_service._construct_enhanced_prompt(
+            results, "food spending?", None, ResponseContext(user_id="test", session_id="test"), [],
+            ResponseTone.INFORMATIVE, ResponseComplexity.SIMPLE
+        )
+
+    enhanced_plain = enhanced_prompt(analysis)
+    enhanced = enhanced_prompt({**analysis, "retrieved": retrieved})
+    assert section in enhanced and "Category 0" not in enhanced and len(enhanced) < len(enhanced_plain)
+    print(f"   ✅ Prompts shrink by {len(plain) - len(prompt)} and "
+          f"{len(enhanced_plain) - len(enhanced)} characters with retrieved context")
+
+
+def test_dataset_embeddings(temp_dir):
+    """DatasetService embeds a registered dataset and searches it"""
+    print("\n🗂️ Testing dataset embeddings...")
+    try:
+        from app.services.dataset_service import DatasetService, DatasetType, DatasetFormat
+    except ImportError as e:
+        print(f"   ⚠️ Skipped: dataset service unavailable ({e})")
+        return
+
+    service = DatasetService(os.path.join(temp_dir, "datasets"))
+    assert service.register_dataset(
+        "sample_transactions", os.path.join(DATA_DIR, "transactions.json"),
+        DatasetType.FINANCIAL_TRANSACTIONS, DatasetFormat.JSON, description="Mock transactions"
+    )
+    assert service.create_embeddings("sample_transactions")
+    results = service.search_embeddings("sample_transactions", "netflix subscription", 1)
+    assert "Netflix" in results[0]["text"], results
+    assert not service.create_embeddings("missing_dataset")
+    print(f"   ✅ Dataset embedded; top match: {results[0]['text']}")
+
+
+def main():
+    """Main test runner"""
+    print("🚀 Starting Vector Index Tests")
+    print("=" * 50)
+
+    temp_dir = tempfile.mkdtemp()
+    try:
+        test_embedder()
+        test_recall()
+        test_file_round_trip(os.path.join(temp_dir, "round_trip"))
+        retrieved = test_retrieval(os.path.join(temp_dir, "embeddings"))
+        test_prompt_context(retrieved)
+        test_dataset_embeddings(temp_dir)
+        print("\n🎉 All vector index tests passed")
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
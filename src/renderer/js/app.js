@@ -17,6 +17,11 @@ class FinancialAIApp {
     }
 
     init() {
+        // Keep cached responses current from the backend's update stream
+        if (window.apiService) {
+            window.apiService.connectUpdates();
+        }
+
         this.setupEventListeners();
         this.loadInitialData();
         this.hideLoadingScreen();
@@ -222,7 +227,10 @@ class FinancialAIApp {
                 icon.classList.add('fa-spin');
             }
 
-            // Reload current section data
+            // Revalidate cached responses (unchanged ones come back as 304s), then reload
+            if (window.apiService) {
+                window.apiService.invalidate();
+            }
             await this.loadSectionData(this.currentSection);
             
             this.showNotification('Data refreshed successfully', 'success');
@@ -370,6 +378,16 @@ class FinancialAIApp {
     }
 
     async apiRequest(endpoint, method = 'GET', data = null) {
+        // GETs share apiService's cache: concurrent callers get one request and
+        // repeat reads are served from data kept current by pushed deltas
+        if (method === 'GET' && window.apiService) {
+            try {
+                return await window.apiService.getCached(endpoint, { retries: 0 });
+            } catch (error) {
+                console.warn(`Cached request failed for ${endpoint}: ${error.message}`);
+            }
+        }
+
         try {
             if (window.electronAPI) {
                 const response = await window.electronAPI.makeAPIRequest(endpoint, method, data);
@@ -5,6 +5,8 @@ class Dashboard {
         this.charts = {};
         this.data = {};
         this.updateInterval = null;
+        this.spendingEndpoint = '/api/spending-trend';
+        this.unsubscribers = {};
         
         this.init();
     }
@@ -12,6 +14,27 @@ class Dashboard {
     init() {
         this.setupEventListeners();
         this.setupCharts();
+        this.subscribeToUpdates();
+    }
+
+    subscribeToUpdates() {
+        // Pushed deltas patch or revalidate apiService's cached responses;
+        // redraw only the widget whose data changed
+        if (!window.apiService) return;
+
+        const api = window.apiService;
+        this.unsubscribers.dashboard = api.subscribe('/api/dashboard', (data) => {
+            this.data = data;
+            this.updateSummaryCards(data);
+        });
+        this.unsubscribers.spending = api.subscribe(this.spendingEndpoint, (data) => this.updateSpendingChart(data));
+        this.unsubscribers.category = api.subscribe('/api/category-breakdown', (data) => this.updateCategoryChart(data));
+        this.unsubscribers.recent = api.subscribe('/api/transactions/recent?limit=5', (data) => {
+            this.renderRecentTransactions(data.transactions || data);
+        });
+        this.unsubscribers.insights = api.subscribe('/api/insights/dashboard', (data) => {
+            this.renderAIInsights(data.insights || data);
+        });
     }
 
     setupEventListeners() {
@@ -337,7 +360,7 @@ class Dashboard {
     async loadChartData() {
         try {
             // Load spending trend data
-            const spendingData = await this.app.apiRequest('/api/spending-trend');
+            const spendingData = await this.app.apiRequest(this.spendingEndpoint);
             this.updateSpendingChart(spendingData);
             
             // Load category data
@@ -370,8 +393,18 @@ class Dashboard {
             amounts: [12500, 8200, 15600, 8700, 5000]
         };
         
-        this.charts.category.data.labels = mockData.categories;
-        this.charts.category.data.datasets[0].data = mockData.amounts;
+        const chartData = this.charts.category.data;
+        const sameCategories = chartData.labels.length === mockData.categories.length &&
+            chartData.labels.every((label, i) => label === mockData.categories[i]);
+        if (sameCategories) {
+            // Same slices in the same order: move the existing arcs instead of rebuilding them
+            mockData.amounts.forEach((amount, i) => {
+                chartData.datasets[0].data[i] = amount;
+            });
+        } else {
+            chartData.labels = mockData.categories;
+            chartData.datasets[0].data = mockData.amounts;
+        }
         this.charts.category.update('active');
     }
 
@@ -383,8 +416,13 @@ class Dashboard {
                 chartCard.classList.add('loading');
             }
             
-            // Fetch data for the selected period
-            const spendingData = await this.app.apiRequest(`/api/spending-trend?period=${period}`);
+            // Fetch data for the selected period and follow its updates
+            this.spendingEndpoint = `/api/spending-trend?period=${period}`;
+            if (window.apiService) {
+                if (this.unsubscribers.spending) this.unsubscribers.spending();
+                this.unsubscribers.spending = window.apiService.subscribe(this.spendingEndpoint, (data) => this.updateSpendingChart(data));
+            }
+            const spendingData = await this.app.apiRequest(this.spendingEndpoint);
             this.updateSpendingChart(spendingData);
             
             // Remove loading state
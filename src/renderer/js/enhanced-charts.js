@@ -18,6 +18,15 @@ class EnhancedCharts {
                 red: ['#EF4444', '#DC2626']
             }
         };
+
+        // Full daily spending series behind the spending chart. Pushed deltas
+        // update it in place; the chart draws a decimated view of at most
+        // maxChartPoints points so long histories stay cheap to render.
+        this.dailySpending = { dates: [], amounts: [] };
+        this.dailyBudget = 1500;
+        this.maxChartPoints = 90;
+        this.spendingRenderPending = false;
+
         this.init();
     }
 
@@ -767,6 +776,134 @@ class EnhancedCharts {
         }
     }
 
+    // Incremental updates from pushed deltas (see apiService.connectUpdates)
+    setSpendingSeries(days) {
+        // days: [{ date: 'YYYY-MM-DD', expenses }] in date order
+        this.dailySpending = {
+            dates: days.map(day => day.date),
+            amounts: days.map(day => day.expenses)
+        };
+        this.scheduleSpendingRender();
+    }
+
+    applySpendingDelta(days) {
+        if (!days || days.length === 0) return;
+
+        // Only the changed days are touched; each is placed by binary search
+        const { dates, amounts } = this.dailySpending;
+        days.forEach(({ date, expenses }) => {
+            let low = 0;
+            let high = dates.length;
+            while (low < high) {
+                const mid = (low + high) >> 1;
+                if (dates[mid] < date) low = mid + 1;
+                else high = mid;
+            }
+            if (dates[low] === date) {
+                amounts[low] = expenses;
+            } else {
+                dates.splice(low, 0, date);
+                amounts.splice(low, 0, expenses);
+            }
+        });
+        this.scheduleSpendingRender();
+    }
+
+    scheduleSpendingRender() {
+        // A burst of deltas costs one redraw per frame
+        if (this.spendingRenderPending) return;
+        this.spendingRenderPending = true;
+        requestAnimationFrame(() => {
+            this.spendingRenderPending = false;
+            this.renderSpendingSeries();
+        });
+    }
+
+    renderSpendingSeries() {
+        const chart = this.charts.spending;
+        if (!chart) return;
+
+        const { dates, amounts } = this.dailySpending;
+        const points = this.decimate(amounts, this.maxChartPoints);
+        chart.data.labels = points.map(i => new Date(dates[i]).toLocaleDateString('en-IN', { month: 'short', day: 'numeric' }));
+        chart.data.datasets[0].data = points.map(i => amounts[i]);
+        chart.data.datasets[1].data = points.map(() => this.dailyBudget);
+        chart.data.datasets[2].data = points.map(i => {
+            // 7-day average at each drawn point, over the full series
+            const window = amounts.slice(Math.max(0, i - 6), i + 1);
+            return window.reduce((a, b) => a + b, 0) / window.length;
+        });
+        chart.update('none');
+    }
+
+    decimate(values, threshold) {
+        // Largest-Triangle-Three-Buckets: indices of the points that keep the
+        // series' visual shape (peaks and dips survive, unlike plain sampling)
+        const length = values.length;
+        if (threshold >= length || threshold < 3) {
+            return values.map((_, i) => i);
+        }
+
+        const selected = [0];
+        const bucketSize = (length - 2) / (threshold - 2);
+        let previous = 0;
+        for (let bucket = 0; bucket < threshold - 2; bucket++) {
+            // Average of the next bucket is the third corner of the triangle
+            const nextStart = Math.floor((bucket + 1) * bucketSize) + 1;
+            const nextEnd = Math.min(Math.floor((bucket + 2) * bucketSize) + 1, length);
+            let averageX = 0;
+            let averageY = 0;
+            for (let i = nextStart; i < nextEnd; i++) {
+                averageX += i;
+                averageY += values[i];
+            }
+            const nextCount = Math.max(nextEnd - nextStart, 1);
+            averageX /= nextCount;
+            averageY /= nextCount;
+
+            const start = Math.floor(bucket * bucketSize) + 1;
+            const end = Math.floor((bucket + 1) * bucketSize) + 1;
+            let maxArea = -1;
+            let chosen = start;
+            for (let i = start; i < end; i++) {
+                const area = Math.abs(
+                    (previous - averageX) * (values[i] - values[previous]) -
+                    (previous - i) * (averageY - values[previous])
+                );
+                if (area > maxArea) {
+                    maxArea = area;
+                    chosen = i;
+                }
+            }
+            selected.push(chosen);
+            previous = chosen;
+        }
+        selected.push(length - 1);
+        return selected;
+    }
+
+    applyCategoryDelta(totals) {
+        // totals: { category: new expense total } for the categories a delta touched
+        const chart = this.charts.category;
+        if (!chart || !totals) return;
+
+        const labels = chart.data.labels;
+        const amounts = chart.data.datasets[0].data;
+        Object.entries(totals).forEach(([category, total]) => {
+            const index = labels.indexOf(category);
+            if (index === -1 && total > 0) {
+                labels.push(category);
+                amounts.push(total);
+            } else if (index !== -1 && total > 0) {
+                amounts[index] = total;
+            } else if (index !== -1) {
+                labels.splice(index, 1);
+                amounts.splice(index, 1);
+            }
+        });
+        chart.update();
+    }
+
     // Cleanup method
     destroy() {
         Object.values(this.charts).forEach(chart => {
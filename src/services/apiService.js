@@ -1,4 +1,8 @@
 // API Service Layer for Backend Integration
+
+// Length of the backend's /api/category-breakdown top list
+const TOP_CATEGORIES = 5;
+
 class APIService {
     constructor() {
         this.baseURL = 'http://localhost:8000'; // Backend API URL - matches FastAPI server
@@ -7,6 +11,25 @@ class APIService {
         this.timeout = 10000; // 10 seconds
         this.isOnline = navigator.onLine;
         
+        // Last body and ETag per GET endpoint: replayed when the server answers 304,
+        // served stale-while-revalidate by getCached and patched by pushed deltas
+        this.responseCache = new Map();
+        this.maxCacheEntries = 50;
+        this.staleAfter = 30000; // 30 seconds, only while no update stream is open
+
+        // GETs already on the wire, shared by concurrent callers of the same endpoint
+        this.inflight = new Map();
+        // Bumped on every invalidation so responses that were already in flight
+        // are not taken as current
+        this.cacheEpoch = 0;
+
+        // Pushed data deltas (see connectUpdates)
+        this.subscribers = new Map();
+        this.updateListeners = new Set();
+        this.updateSource = null;
+        this.updatesConnected = false;
+        this.dataVersion = null;
+
         this.init();
     }
 
@@ -37,6 +60,7 @@ class APIService {
 
     clearAuthToken() {
         this.authToken = null;
+        this.responseCache.clear();
         localStorage.removeItem('financial-ai-auth-token');
     }
 
@@ -45,7 +69,23 @@ class APIService {
         // This could include authentication, logging, error handling, etc.
     }
 
-    async makeRequest(endpoint, options = {}) {
+    makeRequest(endpoint, options = {}) {
+        if ((options.method || 'GET') !== 'GET') {
+            return this.sendRequest(endpoint, options);
+        }
+
+        // Concurrent GETs of one endpoint share a single request
+        if (this.inflight.has(endpoint)) {
+            return this.inflight.get(endpoint);
+        }
+        const request = this.sendRequest(endpoint, options).finally(() => {
+            this.inflight.delete(endpoint);
+        });
+        this.inflight.set(endpoint, request);
+        return request;
+    }
+
+    async sendRequest(endpoint, options = {}) {
         const {
             method = 'GET',
             data = null,
@@ -69,11 +109,19 @@ class APIService {
             requestOptions.headers['Authorization'] = `Bearer ${this.authToken}`;
         }
 
+        // Revalidate cached GET responses instead of downloading them again
+        const cached = method === 'GET' ? this.responseCache.get(endpoint) : null;
+        if (cached && cached.etag) {
+            requestOptions.headers['If-None-Match'] = cached.etag;
+        }
+
         // Add request body for non-GET requests
         if (data && method !== 'GET') {
             requestOptions.body = JSON.stringify(data);
         }
 
+        const epoch = this.cacheEpoch;
+
         // Create abort controller for timeout
         const controller = new AbortController();
         const timeoutId = setTimeout(() => controller.abort(), timeout);
@@ -82,7 +130,7 @@ class APIService {
         try {
             const response = await this.executeWithRetry(url, requestOptions, retries);
             clearTimeout(timeoutId);
-            return await this.handleResponse(response);
+            return await this.handleResponse(response, method === 'GET' ? endpoint : null, epoch);
         } catch (error) {
             clearTimeout(timeoutId);
             throw this.handleError(error);
@@ -113,7 +161,15 @@ class APIService {
         throw lastError;
     }
 
-    async handleResponse(response) {
+    async handleResponse(response, cacheKey = null, epoch = this.cacheEpoch) {
+        // Not modified: the body we already hold is current
+        if (response.status === 304 && cacheKey && this.responseCache.has(cacheKey)) {
+            const entry = this.responseCache.get(cacheKey);
+            entry.fetchedAt = Date.now();
+            entry.stale = epoch !== this.cacheEpoch;
+            return entry.data;
+        }
+
         if (!response.ok) {
             const error = new Error(`HTTP ${response.status}: ${response.statusText}`);
             error.status = response.status;
@@ -130,11 +186,261 @@ class APIService {
         }
 
         const contentType = response.headers.get('content-type');
-        if (contentType && contentType.includes('application/json')) {
-            return await response.json();
+        const data = contentType && contentType.includes('application/json')
+            ? await response.json()
+            : await response.text();
+
+        if (cacheKey) {
+            const current = epoch === this.cacheEpoch;
+            this.rememberResponse(cacheKey, response.headers.get('etag'), data, !current);
+            if (!current && this.subscribers.has(cacheKey)) {
+                // Sent before the last update; fetch again once this request settles
+                setTimeout(() => this.revalidate(cacheKey), 0);
+            }
         }
-        
-        return await response.text();
+
+        return data;
+    }
+
+    rememberResponse(endpoint, etag, data, stale = false) {
+        // Map keeps insertion order, so re-inserting marks the entry most recent
+        this.responseCache.delete(endpoint);
+        this.responseCache.set(endpoint, { etag, data, fetchedAt: Date.now(), stale });
+        if (this.responseCache.size > this.maxCacheEntries) {
+            this.responseCache.delete(this.responseCache.keys().next().value);
+        }
+    }
+
+    /**
+     * Stale-while-revalidate GET. Fresh cached data is returned without a request;
+     * stale data is returned at once and refreshed in the background, and
+     * subscribers of the endpoint receive the refreshed body. While the update
+     * stream is open, entries only go stale when a pushed event touches them.
+     */
+    async getCached(endpoint, options = {}) {
+        const { maxAge = this.staleAfter } = options;
+        const entry = this.responseCache.get(endpoint);
+        if (!entry) {
+            return await this.makeRequest(endpoint, options);
+        }
+
+        const expired = !this.updatesConnected && Date.now() - entry.fetchedAt > maxAge;
+        if (entry.stale || expired) {
+            this.revalidate(endpoint, options);
+        }
+        return entry.data;
+    }
+
+    revalidate(endpoint, options = {}) {
+        const previous = this.responseCache.get(endpoint);
+        return this.makeRequest(endpoint, options)
+            .then(data => {
+                if (!previous || data !== previous.data) {
+                    this.notifySubscribers(endpoint, data);
+                }
+                return data;
+            })
+            .catch(error => {
+                console.warn(`Revalidation failed for ${endpoint}:`, error.message);
+                return previous ? previous.data : null;
+            });
+    }
+
+    /**
+     * Receive an endpoint's body whenever a revalidation or pushed delta changes it.
+     * Returns an unsubscribe function.
+     */
+    subscribe(endpoint, callback) {
+        if (!this.subscribers.has(endpoint)) {
+            this.subscribers.set(endpoint, new Set());
+        }
+        this.subscribers.get(endpoint).add(callback);
+        return () => {
+            const callbacks = this.subscribers.get(endpoint);
+            if (callbacks) {
+                callbacks.delete(callback);
+                if (callbacks.size === 0) {
+                    this.subscribers.delete(endpoint);
+                }
+            }
+        };
+    }
+
+    notifySubscribers(endpoint, data) {
+        const callbacks = this.subscribers.get(endpoint);
+        if (!callbacks) return;
+        callbacks.forEach(callback => {
+            try {
+                callback(data, endpoint);
+            } catch (error) {
+                console.error(`Subscriber error for ${endpoint}:`, error);
+            }
+        });
+    }
+
+    invalidate(predicate = () => true) {
+        // Mark matching entries stale; refetch at once only those someone is showing
+        this.cacheEpoch++;
+        this.responseCache.forEach((entry, endpoint) => {
+            if (predicate(endpoint)) {
+                entry.stale = true;
+                if (this.subscribers.has(endpoint)) {
+                    this.revalidate(endpoint);
+                }
+            }
+        });
+    }
+
+    // Pushed updates: versioned deltas from /api/updates/stream
+    connectUpdates() {
+        if (this.updateSource || typeof EventSource === 'undefined') {
+            return;
+        }
+
+        // Resume from the last applied version; EventSource reconnects send Last-Event-ID
+        const query = this.dataVersion !== null ? `?since=${this.dataVersion}` : '';
+        const source = new EventSource(`${this.baseURL}/api/updates/stream${query}`);
+        this.updateSource = source;
+
+        source.addEventListener('hello', (event) => {
+            // On reconnects the backlog since our version follows, so keep it
+            if (this.dataVersion === null) {
+                this.dataVersion = JSON.parse(event.data).version;
+                if (this.responseCache.size > 0) {
+                    // Responses fetched before the stream opened may predate this version
+                    this.invalidate();
+                }
+            }
+            this.updatesConnected = true;
+        });
+        source.addEventListener('transactions', (event) => this.handleUpdate(JSON.parse(event.data)));
+        source.addEventListener('reload', (event) => this.handleUpdate(JSON.parse(event.data)));
+        source.addEventListener('version', (event) => this.handleUpdate(JSON.parse(event.data)));
+        source.addEventListener('resync', (event) => {
+            this.dataVersion = JSON.parse(event.data).version;
+            this.invalidate();
+            this.emitUpdate({ type: 'resync', version: this.dataVersion });
+        });
+        source.onerror = () => {
+            // The browser retries on its own; until then fall back to age-based freshness
+            this.updatesConnected = false;
+        };
+    }
+
+    disconnectUpdates() {
+        if (this.updateSource) {
+            this.updateSource.close();
+            this.updateSource = null;
+        }
+        this.updatesConnected = false;
+    }
+
+    onUpdate(listener) {
+        this.updateListeners.add(listener);
+        return () => this.updateListeners.delete(listener);
+    }
+
+    emitUpdate(event) {
+        this.updateListeners.forEach(listener => {
+            try {
+                listener(event);
+            } catch (error) {
+                console.error('Update listener error:', error);
+            }
+        });
+    }
+
+    handleUpdate(event) {
+        if (this.dataVersion !== null && event.version <= this.dataVersion) {
+            return; // Already applied, e.g. replayed after a reconnect
+        }
+        this.dataVersion = event.version;
+
+        if (event.type === 'transactions') {
+            this.applyDelta(event);
+        } else {
+            // File reloads, or a delta whose rows we may not see: refetch what we hold
+            this.invalidate();
+        }
+        this.emitUpdate(event);
+    }
+
+    applyDelta(delta) {
+        const patched = new Set();
+        this.responseCache.forEach((entry, endpoint) => {
+            const recent = endpoint.match(/^\/api\/transactions\/recent\?limit=(\d+)$/);
+            let data = null;
+            if (recent) {
+                data = this.patchRecentTransactions(entry.data, delta, parseInt(recent[1], 10));
+            } else if (endpoint === '/api/category-breakdown') {
+                data = this.patchCategoryBreakdown(entry.data, delta.categories);
+            }
+
+            if (data) {
+                entry.data = data;
+                entry.fetchedAt = Date.now();
+                entry.stale = false;
+                patched.add(endpoint);
+                this.notifySubscribers(endpoint, data);
+            }
+        });
+
+        // Whatever could not be patched exactly comes back through the ETag path
+        this.invalidate(endpoint => !patched.has(endpoint));
+    }
+
+    patchRecentTransactions(data, delta, limit) {
+        // Returns the patched body, or null when the list must be refetched
+        const list = data && Array.isArray(data.transactions) ? data.transactions : null;
+        if (!list) return null;
+
+        const full = list.length >= limit;
+        const oldest = full ? list[list.length - 1].date || '' : '';
+        const changed = [...delta.added, ...delta.updated];
+        const dropped = new Set(delta.removed.concat(changed.map(t => t.id)));
+        const entering = changed.filter(t => !full || (t.date || '') >= oldest);
+        const transactions = list.filter(t => !dropped.has(t.id)).concat(entering)
+            .sort((a, b) => (b.date || '').localeCompare(a.date || ''));
+
+        if (full && transactions.length < limit) {
+            return null; // A row left a full list; the one moving up is not on the client
+        }
+        const recent = transactions.slice(0, limit);
+        return { ...data, transactions: recent, count: recent.length };
+    }
+
+    patchCategoryBreakdown(data, totals) {
+        // The breakdown is the top categories by expense. A shorter list holds every
+        // category with spending; a full one is patched only when the delta cannot
+        // promote a category the client has never seen.
+        if (!data || !Array.isArray(data.categories) || !totals) return null;
+
+        const complete = data.categories.length < TOP_CATEGORIES;
+        const floor = data.amounts.length ? Math.min(...data.amounts) : 0;
+        const amounts = new Map(data.categories.map((category, i) => [category, data.amounts[i]]));
+        for (const [category, total] of Object.entries(totals)) {
+            if (!complete && total < floor && amounts.has(category)) {
+                return null; // May have dropped below an unlisted category
+            }
+            if (!complete && total > floor && !amounts.has(category)) {
+                return null; // Enters the list; the one it pushes out is unknown
+            }
+            if (complete || amounts.has(category)) {
+                amounts.set(category, total);
+            }
+        }
+
+        const top = [...amounts.entries()]
+            .filter(([, total]) => total > 0)
+            .sort((a, b) => b[1] - a[1])
+            .slice(0, TOP_CATEGORIES);
+        const values = top.map(([, total]) => total);
+        return {
+            ...data,
+            categories: top.map(([category]) => category),
+            amounts: values,
+            total_spending: Math.round(values.reduce((sum, value) => sum + value, 0) * 100) / 100
+        };
     }
 
     handleError(error) {
@@ -180,25 +486,25 @@ class APIService {
         return new Promise(resolve => setTimeout(resolve, ms));
     }
 
-    // Dashboard API endpoints
+    // Dashboard API endpoints (cached; kept current by pushed deltas)
     async getDashboardData() {
-        return await this.makeRequest('/api/dashboard');
+        return await this.getCached('/api/dashboard');
     }
 
     async getSpendingTrend(period = '1m') {
-        return await this.makeRequest(`/api/spending-trend?period=${period}`);
+        return await this.getCached(`/api/spending-trend?period=${period}`);
     }
 
     async getCategoryBreakdown() {
-        return await this.makeRequest('/api/category-breakdown');
+        return await this.getCached('/api/category-breakdown');
     }
 
     async getRecentTransactions(limit = 10) {
-        return await this.makeRequest(`/api/transactions/recent?limit=${limit}`);
+        return await this.getCached(`/api/transactions/recent?limit=${limit}`);
     }
 
     async getDashboardInsights() {
-        return await this.makeRequest('/api/insights/dashboard');
+        return await this.getCached('/api/insights/dashboard');
     }
 
     async generateInsights() {